@@ -10,13 +10,16 @@
 #include <avalanche/validation.h>
 #include <cashaddrenc.h>
 #include <common/args.h>
+#include <common/system.h>
 #include <consensus/activation.h>
+#include <hash.h>
 #include <logging.h>
 #include <random.h>
 #include <scheduler.h>
 #include <uint256.h>
 #include <util/fastrange.h>
 #include <util/fs_helpers.h>
+#include <util/parallel.h>
 #include <util/time.h>
 #include <validation.h> // For ChainstateManager
 
@@ -28,6 +31,13 @@
 namespace avalanche {
 static constexpr uint64_t PEERS_DUMP_VERSION{1};
 
+/**
+ * The staking reward hashes are computed by up to MAX_STAKING_REWARD_THREADS
+ * threads, each handling at least STAKING_REWARD_CANDIDATES_PER_THREAD proofs.
+ */
+static constexpr size_t MAX_STAKING_REWARD_THREADS{4};
+static constexpr size_t STAKING_REWARD_CANDIDATES_PER_THREAD{2048};
+
 bool PeerManager::addNode(NodeId nodeid, const ProofId &proofid) {
     auto &pview = peers.get<by_proofid>();
     auto it = pview.find(proofid);
@@ -1000,84 +1010,100 @@ bool PeerManager::selectStakingRewardWinner(
 
     const BlockHash prevblockhash = pprev->GetBlockHash();
 
-    std::vector<ProofRef> selectedProofs;
-    ProofRef firstCompliantProof = ProofRef();
-    while (selectedProofs.size() < peers.size()) {
-        double bestRewardRank = std::numeric_limits<double>::max();
-        ProofRef selectedProof = ProofRef();
-        int64_t selectedProofRegistrationTime{0};
-        uint256 bestRewardHash;
-
-        for (const Peer &peer : peers) {
-            if (!peer.proof) {
-                // Should never happen, continue
-                continue;
-            }
-
-            if (!peer.hasFinalized ||
-                peer.registration_time.count() >= maxRegistrationTime) {
-                continue;
-            }
+    struct Candidate {
+        const Peer *peer;
+        uint256 rewardHash;
+        double rewardRank;
+    };
 
-            if (std::find_if(selectedProofs.begin(), selectedProofs.end(),
-                             [&peer](const ProofRef &proof) {
-                                 return peer.getProofId() == proof->getId();
-                             }) != selectedProofs.end()) {
-                continue;
+    // The finalized peers are kept sorted by registration time, so the
+    // eligible ones are found without checking all the peers.
+    std::vector<Candidate> candidates;
+    auto &eligibleView = peers.get<by_staking_eligibility>();
+    const auto eligibleEnd =
+        eligibleView.lower_bound(std::chrono::seconds{maxRegistrationTime});
+    for (auto it = eligibleView.begin(); it != eligibleEnd; ++it) {
+        if (!it->proof) {
+            // Should never happen, continue
+            continue;
+        }
+        candidates.push_back({&*it, uint256(), 0.});
+    }
+
+    // Hashing is the bulk of the work, so split it across a few threads when
+    // there are many candidates.
+    const size_t numThreads = std::min<size_t>(
+        {MAX_STAKING_REWARD_THREADS, size_t(GetNumCores()),
+         candidates.size() / STAKING_REWARD_CANDIDATES_PER_THREAD + 1});
+    util::g_worker_pool.ForRanges(
+        candidates.size(), numThreads, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                Candidate &candidate = candidates[i];
+                CHash256()
+                    .Write(prevblockhash)
+                    .Write(candidate.peer->getProofId())
+                    .Finalize(candidate.rewardHash);
+
+                // To make sure the selection is properly weighted according to
+                // the proof score, we normalize the proofRewardHash to a number
+                // between 0 and 1, then take the logarithm and divide by the
+                // weight. Since it is scale-independent, we can simplify by
+                // removing constants and use base 2 logarithm.
+                // Inspired by: https://stackoverflow.com/a/30226926.
+                candidate.rewardRank =
+                    (256.0 -
+                     std::log2(
+                         UintToArith256(candidate.rewardHash).getdouble())) /
+                    candidate.peer->getScore();
             }
+        });
+
+    candidates.erase(
+        std::remove_if(
+            candidates.begin(), candidates.end(),
+            [&](const Candidate &candidate) {
+                if (candidate.rewardHash != uint256::ZERO) {
+                    return false;
+                }
 
-            uint256 proofRewardHash;
-            CHash256()
-                .Write(prevblockhash)
-                .Write(peer.getProofId())
-                .Finalize(proofRewardHash);
-
-            if (proofRewardHash == uint256::ZERO) {
                 // This either the result of an incredibly unlikely lucky hash,
                 // or a the hash is getting abused. In this case, skip the
                 // proof.
-                LogPrintf(
-                    "Staking reward hash has a suspicious value of zero for "
-                    "proof %s and blockhash %s, skipping\n",
-                    peer.getProofId().ToString(), prevblockhash.ToString());
-                continue;
-            }
+                LogPrintf("Staking reward hash has a suspicious value of zero "
+                          "for proof %s and blockhash %s, skipping\n",
+                          candidate.peer->getProofId().ToString(),
+                          prevblockhash.ToString());
+                return true;
+            }),
+        candidates.end());
+
+    // The best ranking is the lowest ranking value. Select the lowest reward
+    // hash then proofid in the unlikely case of a collision.
+    auto worseCandidate = [](const Candidate &a, const Candidate &b) {
+        if (a.rewardRank != b.rewardRank) {
+            return a.rewardRank > b.rewardRank;
+        }
+        if (a.rewardHash != b.rewardHash) {
+            return b.rewardHash < a.rewardHash;
+        }
+        return b.peer->getProofId() < a.peer->getProofId();
+    };
 
-            // To make sure the selection is properly weighted according to the
-            // proof score, we normalize the proofRewardHash to a number between
-            // 0 and 1, then take the logarithm and divide by the weight. Since
-            // it is scale-independent, we can simplify by removing constants
-            // and use base 2 logarithm.
-            // Inspired by: https://stackoverflow.com/a/30226926.
-            double proofRewardRank =
-                (256.0 -
-                 std::log2(UintToArith256(proofRewardHash).getdouble())) /
-                peer.getScore();
-
-            // The best ranking is the lowest ranking value
-            if (proofRewardRank < bestRewardRank) {
-                bestRewardRank = proofRewardRank;
-                selectedProof = peer.proof;
-                selectedProofRegistrationTime = peer.registration_time.count();
-                bestRewardHash = proofRewardHash;
-            }
+    // Usually only the first few candidates are needed, so rather than
+    // sorting all of them they are popped one by one from a heap.
+    std::make_heap(candidates.begin(), candidates.end(), worseCandidate);
+    auto heapEnd = candidates.end();
 
-            // Select the lowest reward hash then proofid in the unlikely case
-            // of a collision.
-            if (proofRewardRank == bestRewardRank &&
-                (proofRewardHash < bestRewardHash ||
-                 (proofRewardHash == bestRewardHash &&
-                  peer.getProofId() < selectedProof->getId()))) {
-                selectedProof = peer.proof;
-                selectedProofRegistrationTime = peer.registration_time.count();
-                bestRewardHash = proofRewardHash;
-            }
-        }
+    std::vector<ProofRef> selectedProofs;
+    ProofRef firstCompliantProof = ProofRef();
+    while (heapEnd != candidates.begin()) {
+        std::pop_heap(candidates.begin(), heapEnd, worseCandidate);
+        --heapEnd;
 
-        if (!selectedProof) {
-            // No winner
-            break;
-        }
+        const Peer &selectedPeer = *heapEnd->peer;
+        const ProofRef &selectedProof = selectedPeer.proof;
+        const int64_t selectedProofRegistrationTime =
+            selectedPeer.registration_time.count();
 
         if (!firstCompliantProof &&
             selectedProofRegistrationTime < targetRegistrationTime) {
@@ -1361,10 +1387,8 @@ bool PeerManager::loadPeersFromFile(
                     continue;
                 }
 
-                // We don't modify any key so we don't need to rehash.
-                // If the modify fails, it means we don't get the full benefit
-                // from the file but we still added our peer to the set. The
-                // non-overridden fields will be set the normal way.
+                // This reorders the staking eligibility index but doesn't
+                // touch the unique keys, so it can't fail.
                 peersByProofId.modify(it, [&](Peer &p) {
                     p.hasFinalized = hasFinalized;
                     p.registration_time =
@@ -121,6 +121,18 @@ struct score_index {
     result_type operator()(const Peer &p) const { return p.getScore(); }
 };
 
+/**
+ * Registration time of the finalized peers. The other peers are sorted last, so
+ * the peers eligible for the staking rewards are a prefix of this index.
+ */
+struct staking_eligibility_index {
+    using result_type = std::chrono::seconds;
+    result_type operator()(const Peer &p) const {
+        return p.hasFinalized ? p.registration_time
+                              : std::chrono::seconds::max();
+    }
+};
+
 struct next_request_time {};
 
 struct PendingNode {
@@ -134,6 +146,7 @@ struct PendingNode {
 struct by_proofid;
 struct by_nodeid;
 struct by_score;
+struct by_staking_eligibility;
 
 struct RemoteProof {
     ProofId proofid;
@@ -177,7 +190,10 @@ class PeerManager {
                                      SaltedProofIdHasher>,
                   // ordered by score, decreasing order
                   bmi::ordered_non_unique<bmi::tag<by_score>, score_index,
-                                          std::greater<uint32_t>>>>;
+                                          std::greater<uint32_t>>,
+                  // ordered by registration time, finalized peers first
+                  bmi::ordered_non_unique<bmi::tag<by_staking_eligibility>,
+                                          staking_eligibility_index>>>;
 
     PeerId nextPeerId = 0;
     PeerSet peers;
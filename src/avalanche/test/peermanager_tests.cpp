@@ -2639,6 +2639,87 @@ BOOST_AUTO_TEST_CASE(select_staking_reward_winner) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(select_staking_reward_winner_many_proofs) {
+    ChainstateManager &chainman = *Assert(m_node.chainman);
+    avalanche::PeerManager pm(PROOF_DUST_THRESHOLD, chainman);
+    Chainstate &active_chainstate = chainman.ActiveChainstate();
+
+    auto now = GetTime<std::chrono::seconds>();
+    SetMockTime(now);
+
+    // Register enough proofs for the reward hashes to be computed by several
+    // threads, with various scores. Only the finalized ones are eligible.
+    const size_t numProofs = 5000;
+    std::vector<ProofRef> proofs;
+    for (size_t i = 0; i < numProofs; i++) {
+        const CKey key = CKey::MakeCompressedKey();
+        const Amount amount =
+            int64_t(1 + InsecureRandRange(10)) * PROOF_DUST_THRESHOLD;
+        auto proof = buildProof(
+            key, {{createUtxo(active_chainstate, key, amount), amount}});
+        PeerId peerid = TestPeerManager::registerAndGetPeerId(pm, proof);
+        BOOST_CHECK_NE(peerid, NO_PEER);
+        BOOST_CHECK(pm.addNode(NodeId(i), proof->getId()));
+        if (i % 3 != 0) {
+            BOOST_CHECK(pm.setFinalized(peerid));
+        }
+        proofs.push_back(std::move(proof));
+    }
+
+    now += 6 * avalanche::Peer::DANGLING_TIMEOUT + 1s;
+    SetMockTime(now);
+
+    // These ones are too recent to be eligible
+    for (size_t i = 0; i < 10; i++) {
+        const CKey key = CKey::MakeCompressedKey();
+        auto proof = buildProof(
+            key,
+            {{createUtxo(active_chainstate, key), PROOF_DUST_THRESHOLD}});
+        PeerId peerid = TestPeerManager::registerAndGetPeerId(pm, proof);
+        BOOST_CHECK(pm.addNode(NodeId(numProofs + i), proof->getId()));
+        BOOST_CHECK(pm.setFinalized(peerid));
+    }
+
+    CBlockIndex prevBlock;
+    prevBlock.nTime = now.count();
+
+    for (size_t round = 0; round < 10; round++) {
+        BlockHash prevHash{GetRandHash()};
+        prevBlock.phashBlock = &prevHash;
+
+        // Find the winner the straightforward way
+        ProofId expectedWinner;
+        double bestRank = std::numeric_limits<double>::max();
+        uint256 bestHash;
+        for (size_t i = 0; i < numProofs; i++) {
+            if (i % 3 == 0) {
+                continue;
+            }
+
+            const ProofId &proofid = proofs[i]->getId();
+            uint256 hash;
+            CHash256().Write(prevHash).Write(proofid).Finalize(hash);
+            const double rank =
+                (256.0 - std::log2(UintToArith256(hash).getdouble())) /
+                proofs[i]->getScore();
+            if (rank < bestRank ||
+                (rank == bestRank &&
+                 (hash < bestHash ||
+                  (hash == bestHash && proofid < expectedWinner)))) {
+                expectedWinner = proofid;
+                bestRank = rank;
+                bestHash = hash;
+            }
+        }
+
+        // None of the proofs is flaky, so there is no substitute
+        std::vector<std::pair<ProofId, CScript>> winners;
+        BOOST_CHECK(pm.selectStakingRewardWinner(&prevBlock, winners));
+        BOOST_CHECK_EQUAL(winners.size(), 1);
+        BOOST_CHECK(winners[0].first == expectedWinner);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(remote_proof) {
     ChainstateManager &chainman = *Assert(m_node.chainman);
     avalanche::PeerManager pm(PROOF_DUST_THRESHOLD, chainman);
@@ -0,0 +1,68 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chain.h>
+#include <node/blockmap.h>
+#include <random.h>
+#include <util/hasher.h>
+
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+static constexpr int CHAIN_LENGTH{200000};
+
+/**
+ * Serving a getheaders request: build the locator of a block, which walks
+ * its ancestors, and look the locator hashes up in the block index. The
+ * block index is either the arena, laid out by height as after startup, or a
+ * node based map filled in database (random) order as it used to be.
+ */
+template <typename Map> static void BlockIndexLocator(benchmark::Bench &bench) {
+    FastRandomContext rng{/*fDeterministic=*/true};
+    std::vector<BlockHash> hashes(CHAIN_LENGTH);
+    for (BlockHash &hash : hashes) {
+        hash = BlockHash{rng.rand256()};
+    }
+    std::vector<int> order(CHAIN_LENGTH);
+    for (int i = 0; i < CHAIN_LENGTH; i++) {
+        order[i] = i;
+    }
+    Shuffle(order.begin(), order.end(), rng);
+
+    Map map;
+    for (const int height : order) {
+        CBlockIndex &index = map[hashes[height]];
+        index.phashBlock = &map.find(hashes[height])->first;
+        index.nHeight = height;
+        index.pprev = height > 0 ? &map[hashes[height - 1]] : nullptr;
+    }
+    if constexpr (std::is_same_v<Map, node::BlockMap>) {
+        map.SortByHeight();
+    }
+    for (const BlockHash &hash : hashes) {
+        map.find(hash)->second.BuildSkip();
+    }
+
+    bench.run([&] {
+        const CBlockIndex &block{
+            map.find(hashes[rng.randrange(CHAIN_LENGTH)])->second};
+        for (const BlockHash &hash : LocatorEntries(&block)) {
+            ankerl::nanobench::doNotOptimizeAway(map.find(hash)->second);
+        }
+    });
+}
+
+static void BlockIndexLocatorArena(benchmark::Bench &bench) {
+    BlockIndexLocator<node::BlockMap>(bench);
+}
+
+static void BlockIndexLocatorNodeMap(benchmark::Bench &bench) {
+    BlockIndexLocator<std::unordered_map<BlockHash, CBlockIndex, BlockHasher>>(
+        bench);
+}
+
+BENCHMARK(BlockIndexLocatorArena);
+BENCHMARK(BlockIndexLocatorNodeMap);
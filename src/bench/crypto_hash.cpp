@@ -15,6 +15,7 @@
 #include <uint256.h>
 
 #include <string>
+#include <vector>
 
 /* Number of bytes to hash per iteration */
 static const uint64_t BUFFER_SIZE = 1000 * 1000;
@@ -59,6 +60,48 @@ static void SHA256D64_1024(benchmark::Bench &bench) {
         [&] { SHA256D64(in.data(), in.data(), 1024); });
 }
 
+/**
+ * Messages the size of the transactions of a block: mostly 1 or 2 inputs and
+ * 2 outputs, with a few larger transactions.
+ */
+struct BlockTxsData {
+    static constexpr size_t NUM_TXS{100000};
+
+    std::vector<std::vector<uint8_t>> txs;
+    std::vector<const uint8_t *> inputs;
+    std::vector<size_t> sizes;
+
+    BlockTxsData() {
+        FastRandomContext rng(true);
+        for (size_t i = 0; i < NUM_TXS; ++i) {
+            const size_t size{i % 10 == 0 ? 600 + rng.randrange(2000)
+                                          : 200 + rng.randrange(200)};
+            txs.push_back(rng.randbytes(size));
+            inputs.push_back(txs.back().data());
+            sizes.push_back(size);
+        }
+    }
+};
+
+static void SHA256D_BlockTxids(benchmark::Bench &bench) {
+    const BlockTxsData data;
+    std::vector<uint256> txids(data.txs.size());
+    bench.batch(data.txs.size()).unit("tx").run([&] {
+        for (size_t i = 0; i < data.txs.size(); ++i) {
+            txids[i] = Hash(data.txs[i]);
+        }
+    });
+}
+
+static void SHA256DMulti_BlockTxids(benchmark::Bench &bench) {
+    const BlockTxsData data;
+    std::vector<uint8_t> txids(data.txs.size() * CSHA256::OUTPUT_SIZE);
+    bench.batch(data.txs.size()).unit("tx").run([&] {
+        SHA256DMulti(txids.data(), data.inputs.data(), data.sizes.data(),
+                     data.txs.size());
+    });
+}
+
 static void SHA512(benchmark::Bench &bench) {
     uint8_t hash[CSHA512::OUTPUT_SIZE];
     std::vector<uint8_t> in(BUFFER_SIZE, 0);
@@ -128,6 +171,8 @@ BENCHMARK(SHA3_256_1M);
 BENCHMARK(SHA256_32b);
 BENCHMARK(SipHash_32b);
 BENCHMARK(SHA256D64_1024);
+BENCHMARK(SHA256D_BlockTxids);
+BENCHMARK(SHA256DMulti_BlockTxids);
 BENCHMARK(FastRandom_32bit);
 BENCHMARK(FastRandom_1bit);
 
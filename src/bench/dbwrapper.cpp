@@ -0,0 +1,281 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <coins.h>
+#include <common/system.h>
+#include <dbwrapper.h>
+#include <flatfile.h>
+#include <index/disktxpos.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <script/script.h>
+#include <serialize.h>
+#include <test/util/setup_common.h>
+#include <tinyformat.h>
+#include <uint256.h>
+#include <util/fs.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+static constexpr size_t NUM_ENTRIES{200000};
+static constexpr size_t NUM_LOOKUPS{4000};
+
+/**
+ * Compare the throughput of random reads from a database on disk, like the
+ * coins spent by a block, looked up one by one or with
+ * CDBWrapper::MultiRead().
+ */
+struct DBReadSetup {
+    const std::unique_ptr<const BasicTestingSetup> testing_setup{
+        MakeNoLogFileContext<const BasicTestingSetup>()};
+    CDBWrapper db{{.path = testing_setup->m_args.GetDataDirBase() /
+                           "bench_dbwrapper",
+                   .cache_bytes = 8 << 20,
+                   .memory_only = false,
+                   .wipe_data = true}};
+    std::vector<uint256> lookups;
+
+    DBReadSetup() {
+        FastRandomContext rng{/*fDeterministic=*/true};
+        std::vector<uint256> keys;
+        CDBBatch batch(db);
+        for (size_t i = 0; i < NUM_ENTRIES; i++) {
+            keys.push_back(rng.rand256());
+            // About the size of a coin
+            batch.Write(keys.back(), rng.randbytes(40));
+            if (batch.SizeEstimate() > 1 << 20) {
+                db.WriteBatch(batch);
+                batch.Clear();
+            }
+        }
+        db.WriteBatch(batch);
+
+        for (size_t i = 0; i < NUM_LOOKUPS; i++) {
+            lookups.push_back(keys[rng.randrange(keys.size())]);
+        }
+    }
+};
+
+static void DBRead(benchmark::Bench &bench) {
+    DBReadSetup setup;
+    bench.batch(setup.lookups.size()).unit("read").run([&] {
+        std::vector<uint8_t> value;
+        for (const uint256 &key : setup.lookups) {
+            bool found = setup.db.Read(key, value);
+            assert(found);
+        }
+    });
+}
+
+static void DBMultiRead(benchmark::Bench &bench) {
+    DBReadSetup setup;
+    bench.batch(setup.lookups.size()).unit("read").run([&] {
+        const auto values{setup.db.MultiRead<std::vector<uint8_t>>(
+            setup.lookups)};
+        assert(std::all_of(values.begin(), values.end(),
+                           [](const auto &value) { return bool(value); }));
+    });
+}
+
+static void DBMultiReadParallel(benchmark::Bench &bench) {
+    DBReadSetup setup;
+    const size_t threads = std::clamp(GetNumCores(), 1, 4);
+    bench.batch(setup.lookups.size()).unit("read").run([&] {
+        const auto values{setup.db.MultiRead<std::vector<uint8_t>>(
+            setup.lookups, threads)};
+        assert(std::all_of(values.begin(), values.end(),
+                           [](const auto &value) { return bool(value); }));
+    });
+}
+
+/** Key of the entries of the block filter index, by height */
+struct HeightKey {
+    uint32_t height;
+
+    template <typename Stream> void Serialize(Stream &s) const {
+        ser_writedata8(s, uint8_t{'t'});
+        ser_writedata32be(s, height);
+    }
+    template <typename Stream> void Unserialize(Stream &s) {
+        ser_readdata8(s);
+        height = ser_readdata32be(s);
+    }
+};
+
+//! Block hash, then filter hash, header and position
+using FilterEntry =
+    std::pair<uint256, std::pair<uint256, std::pair<uint256, FlatFilePos>>>;
+
+enum class DBKind { CHAINSTATE, TXINDEX, BLOCKFILTER };
+
+//! Number of consecutive block filter index entries read at once
+static constexpr uint32_t FILTER_RANGE{1000};
+
+/**
+ * Compare the read latency and size on disk of the chainstate, txindex and
+ * block filter index databases under each storage profile. The entries are
+ * made up to look like the real ones, so they compress about as well. The
+ * chainstate and the txindex are read by random lookups, the block filter
+ * index by ranges of heights.
+ */
+static void DBProfileRead(benchmark::Bench &bench, DBKind kind,
+                          const std::string &profile_name) {
+    const auto testing_setup{MakeNoLogFileContext<const BasicTestingSetup>()};
+    const fs::path path{testing_setup->m_args.GetDataDirBase() /
+                        "bench_db_profile"};
+    const std::optional<DBStorageProfile> profile{
+        GetDBStorageProfile(profile_name)};
+    assert(profile);
+    CDBWrapper db{{.path = path,
+                   .cache_bytes = 4 << 20,
+                   .memory_only = false,
+                   .wipe_data = true,
+                   .obfuscate = true,
+                   .options = {.storage = *profile}}};
+
+    FastRandomContext rng{/*fDeterministic=*/true};
+    std::vector<COutPoint> outpoints;
+    std::vector<TxId> txids;
+    CDBBatch batch(db);
+    for (uint32_t i = 0; i < NUM_ENTRIES; i++) {
+        switch (kind) {
+            case DBKind::CHAINSTATE: {
+                outpoints.emplace_back(TxId(rng.rand256()), rng.randrange(4));
+                const CScript script{CScript() << OP_DUP << OP_HASH160
+                                               << rng.randbytes(20)
+                                               << OP_EQUALVERIFY
+                                               << OP_CHECKSIG};
+                const Amount amount{int64_t(rng.randrange(1'000'000'000)) *
+                                    SATOSHI};
+                batch.Write(std::make_pair(uint8_t{'C'}, outpoints.back()),
+                            Coin(CTxOut(amount, script),
+                                 700'000 + rng.randrange(100'000), false));
+                break;
+            }
+            case DBKind::TXINDEX: {
+                txids.emplace_back(rng.rand256());
+                batch.Write(std::make_pair(uint8_t{'t'}, txids.back()),
+                            CDiskTxPos(FlatFilePos(i / 20'000, i * 300),
+                                       rng.randrange(1 << 20)));
+                break;
+            }
+            case DBKind::BLOCKFILTER: {
+                const FlatFilePos pos(i / 10'000, i * 500);
+                batch.Write(HeightKey{i},
+                            FilterEntry{rng.rand256(),
+                                        {rng.rand256(), {rng.rand256(), pos}}});
+                break;
+            }
+        }
+        if (batch.SizeEstimate() > 1 << 20) {
+            db.WriteBatch(batch);
+            batch.Clear();
+        }
+    }
+    db.WriteBatch(batch);
+    // Rewrite all the tables with this profile
+    db.CompactRange(uint8_t{0}, uint8_t{0xff});
+
+    uint64_t size_on_disk{0};
+    for (const auto &entry : fs::directory_iterator(path)) {
+        if (entry.is_regular_file()) {
+            size_on_disk += entry.file_size();
+        }
+    }
+    bench.name(strprintf("%s (%u KiB on disk)", bench.name(),
+                         size_on_disk >> 10));
+
+    switch (kind) {
+        case DBKind::CHAINSTATE: {
+            bench.batch(NUM_LOOKUPS).unit("read").run([&] {
+                Coin coin;
+                for (size_t i = 0; i < NUM_LOOKUPS; i++) {
+                    const COutPoint &outpoint{
+                        outpoints[rng.randrange(outpoints.size())]};
+                    bool found = db.Read(std::make_pair(uint8_t{'C'}, outpoint),
+                                         coin);
+                    assert(found);
+                }
+            });
+            break;
+        }
+        case DBKind::TXINDEX: {
+            bench.batch(NUM_LOOKUPS).unit("read").run([&] {
+                CDiskTxPos pos;
+                for (size_t i = 0; i < NUM_LOOKUPS; i++) {
+                    const TxId &txid{txids[rng.randrange(txids.size())]};
+                    bool found =
+                        db.Read(std::make_pair(uint8_t{'t'}, txid), pos);
+                    assert(found);
+                }
+            });
+            break;
+        }
+        case DBKind::BLOCKFILTER: {
+            bench.batch(FILTER_RANGE).unit("read").run([&] {
+                const uint32_t start =
+                    rng.randrange(NUM_ENTRIES - FILTER_RANGE);
+                std::unique_ptr<CDBIterator> it{
+                    const_cast<CDBWrapper &>(db).NewIterator()};
+                it->Seek(HeightKey{start});
+                FilterEntry value;
+                for (uint32_t i = 0; i < FILTER_RANGE; i++, it->Next()) {
+                    HeightKey key;
+                    bool found = it->GetKey(key) && key.height == start + i &&
+                                 it->GetValue(value);
+                    assert(found);
+                }
+            });
+            break;
+        }
+    }
+}
+
+static void DBChainstateDefault(benchmark::Bench &bench) {
+    DBProfileRead(bench, DBKind::CHAINSTATE, "default");
+}
+static void DBChainstateArchive(benchmark::Bench &bench) {
+    DBProfileRead(bench, DBKind::CHAINSTATE, "archive");
+}
+static void DBChainstateScan(benchmark::Bench &bench) {
+    DBProfileRead(bench, DBKind::CHAINSTATE, "scan");
+}
+static void DBTxIndexDefault(benchmark::Bench &bench) {
+    DBProfileRead(bench, DBKind::TXINDEX, "default");
+}
+static void DBTxIndexArchive(benchmark::Bench &bench) {
+    DBProfileRead(bench, DBKind::TXINDEX, "archive");
+}
+static void DBTxIndexScan(benchmark::Bench &bench) {
+    DBProfileRead(bench, DBKind::TXINDEX, "scan");
+}
+static void DBBlockFilterIndexDefault(benchmark::Bench &bench) {
+    DBProfileRead(bench, DBKind::BLOCKFILTER, "default");
+}
+static void DBBlockFilterIndexArchive(benchmark::Bench &bench) {
+    DBProfileRead(bench, DBKind::BLOCKFILTER, "archive");
+}
+static void DBBlockFilterIndexScan(benchmark::Bench &bench) {
+    DBProfileRead(bench, DBKind::BLOCKFILTER, "scan");
+}
+
+BENCHMARK(DBRead);
+BENCHMARK(DBMultiRead);
+BENCHMARK(DBMultiReadParallel);
+BENCHMARK(DBChainstateDefault);
+BENCHMARK(DBChainstateArchive);
+BENCHMARK(DBChainstateScan);
+BENCHMARK(DBTxIndexDefault);
+BENCHMARK(DBTxIndexArchive);
+BENCHMARK(DBTxIndexScan);
+BENCHMARK(DBBlockFilterIndexDefault);
+BENCHMARK(DBBlockFilterIndexArchive);
+BENCHMARK(DBBlockFilterIndexScan);
@@ -4,6 +4,18 @@
 
 #include <bench/bench.h>
 #include <blockfilter.h>
+#include <common/system.h>
+#include <primitives/block.h>
+#include <random.h>
+#include <script/standard.h>
+#include <streams.h>
+#include <undo.h>
+#include <util/parallel.h>
+#include <version.h>
+
+#include <algorithm>
+#include <set>
+#include <vector>
 
 static void ConstructGCSFilter(benchmark::Bench &bench) {
     GCSFilter::ElementSet elements;
@@ -35,5 +47,214 @@ static void MatchGCSFilter(benchmark::Bench &bench) {
     bench.unit("elem").run([&] { filter.Match(GCSFilter::Element()); });
 }
 
+static void MatchDecodedGCSFilter(benchmark::Bench &bench) {
+    GCSFilter::ElementSet elements;
+    for (int i = 0; i < 10000; ++i) {
+        GCSFilter::Element element(32);
+        element[0] = static_cast<uint8_t>(i);
+        element[1] = static_cast<uint8_t>(i >> 8);
+        elements.insert(std::move(element));
+    }
+    const DecodedGCSFilter filter(GCSFilter({0, 0, 20, 1 << 20}, elements));
+
+    bench.unit("elem").run([&] { filter.Match(GCSFilter::Element()); });
+}
+
+static void DeserializeGCSFilter(benchmark::Bench &bench, bool check) {
+    GCSFilter::ElementSet elements;
+    for (int i = 0; i < 10000; ++i) {
+        GCSFilter::Element element(32);
+        element[0] = static_cast<uint8_t>(i);
+        element[1] = static_cast<uint8_t>(i >> 8);
+        elements.insert(std::move(element));
+    }
+    const GCSFilter filter({0, 0, 20, 1 << 20}, elements);
+
+    bench.batch(elements.size()).unit("elem").run([&] {
+        GCSFilter decoded(filter.GetParams(), filter.GetEncoded(),
+                          /*skip_decode_check=*/!check);
+        ankerl::nanobench::doNotOptimizeAway(decoded.GetN());
+    });
+}
+
+static void DeserializeGCSFilterChecked(benchmark::Bench &bench) {
+    DeserializeGCSFilter(bench, true);
+}
+
+static void DeserializeGCSFilterUnchecked(benchmark::Bench &bench) {
+    DeserializeGCSFilter(bench, false);
+}
+
+namespace {
+constexpr size_t RESCAN_CHAIN_LENGTH = 200;
+constexpr size_t RESCAN_TXS_PER_BLOCK = 100;
+constexpr size_t RESCAN_WALLET_SCRIPTS = 100;
+// One block out of RESCAN_WALLET_BLOCK_INTERVAL pays to the wallet.
+constexpr size_t RESCAN_WALLET_BLOCK_INTERVAL = 50;
+
+/**
+ * A synthetic chain of serialized blocks along with their BIP 158 filters, and
+ * a sparse wallet which only receives a payment every few blocks.
+ */
+struct SyntheticRescanChain {
+    std::vector<std::vector<uint8_t>> serialized_blocks;
+    std::vector<BlockFilter> filters;
+    std::set<CScript> wallet_scripts;
+    GCSFilter::ElementSet wallet_elements;
+
+    SyntheticRescanChain() {
+        FastRandomContext rng(/*fDeterministic=*/true);
+        std::vector<CScript> scripts;
+        for (size_t i = 0; i < RESCAN_WALLET_SCRIPTS; ++i) {
+            CScript script = GetScriptForDestination(PKHash(rng.rand160()));
+            scripts.push_back(script);
+            wallet_scripts.insert(script);
+            wallet_elements.emplace(script.begin(), script.end());
+        }
+
+        BlockHash prev_hash;
+        for (size_t height = 0; height < RESCAN_CHAIN_LENGTH; ++height) {
+            CBlock block;
+            block.hashPrevBlock = prev_hash;
+            for (size_t i = 0; i < RESCAN_TXS_PER_BLOCK; ++i) {
+                CMutableTransaction mtx;
+                mtx.vin.emplace_back(TxId(rng.rand256()), 0);
+                mtx.vin[0].scriptSig = CScript() << rng.randbytes(71)
+                                                 << rng.randbytes(33);
+                for (int n = 0; n < 2; ++n) {
+                    mtx.vout.emplace_back(
+                        int64_t(rng.randrange(1000000)) * SATOSHI,
+                        GetScriptForDestination(PKHash(rng.rand160())));
+                }
+                block.vtx.push_back(MakeTransactionRef(std::move(mtx)));
+            }
+            if (height % RESCAN_WALLET_BLOCK_INTERVAL == 0) {
+                CMutableTransaction mtx(*block.vtx.back());
+                mtx.vout[0].scriptPubKey =
+                    scripts[rng.randrange(scripts.size())];
+                block.vtx.back() = MakeTransactionRef(std::move(mtx));
+            }
+
+            CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+            stream << block;
+            serialized_blocks.emplace_back(UCharCast(stream.data()),
+                                           UCharCast(stream.data()) +
+                                               stream.size());
+            filters.emplace_back(BlockFilterType::BASIC, block, CBlockUndo());
+            prev_hash = block.GetHash();
+        }
+    }
+
+    size_t ScanBlock(size_t height) const {
+        CDataStream stream(serialized_blocks[height], SER_NETWORK,
+                           PROTOCOL_VERSION);
+        CBlock block;
+        stream >> block;
+
+        size_t found = 0;
+        for (const CTransactionRef &tx : block.vtx) {
+            for (const CTxOut &txout : tx->vout) {
+                found += wallet_scripts.count(txout.scriptPubKey);
+            }
+        }
+        return found;
+    }
+};
+} // namespace
+
+/**
+ * Rescan a sparse wallet by deserializing and inspecting every block of the
+ * chain.
+ */
+static void RescanFullBlocks(benchmark::Bench &bench) {
+    const SyntheticRescanChain chain;
+    bench.batch(RESCAN_CHAIN_LENGTH).unit("block").run([&] {
+        size_t found = 0;
+        for (size_t height = 0; height < RESCAN_CHAIN_LENGTH; ++height) {
+            found += chain.ScanBlock(height);
+        }
+        assert(found == RESCAN_CHAIN_LENGTH / RESCAN_WALLET_BLOCK_INTERVAL);
+    });
+}
+
+/**
+ * Build the filters of all the blocks of the chain, one block after the other
+ * or several blocks in parallel as when syncing the block filter index.
+ */
+static void BuildBlockFilters(benchmark::Bench &bench, size_t num_threads) {
+    const SyntheticRescanChain chain;
+    std::vector<CBlock> blocks(RESCAN_CHAIN_LENGTH);
+    for (size_t height = 0; height < RESCAN_CHAIN_LENGTH; ++height) {
+        CDataStream stream(chain.serialized_blocks[height], SER_NETWORK,
+                           PROTOCOL_VERSION);
+        stream >> blocks[height];
+    }
+    std::vector<BlockFilter> filters(RESCAN_CHAIN_LENGTH);
+    bench.batch(RESCAN_CHAIN_LENGTH).unit("block").run([&] {
+        util::ParallelForRanges(
+            RESCAN_CHAIN_LENGTH, num_threads, [&](size_t begin, size_t end) {
+                for (size_t height = begin; height < end; ++height) {
+                    filters[height] = BlockFilter(
+                        BlockFilterType::BASIC, blocks[height], CBlockUndo());
+                }
+            });
+    });
+}
+
+static void BuildBlockFiltersSerial(benchmark::Bench &bench) {
+    BuildBlockFilters(bench, 1);
+}
+
+static void BuildBlockFiltersParallel(benchmark::Bench &bench) {
+    BuildBlockFilters(bench, std::max(GetNumCores(), 1));
+}
+
+/**
+ * Rescan a sparse wallet by matching its scripts against the block filters
+ * first, and only deserializing the blocks that match.
+ */
+static void RescanBlockFilters(benchmark::Bench &bench) {
+    const SyntheticRescanChain chain;
+    bench.batch(RESCAN_CHAIN_LENGTH).unit("block").run([&] {
+        size_t found = 0;
+        for (size_t height = 0; height < RESCAN_CHAIN_LENGTH; ++height) {
+            if (chain.filters[height].GetFilter().MatchAny(
+                    chain.wallet_elements)) {
+                found += chain.ScanBlock(height);
+            }
+        }
+        assert(found == RESCAN_CHAIN_LENGTH / RESCAN_WALLET_BLOCK_INTERVAL);
+    });
+}
+
+/**
+ * Same as RescanBlockFilters, with the filters decoded once beforehand as the
+ * block filter index does for the blocks matched recently.
+ */
+static void RescanDecodedBlockFilters(benchmark::Bench &bench) {
+    const SyntheticRescanChain chain;
+    std::vector<DecodedGCSFilter> decoded_filters;
+    for (const BlockFilter &filter : chain.filters) {
+        decoded_filters.emplace_back(filter.GetFilter());
+    }
+    bench.batch(RESCAN_CHAIN_LENGTH).unit("block").run([&] {
+        size_t found = 0;
+        for (size_t height = 0; height < RESCAN_CHAIN_LENGTH; ++height) {
+            if (decoded_filters[height].MatchAny(chain.wallet_elements)) {
+                found += chain.ScanBlock(height);
+            }
+        }
+        assert(found == RESCAN_CHAIN_LENGTH / RESCAN_WALLET_BLOCK_INTERVAL);
+    });
+}
+
 BENCHMARK(ConstructGCSFilter);
 BENCHMARK(MatchGCSFilter);
+BENCHMARK(MatchDecodedGCSFilter);
+BENCHMARK(DeserializeGCSFilterChecked);
+BENCHMARK(DeserializeGCSFilterUnchecked);
+BENCHMARK(BuildBlockFiltersSerial);
+BENCHMARK(BuildBlockFiltersParallel);
+BENCHMARK(RescanFullBlocks);
+BENCHMARK(RescanBlockFilters);
+BENCHMARK(RescanDecodedBlockFilters);
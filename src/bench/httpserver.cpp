@@ -0,0 +1,326 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <coins.h>
+#include <common/args.h>
+#include <compat.h>
+#include <config.h>
+#include <consensus/amount.h>
+#include <httprpc.h>
+#include <httpserver.h>
+#include <kernel/mempool_entry.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <rpc/protocol.h>
+#include <rpc/server.h>
+#include <script/script.h>
+#include <streams.h>
+#include <support/events.h>
+#include <test/util/setup_common.h>
+#include <txmempool.h>
+#include <util/string.h>
+#include <validation.h>
+
+#include <event2/buffer.h>
+#include <event2/http.h>
+
+#include <cassert>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+/** Number of concurrent keep-alive client connections */
+static constexpr size_t NUM_CONNECTIONS = 64;
+/** Number of requests sent over all the connections per iteration */
+static constexpr size_t NUM_REQUESTS = 4096;
+/** Size of the body of the replies sent by the server */
+static constexpr size_t REPLY_SIZE = 16 * 1024;
+/** Number of outpoints looked up per iteration by the REST benchmarks */
+static constexpr size_t NUM_OUTPOINTS = 1000;
+/** Number of transactions looked up per iteration by the REST benchmarks */
+static constexpr size_t NUM_TXS = 1000;
+
+/** Find a local port to run the HTTP server on */
+static uint16_t GetFreeLocalPort() {
+    SOCKET fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    assert(fd != INVALID_SOCKET);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t len = sizeof(addr);
+    bool ok = bind(fd, (struct sockaddr *)&addr, len) == 0 &&
+              getsockname(fd, (struct sockaddr *)&addr, &len) == 0;
+    evutil_closesocket(fd);
+    assert(ok);
+    return ntohs(addr.sin_port);
+}
+
+namespace {
+/** Load generator sending requests over a set of keep-alive connections */
+struct HTTPLoadGenerator {
+    /**
+     * Path and body of the i-th request. Requests with a body are sent as
+     * POST, the others as GET.
+     */
+    using RequestFactory =
+        std::function<std::pair<std::string, std::string>(size_t)>;
+
+    raii_event_base base;
+    std::vector<raii_evhttp_connection> connections;
+    RequestFactory make_request;
+    size_t to_send{0};
+    size_t pending{0};
+    size_t failed{0};
+
+    HTTPLoadGenerator(uint16_t port, RequestFactory make_request_in)
+        : base(obtain_event_base()), make_request(std::move(make_request_in)) {
+        for (size_t i = 0; i < NUM_CONNECTIONS; ++i) {
+            connections.push_back(
+                obtain_evhttp_connection_base(base.get(), "127.0.0.1", port));
+        }
+    }
+
+    static void ReplyCallback(struct evhttp_request *req, void *arg) {
+        auto *pair = static_cast<std::pair<HTTPLoadGenerator *,
+                                           evhttp_connection *> *>(arg);
+        HTTPLoadGenerator &generator = *pair->first;
+        if (!req || evhttp_request_get_response_code(req) != HTTP_OK) {
+            ++generator.failed;
+        }
+        if (--generator.pending == 0) {
+            event_base_loopbreak(generator.base.get());
+        }
+        generator.SendRequest(pair->second);
+        delete pair;
+    }
+
+    void SendRequest(evhttp_connection *conn) {
+        if (to_send == 0) {
+            return;
+        }
+        const auto [path, body] = make_request(--to_send);
+        auto *arg = new std::pair<HTTPLoadGenerator *, evhttp_connection *>(
+            this, conn);
+        struct evhttp_request *req = evhttp_request_new(ReplyCallback, arg);
+        assert(req);
+        evhttp_add_header(evhttp_request_get_output_headers(req), "Host",
+                          "127.0.0.1");
+        if (!body.empty()) {
+            evbuffer_add(evhttp_request_get_output_buffer(req), body.data(),
+                         body.size());
+        }
+        // Ownership of req is transferred to the connection
+        int r = evhttp_make_request(
+            conn, req, body.empty() ? EVHTTP_REQ_GET : EVHTTP_REQ_POST,
+            path.c_str());
+        assert(r == 0);
+    }
+
+    /** Send count requests and wait for all the replies */
+    void Run(size_t count) {
+        to_send = count;
+        pending = count;
+        for (auto &conn : connections) {
+            SendRequest(conn.get());
+        }
+        event_base_dispatch(base.get());
+    }
+};
+
+/** HTTP server listening on a free local port for the duration of a bench */
+struct BenchHTTPServer {
+    const uint16_t port;
+
+    explicit BenchHTTPServer(int event_threads) : port(GetFreeLocalPort()) {
+        gArgs.ForceSetArg("-rpcbind", "127.0.0.1");
+        gArgs.ForceSetArg("-rpcallowip", "127.0.0.1");
+        gArgs.ForceSetArg("-rpcport", ToString(port));
+        gArgs.ForceSetArg("-rpcthreads", "4");
+        gArgs.ForceSetArg("-rpcworkqueue", ToString(NUM_CONNECTIONS));
+        gArgs.ForceSetArg("-rpceventthreads", ToString(event_threads));
+
+        GlobalConfig config;
+        bool initialized = InitHTTPServer(config);
+        assert(initialized);
+    }
+
+    ~BenchHTTPServer() {
+        // The client connections must be closed at this point, so the event
+        // loops can exit.
+        InterruptHTTPServer();
+        StopHTTPServer();
+    }
+};
+} // namespace
+
+/**
+ * Local load generator for the HTTP server: a single client thread keeps
+ * NUM_CONNECTIONS keep-alive connections busy, while the server runs the given
+ * number of event loop threads.
+ */
+static void HTTPServerRequests(benchmark::Bench &bench, int event_threads) {
+    const auto testing_setup = MakeNoLogFileContext<const BasicTestingSetup>();
+
+    BenchHTTPServer server(event_threads);
+    const std::string reply(REPLY_SIZE, 'x');
+    RegisterHTTPHandler("/bench", true,
+                        [&reply](Config &, HTTPRequest *req,
+                                 const std::string &) {
+                            req->WriteHeader("Content-Type", "text/plain");
+                            req->WriteReply(HTTP_OK, reply);
+                            return true;
+                        });
+    StartHTTPServer();
+
+    {
+        HTTPLoadGenerator generator(server.port, [](size_t) {
+            return std::make_pair(std::string{"/bench"}, std::string{});
+        });
+        bench.batch(NUM_REQUESTS).unit("request").run(
+            [&] { generator.Run(NUM_REQUESTS); });
+        assert(generator.failed == 0);
+    }
+
+    UnregisterHTTPHandler("/bench", true);
+}
+
+/**
+ * Look NUM_OUTPOINTS outpoints up through the REST interface, either with one
+ * /rest/getutxos request per outpoint or with a single /rest/batch/getutxos
+ * request. The coins are flushed to the database before the first iteration.
+ */
+static void RESTGetUTXOs(benchmark::Bench &bench, bool batch) {
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>();
+    FastRandomContext rng(/*fDeterministic=*/true);
+
+    std::vector<COutPoint> outpoints;
+    {
+        LOCK(cs_main);
+        CCoinsViewCache &view = testing_setup->m_node.chainman
+                                    ->ActiveChainstate()
+                                    .CoinsTip();
+        for (size_t i = 0; i < NUM_OUTPOINTS; ++i) {
+            outpoints.emplace_back(TxId(rng.rand256()), rng.randrange(4));
+            view.AddCoin(outpoints.back(),
+                         Coin(CTxOut(COIN, CScript() << OP_TRUE), 1, false),
+                         false);
+        }
+        view.Flush();
+    }
+
+    BenchHTTPServer server(1);
+    StartREST(&testing_setup->m_node);
+    if (RPCIsInWarmup(nullptr)) {
+        SetRPCWarmupFinished();
+    }
+    StartHTTPServer();
+
+    {
+        CDataStream batch_request(SER_NETWORK, PROTOCOL_VERSION);
+        batch_request << outpoints;
+        HTTPLoadGenerator generator(server.port, [&](size_t i) {
+            if (batch) {
+                return std::make_pair(std::string{"/rest/batch/getutxos.bin"},
+                                      batch_request.str());
+            }
+            return std::make_pair(
+                strprintf("/rest/getutxos/%s-%d.bin",
+                          outpoints[i].GetTxId().GetHex(), outpoints[i].GetN()),
+                std::string{});
+        });
+        bench.batch(NUM_OUTPOINTS).unit("outpoint").run(
+            [&] { generator.Run(batch ? 1 : NUM_OUTPOINTS); });
+        assert(generator.failed == 0);
+    }
+
+    StopREST();
+}
+
+/**
+ * Look NUM_TXS mempool transactions up through the REST interface, either with
+ * one /rest/tx request per transaction or with a single /rest/batch/tx
+ * request.
+ */
+static void RESTGetTxs(benchmark::Bench &bench, bool batch) {
+    const auto testing_setup = MakeNoLogFileContext<const TestingSetup>();
+    FastRandomContext rng(/*fDeterministic=*/true);
+
+    std::vector<TxId> txids;
+    {
+        CTxMemPool &pool = *testing_setup->m_node.mempool;
+        LOCK2(cs_main, pool.cs);
+        for (size_t i = 0; i < NUM_TXS; ++i) {
+            CMutableTransaction tx;
+            tx.vin.emplace_back(COutPoint(TxId(rng.rand256()), 0));
+            tx.vout.emplace_back(COIN, CScript() << OP_TRUE);
+            const CTransactionRef ptx = MakeTransactionRef(tx);
+            txids.push_back(ptx->GetId());
+            LockPoints lp;
+            pool.addUnchecked(CTxMemPoolEntryRef::make(
+                ptx, Amount::zero(), /*time=*/0, /*entry_height=*/1,
+                /*sigchecks=*/1, lp));
+        }
+    }
+
+    BenchHTTPServer server(1);
+    StartREST(&testing_setup->m_node);
+    if (RPCIsInWarmup(nullptr)) {
+        SetRPCWarmupFinished();
+    }
+    StartHTTPServer();
+
+    {
+        CDataStream batch_request(SER_NETWORK, PROTOCOL_VERSION);
+        batch_request << txids;
+        HTTPLoadGenerator generator(server.port, [&](size_t i) {
+            if (batch) {
+                return std::make_pair(std::string{"/rest/batch/tx.bin"},
+                                      batch_request.str());
+            }
+            return std::make_pair(
+                strprintf("/rest/tx/%s.bin", txids[i].GetHex()),
+                std::string{});
+        });
+        bench.batch(NUM_TXS).unit("tx").run(
+            [&] { generator.Run(batch ? 1 : NUM_TXS); });
+        assert(generator.failed == 0);
+    }
+
+    StopREST();
+}
+
+static void RESTGetUTXOsPerItem(benchmark::Bench &bench) {
+    RESTGetUTXOs(bench, /*batch=*/false);
+}
+
+static void RESTGetUTXOsBatch(benchmark::Bench &bench) {
+    RESTGetUTXOs(bench, /*batch=*/true);
+}
+
+static void RESTGetTxsPerItem(benchmark::Bench &bench) {
+    RESTGetTxs(bench, /*batch=*/false);
+}
+
+static void RESTGetTxsBatch(benchmark::Bench &bench) {
+    RESTGetTxs(bench, /*batch=*/true);
+}
+
+static void HTTPServerRequestsOneEventThread(benchmark::Bench &bench) {
+    HTTPServerRequests(bench, 1);
+}
+
+static void HTTPServerRequestsFourEventThreads(benchmark::Bench &bench) {
+    HTTPServerRequests(bench, 4);
+}
+
+BENCHMARK(HTTPServerRequestsOneEventThread);
+BENCHMARK(HTTPServerRequestsFourEventThreads);
+BENCHMARK(RESTGetUTXOsPerItem);
+BENCHMARK(RESTGetUTXOsBatch);
+BENCHMARK(RESTGetTxsPerItem);
+BENCHMARK(RESTGetTxsBatch);
@@ -0,0 +1,128 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <invrequest.h>
+#include <primitives/txid.h>
+#include <random.h>
+#include <util/hasher.h>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+static constexpr size_t NUM_ANNOUNCEMENTS{100000};
+static constexpr size_t NUM_PEERS{125};
+//! Peers announcing each transaction
+static constexpr size_t ANNOUNCERS{8};
+//! The first peers are the preferred ones
+static constexpr NodeId NUM_PREFERRED{8};
+
+static constexpr auto NONPREF_PEER_DELAY{std::chrono::seconds{2}};
+static constexpr auto GETDATA_INTERVAL{std::chrono::seconds{60}};
+//! Interval between the loops over the peers
+static constexpr auto LOOP_INTERVAL{std::chrono::milliseconds{100}};
+
+struct InvAnnouncement {
+    std::chrono::microseconds time;
+    NodeId peer;
+    //! Index of the transaction
+    size_t tx;
+};
+
+/**
+ * Download flow of 100k transaction announcements from 125 peers through the
+ * InvRequestTracker: every 100ms the announcements received in the meantime
+ * are added, the requestable transactions of each peer are requested, and the
+ * transactions requested in the previous loop are received. The transactions
+ * already received are not tracked again when they are announced.
+ */
+static void InvRequest(benchmark::Bench &bench, bool all_peers) {
+    FastRandomContext rng{/*fDeterministic=*/true};
+
+    // Each transaction is announced by distinct peers within a few seconds
+    std::vector<TxId> txids;
+    std::unordered_map<TxId, size_t, SaltedTxIdHasher> tx_index;
+    std::vector<InvAnnouncement> announcements;
+    for (size_t i = 0; i < NUM_ANNOUNCEMENTS / ANNOUNCERS; i++) {
+        txids.emplace_back(rng.rand256());
+        tx_index.emplace(txids.back(), i);
+        const std::chrono::microseconds time{int64_t(i) * 400};
+        const size_t first_peer = rng.randrange(NUM_PEERS);
+        for (size_t j = 0; j < ANNOUNCERS; j++) {
+            const std::chrono::microseconds delay{
+                int64_t(rng.randrange(2'000'000))};
+            const NodeId peer((first_peer + j * 16) % NUM_PEERS);
+            announcements.push_back({time + delay, peer, i});
+        }
+    }
+    std::sort(announcements.begin(), announcements.end(),
+              [](const InvAnnouncement &a, const InvAnnouncement &b) {
+                  return a.time < b.time;
+              });
+
+    bench.batch(announcements.size()).unit("announcement").run([&] {
+        InvRequestTracker<TxId> tracker{/*deterministic=*/true};
+        std::vector<bool> received(txids.size());
+        std::vector<std::pair<NodeId, TxId>> requested;
+        std::vector<std::pair<NodeId, TxId>> expired;
+        auto request = [&](NodeId peer, const std::vector<TxId> &requestable,
+                           std::chrono::microseconds now) {
+            for (const TxId &txid : requestable) {
+                tracker.RequestedData(peer, txid, now + GETDATA_INTERVAL);
+                requested.emplace_back(peer, txid);
+            }
+        };
+
+        auto next = announcements.begin();
+        for (std::chrono::microseconds now{0};
+             next != announcements.end() || tracker.Size() > 0;
+             now += LOOP_INTERVAL) {
+            for (const auto &[peer, txid] : requested) {
+                tracker.ReceivedResponse(peer, txid);
+                tracker.ForgetInvId(txid);
+                received[tx_index.at(txid)] = true;
+            }
+            requested.clear();
+
+            for (; next != announcements.end() && next->time <= now; ++next) {
+                if (received[next->tx]) {
+                    continue;
+                }
+                const bool preferred = next->peer < NUM_PREFERRED;
+                const auto reqtime{preferred ? next->time
+                                             : next->time + NONPREF_PEER_DELAY};
+                tracker.ReceivedInv(next->peer, txids[next->tx], preferred,
+                                    reqtime);
+            }
+
+            if (all_peers) {
+                for (const auto &[peer, txids] :
+                     tracker.GetRequestable(now, &expired)) {
+                    request(peer, txids, now);
+                }
+            } else {
+                for (NodeId peer = 0; peer < NodeId(NUM_PEERS); peer++) {
+                    request(peer, tracker.GetRequestable(peer, now, &expired),
+                            now);
+                }
+            }
+            assert(expired.empty());
+        }
+    });
+}
+
+static void InvRequestPerPeer(benchmark::Bench &bench) {
+    InvRequest(bench, /*all_peers=*/false);
+}
+
+static void InvRequestAllPeers(benchmark::Bench &bench) {
+    InvRequest(bench, /*all_peers=*/true);
+}
+
+BENCHMARK(InvRequestPerPeer);
+BENCHMARK(InvRequestAllPeers);
@@ -0,0 +1,77 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <chain.h>
+#include <chainparams.h>
+#include <node/blockstorage.h>
+#include <pow/pow.h>
+#include <test/util/setup_common.h>
+#include <txdb.h>
+#include <validation.h>
+
+#include <cassert>
+#include <memory>
+#include <vector>
+
+using node::BlockManager;
+
+static constexpr int NUM_HEADERS{20000};
+
+/**
+ * Time the loading of the block index from the database, which is done at
+ * startup by bitcoind and bitcoin-chainstate, for a chain of headers.
+ */
+static void LoadBlockIndex(benchmark::Bench &bench) {
+    const auto testing_setup{MakeNoLogFileContext<const BasicTestingSetup>(
+        CBaseChainParams::REGTEST)};
+    const CChainParams &params{::Params()};
+
+    std::vector<BlockHash> hashes(NUM_HEADERS);
+    std::vector<CBlockIndex> headers(NUM_HEADERS);
+    CBlockHeader header{params.GenesisBlock().GetBlockHeader()};
+    for (int height = 0; height < NUM_HEADERS; height++) {
+        if (height > 0) {
+            header.hashPrevBlock = hashes[height - 1];
+            header.nTime++;
+            while (!CheckProofOfWork(header.GetHash(), header.nBits,
+                                     params.GetConsensus())) {
+                header.nNonce++;
+            }
+        }
+        hashes[height] = header.GetHash();
+        headers[height] = CBlockIndex{header};
+        headers[height].phashBlock = &hashes[height];
+        headers[height].pprev = height > 0 ? &headers[height - 1] : nullptr;
+        headers[height].nHeight = height;
+    }
+
+    std::unique_ptr<CBlockTreeDB> block_tree_db{
+        std::make_unique<CBlockTreeDB>(DBParams{
+            .path = testing_setup->m_args.GetDataDirNet() / "blocks" / "index",
+            .cache_bytes = 1 << 20,
+            .memory_only = true,
+        })};
+    std::vector<const CBlockIndex *> blockinfo;
+    for (const CBlockIndex &index : headers) {
+        blockinfo.push_back(&index);
+    }
+    bool ok = block_tree_db->WriteBatchSync({}, 0, blockinfo);
+    assert(ok);
+
+    bench.run([&] {
+        BlockManager blockman{BlockManager::Options{
+            .chainparams = params,
+            .blocks_dir = testing_setup->m_args.GetBlocksDirPath(),
+        }};
+        LOCK(cs_main);
+        blockman.m_block_tree_db = std::move(block_tree_db);
+        const bool loaded{blockman.LoadBlockIndexDB()};
+        assert(loaded);
+        assert(blockman.m_block_index.size() == NUM_HEADERS);
+        block_tree_db = std::move(blockman.m_block_tree_db);
+    });
+}
+
+BENCHMARK(LoadBlockIndex);
@@ -0,0 +1,50 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <logging.h>
+#include <test/util/setup_common.h>
+
+#include <memory>
+
+/**
+ * Cost for the logging thread of writing a line to the debug log file,
+ * synchronously or through the asynchronous logging buffers.
+ */
+struct LoggingSetup {
+    const std::unique_ptr<const BasicTestingSetup> testing_setup{
+        MakeNoLogFileContext<const BasicTestingSetup>()};
+    BCLog::Logger logger;
+
+    LoggingSetup() {
+        logger.m_print_to_file = true;
+        logger.m_file_path = testing_setup->m_path_root / "bench.log";
+        logger.m_log_threadnames = true;
+        logger.StartLogging();
+    }
+
+    ~LoggingSetup() { logger.DisconnectTestLogger(); }
+
+    void Log() {
+        logger.LogPrintStr("A log line from the benchmark\n", __func__,
+                           __FILE__, __LINE__);
+    }
+};
+
+static void LoggingSync(benchmark::Bench &bench) {
+    LoggingSetup setup;
+    bench.run([&] { setup.Log(); });
+}
+
+static void LoggingAsync(benchmark::Bench &bench) {
+    LoggingSetup setup;
+    // Wait for the writer rather than dropping lines, so the cost of writing
+    // is accounted for when the buffer is full.
+    setup.logger.StartAsyncLogging(/*block_when_full=*/true);
+    bench.run([&] { setup.Log(); });
+    setup.logger.StopAsyncLogging();
+}
+
+BENCHMARK(LoggingSync);
+BENCHMARK(LoggingAsync);
@@ -0,0 +1,86 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <blockindex.h>
+#include <chainparamsbase.h>
+#include <common/args.h>
+#include <consensus/amount.h>
+#include <kernel/cs_main.h>
+#include <kernel/mempool_entry.h>
+#include <policy/block/preconsensus.h>
+#include <primitives/block.h>
+#include <test/util/setup_common.h>
+#include <txmempool.h>
+
+#include <cassert>
+#include <vector>
+
+static CTransactionRef SpendingTx(uint32_t n) {
+    CMutableTransaction tx;
+    tx.vin.emplace_back(COutPoint(TxId(uint256S("abcd")), n));
+    // About the size of a P2PKH input
+    tx.vin[0].scriptSig = CScript() << std::vector<uint8_t>(72, 0x30)
+                                    << std::vector<uint8_t>(33, 0x02);
+    tx.vout.resize(2);
+    for (CTxOut &txout : tx.vout) {
+        txout.scriptPubKey = CScript() << OP_1 << OP_EQUAL;
+        txout.nValue = COIN;
+    }
+    return MakeTransactionRef(tx);
+}
+
+/**
+ * Check a 32MB block against a mempool with many finalized txs, some of which
+ * are in the block.
+ */
+static void PreConsensusPolicyCheck(benchmark::Bench &bench) {
+    const TestingSetup test_setup{
+        CBaseChainParams::MAIN,
+        /* extra_args */
+        {
+            "-nodebuglogfile",
+            "-nodebug",
+        },
+    };
+    gArgs.ForceSetArg("-avalanchepreconsensus", "1");
+    CTxMemPool &pool = *Assert(test_setup.m_node.mempool);
+
+    const uint32_t n =
+        32'000'000 / ::GetSerializeSize(*SpendingTx(0), PROTOCOL_VERSION);
+    CBlock block;
+    for (uint32_t i = 0; i < n; i++) {
+        block.vtx.push_back(SpendingTx(i));
+    }
+
+    {
+        LOCK2(cs_main, pool.cs);
+        // Finalize a tenth of the block txs and as many unrelated txs
+        for (uint32_t i = 0; i < n / 10; i++) {
+            for (const CTransactionRef &tx :
+                 {block.vtx[i * 10], SpendingTx(n + i)}) {
+                LockPoints lp;
+                auto entry = CTxMemPoolEntryRef::make(tx, COIN, /*time=*/0,
+                                                      /*height=*/1,
+                                                      /*_sigChecks=*/1, lp);
+                pool.addUnchecked(entry);
+                pool.setAvalancheFinalized(entry);
+            }
+        }
+    }
+
+    CBlockIndex prevIndex;
+    CBlockIndex blockIndex;
+    blockIndex.pprev = &prevIndex;
+
+    bench.unit("block").run([&] {
+        BlockPolicyValidationState state;
+        bool valid = PreConsensusPolicy(blockIndex, block, &pool)(state);
+        assert(valid);
+    });
+
+    gArgs.ClearForcedArg("-avalanchepreconsensus");
+}
+
+BENCHMARK(PreConsensusPolicyCheck);
@@ -0,0 +1,145 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <radix.h>
+#include <random.h>
+#include <rcu.h>
+#include <uint256radixkey.h>
+
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+namespace {
+struct RadixElement {
+    uint64_t key;
+
+    explicit RadixElement(uint64_t keyIn) : key(keyIn) {}
+    const uint64_t &getId() const { return key; }
+
+    IMPLEMENT_RCU_REFCOUNT(uint32_t);
+};
+
+struct TxElement {
+    Uint256RadixKey txid;
+
+    explicit TxElement(const uint256 &txidIn) : txid(txidIn) {}
+    const Uint256RadixKey &getId() const { return txid; }
+
+    IMPLEMENT_RCU_REFCOUNT(uint32_t);
+};
+} // namespace
+
+static constexpr int NUM_READERS{2};
+static constexpr int NUM_ELEMENTS{1000};
+
+/**
+ * Insert then remove a burst of elements, as is done to the finalized
+ * transactions and the avalanche proofs on each block, while other threads
+ * keep reading the tree.
+ */
+static void RadixTreeInsertRemove(benchmark::Bench &bench, bool reclaimer) {
+    if (reclaimer) {
+        RCULock::startReclaimer();
+    }
+
+    RadixTree<RadixElement> tree;
+    FastRandomContext rng{/*fDeterministic=*/true};
+    std::vector<uint64_t> keys(NUM_ELEMENTS);
+    for (uint64_t &key : keys) {
+        key = rng.rand64();
+    }
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> readers;
+    for (int i = 0; i < NUM_READERS; i++) {
+        readers.emplace_back([&, i] {
+            size_t n = i;
+            while (!stop) {
+                ankerl::nanobench::doNotOptimizeAway(
+                    tree.get(keys[n++ % keys.size()]));
+            }
+        });
+    }
+
+    bench.batch(2 * NUM_ELEMENTS).unit("operation").run([&] {
+        for (const uint64_t key : keys) {
+            tree.insert(RCUPtr<RadixElement>::make(key));
+        }
+        for (const uint64_t key : keys) {
+            tree.remove(key);
+        }
+    });
+
+    stop = true;
+    for (std::thread &reader : readers) {
+        reader.join();
+    }
+    if (reclaimer) {
+        RCULock::stopReclaimer();
+    }
+    RCULock::synchronize();
+}
+
+static void RadixTreeInsertRemoveInline(benchmark::Bench &bench) {
+    RadixTreeInsertRemove(bench, /*reclaimer=*/false);
+}
+
+static void RadixTreeInsertRemoveReclaimer(benchmark::Bench &bench) {
+    RadixTreeInsertRemove(bench, /*reclaimer=*/true);
+}
+
+static constexpr int NUM_BLOCK_TXS{5000};
+
+/**
+ * Add the transactions of a block to a tree of finalized transactions, then
+ * remove them when the block is finalized, either one by one or as a batch.
+ */
+static void RadixTreeFinalizeBlock(benchmark::Bench &bench, bool batch) {
+    RadixTree<TxElement> tree;
+    FastRandomContext rng{/*fDeterministic=*/true};
+    // Transactions which are not part of the block
+    for (int i = 0; i < NUM_BLOCK_TXS; i++) {
+        tree.insert(RCUPtr<TxElement>::make(rng.rand256()));
+    }
+
+    std::vector<RCUPtr<TxElement>> txs;
+    std::vector<Uint256RadixKey> txids;
+    for (int i = 0; i < NUM_BLOCK_TXS; i++) {
+        txs.push_back(RCUPtr<TxElement>::make(rng.rand256()));
+        txids.push_back(txs.back()->getId());
+    }
+
+    bench.batch(2 * NUM_BLOCK_TXS).unit("operation").run([&] {
+        if (batch) {
+            tree.insertBatch(txs);
+            tree.removeBatch(txids);
+            return;
+        }
+
+        for (const auto &tx : txs) {
+            tree.insert(tx);
+        }
+        for (const auto &txid : txids) {
+            tree.remove(txid);
+        }
+    });
+
+    RCULock::synchronize();
+}
+
+static void RadixTreeFinalizeBlockPerKey(benchmark::Bench &bench) {
+    RadixTreeFinalizeBlock(bench, /*batch=*/false);
+}
+
+static void RadixTreeFinalizeBlockBatch(benchmark::Bench &bench) {
+    RadixTreeFinalizeBlock(bench, /*batch=*/true);
+}
+
+BENCHMARK(RadixTreeInsertRemoveInline);
+BENCHMARK(RadixTreeInsertRemoveReclaimer);
+BENCHMARK(RadixTreeFinalizeBlockPerKey);
+BENCHMARK(RadixTreeFinalizeBlockBatch);
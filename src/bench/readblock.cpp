@@ -0,0 +1,93 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <bench/data.h>
+#include <chain.h>
+#include <node/blockstorage.h>
+#include <streams.h>
+#include <test/util/setup_common.h>
+#include <validation.h>
+
+#include <cassert>
+#include <memory>
+
+using node::BlockManager;
+
+/**
+ * Compare the ways a block can be fetched for publishing it (ZMQ rawblock,
+ * REST, getblock with verbosity 0): deserializing it from disk then
+ * serializing it again, reading the raw bytes from disk, or getting them from
+ * the cache of the recently written blocks.
+ */
+struct ReadBlockSetup {
+    // -rest enables the serialized cache
+    const std::unique_ptr<const TestingSetup> testing_setup{
+        MakeNoLogFileContext<const TestingSetup>(CBaseChainParams::MAIN,
+                                                 {"-rest"})};
+    BlockManager &blockman{testing_setup->m_node.chainman->m_blockman};
+    const BlockManager uncached_blockman{BlockManager::Options{
+        .chainparams = testing_setup->m_node.chainman->GetParams(),
+        .serialized_cache_bytes = 0,
+        .blocks_dir = testing_setup->m_args.GetBlocksDirPath(),
+    }};
+    BlockHash hash;
+    std::unique_ptr<CBlockIndex> index;
+
+    ReadBlockSetup() {
+        CDataStream stream(benchmark::data::block413567, SER_NETWORK,
+                           PROTOCOL_VERSION);
+        CBlock block;
+        stream >> block;
+
+        Chainstate &chainstate{
+            testing_setup->m_node.chainman->ActiveChainstate()};
+        const FlatFilePos pos{
+            blockman.SaveBlockToDisk(block, 1, chainstate.m_chain, nullptr)};
+        assert(!pos.IsNull());
+
+        hash = block.GetHash();
+        index = std::make_unique<CBlockIndex>(block.GetBlockHeader());
+        index->phashBlock = &hash;
+        LOCK(cs_main);
+        index->nFile = pos.nFile;
+        index->nDataPos = pos.nPos;
+        index->nStatus = index->nStatus.withData();
+    }
+};
+
+static void ReadBlockAndSerialize(benchmark::Bench &bench) {
+    ReadBlockSetup setup;
+    bench.run([&] {
+        CBlock block;
+        bool ok = setup.blockman.ReadBlockFromDisk(block, *setup.index);
+        assert(ok);
+        CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+        stream << block;
+        ankerl::nanobench::doNotOptimizeAway(stream.size());
+    });
+}
+
+static void ReadRawBlockFromDisk(benchmark::Bench &bench) {
+    ReadBlockSetup setup;
+    bench.run([&] {
+        node::SerializedData data{
+            setup.uncached_blockman.ReadRawBlock(*setup.index)};
+        assert(data);
+        ankerl::nanobench::doNotOptimizeAway(data->size());
+    });
+}
+
+static void ReadRawBlockCached(benchmark::Bench &bench) {
+    ReadBlockSetup setup;
+    bench.run([&] {
+        node::SerializedData data{setup.blockman.ReadRawBlock(*setup.index)};
+        assert(data);
+        ankerl::nanobench::doNotOptimizeAway(data->size());
+    });
+}
+
+BENCHMARK(ReadBlockAndSerialize);
+BENCHMARK(ReadRawBlockFromDisk);
+BENCHMARK(ReadRawBlockCached);
@@ -6,13 +6,21 @@
 #include <bench/data.h>
 
 #include <rpc/blockchain.h>
+#include <rpc/jsonwriter.h>
 #include <streams.h>
+#include <tinyformat.h>
 #include <validation.h>
 
 #include <test/util/setup_common.h>
 
 #include <univalue.h>
 
+#include <functional>
+
+#ifndef WIN32
+#include <sys/resource.h>
+#endif
+
 namespace {
 
 struct TestBlockAndIndex {
@@ -37,6 +45,37 @@ struct TestBlockAndIndex {
     }
 };
 
+/** Peak resident set size of the process in KiB, or 0 if unknown */
+int64_t PeakRSSKiB() {
+#ifndef WIN32
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) {
+#ifdef __APPLE__
+        // Reported in bytes rather than KiB
+        return usage.ru_maxrss >> 10;
+#else
+        return usage.ru_maxrss;
+#endif
+    }
+#endif
+    return 0;
+}
+
+/**
+ * Run fn once and add how much it raised the peak RSS of the process to the
+ * name of the bench. The peak never goes down, so this is only meaningful
+ * when the bench is run on its own, e.g. with -filter.
+ */
+void NamePeakRSS(benchmark::Bench &bench, const std::function<void()> &fn) {
+    const int64_t before{PeakRSSKiB()};
+    fn();
+    bench.name(strprintf("%s (peak RSS +%d KiB)", bench.name(),
+                         PeakRSSKiB() - before));
+}
+
+/** Thrown by a sink to stop writing after the first chunk */
+struct FirstChunk {};
+
 } // namespace
 
 static void BlockToJsonVerbose(benchmark::Bench &bench) {
@@ -63,3 +102,58 @@ static void BlockToJsonVerboseWrite(benchmark::Bench &bench) {
 }
 
 BENCHMARK(BlockToJsonVerboseWrite);
+
+static void BlockToJsonVerboseBuildAndWrite(benchmark::Bench &bench) {
+    TestBlockAndIndex data;
+    // This is also the latency until the first byte of the reply is sent,
+    // since it is only sent once written as a whole.
+    const auto build_and_write = [&] {
+        auto str = blockToJSON(data.testing_setup->m_node.chainman->m_blockman,
+                               data.block, &data.blockindex, &data.blockindex,
+                               /*txDetails=*/true)
+                       .write();
+        ankerl::nanobench::doNotOptimizeAway(str);
+    };
+    NamePeakRSS(bench, build_and_write);
+    bench.run(build_and_write);
+}
+
+BENCHMARK(BlockToJsonVerboseBuildAndWrite);
+
+static void BlockToJsonVerboseStream(benchmark::Bench &bench) {
+    TestBlockAndIndex data;
+    const auto stream = [&] {
+        size_t written{0};
+        JSONStreamWriter writer(
+            [&written](std::string &&chunk) { written += chunk.size(); });
+        blockToJSON(data.testing_setup->m_node.chainman->m_blockman,
+                    data.block, &data.blockindex, &data.blockindex,
+                    /*txDetails=*/true, writer);
+        writer.Flush();
+        ankerl::nanobench::doNotOptimizeAway(written);
+    };
+    NamePeakRSS(bench, stream);
+    bench.run(stream);
+}
+
+BENCHMARK(BlockToJsonVerboseStream);
+
+/**
+ * Latency until the first chunk of a streamed result is ready to be sent, to
+ * compare with BlockToJsonVerboseBuildAndWrite.
+ */
+static void BlockToJsonVerboseStreamFirstChunk(benchmark::Bench &bench) {
+    TestBlockAndIndex data;
+    bench.run([&] {
+        JSONStreamWriter writer([](std::string &&) { throw FirstChunk{}; });
+        try {
+            blockToJSON(data.testing_setup->m_node.chainman->m_blockman,
+                        data.block, &data.blockindex, &data.blockindex,
+                        /*txDetails=*/true, writer);
+            writer.Flush();
+        } catch (const FirstChunk &) {
+        }
+    });
+}
+
+BENCHMARK(BlockToJsonVerboseStreamFirstChunk);
@@ -0,0 +1,80 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <avalanche/peermanager.h>
+#include <avalanche/proofbuilder.h>
+#include <bench/bench.h>
+#include <chain.h>
+#include <key.h>
+#include <random.h>
+#include <script/standard.h>
+#include <test/util/setup_common.h>
+#include <util/time.h>
+#include <validation.h>
+
+#include <cassert>
+#include <vector>
+
+using avalanche::PROOF_DUST_THRESHOLD;
+
+static constexpr size_t NUM_PROOFS{10000};
+
+/**
+ * Select the staking reward winner among NUM_PROOFS finalized proofs, as is
+ * done on each new tip.
+ */
+static void SelectStakingRewardWinner(benchmark::Bench &bench) {
+    const auto testing_setup{MakeNoLogFileContext<const TestingSetup>(
+        CBaseChainParams::REGTEST, {"-avaproofstakeutxoconfirmations=1"})};
+    ChainstateManager &chainman{*testing_setup->m_node.chainman};
+    avalanche::PeerManager pm(PROOF_DUST_THRESHOLD, chainman);
+
+    auto now = GetTime<std::chrono::seconds>();
+    SetMockTime(now);
+
+    for (size_t i = 0; i < NUM_PROOFS; i++) {
+        const CKey key = CKey::MakeCompressedKey();
+        const CScript script = GetScriptForDestination(PKHash(key.GetPubKey()));
+        const COutPoint outpoint{TxId(GetRandHash()), 0};
+        {
+            LOCK(cs_main);
+            chainman.ActiveChainstate().CoinsTip().AddCoin(
+                outpoint, Coin(CTxOut(PROOF_DUST_THRESHOLD, script), 0, false),
+                false);
+        }
+
+        avalanche::ProofBuilder pb(0, 0, key, script);
+        bool ok = pb.addUTXO(outpoint, PROOF_DUST_THRESHOLD, 0, false, key);
+        assert(ok);
+        const avalanche::ProofRef proof = pb.build();
+        ok = pm.registerProof(proof);
+        assert(ok);
+
+        PeerId peerid{NO_PEER};
+        pm.forPeer(proof->getId(), [&](const avalanche::Peer &peer) {
+            peerid = peer.peerid;
+            return true;
+        });
+        ok = pm.setFinalized(peerid) && pm.addNode(NodeId(i), proof->getId());
+        assert(ok);
+    }
+
+    now += 6 * avalanche::Peer::DANGLING_TIMEOUT + 1s;
+    SetMockTime(now);
+
+    CBlockIndex prevBlock;
+    prevBlock.nTime = now.count();
+    const BlockHash prevHash{GetRandHash()};
+    prevBlock.phashBlock = &prevHash;
+
+    std::vector<std::pair<avalanche::ProofId, CScript>> winners;
+    bench.unit("selection").run([&] {
+        bool ok = pm.selectStakingRewardWinner(&prevBlock, winners);
+        assert(ok);
+    });
+
+    SetMockTime(0);
+}
+
+BENCHMARK(SelectStakingRewardWinner);
@@ -0,0 +1,88 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <bench/bench.h>
+#include <primitives/block.h>
+#include <primitives/transaction.h>
+#include <random.h>
+#include <script/script.h>
+#include <txorphanage.h>
+
+#include <cassert>
+#include <vector>
+
+static constexpr size_t NUM_ORPHANS{100000};
+static constexpr size_t NUM_PARENTS{1000};
+static constexpr size_t NUM_PEERS{125};
+//! Outputs of each parent, spent by the orphans
+static constexpr uint32_t PARENT_OUTPUTS{10};
+
+/**
+ * A flood of orphans, spending the outputs of a thousand missing parents and
+ * announced by 125 peers, going through the orphanage: the orphans are
+ * added, the parents arrive and their children are reconsidered, then a
+ * block spending the outputs of the parents evicts all the orphans.
+ */
+static void OrphanageFlood(benchmark::Bench &bench) {
+    FastRandomContext rng{/*fDeterministic=*/true};
+
+    std::vector<CTransactionRef> parents;
+    for (size_t i = 0; i < NUM_PARENTS; i++) {
+        CMutableTransaction tx;
+        tx.vin.emplace_back(COutPoint(TxId(rng.rand256()), 0));
+        for (uint32_t n = 0; n < PARENT_OUTPUTS; n++) {
+            tx.vout.emplace_back(int64_t(n + 1) * COIN, CScript() << OP_TRUE);
+        }
+        parents.push_back(MakeTransactionRef(tx));
+    }
+
+    std::vector<CTransactionRef> orphans;
+    for (size_t i = 0; i < NUM_ORPHANS; i++) {
+        CMutableTransaction tx;
+        // Spend one of the parents and a coin that is not in the orphanage
+        const CTransactionRef &parent{parents[rng.randrange(NUM_PARENTS)]};
+        tx.vin.emplace_back(
+            COutPoint(parent->GetId(), rng.randrange(PARENT_OUTPUTS)));
+        tx.vin.emplace_back(COutPoint(TxId(rng.rand256()), 0));
+        tx.vout.emplace_back(COIN, CScript() << OP_TRUE);
+        orphans.push_back(MakeTransactionRef(tx));
+    }
+
+    // Conflicts with all the orphans
+    CBlock block;
+    for (const CTransactionRef &parent : parents) {
+        CMutableTransaction tx;
+        for (uint32_t n = 0; n < PARENT_OUTPUTS; n++) {
+            tx.vin.emplace_back(COutPoint(parent->GetId(), n));
+        }
+        tx.vout.emplace_back(COIN, CScript() << OP_TRUE);
+        block.vtx.push_back(MakeTransactionRef(tx));
+    }
+
+    TxOrphanage orphanage;
+    bench.batch(NUM_ORPHANS).unit("orphan").epochs(5).epochIterations(1).run(
+        [&] {
+            for (size_t i = 0; i < NUM_ORPHANS; i++) {
+                orphanage.AddTx(orphans[i], i % NUM_PEERS);
+            }
+
+            size_t children{0};
+            for (const CTransactionRef &parent : parents) {
+                orphanage.AddChildrenToWorkSet(*parent);
+                children +=
+                    orphanage.GetChildrenFromSamePeer(parent, 0).size();
+            }
+            for (NodeId peer = 0; peer < NodeId(NUM_PEERS); peer++) {
+                while (orphanage.GetTxToReconsider(peer)) {
+                    children++;
+                }
+            }
+            assert(children > NUM_ORPHANS);
+
+            orphanage.EraseForBlock(block);
+            assert(orphanage.Size() == 0);
+        });
+}
+
+BENCHMARK(OrphanageFlood);
@@ -3,13 +3,17 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <bench/bench.h>
+#include <hash.h>
 #include <key.h>
 #if defined(HAVE_CONSENSUS_LIB)
 #include <script/bitcoinconsensus.h>
 #endif
+#include <policy/policy.h>
+#include <random.h>
 #include <script/interpreter.h>
 #include <script/script.h>
 #include <script/script_error.h>
+#include <script/script_stack.h>
 #include <script/standard.h>
 #include <streams.h>
 #include <test/util/transaction_utils.h>
@@ -39,3 +43,161 @@ static void VerifyNestedIfScript(benchmark::Bench &bench) {
 }
 
 BENCHMARK(VerifyNestedIfScript);
+
+/**
+ * A script moving and hashing many signature and public key sized elements
+ * without checking signatures, so the cost of the stack dominates: for each
+ * pair the public key hash is checked, then both are concatenated and hashed.
+ */
+static std::pair<CScript, CScript> StackHeavyScripts() {
+    CScript scriptSig;
+    CScript scriptPubKey;
+    for (uint8_t i = 0; i < 10; i++) {
+        const std::vector<uint8_t> sig(72, i);
+        const std::vector<uint8_t> pubkey(33, i);
+        scriptSig << sig << pubkey;
+        scriptPubKey << OP_DUP << OP_HASH160 << ToByteVector(Hash160(pubkey))
+                     << OP_EQUALVERIFY << OP_CAT << OP_SHA256 << OP_DROP;
+    }
+    scriptPubKey << OP_1;
+    return {scriptSig, scriptPubKey};
+}
+
+static void VerifyStackHeavyScript(benchmark::Bench &bench) {
+    const auto [scriptSig, scriptPubKey] = StackHeavyScripts();
+    bench.run([&] {
+        ScriptExecutionMetrics metrics = {};
+        ScriptError error;
+        bool ret = VerifyScript(scriptSig, scriptPubKey,
+                                STANDARD_SCRIPT_VERIFY_FLAGS,
+                                BaseSignatureChecker(), metrics, &error);
+        assert(ret);
+    });
+}
+
+static void VerifyStackHeavyScriptReusedArena(benchmark::Bench &bench) {
+    const auto [scriptSig, scriptPubKey] = StackHeavyScripts();
+    ScriptStackArena arena;
+    bench.run([&] {
+        ScriptExecutionMetrics metrics = {};
+        ScriptError error;
+        bool ret = VerifyScript(scriptSig, scriptPubKey,
+                                STANDARD_SCRIPT_VERIFY_FLAGS,
+                                BaseSignatureChecker(), metrics, arena, &error);
+        assert(ret);
+    });
+}
+
+BENCHMARK(VerifyStackHeavyScript);
+BENCHMARK(VerifyStackHeavyScriptReusedArena);
+
+/**
+ * The inputs of a transaction spending the mix of outputs found in mainnet
+ * blocks: mostly P2PKH, then P2SH 2-of-3 multisig and a few P2PK.
+ */
+struct BlockMixInputs {
+    static constexpr size_t NUM_INPUTS{100};
+    const Amount amount{COIN};
+    CMutableTransaction tx;
+    std::vector<CScript> scriptPubKeys;
+    PrecomputedTransactionData txdata;
+
+    BlockMixInputs() {
+        std::array<CKey, 3> keys;
+        std::vector<CPubKey> pubkeys;
+        for (CKey &key : keys) {
+            key.MakeNewKey(true);
+            pubkeys.push_back(key.GetPubKey());
+        }
+        const CScript multisig = GetScriptForMultisig(2, pubkeys);
+        const SigHashType sigHashType = SigHashType().withForkId();
+
+        tx.vin.resize(NUM_INPUTS);
+        tx.vout.emplace_back(int64_t(NUM_INPUTS) * amount, CScript() << OP_1);
+        for (size_t i = 0; i < NUM_INPUTS; i++) {
+            tx.vin[i].prevout = COutPoint(TxId(GetRandHash()), i);
+        }
+
+        for (size_t i = 0; i < NUM_INPUTS; i++) {
+            auto sign = [&](const CKey &key, const CScript &scriptCode,
+                            bool schnorr) {
+                const uint256 hash =
+                    SignatureHash(scriptCode, tx, i, sigHashType, amount);
+                std::vector<uint8_t> sig;
+                bool ok = schnorr ? key.SignSchnorr(hash, sig)
+                                  : key.SignECDSA(hash, sig);
+                assert(ok);
+                sig.push_back(uint8_t(sigHashType.getRawSigHashType()));
+                return sig;
+            };
+
+            const CKey &key = keys[i % keys.size()];
+            CScript &scriptSig = tx.vin[i].scriptSig;
+            if (i % 20 == 0) {
+                scriptPubKeys.push_back(
+                    GetScriptForRawPubKey(key.GetPubKey()));
+                scriptSig << sign(key, scriptPubKeys.back(), true);
+            } else if (i % 20 <= 3) {
+                scriptPubKeys.push_back(
+                    GetScriptForDestination(ScriptHash(multisig)));
+                scriptSig << OP_0 << sign(keys[0], multisig, false)
+                          << sign(keys[1], multisig, false)
+                          << ToByteVector(multisig);
+            } else {
+                scriptPubKeys.push_back(
+                    GetScriptForDestination(PKHash(key.GetPubKey())));
+                scriptSig << sign(key, scriptPubKeys.back(), i % 2 == 0)
+                          << ToByteVector(key.GetPubKey());
+            }
+        }
+        txdata = PrecomputedTransactionData(tx);
+    }
+};
+
+/** Accepts all the signatures, as if they were in the signature cache */
+class CachedSignatureChecker : public BaseSignatureChecker {
+public:
+    bool CheckSig(const std::vector<uint8_t> &vchSigIn,
+                  const std::vector<uint8_t> &vchPubKey,
+                  const CScript &scriptCode, uint32_t flags) const final {
+        return true;
+    }
+};
+
+static void VerifyScriptBlockMix(benchmark::Bench &bench, bool cached_sigs) {
+    const ECCVerifyHandle verify_handle;
+    ECC_Start();
+
+    const BlockMixInputs inputs;
+    ScriptStackArena arena;
+    bench.batch(BlockMixInputs::NUM_INPUTS).unit("input").run([&] {
+        for (size_t i = 0; i < BlockMixInputs::NUM_INPUTS; i++) {
+            const MutableTransactionSignatureChecker tx_checker(
+                &inputs.tx, i, inputs.amount, inputs.txdata);
+            const CachedSignatureChecker cached_checker;
+            ScriptExecutionMetrics metrics = {};
+            ScriptError error;
+            bool ret = VerifyScript(
+                inputs.tx.vin[i].scriptSig, inputs.scriptPubKeys[i],
+                STANDARD_SCRIPT_VERIFY_FLAGS,
+                cached_sigs ? static_cast<const BaseSignatureChecker &>(
+                                  cached_checker)
+                            : tx_checker,
+                metrics, arena, &error);
+            assert(ret);
+        }
+    });
+
+    ECC_Stop();
+}
+
+static void VerifyScriptBlockMixInputs(benchmark::Bench &bench) {
+    VerifyScriptBlockMix(bench, false);
+}
+
+static void VerifyScriptBlockMixInputsCachedSigs(benchmark::Bench &bench) {
+    VerifyScriptBlockMix(bench, true);
+}
+
+BENCHMARK(VerifyScriptBlockMixInputs);
+BENCHMARK(VerifyScriptBlockMixInputsCachedSigs);
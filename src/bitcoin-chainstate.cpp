@@ -79,7 +79,7 @@ int main(int argc, char *argv[]) {
     // SETUP: Scheduling and Background Signals
     CScheduler scheduler{};
     // Start the lightweight task scheduler thread
-    scheduler.m_service_thread = std::thread(util::TraceThread, "scheduler",
+    scheduler.m_service_threads.emplace_back(util::TraceThread, "scheduler",
                                              [&] { scheduler.serviceQueue(); });
 
     // Gather some entropy once per minute.
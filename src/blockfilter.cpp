@@ -6,12 +6,14 @@
 
 #include <crypto/siphash.h>
 #include <hash.h>
+#include <memusage.h>
 #include <primitives/transaction.h>
 #include <script/script.h>
 #include <streams.h>
 #include <util/fastrange.h>
 #include <util/golombrice.h>
 
+#include <algorithm>
 #include <mutex>
 #include <sstream>
 
@@ -25,19 +27,22 @@ static const std::map<BlockFilterType, std::string> g_filter_types = {
     {BlockFilterType::BASIC, "basic"},
 };
 
-uint64_t GCSFilter::HashToRange(const Element &element) const {
-    uint64_t hash = CSipHasher(m_params.m_siphash_k0, m_params.m_siphash_k1)
+/** Hash a data element to an integer in the range [0, F). */
+static uint64_t HashToRange(const GCSFilter::Params &params, uint64_t F,
+                            Span<const uint8_t> element) {
+    uint64_t hash = CSipHasher(params.m_siphash_k0, params.m_siphash_k1)
                         .Write(element.data(), element.size())
                         .Finalize();
-    return FastRange64(hash, m_F);
+    return FastRange64(hash, F);
 }
 
-std::vector<uint64_t>
-GCSFilter::BuildHashedSet(const ElementSet &elements) const {
+static std::vector<uint64_t>
+BuildHashedSet(const GCSFilter::Params &params, uint64_t F,
+               const GCSFilter::ElementSet &elements) {
     std::vector<uint64_t> hashed_elements;
     hashed_elements.reserve(elements.size());
-    for (const Element &element : elements) {
-        hashed_elements.push_back(HashToRange(element));
+    for (const GCSFilter::Element &element : elements) {
+        hashed_elements.push_back(HashToRange(params, F, element));
     }
     std::sort(hashed_elements.begin(), hashed_elements.end());
     return hashed_elements;
@@ -46,7 +51,8 @@ GCSFilter::BuildHashedSet(const ElementSet &elements) const {
 GCSFilter::GCSFilter(const Params &params)
     : m_params(params), m_N(0), m_F(0), m_encoded{0} {}
 
-GCSFilter::GCSFilter(const Params &params, std::vector<uint8_t> encoded_filter)
+GCSFilter::GCSFilter(const Params &params, std::vector<uint8_t> encoded_filter,
+                     bool skip_decode_check)
     : m_params(params), m_encoded(std::move(encoded_filter)) {
     SpanReader stream{GCS_SER_TYPE, GCS_SER_VERSION, m_encoded};
 
@@ -57,6 +63,10 @@ GCSFilter::GCSFilter(const Params &params, std::vector<uint8_t> encoded_filter)
     }
     m_F = static_cast<uint64_t>(m_N) * static_cast<uint64_t>(m_params.m_M);
 
+    if (skip_decode_check) {
+        return;
+    }
+
     // Verify that the encoded filter contains exactly N elements. If it has too
     // much or too little data, a std::ios_base::failure exception will be
     // raised.
@@ -71,25 +81,73 @@ GCSFilter::GCSFilter(const Params &params, std::vector<uint8_t> encoded_filter)
 
 GCSFilter::GCSFilter(const Params &params, const ElementSet &elements)
     : m_params(params) {
-    size_t N = elements.size();
+    Encode({elements.begin(), elements.end()});
+}
+
+GCSFilter::GCSFilter(const Params &params,
+                     const std::vector<Span<const uint8_t>> &elements)
+    : m_params(params) {
+    Encode(elements);
+}
+
+void GCSFilter::Encode(const std::vector<Span<const uint8_t>> &elements) {
+    // The range of the hashes depends on the number of distinct elements, so
+    // the elements are hashed first and mapped to the range once the
+    // duplicates are dropped. Mapping to the range preserves the order of the
+    // hashes, and sorting the elements with the same hash by content puts the
+    // duplicates next to each other.
+    struct HashedElement {
+        uint64_t hash;
+        Span<const uint8_t> element;
+    };
+    std::vector<HashedElement> hashed_elements;
+    hashed_elements.reserve(elements.size());
+    for (const Span<const uint8_t> &element : elements) {
+        hashed_elements.push_back(
+            {CSipHasher(m_params.m_siphash_k0, m_params.m_siphash_k1)
+                 .Write(element.data(), element.size())
+                 .Finalize(),
+             element});
+    }
+    std::sort(hashed_elements.begin(), hashed_elements.end(),
+              [](const HashedElement &a, const HashedElement &b) {
+                  if (a.hash != b.hash) {
+                      return a.hash < b.hash;
+                  }
+                  return std::lexicographical_compare(
+                      a.element.begin(), a.element.end(), b.element.begin(),
+                      b.element.end());
+              });
+    hashed_elements.erase(
+        std::unique(hashed_elements.begin(), hashed_elements.end(),
+                    [](const HashedElement &a, const HashedElement &b) {
+                        return a.hash == b.hash &&
+                               std::equal(a.element.begin(), a.element.end(),
+                                          b.element.begin(), b.element.end());
+                    }),
+        hashed_elements.end());
+
+    size_t N = hashed_elements.size();
     m_N = static_cast<uint32_t>(N);
     if (m_N != N) {
         throw std::invalid_argument("N must be <2^32");
     }
     m_F = static_cast<uint64_t>(m_N) * static_cast<uint64_t>(m_params.m_M);
 
+    m_encoded.clear();
     CVectorWriter stream(GCS_SER_TYPE, GCS_SER_VERSION, m_encoded, 0);
 
     WriteCompactSize(stream, m_N);
 
-    if (elements.empty()) {
+    if (hashed_elements.empty()) {
         return;
     }
 
     BitStreamWriter<CVectorWriter> bitwriter(stream);
 
     uint64_t last_value = 0;
-    for (uint64_t value : BuildHashedSet(elements)) {
+    for (const HashedElement &hashed_element : hashed_elements) {
+        uint64_t value = FastRange64(hashed_element.hash, m_F);
         uint64_t delta = value - last_value;
         GolombRiceEncode(bitwriter, m_params.m_P, delta);
         last_value = value;
@@ -131,15 +189,66 @@ bool GCSFilter::MatchInternal(const uint64_t *element_hashes,
 }
 
 bool GCSFilter::Match(const Element &element) const {
-    uint64_t query = HashToRange(element);
+    uint64_t query = HashToRange(m_params, m_F, element);
     return MatchInternal(&query, 1);
 }
 
 bool GCSFilter::MatchAny(const ElementSet &elements) const {
-    const std::vector<uint64_t> queries = BuildHashedSet(elements);
+    const std::vector<uint64_t> queries =
+        BuildHashedSet(m_params, m_F, elements);
     return MatchInternal(queries.data(), queries.size());
 }
 
+std::vector<uint64_t> GCSFilter::Decode() const {
+    SpanReader stream{GCS_SER_TYPE, GCS_SER_VERSION, m_encoded};
+
+    // Seek forward by size of N
+    uint64_t N = ReadCompactSize(stream);
+    assert(N == m_N);
+
+    BitStreamReader<SpanReader> bitreader{stream};
+
+    std::vector<uint64_t> hashes;
+    // Each element takes at least one bit, don't trust N if the filter was
+    // not checked.
+    hashes.reserve(std::min<uint64_t>(m_N, 8 * m_encoded.size()));
+    uint64_t value = 0;
+    for (uint32_t i = 0; i < m_N; ++i) {
+        value += GolombRiceDecode(bitreader, m_params.m_P);
+        hashes.push_back(value);
+    }
+    return hashes;
+}
+
+DecodedGCSFilter::DecodedGCSFilter(const GCSFilter &filter)
+    : m_params(filter.GetParams()),
+      m_F(static_cast<uint64_t>(filter.GetN()) *
+          static_cast<uint64_t>(m_params.m_M)),
+      m_hashes(filter.Decode()) {}
+
+bool DecodedGCSFilter::Match(const GCSFilter::Element &element) const {
+    return std::binary_search(m_hashes.begin(), m_hashes.end(),
+                              HashToRange(m_params, m_F, element));
+}
+
+bool DecodedGCSFilter::MatchAny(const GCSFilter::ElementSet &elements) const {
+    auto it = m_hashes.begin();
+    for (uint64_t query : BuildHashedSet(m_params, m_F, elements)) {
+        it = std::lower_bound(it, m_hashes.end(), query);
+        if (it == m_hashes.end()) {
+            return false;
+        }
+        if (*it == query) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t DecodedGCSFilter::DynamicMemoryUsage() const {
+    return memusage::DynamicUsage(m_hashes);
+}
+
 const std::string &BlockFilterTypeName(BlockFilterType filter_type) {
     static std::string unknown_retval = "";
     auto it = g_filter_types.find(filter_type);
@@ -190,9 +299,13 @@ const std::string &ListBlockFilterTypes() {
     return type_list;
 }
 
-static GCSFilter::ElementSet BasicFilterElements(const CBlock &block,
-                                                 const CBlockUndo &block_undo) {
-    GCSFilter::ElementSet elements;
+/**
+ * The elements of the basic filter of the block, with duplicates. They point
+ * into the block and its undo data.
+ */
+static std::vector<Span<const uint8_t>>
+BasicFilterElements(const CBlock &block, const CBlockUndo &block_undo) {
+    std::vector<Span<const uint8_t>> elements;
 
     for (const CTransactionRef &tx : block.vtx) {
         for (const CTxOut &txout : tx->vout) {
@@ -200,7 +313,7 @@ static GCSFilter::ElementSet BasicFilterElements(const CBlock &block,
             if (script.empty() || script[0] == OP_RETURN) {
                 continue;
             }
-            elements.emplace(script.begin(), script.end());
+            elements.emplace_back(script.data(), script.size());
         }
     }
 
@@ -210,7 +323,7 @@ static GCSFilter::ElementSet BasicFilterElements(const CBlock &block,
             if (script.empty()) {
                 continue;
             }
-            elements.emplace(script.begin(), script.end());
+            elements.emplace_back(script.data(), script.size());
         }
     }
 
@@ -219,13 +332,14 @@ static GCSFilter::ElementSet BasicFilterElements(const CBlock &block,
 
 BlockFilter::BlockFilter(BlockFilterType filter_type,
                          const BlockHash &block_hash,
-                         std::vector<uint8_t> filter)
+                         std::vector<uint8_t> filter,
+                         bool skip_decode_check)
     : m_filter_type(filter_type), m_block_hash(block_hash) {
     GCSFilter::Params params;
     if (!BuildParams(params)) {
         throw std::invalid_argument("unknown filter_type");
     }
-    m_filter = GCSFilter(params, std::move(filter));
+    m_filter = GCSFilter(params, std::move(filter), skip_decode_check);
 }
 
 BlockFilter::BlockFilter(BlockFilterType filter_type, const CBlock &block,
@@ -8,6 +8,7 @@
 #include <primitives/block.h>
 #include <primitives/blockhash.h>
 #include <serialize.h>
+#include <span.h>
 #include <uint256.h>
 #include <undo.h>
 #include <util/bytevectorhash.h>
@@ -45,10 +46,8 @@ private:
     uint64_t m_F; //!< Range of element hashes, F = N * M
     std::vector<uint8_t> m_encoded;
 
-    /** Hash a data element to an integer in the range [0, N * M). */
-    uint64_t HashToRange(const Element &element) const;
-
-    std::vector<uint64_t> BuildHashedSet(const ElementSet &elements) const;
+    /** Encode the elements, dropping the duplicates. */
+    void Encode(const std::vector<Span<const uint8_t>> &elements);
 
     /** Helper method used to implement Match and MatchAny */
     bool MatchInternal(const uint64_t *sorted_element_hashes,
@@ -58,12 +57,24 @@ public:
     /** Constructs an empty filter. */
     explicit GCSFilter(const Params &params = Params());
 
-    /** Reconstructs an already-created filter from an encoding. */
-    GCSFilter(const Params &params, std::vector<uint8_t> encoded_filter);
+    /**
+     * Reconstructs an already-created filter from an encoding. Unless
+     * skip_decode_check is set, the whole filter is decoded to check that it
+     * is well formed, which can be skipped for the filters we built.
+     */
+    GCSFilter(const Params &params, std::vector<uint8_t> encoded_filter,
+              bool skip_decode_check = false);
 
     /** Builds a new filter from the params and set of elements. */
     GCSFilter(const Params &params, const ElementSet &elements);
 
+    /**
+     * Builds a new filter from the params and elements, which may contain
+     * duplicates. This saves copying the elements to a set.
+     */
+    GCSFilter(const Params &params,
+              const std::vector<Span<const uint8_t>> &elements);
+
     uint32_t GetN() const { return m_N; }
     const Params &GetParams() const { return m_params; }
     const std::vector<uint8_t> &GetEncoded() const { return m_encoded; }
@@ -80,6 +91,34 @@ public:
      * efficient that checking Match on multiple elements separately.
      */
     bool MatchAny(const ElementSet &elements) const;
+
+    /**
+     * Decode the filter. Returns the sorted hashes of its elements, see
+     * DecodedGCSFilter.
+     */
+    std::vector<uint64_t> Decode() const;
+};
+
+/**
+ * A GCS filter decoded in memory, for filters matched repeatedly: matching it
+ * doesn't go through the Golomb-Rice coding again, but it takes 8 bytes per
+ * element instead of about 2.5.
+ */
+class DecodedGCSFilter {
+private:
+    GCSFilter::Params m_params;
+    uint64_t m_F;
+    //! Sorted hashes of the elements
+    std::vector<uint64_t> m_hashes;
+
+public:
+    /** Decode the filter, may throw std::ios_base::failure */
+    explicit DecodedGCSFilter(const GCSFilter &filter);
+
+    bool Match(const GCSFilter::Element &element) const;
+    bool MatchAny(const GCSFilter::ElementSet &elements) const;
+
+    size_t DynamicMemoryUsage() const;
 };
 
 constexpr uint8_t BASIC_FILTER_P = 19;
@@ -121,7 +160,7 @@ public:
 
     //! Reconstruct a BlockFilter from parts.
     BlockFilter(BlockFilterType filter_type, const BlockHash &block_hash,
-                std::vector<uint8_t> filter);
+                std::vector<uint8_t> filter, bool skip_decode_check = false);
 
     //! Construct a new BlockFilter of the specified type from a block.
     BlockFilter(BlockFilterType filter_type, const CBlock &block,
@@ -13,6 +13,17 @@
 bool CCoinsView::GetCoin(const COutPoint &outpoint, Coin &coin) const {
     return false;
 }
+std::vector<std::optional<Coin>>
+CCoinsView::GetCoins(const std::vector<COutPoint> &outpoints) const {
+    std::vector<std::optional<Coin>> coins(outpoints.size());
+    for (size_t i = 0; i < outpoints.size(); i++) {
+        Coin coin;
+        if (GetCoin(outpoints[i], coin)) {
+            coins[i] = std::move(coin);
+        }
+    }
+    return coins;
+}
 BlockHash CCoinsView::GetBestBlock() const {
     return BlockHash();
 }
@@ -101,6 +112,50 @@ bool CCoinsViewCache::GetCoin(const COutPoint &outpoint, Coin &coin) const {
     return !coin.IsSpent();
 }
 
+void CCoinsViewCache::PrefetchCoins(
+    const std::vector<COutPoint> &outpoints) const {
+    std::vector<COutPoint> missing;
+    for (const COutPoint &outpoint : outpoints) {
+        if (cacheCoins.find(outpoint) == cacheCoins.end()) {
+            missing.push_back(outpoint);
+        }
+    }
+    if (missing.empty()) {
+        return;
+    }
+
+    std::vector<std::optional<Coin>> coins{base->GetCoins(missing)};
+    for (size_t i = 0; i < missing.size(); i++) {
+        if (!coins[i]) {
+            continue;
+        }
+        // GetCoins() only returns unspent coins, so unlike FetchCoin() there
+        // is no spent entry to mark as FRESH.
+        assert(!coins[i]->IsSpent());
+        // The outpoints may contain duplicates, which are only inserted once.
+        auto [it, inserted] = cacheCoins.emplace(
+            std::piecewise_construct, std::forward_as_tuple(missing[i]),
+            std::forward_as_tuple(std::move(*coins[i])));
+        if (!inserted) {
+            continue;
+        }
+        cachedCoinsUsage += it->second.coin.DynamicMemoryUsage();
+    }
+}
+
+std::vector<std::optional<Coin>>
+CCoinsViewCache::GetCoins(const std::vector<COutPoint> &outpoints) const {
+    PrefetchCoins(outpoints);
+    std::vector<std::optional<Coin>> coins(outpoints.size());
+    for (size_t i = 0; i < outpoints.size(); i++) {
+        CCoinsMap::const_iterator it = cacheCoins.find(outpoints[i]);
+        if (it != cacheCoins.end() && !it->second.coin.IsSpent()) {
+            coins[i] = it->second.coin;
+        }
+    }
+    return coins;
+}
+
 void CCoinsViewCache::AddCoin(const COutPoint &outpoint, Coin coin,
                               bool possible_overwrite) {
     assert(!coin.IsSpent());
@@ -405,20 +460,34 @@ const Coin &AccessByTxid(const CCoinsViewCache &view, const TxId &txid) {
     return coinEmpty;
 }
 
+void CCoinsViewErrorCatcher::HandleReadError(
+    const std::runtime_error &e) const {
+    for (auto f : m_err_callbacks) {
+        f();
+    }
+    LogPrintf("Error reading from database: %s\n", e.what());
+    // Starting the shutdown sequence and returning false to the caller
+    // would be interpreted as 'entry not found' (as opposed to unable to
+    // read data), and could lead to invalid interpretation. Just exit
+    // immediately, as we can't continue anyway, and all writes should be
+    // atomic.
+    std::abort();
+}
+
 bool CCoinsViewErrorCatcher::GetCoin(const COutPoint &outpoint,
                                      Coin &coin) const {
     try {
         return CCoinsViewBacked::GetCoin(outpoint, coin);
     } catch (const std::runtime_error &e) {
-        for (auto f : m_err_callbacks) {
-            f();
-        }
-        LogPrintf("Error reading from database: %s\n", e.what());
-        // Starting the shutdown sequence and returning false to the caller
-        // would be interpreted as 'entry not found' (as opposed to unable to
-        // read data), and could lead to invalid interpretation. Just exit
-        // immediately, as we can't continue anyway, and all writes should be
-        // atomic.
-        std::abort();
+        HandleReadError(e);
+    }
+}
+
+std::vector<std::optional<Coin>> CCoinsViewErrorCatcher::GetCoins(
+    const std::vector<COutPoint> &outpoints) const {
+    try {
+        return base->GetCoins(outpoints);
+    } catch (const std::runtime_error &e) {
+        HandleReadError(e);
     }
 }
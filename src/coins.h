@@ -16,7 +16,10 @@
 #include <cassert>
 #include <cstdint>
 #include <functional>
+#include <optional>
+#include <stdexcept>
 #include <unordered_map>
+#include <vector>
 
 /**
  * A UTXO entry.
@@ -169,6 +172,14 @@ public:
      */
     virtual bool GetCoin(const COutPoint &outpoint, Coin &coin) const;
 
+    /**
+     * Retrieve the unspent coins for several outpoints at once, in the same
+     * order, std::nullopt for the ones GetCoin() wouldn't find. Views backed
+     * by a database override this to batch the reads.
+     */
+    virtual std::vector<std::optional<Coin>>
+    GetCoins(const std::vector<COutPoint> &outpoints) const;
+
     //! Just check whether a given outpoint is unspent.
     virtual bool HaveCoin(const COutPoint &outpoint) const;
 
@@ -245,6 +256,8 @@ public:
 
     // Standard CCoinsView methods
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
+    std::vector<std::optional<Coin>>
+    GetCoins(const std::vector<COutPoint> &outpoints) const override;
     bool HaveCoin(const COutPoint &outpoint) const override;
     BlockHash GetBestBlock() const override;
     void SetBestBlock(const BlockHash &hashBlock);
@@ -262,6 +275,14 @@ public:
      */
     bool HaveCoinInCache(const COutPoint &outpoint) const;
 
+    /**
+     * Load the coins not in the cache yet with a single GetCoins() call to the
+     * backing view, so the following lookups of these outpoints are cache
+     * hits. This is faster than fetching them one by one when the backing
+     * view batches the database reads.
+     */
+    void PrefetchCoins(const std::vector<COutPoint> &outpoints) const;
+
     /**
      * Return a reference to Coin in the cache, or coinEmpty if not found.
      * This is more efficient than GetCoin.
@@ -381,8 +402,13 @@ public:
     }
 
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
+    std::vector<std::optional<Coin>>
+    GetCoins(const std::vector<COutPoint> &outpoints) const override;
 
 private:
+    /** Run the callbacks and exit on a database read error */
+    [[noreturn]] void HandleReadError(const std::runtime_error &e) const;
+
     /**
      * A list of callbacks to execute upon leveldb read error.
      */
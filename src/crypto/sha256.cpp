@@ -9,6 +9,7 @@
 
 #include <cassert>
 #include <cstring>
+#include <utility>
 
 #if defined(__x86_64__) || defined(__amd64__) || defined(__i386__)
 #if defined(USE_ASM)
@@ -20,11 +21,13 @@ void Transform(uint32_t *s, const uint8_t *chunk, size_t blocks);
 
 namespace sha256d64_sse41 {
 void Transform_4way(uint8_t *out, const uint8_t *in);
-}
+void TransformMulti_4way(uint32_t *s, const uint8_t *const *chunks);
+} // namespace sha256d64_sse41
 
 namespace sha256d64_avx2 {
 void Transform_8way(uint8_t *out, const uint8_t *in);
-}
+void TransformMulti_8way(uint32_t *s, const uint8_t *const *chunks);
+} // namespace sha256d64_avx2
 
 namespace sha256d64_shani {
 void Transform_2way(uint8_t *out, const uint8_t *in);
@@ -32,7 +35,8 @@ void Transform_2way(uint8_t *out, const uint8_t *in);
 
 namespace sha256_shani {
 void Transform(uint32_t *s, const uint8_t *chunk, size_t blocks);
-}
+void TransformMulti_2way(uint32_t *s, const uint8_t *const *chunks);
+} // namespace sha256_shani
 
 // Internal implementation code.
 namespace {
@@ -578,6 +582,8 @@ namespace sha256 {
 
 typedef void (*TransformType)(uint32_t *, const uint8_t *, size_t);
 typedef void (*TransformD64Type)(uint8_t *, const uint8_t *);
+//! Transform one block of each lane, the state of lane i being s[8*i..8*i+8]
+typedef void (*TransformMultiType)(uint32_t *, const uint8_t *const *);
 
 template <TransformType tr>
 void TransformD64Wrapper(uint8_t *out, const uint8_t *in) {
@@ -618,6 +624,9 @@ TransformD64Type TransformD64 = sha256::TransformD64;
 TransformD64Type TransformD64_2way = nullptr;
 TransformD64Type TransformD64_4way = nullptr;
 TransformD64Type TransformD64_8way = nullptr;
+TransformMultiType TransformMulti_2way = nullptr;
+TransformMultiType TransformMulti_4way = nullptr;
+TransformMultiType TransformMulti_8way = nullptr;
 
 bool SelfTest() {
     // Input state (equal to the initial SHA256 state)
@@ -729,6 +738,28 @@ bool SelfTest() {
         }
     }
 
+    // Test the TransformMulti_* kernels, if available. Lane i hashes the
+    // i-th block of the input from the state of the previous ones.
+    for (const auto &[transform, lanes] :
+         {std::pair{TransformMulti_2way, 2}, std::pair{TransformMulti_4way, 4},
+          std::pair{TransformMulti_8way, 8}}) {
+        if (!transform) {
+            continue;
+        }
+        uint32_t state[64];
+        const uint8_t *chunks[8];
+        for (int i = 0; i < lanes; ++i) {
+            std::copy(result[i], result[i] + 8, state + 8 * i);
+            chunks[i] = data + 1 + 64 * i;
+        }
+        transform(state, chunks);
+        for (int i = 0; i < lanes; ++i) {
+            if (!std::equal(state + 8 * i, state + 8 * i + 8, result[i + 1])) {
+                return false;
+            }
+        }
+    }
+
     return true;
 }
 
@@ -741,6 +772,112 @@ bool AVXEnabled() {
     return (a & 6) == 6;
 }
 #endif
+
+/**
+ * Double SHA-256 of count messages, hashing them LANES at a time with a
+ * kernel that transforms one block of each lane in lockstep. A lane moves on
+ * to the next message as soon as it is done with its own, so messages of
+ * different sizes don't leave lanes idle until the last one is hashed.
+ */
+template <int LANES>
+void SHA256DMultiLanes(TransformMultiType transform, uint8_t *output,
+                       const uint8_t *const *inputs, const size_t *sizes,
+                       size_t count) {
+    static const uint8_t zero_block[64] = {0};
+
+    struct Lane {
+        //! Position of the message, count if the lane is idle
+        size_t index;
+        //! Full blocks of the message not hashed yet
+        const uint8_t *data;
+        size_t full_blocks;
+        //! The padded last 1 or 2 blocks, or the digest of the first hash
+        uint8_t tail[128];
+        size_t tail_pos;
+        size_t tail_blocks;
+        bool second_hash;
+    };
+    Lane lanes[LANES];
+    // Idle lanes are still transformed, from zeroes
+    uint32_t state[8 * LANES]{};
+    size_t next{0};
+
+    auto start_message = [&](int i) {
+        Lane &lane = lanes[i];
+        lane.index = next < count ? next++ : count;
+        if (lane.index == count) {
+            return;
+        }
+        const size_t size{sizes[lane.index]};
+        const size_t remaining{size % 64};
+        lane.data = inputs[lane.index];
+        lane.full_blocks = size / 64;
+        lane.tail_pos = 0;
+        lane.tail_blocks = remaining + 9 <= 64 ? 1 : 2;
+        lane.second_hash = false;
+        std::memset(lane.tail, 0, sizeof(lane.tail));
+        if (remaining > 0) {
+            std::memcpy(lane.tail, lane.data + 64 * lane.full_blocks,
+                        remaining);
+        }
+        lane.tail[remaining] = 0x80;
+        WriteBE64(lane.tail + 64 * lane.tail_blocks - 8, uint64_t(size) << 3);
+        sha256::Initialize(state + 8 * i);
+    };
+    for (int i = 0; i < LANES; ++i) {
+        start_message(i);
+    }
+
+    while (true) {
+        const uint8_t *chunks[LANES];
+        bool busy{false};
+        for (int i = 0; i < LANES; ++i) {
+            Lane &lane = lanes[i];
+            if (lane.index == count) {
+                chunks[i] = zero_block;
+            } else if (lane.full_blocks > 0) {
+                chunks[i] = lane.data;
+                lane.data += 64;
+                lane.full_blocks--;
+                busy = true;
+            } else {
+                chunks[i] = lane.tail + 64 * lane.tail_pos++;
+                busy = true;
+            }
+        }
+        if (!busy) {
+            return;
+        }
+        transform(state, chunks);
+
+        for (int i = 0; i < LANES; ++i) {
+            Lane &lane = lanes[i];
+            if (lane.index == count || lane.full_blocks > 0 ||
+                lane.tail_pos < lane.tail_blocks) {
+                continue;
+            }
+            uint32_t *s = state + 8 * i;
+            if (lane.second_hash) {
+                for (int j = 0; j < 8; ++j) {
+                    WriteBE32(output + 32 * lane.index + 4 * j, s[j]);
+                }
+                start_message(i);
+                continue;
+            }
+            // Hash the 32 bytes digest, padded to a single block
+            std::memset(lane.tail, 0, 64);
+            for (int j = 0; j < 8; ++j) {
+                WriteBE32(lane.tail + 4 * j, s[j]);
+            }
+            lane.tail[32] = 0x80;
+            WriteBE64(lane.tail + 56, 256);
+            lane.tail_pos = 0;
+            lane.tail_blocks = 1;
+            lane.second_hash = true;
+            sha256::Initialize(s);
+        }
+    }
+}
 } // namespace
 
 std::string SHA256AutoDetect() {
@@ -780,6 +917,7 @@ std::string SHA256AutoDetect() {
         Transform = sha256_shani::Transform;
         TransformD64 = TransformD64Wrapper<sha256_shani::Transform>;
         TransformD64_2way = sha256d64_shani::Transform_2way;
+        TransformMulti_2way = sha256_shani::TransformMulti_2way;
         ret = "shani(1way,2way)";
         have_sse4 = false; // Disable SSE4/AVX2;
         have_avx2 = false;
@@ -794,6 +932,7 @@ std::string SHA256AutoDetect() {
 #endif
 #if defined(ENABLE_SSE41) && !defined(BUILD_BITCOIN_INTERNAL)
         TransformD64_4way = sha256d64_sse41::Transform_4way;
+        TransformMulti_4way = sha256d64_sse41::TransformMulti_4way;
         ret += ",sse41(4way)";
 #endif
     }
@@ -801,6 +940,7 @@ std::string SHA256AutoDetect() {
 #if defined(ENABLE_AVX2) && !defined(BUILD_BITCOIN_INTERNAL)
     if (have_avx2 && have_avx && enabled_avx) {
         TransformD64_8way = sha256d64_avx2::Transform_8way;
+        TransformMulti_8way = sha256d64_avx2::TransformMulti_8way;
         ret += ",avx2(8way)";
     }
 #endif
@@ -895,3 +1035,29 @@ void SHA256D64(uint8_t *out, const uint8_t *in, size_t blocks) {
         --blocks;
     }
 }
+
+void SHA256DMulti(uint8_t *output, const uint8_t *const *inputs,
+                  const size_t *sizes, size_t count) {
+    if (count >= 2) {
+        if (TransformMulti_8way) {
+            SHA256DMultiLanes<8>(TransformMulti_8way, output, inputs, sizes,
+                                 count);
+            return;
+        }
+        if (TransformMulti_4way) {
+            SHA256DMultiLanes<4>(TransformMulti_4way, output, inputs, sizes,
+                                 count);
+            return;
+        }
+        if (TransformMulti_2way) {
+            SHA256DMultiLanes<2>(TransformMulti_2way, output, inputs, sizes,
+                                 count);
+            return;
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        uint8_t buf[CSHA256::OUTPUT_SIZE];
+        CSHA256().Write(inputs[i], sizes[i]).Finalize(buf);
+        CSHA256().Write(buf, CSHA256::OUTPUT_SIZE).Finalize(output + 32 * i);
+    }
+}
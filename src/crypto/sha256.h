@@ -39,4 +39,15 @@ std::string SHA256AutoDetect();
  */
 void SHA256D64(uint8_t *output, const uint8_t *input, size_t blocks);
 
+/**
+ * Compute multiple double-SHA256's of messages of any size, hashing several
+ * of them in lockstep when the CPU allows it.
+ * output:  pointer to a count*32 byte output buffer
+ * inputs:  pointers to the count messages
+ * sizes:   sizes of the count messages
+ * count:   the number of hashes to compute.
+ */
+void SHA256DMulti(uint8_t *output, const uint8_t *const *inputs,
+                  const size_t *sizes, size_t count);
+
 #endif // BITCOIN_CRYPTO_SHA256_H
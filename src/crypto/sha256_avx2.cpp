@@ -452,6 +452,78 @@ void Transform_8way(uint8_t *out, const uint8_t *in) {
     Write8(out, 24, Add(g, K(0x1f83d9abul)));
     Write8(out, 28, Add(h, K(0x5be0cd19ul)));
 }
+
+namespace {
+    const uint32_t ROUND_CONSTANTS[64] = {
+        0x428a2f98ul, 0x71374491ul, 0xb5c0fbcful, 0xe9b5dba5ul, 0x3956c25bul,
+        0x59f111f1ul, 0x923f82a4ul, 0xab1c5ed5ul, 0xd807aa98ul, 0x12835b01ul,
+        0x243185beul, 0x550c7dc3ul, 0x72be5d74ul, 0x80deb1feul, 0x9bdc06a7ul,
+        0xc19bf174ul, 0xe49b69c1ul, 0xefbe4786ul, 0x0fc19dc6ul, 0x240ca1ccul,
+        0x2de92c6ful, 0x4a7484aaul, 0x5cb0a9dcul, 0x76f988daul, 0x983e5152ul,
+        0xa831c66dul, 0xb00327c8ul, 0xbf597fc7ul, 0xc6e00bf3ul, 0xd5a79147ul,
+        0x06ca6351ul, 0x14292967ul, 0x27b70a85ul, 0x2e1b2138ul, 0x4d2c6dfcul,
+        0x53380d13ul, 0x650a7354ul, 0x766a0abbul, 0x81c2c92eul, 0x92722c85ul,
+        0xa2bfe8a1ul, 0xa81a664bul, 0xc24b8b70ul, 0xc76c51a3ul, 0xd192e819ul,
+        0xd6990624ul, 0xf40e3585ul, 0x106aa070ul, 0x19a4c116ul, 0x1e376c08ul,
+        0x2748774cul, 0x34b0bcb5ul, 0x391c0cb3ul, 0x4ed8aa4aul, 0x5b9cca4ful,
+        0x682e6ff3ul, 0x748f82eeul, 0x78a5636ful, 0x84c87814ul, 0x8cc70208ul,
+        0x90befffaul, 0xa4506cebul, 0xbef9a3f7ul, 0xc67178f2ul};
+
+    /** Read the same big endian word from the 8 chunks */
+    __m256i inline ReadWords(const uint8_t *const *chunks, int offset) {
+        return _mm256_set_epi32(
+            ReadBE32(chunks[0] + offset), ReadBE32(chunks[1] + offset),
+            ReadBE32(chunks[2] + offset), ReadBE32(chunks[3] + offset),
+            ReadBE32(chunks[4] + offset), ReadBE32(chunks[5] + offset),
+            ReadBE32(chunks[6] + offset), ReadBE32(chunks[7] + offset));
+    }
+} // namespace
+
+void TransformMulti_8way(uint32_t *s, const uint8_t *const *chunks) {
+    // Each vector holds the same word of the state of the 8 lanes
+    __m256i state[8];
+    for (int i = 0; i < 8; i++) {
+        state[i] = _mm256_set_epi32(s[i], s[8 + i], s[16 + i], s[24 + i],
+                                    s[32 + i], s[40 + i], s[48 + i],
+                                    s[56 + i]);
+    }
+    __m256i w[16];
+    for (int i = 0; i < 16; i++) {
+        w[i] = ReadWords(chunks, 4 * i);
+    }
+    auto W = [&](int i) {
+        if (i >= 16) {
+            Inc(w[i % 16], sigma1(w[(i + 14) % 16]), w[(i + 9) % 16],
+                sigma0(w[(i + 1) % 16]));
+        }
+        return Add(K(ROUND_CONSTANTS[i]), w[i % 16]);
+    };
+
+    __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+    __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+    for (int i = 0; i < 64; i += 8) {
+        Round(a, b, c, d, e, f, g, h, W(i));
+        Round(h, a, b, c, d, e, f, g, W(i + 1));
+        Round(g, h, a, b, c, d, e, f, W(i + 2));
+        Round(f, g, h, a, b, c, d, e, W(i + 3));
+        Round(e, f, g, h, a, b, c, d, W(i + 4));
+        Round(d, e, f, g, h, a, b, c, W(i + 5));
+        Round(c, d, e, f, g, h, a, b, W(i + 6));
+        Round(b, c, d, e, f, g, h, a, W(i + 7));
+    }
+    const __m256i result[8] = {Add(state[0], a), Add(state[1], b),
+                               Add(state[2], c), Add(state[3], d),
+                               Add(state[4], e), Add(state[5], f),
+                               Add(state[6], g), Add(state[7], h)};
+
+    for (int i = 0; i < 8; i++) {
+        uint32_t words[8];
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(words), result[i]);
+        for (int lane = 0; lane < 8; lane++) {
+            s[8 * lane + i] = words[7 - lane];
+        }
+    }
+}
 } // namespace sha256d64_avx2
 
 #endif
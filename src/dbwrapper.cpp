@@ -5,7 +5,9 @@
 #include <dbwrapper.h>
 
 #include <random.h>
+#include <sync.h>
 #include <util/fs_helpers.h>
+#include <util/parallel.h>
 
 #include <leveldb/cache.h>
 #include <leveldb/env.h>
@@ -15,6 +17,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <memory>
+#include <numeric>
 
 class CBitcoinLevelDBLogger : public leveldb::Logger {
 public:
@@ -99,13 +102,40 @@ static void SetMaxOpenFiles(leveldb::Options *options) {
              options->max_open_files, default_open_files);
 }
 
-static leveldb::Options GetOptions(size_t nCacheSize) {
+std::optional<DBStorageProfile> GetDBStorageProfile(const std::string &name) {
+    if (name == "default") {
+        return DBStorageProfile{};
+    }
+    if (name == "archive") {
+        return DBStorageProfile{.compression = true,
+                                .bloom_bits = 10,
+                                .block_size = 16 << 10,
+                                .block_cache_percent = 75};
+    }
+    if (name == "scan") {
+        return DBStorageProfile{.compression = true,
+                                .bloom_bits = 0,
+                                .block_size = 64 << 10,
+                                .block_cache_percent = 75};
+    }
+    return std::nullopt;
+}
+
+static leveldb::Options GetOptions(size_t nCacheSize,
+                                   const DBStorageProfile &profile) {
+    const size_t block_cache_size =
+        nCacheSize / 100 * std::clamp(profile.block_cache_percent, 0, 100);
     leveldb::Options options;
-    options.block_cache = leveldb::NewLRUCache(nCacheSize / 2);
+    options.block_cache = leveldb::NewLRUCache(block_cache_size);
     // up to two write buffers may be held in memory simultaneously
-    options.write_buffer_size = nCacheSize / 4;
-    options.filter_policy = leveldb::NewBloomFilterPolicy(10);
-    options.compression = leveldb::kNoCompression;
+    options.write_buffer_size = (nCacheSize - block_cache_size) / 2;
+    options.filter_policy =
+        profile.bloom_bits > 0
+            ? leveldb::NewBloomFilterPolicy(profile.bloom_bits)
+            : nullptr;
+    options.block_size = profile.block_size;
+    options.compression = profile.compression ? leveldb::kSnappyCompression
+                                              : leveldb::kNoCompression;
     options.info_log = new CBitcoinLevelDBLogger();
     if (leveldb::kMajorVersion > 1 ||
         (leveldb::kMajorVersion == 1 && leveldb::kMinorVersion >= 16)) {
@@ -125,7 +155,7 @@ CDBWrapper::CDBWrapper(const DBParams &params)
     iteroptions.verify_checksums = true;
     iteroptions.fill_cache = false;
     syncoptions.sync = true;
-    options = GetOptions(params.cache_bytes);
+    options = GetOptions(params.cache_bytes, params.options.storage);
     options.create_if_missing = true;
     if (params.memory_only) {
         penv = leveldb::NewMemEnv(leveldb::Env::Default());
@@ -148,6 +178,12 @@ CDBWrapper::CDBWrapper(const DBParams &params)
         leveldb::DB::Open(options, fs::PathToString(params.path), &pdb);
     dbwrapper_private::HandleError(status);
     LogPrintf("Opened LevelDB successfully\n");
+    LogPrint(BCLog::LEVELDB,
+             "LevelDB %s using compression=%d bloom_bits=%d block_size=%u "
+             "write_buffer_size=%u\n",
+             m_name, params.options.storage.compression,
+             params.options.storage.bloom_bits, options.block_size,
+             options.write_buffer_size);
 
     if (params.options.force_compact) {
         LogPrintf("Starting database compaction of %s\n",
@@ -211,6 +247,57 @@ bool CDBWrapper::WriteBatch(CDBBatch &batch, bool fSync) {
     return true;
 }
 
+std::vector<std::optional<std::string>>
+CDBWrapper::MultiReadRaw(const std::vector<std::string> &keys,
+                         size_t num_threads) const {
+    std::vector<size_t> order(keys.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return leveldb::Slice(keys[a]).compare(leveldb::Slice(keys[b])) < 0;
+    });
+
+    std::vector<std::optional<std::string>> values(keys.size());
+    Mutex error_mutex;
+    leveldb::Status error;
+    util::g_worker_pool.ForRanges(
+        order.size(), num_threads, [&](size_t begin, size_t end) {
+            std::unique_ptr<leveldb::Iterator> it{
+                pdb->NewIterator(readoptions)};
+            for (size_t i = begin; i < end; i++) {
+                const leveldb::Slice key{keys[order[i]]};
+                if (!it->Valid() || it->key().compare(key) < 0) {
+                    // The next entry is often the one we are looking for, or
+                    // past it, which saves seeking from the top of the
+                    // database.
+                    if (it->Valid()) {
+                        it->Next();
+                    }
+                    if (!it->Valid() || it->key().compare(key) < 0) {
+                        it->Seek(key);
+                    }
+                    if (!it->Valid()) {
+                        // The remaining keys are all past the end
+                        break;
+                    }
+                }
+                if (it->key() == key) {
+                    values[order[i]] = it->value().ToString();
+                }
+            }
+            if (!it->status().ok()) {
+                LOCK(error_mutex);
+                error = it->status();
+            }
+        });
+
+    // Throw from the calling thread, once all the shards are done
+    if (!error.ok()) {
+        LogPrintf("LevelDB read failure: %s\n", error.ToString());
+        dbwrapper_private::HandleError(error);
+    }
+    return values;
+}
+
 size_t CDBWrapper::DynamicMemoryUsage() const {
     std::string memory;
     if (!pdb->GetProperty("leveldb.approximate-memory-usage", &memory)) {
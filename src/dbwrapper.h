@@ -18,14 +18,47 @@
 #include <leveldb/write_batch.h>
 
 #include <optional>
+#include <string>
+#include <vector>
 
 static const size_t DBWRAPPER_PREALLOC_KEY_SIZE = 64;
 static const size_t DBWRAPPER_PREALLOC_VALUE_SIZE = 1024;
 
+/**
+ * Layout of the leveldb tables and split of the cache, chosen for the way a
+ * database is accessed. The defaults suit the chainstate, which is small
+ * enough to be mostly cached and is read by random lookups.
+ */
+struct DBStorageProfile {
+    //! Compress the table blocks with Snappy. This has no effect if leveldb is
+    //! built without Snappy, and the compressed tables can't be read by such a
+    //! build.
+    bool compression = false;
+    //! Bits per key of the bloom filters, 0 to not build them.
+    int bloom_bits = 10;
+    //! Approximate size of the table blocks, before compression.
+    size_t block_size = 4096;
+    //! Share of the cache used for the table blocks, in %. The rest is split
+    //! between the two write buffers leveldb may hold.
+    int block_cache_percent = 50;
+};
+
+/**
+ * The storage profile with the given name:
+ *  - "default": the DBStorageProfile defaults.
+ *  - "archive": compressed and larger blocks, with most of the cache used for
+ *    reading. For large databases of random lookups, like the txindex.
+ *  - "scan": same as archive without the bloom filters, which are not used
+ *    when iterating. For databases read by range, like the block filter
+ *    index.
+ */
+std::optional<DBStorageProfile> GetDBStorageProfile(const std::string &name);
+
 //! User-controlled performance and debug options.
 struct DBOptions {
     //! Compact database on startup.
     bool force_compact = false;
+    DBStorageProfile storage{};
 };
 
 //! Application-specific storage settings.
@@ -195,6 +228,17 @@ public:
     }
 
     unsigned int GetValueSize() { return piter->value().size(); }
+
+    /**
+     * The value at the current position, as stored in the database. It is
+     * only valid until the iterator moves, and must be decoded with
+     * CDBWrapper::DecodeValue().
+     */
+    Span<const uint8_t> GetRawValue() const {
+        leveldb::Slice slValue = piter->value();
+        return {reinterpret_cast<const uint8_t *>(slValue.data()),
+                slValue.size()};
+    }
 };
 
 class CDBWrapper {
@@ -238,6 +282,14 @@ private:
 
     std::vector<uint8_t> CreateObfuscateKey() const;
 
+    /**
+     * Look up the serialized keys with sorted iterator walks, see
+     * MultiRead().
+     */
+    std::vector<std::optional<std::string>>
+    MultiReadRaw(const std::vector<std::string> &keys,
+                 size_t num_threads) const;
+
     //! path to filesystem storage
     const fs::path m_path;
 
@@ -275,6 +327,58 @@ public:
         return true;
     }
 
+    /**
+     * Read the values of several keys at once. Rather than looking up each key
+     * from the top of the database, the keys are sorted and an iterator walks
+     * over them in order, so the keys close to each other are read from the
+     * table block the iterator has already loaded. The sorted keys can be
+     * split into shards, each walked by its own iterator from one of up to
+     * num_threads threads.
+     *
+     * Returns the values in the order of the keys, std::nullopt for the keys
+     * that are not found or whose value can't be deserialized.
+     */
+    template <typename V, typename K>
+    std::vector<std::optional<V>> MultiRead(const std::vector<K> &keys,
+                                            size_t num_threads = 1) const {
+        std::vector<std::string> raw_keys;
+        raw_keys.reserve(keys.size());
+        CDataStream ssKey(SER_DISK, CLIENT_VERSION);
+        for (const K &key : keys) {
+            ssKey.clear();
+            ssKey << key;
+            raw_keys.push_back(ssKey.str());
+        }
+
+        std::vector<std::optional<std::string>> raw_values{
+            MultiReadRaw(raw_keys, num_threads)};
+        std::vector<std::optional<V>> values(keys.size());
+        for (size_t i = 0; i < keys.size(); i++) {
+            V value;
+            if (raw_values[i] &&
+                DecodeValue(MakeUCharSpan(*raw_values[i]), value)) {
+                values[i] = std::move(value);
+            }
+        }
+        return values;
+    }
+
+    /**
+     * Deserialize a value obtained from CDBIterator::GetRawValue(). This
+     * doesn't access the database, so it can be called from any thread.
+     */
+    template <typename V>
+    bool DecodeValue(Span<const uint8_t> raw, V &value) const {
+        try {
+            CDataStream ssValue{MakeByteSpan(raw), SER_DISK, CLIENT_VERSION};
+            ssValue.Xor(obfuscate_key);
+            ssValue >> value;
+        } catch (const std::exception &) {
+            return false;
+        }
+        return true;
+    }
+
     template <typename K, typename V>
     bool Write(const K &key, const V &value, bool fSync = false) {
         CDBBatch batch(*this);
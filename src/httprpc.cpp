@@ -9,6 +9,7 @@
 #include <config.h>
 #include <crypto/hmac_sha256.h>
 #include <logging.h>
+#include <rpc/jsonwriter.h>
 #include <rpc/protocol.h>
 #include <util/strencodings.h>
 #include <util/translation.h>
@@ -90,7 +91,7 @@ static void JSONErrorReply(HTTPRequest *req, const UniValue &objError,
     std::string strReply = JSONRPCReply(NullUniValue, objError, id);
 
     req->WriteHeader("Content-Type", "application/json");
-    req->WriteReply(nStatus, strReply);
+    req->WriteReply(nStatus, std::move(strReply));
 }
 
 /*
@@ -354,7 +355,56 @@ bool HTTPRPCRequestProcessor::ProcessHTTPRequest(HTTPRequest *req) {
                 req->WriteReply(HTTP_FORBIDDEN);
                 return false;
             }
-            UniValue result = rpcServer.ExecuteCommand(config, jreq);
+
+            // Commands supporting it stream their result to the client while
+            // it is being built, so large results are never held in memory as
+            // a whole. Writing blocks while the client catches up.
+            bool reply_started{false};
+            JSONStreamWriter writer([&](std::string &&chunk) {
+                if (!reply_started) {
+                    req->WriteHeader("Content-Type", "application/json");
+                    req->StartReply(HTTP_OK);
+                    req->WriteReplyChunk("{\"result\":");
+                    reply_started = true;
+                }
+                req->WriteReplyChunk(std::move(chunk));
+            });
+            jreq.result_writer = &writer;
+
+            UniValue result;
+            try {
+                result = rpcServer.ExecuteCommand(config, jreq);
+            } catch (...) {
+                if (!reply_started) {
+                    throw;
+                }
+                // Part of the result has already been sent with a 200 status,
+                // so the error can't be reported anymore. Close the connection
+                // without terminating the reply, so the client gets a
+                // transport error rather than a truncated result.
+                LogPrintf("RPC method %s failed while streaming its result, "
+                          "dropping the connection\n",
+                          jreq.strMethod);
+                req->AbortReply();
+                return false;
+            }
+
+            if (writer.IsComplete()) {
+                writer.Flush();
+                req->WriteReplyChunk(strprintf(",\"error\":null,\"id\":%s}\n",
+                                               jreq.id.write()));
+                req->EndReply();
+                return true;
+            }
+            if (reply_started) {
+                // The command returned without completing the result it
+                // started streaming, so the reply can't be completed either.
+                LogPrintf("RPC method %s did not complete its streamed result, "
+                          "dropping the connection\n",
+                          jreq.strMethod);
+                req->AbortReply();
+                return false;
+            }
 
             // Send reply
             strReply = JSONRPCReply(result, NullUniValue, jreq.id);
@@ -389,7 +439,7 @@ bool HTTPRPCRequestProcessor::ProcessHTTPRequest(HTTPRequest *req) {
         }
 
         req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strReply);
+        req->WriteReply(HTTP_OK, std::move(strReply));
     } catch (const UniValue &objError) {
         JSONErrorReply(req, objError, jreq.id);
         return false;
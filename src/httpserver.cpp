@@ -16,12 +16,14 @@
 #include <shutdown.h>
 #include <sync.h>
 #include <util/strencodings.h>
+#include <util/string.h>
 #include <util/threadnames.h>
 #include <util/translation.h>
 
 #include <event2/buffer.h>
 #include <event2/bufferevent.h>
 #include <event2/keyvalq_struct.h>
+#include <event2/listener.h>
 #include <event2/thread.h>
 #include <event2/util.h>
 
@@ -30,11 +32,13 @@
 #include <sys/stat.h>
 #include <sys/types.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
-#include <deque>
 #include <memory>
+#include <thread>
 
 /** Maximum size of http request (request line + headers) */
 static const size_t MAX_HEADERS_SIZE = 8192;
@@ -45,6 +49,12 @@ static const size_t MAX_HEADERS_SIZE = 8192;
  */
 static const size_t MIN_SUPPORTED_BODY_SIZE = 0x02000000;
 
+/**
+ * Maximum size of the chunks of a reply waiting to be written to the
+ * connection before the next one is held back.
+ */
+static const size_t MAX_REPLY_BYTES_IN_FLIGHT = 1024 * 1024;
+
 /** HTTP request work item */
 class HTTPWorkItem final : public HTTPClosure {
 public:
@@ -65,58 +75,147 @@ private:
 /**
  * Simple work queue for distributing work over multiple threads.
  * Work items are simply callable objects.
+ *
+ * The queue is a bounded multi-producer multi-consumer ring buffer, so the
+ * event loop threads never contend on a lock when enqueuing work. Idle workers
+ * sleep on a semaphore which is posted once per enqueued item.
  */
 template <typename WorkItem> class WorkQueue {
 private:
-    /** Mutex protects entire object */
-    Mutex cs;
-    std::condition_variable cond;
-    std::deque<std::unique_ptr<WorkItem>> queue;
-    bool running;
-    size_t maxDepth;
+    struct Slot {
+        /**
+         * Position this slot is ready for: equal to the enqueue position when
+         * it is free, to the enqueue position + 1 when it holds an item.
+         */
+        std::atomic<size_t> sequence;
+        WorkItem *item;
+    };
+
+    //! Number of times a woken up worker retries dequeuing before blocking
+    static constexpr int MAX_DEQUEUE_SPINS{100};
+
+    const size_t maxDepth;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<size_t> enqueuePos{0};
+    std::atomic<size_t> dequeuePos{0};
+    std::atomic<bool> running{true};
+    CSemaphore available{0};
+    //! Workers waiting for a producer to finish publishing the item they got
+    //! woken up for, see Run()
+    Mutex cs_stalled;
+    std::condition_variable stalledCond;
+    std::atomic<int> stalledWorkers{0};
+
+    /** Dequeue a work item if one is ready, or return nullptr */
+    WorkItem *TryDequeue() {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Slot *slot;
+        while (true) {
+            slot = &slots[pos % maxDepth];
+            const size_t seq = slot->sequence.load(std::memory_order_acquire);
+            if (seq == pos + 1) {
+                if (dequeuePos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (seq < pos + 1) {
+                // Empty, or the producer of this slot is not done yet
+                return nullptr;
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+        WorkItem *item = slot->item;
+        slot->sequence.store(pos + maxDepth, std::memory_order_release);
+        return item;
+    }
 
 public:
-    explicit WorkQueue(size_t _maxDepth) : running(true), maxDepth(_maxDepth) {}
+    explicit WorkQueue(size_t _maxDepth)
+        : maxDepth(_maxDepth), slots(new Slot[_maxDepth]) {
+        for (size_t i = 0; i < maxDepth; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+            slots[i].item = nullptr;
+        }
+    }
     /**
      * Precondition: worker threads have all stopped (they have all been joined)
      */
-    ~WorkQueue() {}
+    ~WorkQueue() {
+        while (WorkItem *item = TryDequeue()) {
+            delete item;
+        }
+    }
 
-    /** Enqueue a work item */
-    bool Enqueue(WorkItem *item) EXCLUSIVE_LOCKS_REQUIRED(!cs) {
-        LOCK(cs);
-        if (queue.size() >= maxDepth) {
-            return false;
+    /** Enqueue a work item, the queue takes ownership on success */
+    bool Enqueue(WorkItem *item) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        Slot *slot;
+        while (true) {
+            slot = &slots[pos % maxDepth];
+            const size_t seq = slot->sequence.load(std::memory_order_acquire);
+            if (seq == pos) {
+                if (enqueuePos.compare_exchange_weak(
+                        pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (seq < pos) {
+                // The slot still holds the item from the previous lap: the
+                // queue is full.
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        slot->item = item;
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        // Pairs with the fence in Run(): either the stalled worker sees the
+        // item, or this sees the worker and wakes it up.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (stalledWorkers.load(std::memory_order_relaxed) > 0) {
+            LOCK(cs_stalled);
+            stalledCond.notify_all();
         }
-        queue.emplace_back(std::unique_ptr<WorkItem>(item));
-        cond.notify_one();
+        available.post();
         return true;
     }
 
     /** Thread function */
-    void Run() EXCLUSIVE_LOCKS_REQUIRED(!cs) {
+    void Run() {
         while (true) {
-            std::unique_ptr<WorkItem> i;
-            {
-                WAIT_LOCK(cs, lock);
-                while (running && queue.empty()) {
-                    cond.wait(lock);
-                }
-                if (!running) {
-                    break;
-                }
-                i = std::move(queue.front());
-                queue.pop_front();
+            available.wait();
+            if (!running) {
+                // Pass the wake up on to the next worker
+                available.post();
+                break;
+            }
+            // Each post matches a published item, but an earlier slot might
+            // still be in the process of being filled by its producer. This
+            // is short, so spin for a little while, then block until the next
+            // item is published in case that producer got preempted.
+            std::unique_ptr<WorkItem> i{TryDequeue()};
+            for (int spins = 0; !i && spins < MAX_DEQUEUE_SPINS; ++spins) {
+                std::this_thread::yield();
+                i.reset(TryDequeue());
+            }
+            if (!i) {
+                WAIT_LOCK(cs_stalled, lock);
+                stalledWorkers.fetch_add(1, std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                stalledCond.wait(lock, [&] {
+                    i.reset(TryDequeue());
+                    return i != nullptr;
+                });
+                stalledWorkers.fetch_sub(1, std::memory_order_relaxed);
             }
             (*i)();
         }
     }
 
     /** Interrupt and exit loops */
-    void Interrupt() EXCLUSIVE_LOCKS_REQUIRED(!cs) {
-        LOCK(cs);
+    void Interrupt() {
         running = false;
-        cond.notify_all();
+        available.post();
     }
 };
 
@@ -129,20 +228,31 @@ struct HTTPPathHandler {
     HTTPRequestHandler handler;
 };
 
+/** libevent event loop and HTTP server, driven by its own thread */
+struct HTTPEventLoop {
+    //! libevent event loop
+    struct event_base *base;
+    //! HTTP server
+    struct evhttp *http;
+    //! Bound listening sockets
+    std::vector<evhttp_bound_socket *> boundSockets;
+    //! Event dispatcher thread
+    std::thread thread;
+
+    HTTPEventLoop(struct event_base *_base, struct evhttp *_http)
+        : base(_base), http(_http) {}
+};
+
 /** HTTP module state */
 
-//! libevent event loop
-static struct event_base *eventBase = nullptr;
-//! HTTP server
-static struct evhttp *eventHTTP = nullptr;
+//! Event loops, the first one also serves timers and custom events
+static std::vector<HTTPEventLoop> eventLoops;
 //! List of subnets to allow RPC connections from
 static std::vector<CSubNet> rpc_allow_subnets;
-//! Work queue for handling longer requests off the event loop thread
+//! Work queue for handling longer requests off the event loop threads
 static WorkQueue<HTTPClosure> *workQueue = nullptr;
 //! Handlers for (sub)paths
 static std::vector<HTTPPathHandler> pathHandlers;
-//! Bound listening sockets
-static std::vector<evhttp_bound_socket *> boundSockets;
 
 /** Check if a network address is allowed to access the HTTP server */
 static bool ClientAllowed(const CNetAddr &netaddr) {
@@ -296,8 +406,9 @@ static void http_reject_request_cb(struct evhttp_request *req, void *) {
 }
 
 /** Event dispatcher thread */
-static bool ThreadHTTP(struct event_base *base) {
-    util::ThreadRename("http");
+static bool ThreadHTTP(struct event_base *base, int loop_num) {
+    util::ThreadRename(loop_num == 0 ? std::string{"http"}
+                                     : strprintf("http.%i", loop_num));
     LogPrint(BCLog::HTTP, "Entering http event loop\n");
     event_base_dispatch(base);
     // Event loop will be interrupted by InterruptHTTPServer()
@@ -305,8 +416,91 @@ static bool ThreadHTTP(struct event_base *base) {
     return event_base_got_break(base) == 0;
 }
 
-/** Bind HTTP server to specified addresses */
-static bool HTTPBindAddresses(struct evhttp *http) {
+#ifdef LEV_OPT_REUSEABLE_PORT
+/** Resolve the address to bind to, the same way evhttp_bind_socket does */
+static struct evutil_addrinfo *HTTPResolveBindAddress(const std::string &host,
+                                                      uint16_t port) {
+    struct evutil_addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    // Same as evhttp_bind_socket_with_handle
+    hints.ai_flags = EVUTIL_AI_PASSIVE | EVUTIL_AI_ADDRCONFIG;
+    struct evutil_addrinfo *aitop = nullptr;
+    if (evutil_getaddrinfo(host.empty() ? nullptr : host.c_str(),
+                           ToString(port).c_str(), &hints, &aitop) != 0) {
+        return nullptr;
+    }
+    return aitop;
+}
+#endif
+
+/**
+ * Check that the address is free with a plain bind, without SO_REUSEPORT.
+ *
+ * SO_REUSEPORT lets any other socket of the same user that also set it share
+ * the address, so binding the event loops straight away would silently split
+ * the connections with another process already listening there, e.g. a
+ * second node started on the same RPC port. The plain bind fails in that
+ * case, like it does with a single event loop.
+ */
+static bool HTTPProbeBindAddress(const std::string &host, uint16_t port) {
+#ifdef LEV_OPT_REUSEABLE_PORT
+    struct evutil_addrinfo *aitop = HTTPResolveBindAddress(host, port);
+    if (!aitop) {
+        return false;
+    }
+    evutil_socket_t fd =
+        socket(aitop->ai_family, aitop->ai_socktype, aitop->ai_protocol);
+    bool available{false};
+    if (fd != EVUTIL_INVALID_SOCKET) {
+        // Same as the listeners, so a socket in TIME_WAIT does not count
+        available = evutil_make_listen_socket_reuseable(fd) == 0 &&
+                    bind(fd, aitop->ai_addr, aitop->ai_addrlen) == 0;
+        evutil_closesocket(fd);
+    }
+    evutil_freeaddrinfo(aitop);
+    return available;
+#else
+    return false;
+#endif
+}
+
+/**
+ * Bind a listening socket with SO_REUSEPORT set, so that several event loops
+ * can listen on the same address and the kernel balances the incoming
+ * connections between them. HTTPProbeBindAddress() should be called first.
+ */
+static evhttp_bound_socket *HTTPBindReusePort(struct event_base *base,
+                                              struct evhttp *http,
+                                              const std::string &host,
+                                              uint16_t port) {
+#ifdef LEV_OPT_REUSEABLE_PORT
+    struct evutil_addrinfo *aitop = HTTPResolveBindAddress(host, port);
+    if (!aitop) {
+        return nullptr;
+    }
+    struct evconnlistener *listener = evconnlistener_new_bind(
+        base, nullptr, nullptr,
+        LEV_OPT_CLOSE_ON_FREE | LEV_OPT_CLOSE_ON_EXEC | LEV_OPT_REUSEABLE |
+            LEV_OPT_REUSEABLE_PORT,
+        -1, aitop->ai_addr, aitop->ai_addrlen);
+    evutil_freeaddrinfo(aitop);
+    if (!listener) {
+        return nullptr;
+    }
+    evhttp_bound_socket *bind_handle = evhttp_bind_listener(http, listener);
+    if (!bind_handle) {
+        evconnlistener_free(listener);
+    }
+    return bind_handle;
+#else
+    return nullptr;
+#endif
+}
+
+/** Bind the HTTP servers of all event loops to specified addresses */
+static bool HTTPBindAddresses() {
     uint16_t http_port{static_cast<uint16_t>(
         gArgs.GetIntArg("-rpcport", BaseParams().RPCPort()))};
     std::vector<std::pair<std::string, uint16_t>> endpoints;
@@ -336,27 +530,56 @@ static bool HTTPBindAddresses(struct evhttp *http) {
     }
 
     // Bind addresses
+    bool bound = false;
     for (std::vector<std::pair<std::string, uint16_t>>::iterator i =
              endpoints.begin();
          i != endpoints.end(); ++i) {
         LogPrint(BCLog::HTTP, "Binding RPC on address %s port %i\n", i->first,
                  i->second);
-        evhttp_bound_socket *bind_handle = evhttp_bind_socket_with_handle(
-            http, i->first.empty() ? nullptr : i->first.c_str(), i->second);
-        if (bind_handle) {
-            CNetAddr addr;
-            if (i->first.empty() ||
-                (LookupHost(i->first, addr, false) && addr.IsBindAny())) {
-                LogPrintf("WARNING: the RPC server is not safe to expose to "
-                          "untrusted networks such as the public internet\n");
-            }
-            boundSockets.push_back(bind_handle);
-        } else {
+        if (eventLoops.size() > 1 &&
+            !HTTPProbeBindAddress(i->first, i->second)) {
             LogPrintf("Binding RPC on address %s port %i failed.\n", i->first,
                       i->second);
+            continue;
+        }
+        for (size_t loop_num = 0; loop_num < eventLoops.size(); ++loop_num) {
+            HTTPEventLoop &loop = eventLoops[loop_num];
+            // With a single event loop there is no need to share the address,
+            // so keep using the plain libevent binding.
+            evhttp_bound_socket *bind_handle =
+                eventLoops.size() == 1
+                    ? evhttp_bind_socket_with_handle(
+                          loop.http,
+                          i->first.empty() ? nullptr : i->first.c_str(),
+                          i->second)
+                    : HTTPBindReusePort(loop.base, loop.http, i->first,
+                                        i->second);
+            if (!bind_handle) {
+                if (loop_num == 0) {
+                    LogPrintf("Binding RPC on address %s port %i failed.\n",
+                              i->first, i->second);
+                    break;
+                }
+                LogPrintf("Binding RPC on address %s port %i failed for "
+                          "event loop %d, connections to this address will "
+                          "be served by %d event loops.\n",
+                          i->first, i->second, loop_num, loop_num);
+                break;
+            }
+            if (loop_num == 0) {
+                CNetAddr addr;
+                if (i->first.empty() ||
+                    (LookupHost(i->first, addr, false) && addr.IsBindAny())) {
+                    LogPrintf(
+                        "WARNING: the RPC server is not safe to expose to "
+                        "untrusted networks such as the public internet\n");
+                }
+                bound = true;
+            }
+            loop.boundSockets.push_back(bind_handle);
         }
     }
-    return !boundSockets.empty();
+    return bound;
 }
 
 /** Simple wrapper to set thread name and run work queue */
@@ -400,31 +623,54 @@ bool InitHTTPServer(Config &config) {
     evthread_use_pthreads();
 #endif
 
-    raii_event_base base_ctr = obtain_event_base();
-
-    /* Create a new evhttp object to handle requests. */
-    raii_evhttp http_ctr = obtain_evhttp(base_ctr.get());
-    struct evhttp *http = http_ctr.get();
-    if (!http) {
-        LogPrintf("couldn't create evhttp. Exiting.\n");
-        return false;
+    int eventThreads = std::max(
+        (long)gArgs.GetIntArg("-rpceventthreads", DEFAULT_HTTP_EVENT_THREADS),
+        1L);
+#ifndef LEV_OPT_REUSEABLE_PORT
+    if (eventThreads > 1) {
+        LogPrintf("HTTP: libevent doesn't support SO_REUSEPORT listeners, "
+                  "using a single event thread\n");
+        eventThreads = 1;
     }
+#endif
 
-    evhttp_set_timeout(http, gArgs.GetIntArg("-rpcservertimeout",
-                                             DEFAULT_HTTP_SERVER_TIMEOUT));
-    evhttp_set_max_headers_size(http, MAX_HEADERS_SIZE);
-    evhttp_set_max_body_size(http, MIN_SUPPORTED_BODY_SIZE +
-                                       2 * config.GetMaxBlockSize());
-    evhttp_set_gencb(http, http_request_cb, &config);
+    // The evhttp objects are declared last so they are freed before their
+    // event base in case of failure.
+    std::vector<raii_event_base> base_ctrs;
+    std::vector<raii_evhttp> http_ctrs;
+    for (int i = 0; i < eventThreads; i++) {
+        raii_event_base base_ctr = obtain_event_base();
+
+        /* Create a new evhttp object to handle requests. */
+        raii_evhttp http_ctr = obtain_evhttp(base_ctr.get());
+        struct evhttp *http = http_ctr.get();
+        if (!http) {
+            LogPrintf("couldn't create evhttp. Exiting.\n");
+            eventLoops.clear();
+            return false;
+        }
 
-    // Only POST and OPTIONS are supported, but we return HTTP 405 for the
-    // others
-    evhttp_set_allowed_methods(
-        http, EVHTTP_REQ_GET | EVHTTP_REQ_POST | EVHTTP_REQ_HEAD |
-                  EVHTTP_REQ_PUT | EVHTTP_REQ_DELETE | EVHTTP_REQ_OPTIONS);
+        evhttp_set_timeout(http, gArgs.GetIntArg("-rpcservertimeout",
+                                                 DEFAULT_HTTP_SERVER_TIMEOUT));
+        evhttp_set_max_headers_size(http, MAX_HEADERS_SIZE);
+        evhttp_set_max_body_size(http, MIN_SUPPORTED_BODY_SIZE +
+                                           2 * config.GetMaxBlockSize());
+        evhttp_set_gencb(http, http_request_cb, &config);
+
+        // Only POST and OPTIONS are supported, but we return HTTP 405 for the
+        // others
+        evhttp_set_allowed_methods(
+            http, EVHTTP_REQ_GET | EVHTTP_REQ_POST | EVHTTP_REQ_HEAD |
+                      EVHTTP_REQ_PUT | EVHTTP_REQ_DELETE | EVHTTP_REQ_OPTIONS);
+
+        eventLoops.emplace_back(base_ctr.get(), http);
+        base_ctrs.push_back(std::move(base_ctr));
+        http_ctrs.push_back(std::move(http_ctr));
+    }
 
-    if (!HTTPBindAddresses(http)) {
+    if (!HTTPBindAddresses()) {
         LogPrintf("Unable to bind any endpoint for RPC server\n");
+        eventLoops.clear();
         return false;
     }
 
@@ -434,9 +680,13 @@ bool InitHTTPServer(Config &config) {
     LogPrintf("HTTP: creating work queue of depth %d\n", workQueueDepth);
 
     workQueue = new WorkQueue<HTTPClosure>(workQueueDepth);
-    // transfer ownership to eventBase/HTTP via .release()
-    eventBase = base_ctr.release();
-    eventHTTP = http_ctr.release();
+    // transfer ownership to eventLoops via .release()
+    for (auto &http_ctr : http_ctrs) {
+        http_ctr.release();
+    }
+    for (auto &base_ctr : base_ctrs) {
+        base_ctr.release();
+    }
     return true;
 }
 
@@ -454,15 +704,17 @@ bool UpdateHTTPServerLogging(bool enable) {
 #endif
 }
 
-static std::thread g_thread_http;
 static std::vector<std::thread> g_thread_http_workers;
 
 void StartHTTPServer() {
     LogPrint(BCLog::HTTP, "Starting HTTP server\n");
     int rpcThreads = std::max(
         (long)gArgs.GetIntArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
-    LogPrintf("HTTP: starting %d worker threads\n", rpcThreads);
-    g_thread_http = std::thread(ThreadHTTP, eventBase);
+    LogPrintf("HTTP: starting %d event threads and %d worker threads\n",
+              eventLoops.size(), rpcThreads);
+    for (size_t i = 0; i < eventLoops.size(); i++) {
+        eventLoops[i].thread = std::thread(ThreadHTTP, eventLoops[i].base, i);
+    }
 
     for (int i = 0; i < rpcThreads; i++) {
         g_thread_http_workers.emplace_back(HTTPWorkQueueRun, workQueue, i);
@@ -471,9 +723,9 @@ void StartHTTPServer() {
 
 void InterruptHTTPServer() {
     LogPrint(BCLog::HTTP, "Interrupting HTTP server\n");
-    if (eventHTTP) {
+    for (HTTPEventLoop &loop : eventLoops) {
         // Reject requests on current connections
-        evhttp_set_gencb(eventHTTP, http_reject_request_cb, nullptr);
+        evhttp_set_gencb(loop.http, http_reject_request_cb, nullptr);
     }
     if (workQueue) {
         workQueue->Interrupt();
@@ -491,31 +743,31 @@ void StopHTTPServer() {
         delete workQueue;
         workQueue = nullptr;
     }
-    // Unlisten sockets, these are what make the event loop running, which means
-    // that after this and all connections are closed the event loop will quit.
-    for (evhttp_bound_socket *socket : boundSockets) {
-        evhttp_del_accept_socket(eventHTTP, socket);
-    }
-    boundSockets.clear();
-    if (eventBase) {
-        LogPrint(BCLog::HTTP, "Waiting for HTTP event thread to exit\n");
-        if (g_thread_http.joinable()) {
-            g_thread_http.join();
+    // Unlisten sockets, these are what make the event loops running, which
+    // means that after this and all connections are closed the event loops
+    // will quit.
+    for (HTTPEventLoop &loop : eventLoops) {
+        for (evhttp_bound_socket *socket : loop.boundSockets) {
+            evhttp_del_accept_socket(loop.http, socket);
         }
+        loop.boundSockets.clear();
     }
-    if (eventHTTP) {
-        evhttp_free(eventHTTP);
-        eventHTTP = nullptr;
+    if (!eventLoops.empty()) {
+        LogPrint(BCLog::HTTP, "Waiting for HTTP event threads to exit\n");
     }
-    if (eventBase) {
-        event_base_free(eventBase);
-        eventBase = nullptr;
+    for (HTTPEventLoop &loop : eventLoops) {
+        if (loop.thread.joinable()) {
+            loop.thread.join();
+        }
+        evhttp_free(loop.http);
+        event_base_free(loop.base);
     }
+    eventLoops.clear();
     LogPrint(BCLog::HTTP, "Stopped HTTP server\n");
 }
 
 struct event_base *EventBase() {
-    return eventBase;
+    return eventLoops.empty() ? nullptr : eventLoops.front().base;
 }
 
 static void httpevent_callback_fn(evutil_socket_t, short, void *data) {
@@ -546,8 +798,17 @@ void HTTPEvent::trigger(struct timeval *tv) {
     }
 }
 HTTPRequest::HTTPRequest(struct evhttp_request *_req, bool _replySent)
-    : req(_req), replySent(_replySent) {}
+    : req(_req), replySent(_replySent) {
+    // Replies must be sent from the event loop the connection belongs to.
+    evhttp_connection *conn = evhttp_request_get_connection(req);
+    base = conn ? evhttp_connection_get_base(conn) : EventBase();
+}
 HTTPRequest::~HTTPRequest() {
+    if (replyStarted && !replySent) {
+        // The body is truncated, don't let the client think it is complete
+        LogPrintf("%s: Unterminated reply\n", __func__);
+        AbortReply();
+    }
     if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
@@ -599,42 +860,190 @@ void HTTPRequest::WriteHeader(const std::string &hdr,
     evhttp_add_header(headers, hdr.c_str(), value.c_str());
 }
 
+/**
+ * Re-enable reading from the socket once a reply has been sent. This is the
+ * second part of the libevent workaround in http_request_cb.
+ */
+static void ReenableReading(evhttp_connection *conn) {
+    if (event_get_version_number() >= 0x02010600 &&
+        event_get_version_number() < 0x02020001) {
+        if (conn) {
+            bufferevent *bev = evhttp_connection_get_bufferevent(conn);
+            if (bev) {
+                bufferevent_enable(bev, EV_READ | EV_WRITE);
+            }
+        }
+    }
+}
+
 /**
  * Closure sent to main thread to request a reply to be sent to a HTTP request.
  * Replies must be sent in the main loop in the main http thread, this cannot be
  * done from worker threads.
  */
-void HTTPRequest::WriteReply(int nStatus, const std::string &strReply) {
-    assert(!replySent && req);
-    if (ShutdownRequested()) {
-        WriteHeader("Connection", "close");
+void HTTPRequest::WriteReply(int nStatus, std::string strReply) {
+    assert(!replySent && !replyStarted && req);
+    // Send event to the connection's http thread to send reply message
+    struct evbuffer *evb = evhttp_request_get_output_buffer(req);
+    assert(evb);
+    if (!strReply.empty()) {
+        // Hand the reply body over to the evbuffer without copying it, the
+        // string is freed once libevent is done sending it.
+        std::string *body = new std::string(std::move(strReply));
+        evbuffer_add_reference(
+            evb, body->data(), body->size(),
+            [](const void *, size_t, void *extra) {
+                delete static_cast<std::string *>(extra);
+            },
+            body);
     }
-    // Send event to main http thread to send reply message
+    SendReply(nStatus);
+}
+
+void HTTPRequest::WriteReply(int nStatus,
+                             std::shared_ptr<const std::vector<uint8_t>> body) {
+    assert(!replySent && !replyStarted && req);
     struct evbuffer *evb = evhttp_request_get_output_buffer(req);
     assert(evb);
-    evbuffer_add(evb, strReply.data(), strReply.size());
+    if (body && !body->empty()) {
+        // The evbuffer holds a reference to the body until it is sent
+        auto *ref = new std::shared_ptr<const std::vector<uint8_t>>(
+            std::move(body));
+        evbuffer_add_reference(
+            evb, (*ref)->data(), (*ref)->size(),
+            [](const void *, size_t, void *extra) {
+                delete static_cast<
+                    std::shared_ptr<const std::vector<uint8_t>> *>(extra);
+            },
+            ref);
+    }
+    SendReply(nStatus);
+}
+
+void HTTPRequest::SendReply(int nStatus) {
+    if (ShutdownRequested()) {
+        WriteHeader("Connection", "close");
+    }
     auto req_copy = req;
-    HTTPEvent *ev = new HTTPEvent(eventBase, true, [req_copy, nStatus] {
+    HTTPEvent *ev = new HTTPEvent(base, true, [req_copy, nStatus] {
         evhttp_send_reply(req_copy, nStatus, nullptr, nullptr);
-        // Re-enable reading from the socket. This is the second part of the
-        // libevent workaround above.
-        if (event_get_version_number() >= 0x02010600 &&
-            event_get_version_number() < 0x02020001) {
-            evhttp_connection *conn = evhttp_request_get_connection(req_copy);
-            if (conn) {
-                bufferevent *bev = evhttp_connection_get_bufferevent(conn);
-                if (bev) {
-                    bufferevent_enable(bev, EV_READ | EV_WRITE);
-                }
-            }
+        ReenableReading(evhttp_request_get_connection(req_copy));
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    // transferred back to main thread.
+    req = nullptr;
+}
+
+/**
+ * Bytes of the chunks of a reply handed over to libevent. They are released
+ * once libevent is done with a chunk, i.e. when it has been written to the
+ * socket or dropped with the connection.
+ */
+struct HTTPRequest::ChunksInFlight {
+    Mutex cs;
+    std::condition_variable cond;
+    size_t bytes GUARDED_BY(cs){0};
+};
+
+/** Body of a reply chunk, which releases its bytes when libevent frees it */
+struct HTTPRequest::ReplyChunk {
+    std::string data;
+    std::shared_ptr<ChunksInFlight> inFlight;
+
+    ~ReplyChunk() {
+        LOCK(inFlight->cs);
+        inFlight->bytes -= data.size();
+        inFlight->cond.notify_all();
+    }
+};
+
+void HTTPRequest::StartReply(int nStatus) {
+    assert(!replySent && !replyStarted && req);
+    chunksInFlight = std::make_shared<ChunksInFlight>();
+    if (ShutdownRequested()) {
+        WriteHeader("Connection", "close");
+    }
+    auto req_copy = req;
+    HTTPEvent *ev = new HTTPEvent(base, true, [req_copy, nStatus] {
+        evhttp_send_reply_start(req_copy, nStatus, nullptr);
+    });
+    ev->trigger(nullptr);
+    replyStarted = true;
+}
+
+void HTTPRequest::WriteReplyChunk(std::string chunk) {
+    assert(replyStarted && req);
+    if (chunk.empty()) {
+        // An empty chunk would terminate the reply
+        return;
+    }
+    {
+        // Let the connection catch up. A stalled client can't hold this
+        // forever: the connection is closed after -rpcservertimeout without
+        // progress, which releases its chunks.
+        WAIT_LOCK(chunksInFlight->cs, lock);
+        chunksInFlight->cond.wait(
+            lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(chunksInFlight->cs) {
+                return chunksInFlight->bytes < MAX_REPLY_BYTES_IN_FLIGHT;
+            });
+        chunksInFlight->bytes += chunk.size();
+    }
+    auto req_copy = req;
+    auto *body = new ReplyChunk{std::move(chunk), chunksInFlight};
+    // Events are processed in the order they are triggered, so the chunks are
+    // sent in order.
+    HTTPEvent *ev = new HTTPEvent(base, true, [req_copy, body] {
+        struct evbuffer *evb = evbuffer_new();
+        if (evb) {
+            // The chunk is moved to the output buffer of the connection
+            // without copying it, and freed once it has been written.
+            evbuffer_add_reference(
+                evb, body->data.data(), body->data.size(),
+                [](const void *, size_t, void *extra) {
+                    delete static_cast<ReplyChunk *>(extra);
+                },
+                body);
+            evhttp_send_reply_chunk(req_copy, evb);
+            evbuffer_free(evb);
+        } else {
+            delete body;
         }
     });
     ev->trigger(nullptr);
+}
+
+void HTTPRequest::EndReply() {
+    assert(replyStarted && req);
+    auto req_copy = req;
+    HTTPEvent *ev = new HTTPEvent(base, true, [req_copy] {
+        // The connection has to be retrieved before the request is possibly
+        // freed by evhttp_send_reply_end().
+        evhttp_connection *conn = evhttp_request_get_connection(req_copy);
+        evhttp_send_reply_end(req_copy);
+        ReenableReading(conn);
+    });
+    ev->trigger(nullptr);
     replySent = true;
     // transferred back to main thread.
     req = nullptr;
 }
 
+void HTTPRequest::AbortReply() {
+    assert(replyStarted && req);
+    auto req_copy = req;
+    HTTPEvent *ev = new HTTPEvent(base, true, [req_copy] {
+        // Freeing the connection also frees the request
+        evhttp_connection *conn = evhttp_request_get_connection(req_copy);
+        if (conn) {
+            evhttp_connection_free(conn);
+        }
+    });
+    ev->trigger(nullptr);
+    replySent = true;
+    req = nullptr;
+}
+
 CService HTTPRequest::GetPeer() const {
     evhttp_connection *con = evhttp_request_get_connection(req);
     CService peer;
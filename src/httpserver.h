@@ -6,10 +6,14 @@
 #ifndef BITCOIN_HTTPSERVER_H
 #define BITCOIN_HTTPSERVER_H
 
+#include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
+#include <vector>
 
 static const int DEFAULT_HTTP_THREADS = 4;
+static const int DEFAULT_HTTP_EVENT_THREADS = 1;
 static const int DEFAULT_HTTP_WORKQUEUE = 16;
 static const int DEFAULT_HTTP_SERVER_TIMEOUT = 30;
 
@@ -74,7 +78,18 @@ struct event_base *EventBase();
 class HTTPRequest {
 private:
     struct evhttp_request *req;
+    //! Event loop of the connection this request was received on
+    struct event_base *base;
     bool replySent;
+    bool replyStarted{false};
+
+    struct ChunksInFlight;
+    struct ReplyChunk;
+    //! Chunks of a started reply not yet written to the connection
+    std::shared_ptr<ChunksInFlight> chunksInFlight;
+
+    /** Send the reply once its body is in the output buffer */
+    void SendReply(int nStatus);
 
 public:
     explicit HTTPRequest(struct evhttp_request *req, bool replySent = false);
@@ -116,13 +131,56 @@ public:
      * Write HTTP reply.
      * nStatus is the HTTP status code to send.
      * strReply is the body of the reply. Keep it empty to send a standard
-     * message.
+     * message. Move large replies in to avoid copying them.
      *
      * @note Can be called only once. As this will give the request back to the
      * main thread, do not call any other HTTPRequest methods after calling
      * this.
      */
-    void WriteReply(int nStatus, const std::string &strReply = "");
+    void WriteReply(int nStatus, std::string strReply = "");
+    /**
+     * Write HTTP reply with a shared body, which is sent without copying it
+     * and kept alive until libevent is done with it.
+     */
+    void WriteReply(int nStatus,
+                    std::shared_ptr<const std::vector<uint8_t>> body);
+
+    /**
+     * Start a chunked HTTP reply, for replies which are produced
+     * incrementally. The body is then sent with WriteReplyChunk() and the
+     * reply is completed with EndReply().
+     *
+     * @note Headers must be written before calling this.
+     */
+    void StartReply(int nStatus);
+
+    /**
+     * Send the next part of the body of a reply started with StartReply().
+     *
+     * This blocks while too much of the body is waiting to be written to the
+     * connection, so a reply produced faster than the client reads it is not
+     * buffered in memory as a whole.
+     */
+    void WriteReplyChunk(std::string chunk);
+
+    /**
+     * Complete a reply started with StartReply().
+     *
+     * @note Like WriteReply(), do not call any other HTTPRequest methods after
+     * calling this.
+     */
+    void EndReply();
+
+    /**
+     * Give up on a reply started with StartReply(), when its body can't be
+     * completed. The connection is closed without sending the terminating
+     * chunk, so the client sees a transport error rather than a complete
+     * reply with a truncated body.
+     *
+     * @note Like WriteReply(), do not call any other HTTPRequest methods after
+     * calling this.
+     */
+    void AbortReply();
 };
 
 /** Event handler closure */
@@ -18,12 +18,16 @@
 #include <validation.h> // For Chainstate
 #include <warnings.h>
 
+#include <algorithm>
 #include <functional>
+#include <vector>
 
 constexpr uint8_t DB_BEST_BLOCK{'B'};
 
 constexpr int64_t SYNC_LOG_INTERVAL = 30;           // secon
 constexpr int64_t SYNC_LOCATOR_WRITE_INTERVAL = 30; // seconds
+//! Maximum number of transactions in the blocks read at once while syncing
+constexpr unsigned int MAX_SYNC_BATCH_TXS = 100000;
 
 template <typename... Args>
 static void FatalError(const char *fmt, const Args &...args) {
@@ -34,16 +38,17 @@ static void FatalError(const char *fmt, const Args &...args) {
     StartShutdown();
 }
 
-BaseIndex::DB::DB(const fs::path &path, size_t n_cache_size, bool f_memory,
-                  bool f_wipe, bool f_obfuscate)
+BaseIndex::DB::DB(const fs::path &path, const std::string &db_name,
+                  size_t n_cache_size, bool f_memory, bool f_wipe,
+                  bool f_obfuscate)
     : CDBWrapper{DBParams{.path = path,
                           .cache_bytes = n_cache_size,
                           .memory_only = f_memory,
                           .wipe_data = f_wipe,
                           .obfuscate = f_obfuscate,
-                          .options = [] {
+                          .options = [&db_name] {
                               DBOptions options;
-                              node::ReadDatabaseArgs(gArgs, options);
+                              node::ReadDatabaseArgs(gArgs, options, db_name);
                               return options;
                           }()}} {}
 
@@ -146,6 +151,8 @@ void BaseIndex::ThreadSync() {
     if (!m_synced) {
         int64_t last_log_time = 0;
         int64_t last_locator_write_time = 0;
+        const size_t batch_size{std::max<size_t>(SyncBatchSize(), 1)};
+        std::vector<const CBlockIndex *> batch;
         while (true) {
             if (m_interrupt) {
                 SetBestBlockIndex(pindex);
@@ -176,6 +183,21 @@ void BaseIndex::ThreadSync() {
                     return;
                 }
                 pindex = pindex_next;
+
+                // Add the next blocks of the active chain to the batch, as
+                // long as their transactions don't take too much memory.
+                batch.assign(1, pindex);
+                unsigned int batch_txs{pindex->nTx};
+                while (batch.size() < batch_size) {
+                    const CBlockIndex *pindex_batch{
+                        m_chainstate->m_chain.Next(batch.back())};
+                    if (!pindex_batch ||
+                        batch_txs + pindex_batch->nTx > MAX_SYNC_BATCH_TXS) {
+                        break;
+                    }
+                    batch.push_back(pindex_batch);
+                    batch_txs += pindex_batch->nTx;
+                }
             }
 
             int64_t current_time = GetTime();
@@ -193,17 +215,23 @@ void BaseIndex::ThreadSync() {
                 Commit();
             }
 
-            CBlock block;
-            if (!m_chainstate->m_blockman.ReadBlockFromDisk(block, *pindex)) {
-                FatalError("%s: Failed to read block %s from disk", __func__,
-                           pindex->GetBlockHash().ToString());
-                return;
+            std::vector<CBlock> blocks(batch.size());
+            for (size_t i = 0; i < batch.size(); i++) {
+                if (!m_chainstate->m_blockman.ReadBlockFromDisk(blocks[i],
+                                                                *batch[i])) {
+                    FatalError("%s: Failed to read block %s from disk",
+                               __func__, batch[i]->GetBlockHash().ToString());
+                    return;
+                }
             }
-            if (!WriteBlock(block, pindex)) {
-                FatalError("%s: Failed to write block %s to index database",
-                           __func__, pindex->GetBlockHash().ToString());
+            if (!WriteBlocks(blocks, batch)) {
+                FatalError("%s: Failed to write blocks %s to %s to index "
+                           "database",
+                           __func__, batch.front()->GetBlockHash().ToString(),
+                           batch.back()->GetBlockHash().ToString());
                 return;
             }
+            pindex = batch.back();
         }
     }
 
@@ -214,6 +242,17 @@ void BaseIndex::ThreadSync() {
     }
 }
 
+bool BaseIndex::WriteBlocks(const std::vector<CBlock> &blocks,
+                            const std::vector<const CBlockIndex *> &pindexes) {
+    assert(blocks.size() == pindexes.size());
+    for (size_t i = 0; i < blocks.size(); i++) {
+        if (!WriteBlock(blocks[i], pindexes[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
 bool BaseIndex::Commit() {
     CDBBatch batch(GetDB());
     if (!CommitInternal(batch) || !GetDB().WriteBatch(batch)) {
@@ -9,6 +9,9 @@
 #include <threadinterrupt.h>
 #include <validationinterface.h>
 
+#include <string>
+#include <vector>
+
 class CBlock;
 class CBlockIndex;
 class Chainstate;
@@ -35,8 +38,13 @@ protected:
      */
     class DB : public CDBWrapper {
     public:
-        DB(const fs::path &path, size_t n_cache_size, bool f_memory = false,
-           bool f_wipe = false, bool f_obfuscate = false);
+        /**
+         * db_name selects the options of the database in the -dbprofile
+         * arguments, see node::ReadDatabaseArgs().
+         */
+        DB(const fs::path &path, const std::string &db_name,
+           size_t n_cache_size, bool f_memory = false, bool f_wipe = false,
+           bool f_obfuscate = false);
 
         /// Read block locator of the chain that the index is in sync with.
         bool ReadBestBlock(CBlockLocator &locator) const;
@@ -96,6 +104,17 @@ protected:
         return true;
     }
 
+    /// Maximum number of consecutive blocks passed at once to WriteBlocks
+    /// while syncing.
+    virtual size_t SyncBatchSize() const { return 1; }
+
+    /// Write update index entries for consecutive blocks of the active chain
+    /// while syncing, the first one being the successor of the best block.
+    /// Calls WriteBlock for each block by default, can be overridden to
+    /// process the blocks in parallel.
+    virtual bool WriteBlocks(const std::vector<CBlock> &blocks,
+                             const std::vector<const CBlockIndex *> &pindexes);
+
     /// Virtual method called internally by Commit that can be overridden to
     /// atomically commit more index state.
     virtual bool CommitInternal(CDBBatch &batch);
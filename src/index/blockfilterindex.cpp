@@ -3,13 +3,16 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <common/args.h>
+#include <common/system.h>
 #include <dbwrapper.h>
 #include <index/blockfilterindex.h>
 #include <node/blockstorage.h>
 #include <primitives/blockhash.h>
 #include <util/fs_helpers.h>
+#include <util/parallel.h>
 #include <validation.h>
 
+#include <algorithm>
 #include <map>
 
 /**
@@ -50,6 +53,18 @@ constexpr unsigned int FLTR_FILE_CHUNK_SIZE = 0x100000;
  */
 constexpr size_t CF_HEADERS_CACHE_MAX_SZ{2000};
 
+/** Maximum number of decoded filters kept in memory for matching. */
+constexpr size_t DECODED_FILTER_CACHE_SIZE{200};
+
+/**
+ * Maximum number of blocks remembered as matched once, so their filter is
+ * decoded and cached when they are matched again.
+ */
+constexpr size_t MATCHED_ONCE_SIZE{1000};
+
+/** Maximum number of filters built in parallel while syncing. */
+constexpr int MAX_SYNC_THREADS{8};
+
 namespace {
 
 struct DBVal {
@@ -116,8 +131,8 @@ BlockFilterIndex::BlockFilterIndex(BlockFilterType filter_type,
     fs::create_directories(path);
 
     m_name = filter_name + " block filter index";
-    m_db = std::make_unique<BaseIndex::DB>(path / "db", n_cache_size, f_memory,
-                                           f_wipe);
+    m_db = std::make_unique<BaseIndex::DB>(path / "db", "blockfilterindex",
+                                           n_cache_size, f_memory, f_wipe);
     m_filter_fileseq = std::make_unique<FlatFileSeq>(std::move(path), "fltr",
                                                      FLTR_FILE_CHUNK_SIZE);
 }
@@ -159,7 +174,8 @@ bool BlockFilterIndex::CommitInternal(CDBBatch &batch) {
 }
 
 bool BlockFilterIndex::ReadFilterFromDisk(const FlatFilePos &pos,
-                                          BlockFilter &filter) const {
+                                          BlockFilter &filter,
+                                          bool skip_decode_check) const {
     AutoFile filein{m_filter_fileseq->Open(pos, true)};
     if (filein.IsNull()) {
         return false;
@@ -169,8 +185,8 @@ bool BlockFilterIndex::ReadFilterFromDisk(const FlatFilePos &pos,
     std::vector<uint8_t> encoded_filter;
     try {
         filein >> block_hash >> encoded_filter;
-        filter =
-            BlockFilter(GetFilterType(), block_hash, std::move(encoded_filter));
+        filter = BlockFilter(GetFilterType(), block_hash,
+                             std::move(encoded_filter), skip_decode_check);
     } catch (const std::exception &e) {
         return error("%s: Failed to deserialize block filter from disk: %s",
                      __func__, e.what());
@@ -229,34 +245,45 @@ size_t BlockFilterIndex::WriteFilterToDisk(FlatFilePos &pos,
     return data_size;
 }
 
-bool BlockFilterIndex::WriteBlock(const CBlock &block,
-                                  const CBlockIndex *pindex) {
+bool BlockFilterIndex::BuildFilter(const CBlock &block,
+                                   const CBlockIndex *pindex,
+                                   BlockFilter &filter) const {
     CBlockUndo block_undo;
-    uint256 prev_header;
-
-    if (pindex->nHeight > 0) {
-        if (!m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *pindex)) {
-            return false;
-        }
+    if (pindex->nHeight > 0 &&
+        !m_chainstate->m_blockman.UndoReadFromDisk(block_undo, *pindex)) {
+        return false;
+    }
+    filter = BlockFilter(m_filter_type, block, block_undo);
+    return true;
+}
 
-        std::pair<BlockHash, DBVal> read_out;
-        if (!m_db->Read(DBHeightKey(pindex->nHeight - 1), read_out)) {
-            return false;
-        }
+bool BlockFilterIndex::ReadPrevFilterHeader(const CBlockIndex *pindex,
+                                            uint256 &prev_header) const {
+    if (pindex->nHeight == 0) {
+        prev_header.SetNull();
+        return true;
+    }
 
-        BlockHash expected_block_hash = pindex->pprev->GetBlockHash();
-        if (read_out.first != expected_block_hash) {
-            return error("%s: previous block header belongs to unexpected "
-                         "block %s; expected %s",
-                         __func__, read_out.first.ToString(),
-                         expected_block_hash.ToString());
-        }
+    std::pair<BlockHash, DBVal> read_out;
+    if (!m_db->Read(DBHeightKey(pindex->nHeight - 1), read_out)) {
+        return false;
+    }
 
-        prev_header = read_out.second.header;
+    BlockHash expected_block_hash = pindex->pprev->GetBlockHash();
+    if (read_out.first != expected_block_hash) {
+        return error("%s: previous block header belongs to unexpected "
+                     "block %s; expected %s",
+                     __func__, read_out.first.ToString(),
+                     expected_block_hash.ToString());
     }
 
-    BlockFilter filter(m_filter_type, block, block_undo);
+    prev_header = read_out.second.header;
+    return true;
+}
 
+bool BlockFilterIndex::WriteFilter(const BlockFilter &filter,
+                                   const CBlockIndex *pindex,
+                                   uint256 &header) {
     size_t bytes_written = WriteFilterToDisk(m_next_filter_pos, filter);
     if (bytes_written == 0) {
         return false;
@@ -265,7 +292,7 @@ bool BlockFilterIndex::WriteBlock(const CBlock &block,
     std::pair<BlockHash, DBVal> value;
     value.first = pindex->GetBlockHash();
     value.second.hash = filter.GetHash();
-    value.second.header = filter.ComputeHeader(prev_header);
+    value.second.header = filter.ComputeHeader(header);
     value.second.pos = m_next_filter_pos;
 
     if (!m_db->Write(DBHeightKey(pindex->nHeight), value)) {
@@ -273,6 +300,48 @@ bool BlockFilterIndex::WriteBlock(const CBlock &block,
     }
 
     m_next_filter_pos.nPos += bytes_written;
+    header = value.second.header;
+    return true;
+}
+
+bool BlockFilterIndex::WriteBlock(const CBlock &block,
+                                  const CBlockIndex *pindex) {
+    uint256 header;
+    BlockFilter filter;
+    return ReadPrevFilterHeader(pindex, header) &&
+           BuildFilter(block, pindex, filter) &&
+           WriteFilter(filter, pindex, header);
+}
+
+size_t BlockFilterIndex::SyncBatchSize() const {
+    return std::clamp(GetNumCores(), 1, MAX_SYNC_THREADS);
+}
+
+bool BlockFilterIndex::WriteBlocks(
+    const std::vector<CBlock> &blocks,
+    const std::vector<const CBlockIndex *> &pindexes) {
+    assert(blocks.size() == pindexes.size());
+
+    // Building the filters is independent for each block, but the headers
+    // chain, so they are written in order.
+    std::vector<BlockFilter> filters(blocks.size());
+    std::vector<uint8_t> built(blocks.size(), false);
+    util::g_worker_pool.ForRanges(
+        blocks.size(), blocks.size(), [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                built[i] = BuildFilter(blocks[i], pindexes[i], filters[i]);
+            }
+        });
+
+    uint256 header;
+    if (!ReadPrevFilterHeader(pindexes.front(), header)) {
+        return false;
+    }
+    for (size_t i = 0; i < blocks.size(); i++) {
+        if (!built[i] || !WriteFilter(filters[i], pindexes[i], header)) {
+            return false;
+        }
+    }
     return true;
 }
 
@@ -416,6 +485,72 @@ bool BlockFilterIndex::LookupFilter(const CBlockIndex *block_index,
     return ReadFilterFromDisk(entry.pos, filter_out);
 }
 
+std::optional<bool>
+BlockFilterIndex::MatchAny(const CBlockIndex *block_index,
+                           const GCSFilter::ElementSet &elements) const {
+    const BlockHash block_hash{block_index->GetBlockHash()};
+    DecodedFilterRef decoded;
+    bool matched_before{false};
+    {
+        LOCK(m_cs_decoded_cache);
+        auto it = m_decoded_cache_map.find(block_hash);
+        if (it != m_decoded_cache_map.end()) {
+            // Move the entry to the front of the list
+            m_decoded_cache.splice(m_decoded_cache.begin(), m_decoded_cache,
+                                   it->second);
+            decoded = it->second->second;
+        } else if (m_matched_once.erase(block_hash) == 0) {
+            // Forget them all rather than keeping an order, a rescan only
+            // matches each block once anyway.
+            if (m_matched_once.size() >= MATCHED_ONCE_SIZE) {
+                m_matched_once.clear();
+            }
+            m_matched_once.insert(block_hash);
+        } else {
+            matched_before = true;
+        }
+    }
+    if (decoded) {
+        return decoded->MatchAny(elements);
+    }
+
+    DBVal entry;
+    BlockFilter filter;
+    // The filter is only matched locally, so it is not decoded to check it is
+    // well formed beforehand. A malformed filter fails the match instead.
+    if (!LookupOne(*m_db, block_index, entry) ||
+        !ReadFilterFromDisk(entry.pos, filter, /*skip_decode_check=*/true)) {
+        return std::nullopt;
+    }
+    try {
+        // A block matched for the first time, e.g. by a one-off rescan, is
+        // matched straight from its encoding rather than decoded and cached,
+        // which would evict the filters that are matched repeatedly.
+        if (!matched_before) {
+            return filter.GetFilter().MatchAny(elements);
+        }
+        decoded = std::make_shared<const DecodedGCSFilter>(filter.GetFilter());
+    } catch (const std::exception &e) {
+        error("%s: Failed to decode block filter %s: %s", __func__,
+              block_hash.ToString(), e.what());
+        return std::nullopt;
+    }
+
+    {
+        LOCK(m_cs_decoded_cache);
+        if (m_decoded_cache_map.count(block_hash) == 0) {
+            m_decoded_cache.emplace_front(block_hash, decoded);
+            m_decoded_cache_map.emplace(block_hash, m_decoded_cache.begin());
+            if (m_decoded_cache.size() > DECODED_FILTER_CACHE_SIZE) {
+                m_decoded_cache_map.erase(m_decoded_cache.back().first);
+                m_decoded_cache.pop_back();
+            }
+        }
+    }
+
+    return decoded->MatchAny(elements);
+}
+
 bool BlockFilterIndex::LookupFilterHeader(const CBlockIndex *block_index,
                                           uint256 &header_out) {
     LOCK(m_cs_headers_cache);
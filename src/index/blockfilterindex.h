@@ -11,6 +11,13 @@
 #include <index/base.h>
 #include <util/hasher.h>
 
+#include <list>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 static const char *const DEFAULT_BLOCKFILTERINDEX = "0";
 
 /** Interval between compact filter checkpoints. See BIP 157. */
@@ -33,7 +40,12 @@ private:
     FlatFilePos m_next_filter_pos;
     std::unique_ptr<FlatFileSeq> m_filter_fileseq;
 
-    bool ReadFilterFromDisk(const FlatFilePos &pos, BlockFilter &filter) const;
+    /**
+     * Read a filter. Unless skip_decode_check is set, it is decoded to check
+     * it is well formed, as it may be served to peers.
+     */
+    bool ReadFilterFromDisk(const FlatFilePos &pos, BlockFilter &filter,
+                            bool skip_decode_check = false) const;
     size_t WriteFilterToDisk(FlatFilePos &pos, const BlockFilter &filter);
 
     Mutex m_cs_headers_cache;
@@ -44,8 +56,42 @@ private:
     std::unordered_map<BlockHash, uint256, FilterHeaderHasher>
         m_headers_cache GUARDED_BY(m_cs_headers_cache);
 
+    using DecodedFilterRef = std::shared_ptr<const DecodedGCSFilter>;
+
+    mutable Mutex m_cs_decoded_cache;
+    /**
+     * Decoded filters of the blocks matched recently, most recent first, so
+     * the wallets rescanning the same blocks don't decode them again.
+     */
+    mutable std::list<std::pair<BlockHash, DecodedFilterRef>>
+        m_decoded_cache GUARDED_BY(m_cs_decoded_cache);
+    mutable std::unordered_map<BlockHash, decltype(m_decoded_cache)::iterator,
+                               FilterHeaderHasher>
+        m_decoded_cache_map GUARDED_BY(m_cs_decoded_cache);
+    /**
+     * Blocks matched once recently, whose filter is only decoded and cached
+     * when they are matched again.
+     */
+    mutable std::unordered_set<BlockHash, FilterHeaderHasher>
+        m_matched_once GUARDED_BY(m_cs_decoded_cache);
+
     bool AllowPrune() const override { return true; }
 
+    /** Build the filter of a block, reading its undo data */
+    bool BuildFilter(const CBlock &block, const CBlockIndex *pindex,
+                     BlockFilter &filter) const;
+
+    /**
+     * Write the filter of the block. header is the filter header of the
+     * previous block, and is set to the header of this one.
+     */
+    bool WriteFilter(const BlockFilter &filter, const CBlockIndex *pindex,
+                     uint256 &header);
+
+    /** Read the filter header of the previous block of pindex */
+    bool ReadPrevFilterHeader(const CBlockIndex *pindex,
+                              uint256 &prev_header) const;
+
 protected:
     bool Init() override;
 
@@ -53,6 +99,12 @@ protected:
 
     bool WriteBlock(const CBlock &block, const CBlockIndex *pindex) override;
 
+    size_t SyncBatchSize() const override;
+
+    /** Build the filters of the blocks in parallel, then write them */
+    bool WriteBlocks(const std::vector<CBlock> &blocks,
+                     const std::vector<const CBlockIndex *> &pindexes) override;
+
     bool Rewind(const CBlockIndex *current_tip,
                 const CBlockIndex *new_tip) override;
 
@@ -71,6 +123,15 @@ public:
     bool LookupFilter(const CBlockIndex *block_index,
                       BlockFilter &filter_out) const;
 
+    /**
+     * Check whether any of the elements may be in the filter of the block,
+     * or std::nullopt if the filter is not found. The filters of the blocks
+     * matched repeatedly are kept decoded in memory.
+     */
+    std::optional<bool> MatchAny(const CBlockIndex *block_index,
+                                 const GCSFilter::ElementSet &elements) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_cs_decoded_cache);
+
     /** Get a single filter header by block. */
     bool LookupFilterHeader(const CBlockIndex *block_index, uint256 &header_out)
         EXCLUSIVE_LOCKS_REQUIRED(!m_cs_headers_cache);
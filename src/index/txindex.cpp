@@ -30,8 +30,8 @@ public:
 };
 
 TxIndex::DB::DB(size_t n_cache_size, bool f_memory, bool f_wipe)
-    : BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "txindex", n_cache_size,
-                    f_memory, f_wipe) {}
+    : BaseIndex::DB(gArgs.GetDataDirNet() / "indexes" / "txindex", "txindex",
+                    n_cache_size, f_memory, f_wipe) {}
 
 bool TxIndex::DB::ReadTxPos(const TxId &txid, CDiskTxPos &pos) const {
     return Read(std::make_pair(DB_TXINDEX, txid), pos);
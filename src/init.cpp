@@ -57,6 +57,7 @@
 #include <node/validation_cache_args.h>
 #include <policy/policy.h>
 #include <policy/settings.h>
+#include <rcu.h>
 #include <rpc/blockchain.h>
 #include <rpc/register.h>
 #include <rpc/server.h>
@@ -76,6 +77,7 @@
 #include <util/fs.h>
 #include <util/fs_helpers.h>
 #include <util/moneystr.h>
+#include <util/parallel.h>
 #include <util/string.h>
 #include <util/syserror.h>
 #include <util/thread.h>
@@ -113,6 +115,7 @@
 #include <thread>
 #include <vector>
 
+using kernel::DEFAULT_SERIALIZED_CACHE_SIZE;
 using kernel::DEFAULT_STOPAFTERBLOCKIMPORT;
 using kernel::DumpMempool;
 using kernel::ValidationCacheSizes;
@@ -272,10 +275,14 @@ void Shutdown(NodeContext &node) {
     if (node.scheduler) {
         node.scheduler->stop();
     }
+    if (node.validation_signals_scheduler) {
+        node.validation_signals_scheduler->stop();
+    }
     if (node.chainman && node.chainman->m_load_block.joinable()) {
         node.chainman->m_load_block.join();
     }
     StopScriptCheckWorkerThreads();
+    util::g_worker_pool.StopWorkerThreads();
 
     // After the threads that potentially access these pointers have been
     // stopped, destruct and reset all to nullptr.
@@ -357,7 +364,9 @@ void Shutdown(NodeContext &node) {
     init::UnsetGlobals();
     node.mempool.reset();
     node.chainman.reset();
+    node.validation_signals_scheduler.reset();
     node.scheduler.reset();
+    RCULock::stopReclaimer();
 
     try {
         if (!fs::remove(GetPidFile(*node.args))) {
@@ -370,6 +379,8 @@ void Shutdown(NodeContext &node) {
     }
 
     LogPrintf("%s: done\n", __func__);
+    // Write the remaining lines before exiting, in case of -logasync
+    LogInstance().StopAsyncLogging();
 }
 
 /**
@@ -543,6 +554,17 @@ void SetupServerArgs(NodeContext &node) {
         strprintf("Set database cache size in MiB (%d to %d, default: %d)",
                   MIN_DB_CACHE_MB, MAX_DB_CACHE_MB, DEFAULT_DB_CACHE_MB),
         ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg(
+        "-dbprofile=<[database:]profile>",
+        "Set the storage profile of the databases, or only of the given "
+        "database (blocks, chainstate, txindex, coinstatsindex or "
+        "blockfilterindex). The profiles are: default, archive (compressed "
+        "larger blocks, more cache for reading, for large databases of random "
+        "lookups) and scan (archive without bloom filters, for databases read "
+        "by range). Compression requires leveldb to be built with Snappy, and "
+        "the compressed tables can't be read by a build without it. Can be "
+        "specified multiple times (default: default)",
+        ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg(
         "-includeconf=<file>",
         "Specify additional configuration file, relative to the -datadir path "
@@ -617,6 +639,26 @@ void SetupServerArgs(NodeContext &node) {
         "-reindex",
         "Rebuild chain state and block index from the blk*.dat files on disk",
         ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg(
+        "-schedulerthreads=<n>",
+        strprintf("Set the number of threads delivering the validation "
+                  "notifications. They are delivered to each subscriber "
+                  "(wallets, indexes, ZMQ, ...) independently, but a slow "
+                  "subscriber only stops delaying the others when there are "
+                  "several threads. With more than 1, these threads are "
+                  "separate from the thread running the other background "
+                  "tasks (default: %d)",
+                  DEFAULT_SCHEDULER_THREADS),
+        ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsman.AddArg(
+        "-serializedcachesize=<n>",
+        strprintf("Memory used to keep the recently written blocks and "
+                  "published transactions serialized, so they can be published "
+                  "by ZMQ, REST and RPC without reading them from disk or "
+                  "serializing them again, in MiB (0 to disable, default: %d "
+                  "with -zmqpubrawblock, -zmqpubrawtx or -rest, 0 otherwise)",
+                  DEFAULT_SERIALIZED_CACHE_SIZE),
+        ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsman.AddArg(
         "-settings=<file>",
         strprintf(
@@ -1289,6 +1331,13 @@ void SetupServerArgs(NodeContext &node) {
             "Set the number of threads to service RPC calls (default: %d)",
             DEFAULT_HTTP_THREADS),
         ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
+    argsman.AddArg(
+        "-rpceventthreads=<n>",
+        strprintf("Set the number of threads accepting RPC and REST "
+                  "connections and running their event loop. Values above 1 "
+                  "require SO_REUSEPORT support (default: %d)",
+                  DEFAULT_HTTP_EVENT_THREADS),
+        ArgsManager::ALLOW_ANY, OptionsCategory::RPC);
     argsman.AddArg(
         "-rpccorsdomain=value",
         "Domain from which to accept cross origin requests (browser enforced)",
@@ -2112,15 +2161,43 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
               script_threads);
     if (script_threads >= 1) {
         StartScriptCheckWorkerThreads(script_threads);
+        // The other block and tip processing work shares as many threads
+        util::g_worker_pool.StartWorkerThreads(script_threads, "worker");
     }
 
+    // The radix trees (finalized transactions, avalanche proofs) release
+    // their memory from a background thread.
+    RCULock::startReclaimer();
+
     assert(!node.scheduler);
     node.scheduler = std::make_unique<CScheduler>();
 
     // Start the lightweight task scheduler thread
-    node.scheduler->m_service_thread =
-        std::thread(&util::TraceThread, "scheduler",
-                    [&] { node.scheduler->serviceQueue(); });
+    node.scheduler->m_service_threads.emplace_back(
+        util::TraceThread, "scheduler", [&] { node.scheduler->serviceQueue(); });
+
+    // The validation interface subscribers are notified in parallel from
+    // their own threads if there are several of them. With a single thread
+    // they take turns on the node scheduler, so a slow subscriber still
+    // delays the others. The periodic tasks of the scheduler rely on running
+    // one at a time, so they stay on its single thread.
+    CScheduler *validation_signals_scheduler{node.scheduler.get()};
+    const int validation_signals_threads = std::max<int>(
+        1, args.GetIntArg("-schedulerthreads", DEFAULT_SCHEDULER_THREADS));
+    if (validation_signals_threads > 1) {
+        assert(!node.validation_signals_scheduler);
+        node.validation_signals_scheduler = std::make_unique<CScheduler>();
+        for (int i = 0; i < validation_signals_threads; i++) {
+            const std::string thread_name{strprintf("valsignals.%d", i)};
+            node.validation_signals_scheduler->m_service_threads.emplace_back(
+                [&node, thread_name] {
+                    util::TraceThread(thread_name.c_str(), [&] {
+                        node.validation_signals_scheduler->serviceQueue();
+                    });
+                });
+        }
+        validation_signals_scheduler = node.validation_signals_scheduler.get();
+    }
 
     // Gather some entropy once per minute.
     node.scheduler->scheduleEvery(
@@ -2130,7 +2207,8 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
         },
         std::chrono::minutes{1});
 
-    GetMainSignals().RegisterBackgroundSignalScheduler(*node.scheduler);
+    GetMainSignals().RegisterBackgroundSignalScheduler(
+        *validation_signals_scheduler);
 
     /**
      * Register RPC commands regardless of -server setting so they will be
@@ -2341,9 +2419,13 @@ bool AppInitMain(Config &config, RPCServer &rpcServer,
 
 #if ENABLE_ZMQ
     g_zmq_notification_interface = CZMQNotificationInterface::Create(
-        [&chainman = node.chainman](CBlock &block, const CBlockIndex &index) {
+        [&chainman = node.chainman](const CBlockIndex &index) {
+            assert(chainman);
+            return chainman->m_blockman.ReadRawBlock(index);
+        },
+        [&chainman = node.chainman](const CTransaction &tx) {
             assert(chainman);
-            return chainman->m_blockman.ReadBlockFromDisk(block, index);
+            return chainman->m_blockman.GetSerializedTransaction(tx);
         });
 
     if (g_zmq_notification_interface) {
@@ -115,6 +115,20 @@ void AddLoggingArgs(ArgsManager &argsman) {
             "(source file, line number and function name) (default: %u)",
             DEFAULT_LOGSOURCELOCATIONS),
         ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
+    argsman.AddArg(
+        "-logasync",
+        strprintf("Write the debug output from a background thread, so the "
+                  "logging threads never wait on I/O. The last lines might be "
+                  "lost if the node crashes (default: %u)",
+                  DEFAULT_LOGASYNC),
+        ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
+    argsman.AddArg(
+        "-logasyncblock",
+        strprintf("With -logasync, wait for the background thread when a "
+                  "thread logs more than %u lines faster than they can be "
+                  "written, instead of dropping the lines (default: %u)",
+                  DEFAULT_LOGASYNC_BUFFER_SIZE, DEFAULT_LOGASYNCBLOCK),
+        ArgsManager::ALLOW_ANY, OptionsCategory::DEBUG_TEST);
     argsman.AddArg(
         "-logtimemicros",
         strprintf("Add microsecond precision to debug timestamps (default: %u)",
@@ -204,6 +218,11 @@ bool StartLogging(const ArgsManager &args) {
                       fs::PathToString(logger.m_file_path)));
     }
 
+    if (args.GetBoolArg("-logasync", DEFAULT_LOGASYNC)) {
+        logger.StartAsyncLogging(
+            args.GetBoolArg("-logasyncblock", DEFAULT_LOGASYNCBLOCK));
+    }
+
     if (!logger.m_log_timestamps) {
         LogPrintf("Startup time: %s\n", FormatISO8601DateTime(GetTime()));
     }
@@ -5,6 +5,7 @@
 #ifndef BITCOIN_INTERFACES_CHAIN_H
 #define BITCOIN_INTERFACES_CHAIN_H
 
+#include <blockfilter.h>
 #include <primitives/transaction.h>
 #include <primitives/txid.h>
 #include <util/settings.h> // For util::SettingsValue
@@ -145,6 +146,17 @@ public:
     virtual std::optional<int>
     findLocatorFork(const CBlockLocator &locator) = 0;
 
+    //! Returns whether a block filter index is available.
+    virtual bool hasBlockFilterIndex(BlockFilterType filter_type) = 0;
+
+    //! Returns whether any of the elements match the block via a BIP 157 block
+    //! filter or std::nullopt if the block filter for this block couldn't be
+    //! found.
+    virtual std::optional<bool>
+    blockFilterMatchesAny(BlockFilterType filter_type,
+                          const BlockHash &block_hash,
+                          const GCSFilter::ElementSet &filter_set) = 0;
+
     //! Return whether node has the block and optionally return block metadata
     //! or contents.
     virtual bool findBlock(const BlockHash &hash,
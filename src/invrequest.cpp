@@ -6,16 +6,19 @@
 
 #include <crypto/siphash.h>
 #include <net.h>
+#include <prevector.h>
 #include <random.h>
+#include <util/hasher.h>
 
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index_container.hpp>
-
+#include <algorithm>
 #include <cassert>
 #include <chrono>
 #include <functional>
+#include <limits>
+#include <map>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 namespace {
 
@@ -23,8 +26,7 @@ namespace {
  * The various states a (invid, peer) pair can be in.
  *
  * Note that CANDIDATE is split up into 3 substates (DELAYED, BEST, READY),
- * allowing more efficient implementation. Also note that the sorting order of
- * ByInvIdView relies on the specific order of values in this enum.
+ * allowing more efficient implementation.
  *
  * Expected behaviour is:
  *   - When first announced by a peer, the state is CANDIDATE_DELAYED until
@@ -62,24 +64,41 @@ enum class State : uint8_t {
 //! Type alias for sequence numbers.
 using SequenceNumber = uint64_t;
 
+//! Type alias for priorities.
+using Priority = uint64_t;
+
+//! Type alias for the position of an announcement in the tracker's storage.
+using AnnPos = uint32_t;
+
+//! Position of no announcement, also marks the free storage slots.
+constexpr AnnPos NO_ANNOUNCEMENT{std::numeric_limits<AnnPos>::max()};
+
+/**
+ * Number of free storage slots, or of outdated time events, below which they
+ * are never released.
+ */
+constexpr size_t MIN_COMPACTION{1024};
+
 /**
  * An announcement. This is the data we track for each invid that is announced
  * to us by each peer.
  */
 struct Announcement {
     /** InvId that was announced. */
-    const uint256 m_invid;
+    uint256 m_invid;
     /**
      * For CANDIDATE_{DELAYED,BEST,READY} the reqtime; for REQUESTED the
      * expiry.
      */
     std::chrono::microseconds m_time;
     /** What peer the request was from. */
-    const NodeId m_peer;
+    NodeId m_peer;
+    /** The priority of this announcement, which doesn't depend on its state. */
+    Priority m_priority;
     /** What sequence number this announcement has. */
-    const SequenceNumber m_sequence : 60;
+    SequenceNumber m_sequence : 60;
     /** Whether the request is preferred. */
-    const bool m_preferred : 1;
+    bool m_preferred : 1;
 
     /**
      * What state this announcement is in.
@@ -89,12 +108,34 @@ struct Announcement {
      */
     uint8_t m_state : 3;
 
+    /**
+     * Position of this announcement among the announcements of its peer, or
+     * NO_ANNOUNCEMENT if this storage slot is free.
+     */
+    AnnPos m_peer_pos{0};
+
+    /**
+     * Position of this announcement among the CANDIDATE_BEST announcements of
+     * its peer, or NO_ANNOUNCEMENT if it is not CANDIDATE_BEST.
+     */
+    AnnPos m_best_pos{NO_ANNOUNCEMENT};
+
+    /**
+     * Incremented whenever the announcement stops waiting for its m_time, so
+     * the time events it left behind can be recognized as outdated. It is kept
+     * when the storage slot is reused.
+     */
+    uint32_t m_generation{0};
+
     /** Convert m_state to a State enum. */
     State GetState() const { return static_cast<State>(m_state); }
 
     /** Convert a State enum to a uint8_t and store it in m_state. */
     void SetState(State state) { m_state = static_cast<uint8_t>(state); }
 
+    /** Whether this storage slot holds no announcement. */
+    bool IsFree() const { return m_peer_pos == NO_ANNOUNCEMENT; }
+
     /**
      * Whether this announcement is selected. There can be at most 1 selected
      * peer per invid.
@@ -124,15 +165,13 @@ struct Announcement {
      * CANDIDATE_DELAYED state.
      */
     Announcement(const uint256 &invid, NodeId peer, bool preferred,
-                 std::chrono::microseconds reqtime, SequenceNumber sequence)
-        : m_invid(invid), m_time(reqtime), m_peer(peer), m_sequence(sequence),
-          m_preferred(preferred),
+                 std::chrono::microseconds reqtime, SequenceNumber sequence,
+                 Priority priority)
+        : m_invid(invid), m_time(reqtime), m_peer(peer), m_priority(priority),
+          m_sequence(sequence), m_preferred(preferred),
           m_state(static_cast<uint8_t>(State::CANDIDATE_DELAYED)) {}
 };
 
-//! Type alias for priorities.
-using Priority = uint64_t;
-
 /**
  * A functor with embedded salt that computes priority of an announcement.
  *
@@ -161,115 +200,25 @@ public:
     }
 };
 
-// Definitions for the 3 indexes used in the main data structure.
-//
-// Each index has a By* type to identify it, a By*View data type to represent
-// the view of announcement it is sorted by, and an By*ViewExtractor type to
-// convert an announcement into the By*View type. See
-// https://www.boost.org/doc/libs/1_58_0/libs/multi_index/doc/reference/key_extraction.html#key_extractors
-// for more information about the key extraction concept.
-
-// The ByPeer index is sorted by (peer, state == CANDIDATE_BEST, invid)
-//
-// Uses:
-// * Looking up existing announcements by peer/invid, by checking both (peer,
-//   false, invid) and (peer, true, invid).
-// * Finding all CANDIDATE_BEST announcements for a given peer in
-//   GetRequestable.
-struct ByPeer {};
-using ByPeerView = std::tuple<NodeId, bool, const uint256 &>;
-struct ByPeerViewExtractor {
-    using result_type = ByPeerView;
-    result_type operator()(const Announcement &ann) const {
-        return ByPeerView{ann.m_peer, ann.GetState() == State::CANDIDATE_BEST,
-                          ann.m_invid};
-    }
-};
-
-// The ByInvId index is sorted by (invid, state, priority).
-//
-// Note: priority == 0 whenever state != CANDIDATE_READY.
-//
-// Uses:
-// * Deleting all announcements with a given invid in ForgetInvId.
-// * Finding the best CANDIDATE_READY to convert to CANDIDATE_BEST, when no
-//   other CANDIDATE_READY or REQUESTED announcement exists for that invid.
-// * Determining when no more non-COMPLETED announcements for a given invid
-//   exist, so the COMPLETED ones can be deleted.
-struct ByInvId {};
-using ByInvIdView = std::tuple<const uint256 &, State, Priority>;
-class ByInvIdViewExtractor {
-    const PriorityComputer &m_computer;
-
-public:
-    explicit ByInvIdViewExtractor(const PriorityComputer &computer)
-        : m_computer(computer) {}
-    using result_type = ByInvIdView;
-    result_type operator()(const Announcement &ann) const {
-        const Priority prio =
-            (ann.GetState() == State::CANDIDATE_READY) ? m_computer(ann) : 0;
-        return ByInvIdView{ann.m_invid, ann.GetState(), prio};
-    }
-};
-
-enum class WaitState {
-    //! Used for announcements that need efficient testing of "is their
-    //! timestamp in the future?".
-    FUTURE_EVENT,
-    //! Used for announcements whose timestamp is not relevant.
-    NO_EVENT,
-    //! Used for announcements that need efficient testing of "is their
-    //! timestamp in the past?".
-    PAST_EVENT,
+/** An announcement of an invid, with the peer it is from. */
+struct PeerAnnouncement {
+    NodeId m_peer;
+    AnnPos m_pos;
 };
 
-WaitState GetWaitState(const Announcement &ann) {
-    if (ann.IsWaiting()) {
-        return WaitState::FUTURE_EVENT;
-    }
-    if (ann.IsSelectable()) {
-        return WaitState::PAST_EVENT;
-    }
-    return WaitState::NO_EVENT;
-}
-
-// The ByTime index is sorted by (wait_state, time).
-//
-// All announcements with a timestamp in the future can be found by iterating
-// the index forward from the beginning. All announcements with a timestamp in
-// the past can be found by iterating the index backwards from the end.
-//
-// Uses:
-// * Finding CANDIDATE_DELAYED announcements whose reqtime has passed, and
-//   REQUESTED announcements whose expiry has passed.
-// * Finding CANDIDATE_READY/BEST announcements whose reqtime is in the future
-//   (when the clock time went backwards).
-struct ByTime {};
-using ByTimeView = std::pair<WaitState, std::chrono::microseconds>;
-struct ByTimeViewExtractor {
-    using result_type = ByTimeView;
-    result_type operator()(const Announcement &ann) const {
-        return ByTimeView{GetWaitState(ann), ann.m_time};
-    }
+/** The announcements of an invid. */
+struct InvIdAnnouncements {
+    //! Contiguous, so the announcement of a peer is found by a linear scan
+    //! without touching the announcements themselves. The first ones are held
+    //! inline, which is usually enough as an invid is requested and forgotten
+    //! soon after the first announcements.
+    prevector<8, PeerAnnouncement> m_anns;
+    //! The CANDIDATE_BEST or REQUESTED announcement, if any.
+    AnnPos m_selected{NO_ANNOUNCEMENT};
+    //! Number of announcements that are not COMPLETED.
+    size_t m_non_completed{0};
 };
 
-/**
- * Data type for the main data structure (Announcement objects with
- * ByPeer/ByInvId/ByTime indexes).
- */
-using Index = boost::multi_index_container<
-    Announcement,
-    boost::multi_index::indexed_by<
-        boost::multi_index::ordered_unique<boost::multi_index::tag<ByPeer>,
-                                           ByPeerViewExtractor>,
-        boost::multi_index::ordered_non_unique<boost::multi_index::tag<ByInvId>,
-                                               ByInvIdViewExtractor>,
-        boost::multi_index::ordered_non_unique<boost::multi_index::tag<ByTime>,
-                                               ByTimeViewExtractor>>>;
-
-/** Helper type to simplify syntax of iterator types. */
-template <typename Tag> using Iter = typename Index::index<Tag>::type::iterator;
-
 /** Per-peer statistics object. */
 struct PeerInfo {
     //! Total number of announcements for this peer.
@@ -278,6 +227,37 @@ struct PeerInfo {
     size_t m_completed = 0;
     //! Number of REQUESTED announcements for this peer.
     size_t m_requested = 0;
+    //! Number of CANDIDATE_BEST announcements for this peer.
+    size_t m_candidate_best = 0;
+};
+
+/** Per-peer data. */
+struct PeerData {
+    PeerInfo m_info;
+    //! The positions of all the announcements of this peer, in no particular
+    //! order.
+    std::vector<AnnPos> m_anns;
+    //! The positions of the CANDIDATE_BEST announcements of this peer, in no
+    //! particular order, so GetRequestable doesn't visit the others.
+    std::vector<AnnPos> m_best;
+};
+
+/**
+ * The time a CANDIDATE_DELAYED or REQUESTED announcement waits for. Events are
+ * not removed when the announcement stops waiting, they are outdated once its
+ * generation changed.
+ */
+struct TimeEvent {
+    std::chrono::microseconds m_time;
+    AnnPos m_pos;
+    uint32_t m_generation;
+};
+
+/** Comparator making a min-heap of time events. */
+struct LaterEvent {
+    bool operator()(const TimeEvent &a, const TimeEvent &b) const {
+        return a.m_time > b.m_time;
+    }
 };
 
 /** Per-invid statistics object. Only used for sanity checking. */
@@ -304,29 +284,41 @@ struct InvIdInfo {
 
 /** Compare two PeerInfo objects. Only used for sanity checking. */
 bool operator==(const PeerInfo &a, const PeerInfo &b) {
-    return std::tie(a.m_total, a.m_completed, a.m_requested) ==
-           std::tie(b.m_total, b.m_completed, b.m_requested);
+    return std::tie(a.m_total, a.m_completed, a.m_requested,
+                    a.m_candidate_best) ==
+           std::tie(b.m_total, b.m_completed, b.m_requested,
+                    b.m_candidate_best);
 };
 
 /**
- * (Re)compute the PeerInfo map from the index. Only used for sanity checking.
+ * (Re)compute the PeerInfo map from the announcements. Only used for sanity
+ * checking.
  */
-std::unordered_map<NodeId, PeerInfo> RecomputePeerInfo(const Index &index) {
+std::unordered_map<NodeId, PeerInfo>
+RecomputePeerInfo(const std::vector<Announcement> &announcements) {
     std::unordered_map<NodeId, PeerInfo> ret;
-    for (const Announcement &ann : index) {
+    for (const Announcement &ann : announcements) {
+        if (ann.IsFree()) {
+            continue;
+        }
         PeerInfo &info = ret[ann.m_peer];
         ++info.m_total;
         info.m_requested += (ann.GetState() == State::REQUESTED);
         info.m_completed += (ann.GetState() == State::COMPLETED);
+        info.m_candidate_best += (ann.GetState() == State::CANDIDATE_BEST);
     }
     return ret;
 }
 
 /** Compute the InvIdInfo map. Only used for sanity checking. */
 std::map<uint256, InvIdInfo>
-ComputeInvIdInfo(const Index &index, const PriorityComputer &computer) {
+ComputeInvIdInfo(const std::vector<Announcement> &announcements,
+                 const PriorityComputer &computer) {
     std::map<uint256, InvIdInfo> ret;
-    for (const Announcement &ann : index) {
+    for (const Announcement &ann : announcements) {
+        if (ann.IsFree()) {
+            continue;
+        }
         InvIdInfo &info = ret[ann.m_invid];
         // Classify how many announcements of each state we have for this invid.
         info.m_candidate_delayed +=
@@ -352,8 +344,20 @@ ComputeInvIdInfo(const Index &index, const PriorityComputer &computer) {
 
 } // namespace
 
-/** Actual implementation for InvRequestTracker's data structure. */
+/**
+ * Actual implementation for InvRequestTracker's data structure.
+ *
+ * The announcements are stored contiguously and referred to by position. They
+ * are indexed by invid in a hash map, and each peer has an array of the
+ * positions of its announcements, and another one of its CANDIDATE_BEST
+ * announcements. The times the CANDIDATE_DELAYED and
+ * REQUESTED announcements wait for are kept in a min-heap, so moving time
+ * forward only looks at the announcements whose time has passed.
+ */
 class InvRequestTrackerImpl : public InvRequestTrackerImplInterface {
+    using InvIdMap =
+        std::unordered_map<uint256, InvIdAnnouncements, SaltedUint256Hasher>;
+
     //! The current sequence number. Increases for every announcement. This is
     //! used to sort invid returned by GetRequestable in announcement order.
     SequenceNumber m_current_sequence{0};
@@ -361,23 +365,114 @@ class InvRequestTrackerImpl : public InvRequestTrackerImplInterface {
     //! This tracker's priority computer.
     const PriorityComputer m_computer;
 
-    //! This tracker's main data structure. See SanityCheck() for the invariants
-    //! that apply to it.
-    Index m_index;
+    //! This tracker's announcements. The slots of the erased announcements are
+    //! reused by the new ones, and released once they are the majority. See
+    //! SanityCheck() for the invariants that apply to the data structures.
+    std::vector<Announcement> m_announcements;
+
+    //! Free slots of m_announcements.
+    std::vector<AnnPos> m_free;
+
+    //! Announcements by invid.
+    InvIdMap m_invids;
 
-    //! Map with this tracker's per-peer statistics.
-    std::unordered_map<NodeId, PeerInfo> m_peerinfo;
+    //! Map with this tracker's per-peer statistics and announcements.
+    std::unordered_map<NodeId, PeerData> m_peers;
+
+    //! Min-heap of the times the CANDIDATE_DELAYED and REQUESTED announcements
+    //! wait for, including outdated events.
+    std::vector<TimeEvent> m_time_events;
+
+    //! Number of CANDIDATE_DELAYED and REQUESTED announcements, which have one
+    //! up to date event each.
+    size_t m_waiting{0};
+
+    //! Upper bound of the times of the CANDIDATE_READY and CANDIDATE_BEST
+    //! announcements. They are all in the past unless time went backwards.
+    std::chrono::microseconds m_max_selectable_time{
+        std::chrono::microseconds::min()};
 
 public:
     void SanityCheck() const {
-        // Recompute m_peerdata from m_index. This verifies the data in it as it
-        // should just be caching statistics on m_index. It also verifies the
-        // invariant that no PeerInfo announcements with m_total==0 exist.
-        assert(m_peerinfo == RecomputePeerInfo(m_index));
+        // Recompute the peer statistics from the announcements. This verifies
+        // the data in m_peers as it should just be caching statistics on
+        // them. It also verifies the invariant that no PeerData with
+        // m_total==0 exist.
+        std::unordered_map<NodeId, PeerInfo> peerinfo;
+        for (const auto &[peer, data] : m_peers) {
+            assert(data.m_anns.size() == data.m_info.m_total);
+            for (size_t i = 0; i < data.m_anns.size(); ++i) {
+                const Announcement &ann = m_announcements[data.m_anns[i]];
+                assert(!ann.IsFree());
+                assert(ann.m_peer == peer && ann.m_peer_pos == i);
+            }
+            assert(data.m_best.size() == data.m_info.m_candidate_best);
+            for (size_t i = 0; i < data.m_best.size(); ++i) {
+                const Announcement &ann = m_announcements[data.m_best[i]];
+                assert(!ann.IsFree());
+                assert(ann.GetState() == State::CANDIDATE_BEST);
+                assert(ann.m_peer == peer && ann.m_best_pos == i);
+            }
+            peerinfo.emplace(peer, data.m_info);
+        }
+        assert(peerinfo == RecomputePeerInfo(m_announcements));
+
+        // Verify the announcements indexed by invid, which must cover all of
+        // them.
+        size_t indexed = 0;
+        for (const auto &[invid, anns] : m_invids) {
+            size_t non_completed = 0;
+            AnnPos selected = NO_ANNOUNCEMENT;
+            for (const PeerAnnouncement &peer_ann : anns.m_anns) {
+                const Announcement &ann = m_announcements[peer_ann.m_pos];
+                assert(!ann.IsFree());
+                assert(ann.m_invid == invid && ann.m_peer == peer_ann.m_peer);
+                non_completed += ann.GetState() != State::COMPLETED;
+                if (ann.IsSelected()) {
+                    selected = peer_ann.m_pos;
+                }
+            }
+            assert(anns.m_non_completed == non_completed);
+            assert(anns.m_selected == selected);
+            indexed += anns.m_anns.size();
+        }
+        assert(indexed == Size());
+
+        // Every CANDIDATE_DELAYED and REQUESTED announcement has exactly one up
+        // to date time event, and the priorities and the bound of the
+        // selectable times are correct.
+        assert(std::is_heap(m_time_events.begin(), m_time_events.end(),
+                            LaterEvent{}));
+        size_t up_to_date = 0;
+        for (const TimeEvent &event : m_time_events) {
+            const Announcement &ann = m_announcements[event.m_pos];
+            if (ann.m_generation == event.m_generation) {
+                assert(!ann.IsFree() && ann.IsWaiting());
+                assert(ann.m_time == event.m_time);
+                ++up_to_date;
+            }
+        }
+        size_t waiting = 0;
+        size_t free = 0;
+        for (const Announcement &ann : m_announcements) {
+            if (ann.IsFree()) {
+                ++free;
+                continue;
+            }
+            waiting += ann.IsWaiting();
+            assert((ann.GetState() == State::CANDIDATE_BEST) ==
+                   (ann.m_best_pos != NO_ANNOUNCEMENT));
+            if (ann.IsSelectable()) {
+                assert(ann.m_time <= m_max_selectable_time);
+            }
+            assert(ann.m_priority == m_computer(ann));
+        }
+        assert(up_to_date == m_waiting && waiting == m_waiting);
+        assert(free == m_free.size());
 
-        // Calculate per-invid statistics from m_index, and validate
+        // Calculate per-invid statistics from the announcements, and validate
         // invariants.
-        for (auto &item : ComputeInvIdInfo(m_index, m_computer)) {
+        for (auto &item : ComputeInvIdInfo(m_announcements, m_computer)) {
             InvIdInfo &info = item.second;
 
             // Cannot have only COMPLETED peer (invid should have been forgotten
@@ -412,7 +507,10 @@ public:
     }
 
     void PostGetRequestableSanityCheck(std::chrono::microseconds now) const {
-        for (const Announcement &ann : m_index) {
+        for (const Announcement &ann : m_announcements) {
+            if (ann.IsFree()) {
+                continue;
+            }
             if (ann.IsWaiting()) {
                 // REQUESTED and CANDIDATE_DELAYED must have a time in the
                 // future (they should have been converted to
@@ -429,118 +527,239 @@ public:
     }
 
 private:
-    //! Wrapper around Index::...::erase that keeps m_peerinfo up to date.
-    template <typename Tag> Iter<Tag> Erase(Iter<Tag> it) {
-        auto peerit = m_peerinfo.find(it->m_peer);
-        peerit->second.m_completed -= it->GetState() == State::COMPLETED;
-        peerit->second.m_requested -= it->GetState() == State::REQUESTED;
-        if (--peerit->second.m_total == 0) {
-            m_peerinfo.erase(peerit);
+    //! Find the announcement of a peer among those of an invid.
+    static AnnPos FindAnnouncement(const InvIdAnnouncements &anns,
+                                   NodeId peer) {
+        for (const PeerAnnouncement &peer_ann : anns.m_anns) {
+            if (peer_ann.m_peer == peer) {
+                return peer_ann.m_pos;
+            }
         }
-        return m_index.get<Tag>().erase(it);
+        return NO_ANNOUNCEMENT;
+    }
+
+    //! Remove the outdated time events.
+    void PruneTimeEvents() {
+        m_time_events.erase(
+            std::remove_if(m_time_events.begin(), m_time_events.end(),
+                           [this](const TimeEvent &event) {
+                               return m_announcements[event.m_pos]
+                                          .m_generation != event.m_generation;
+                           }),
+            m_time_events.end());
+        std::make_heap(m_time_events.begin(), m_time_events.end(),
+                       LaterEvent{});
+    }
+
+    //! Wait for the time of an announcement, which just became
+    //! CANDIDATE_DELAYED or REQUESTED.
+    void AddTimeEvent(AnnPos pos) {
+        ++m_waiting;
+        if (m_time_events.size() > 2 * m_waiting + MIN_COMPACTION) {
+            PruneTimeEvents();
+        }
+        const Announcement &ann = m_announcements[pos];
+        m_time_events.push_back({ann.m_time, pos, ann.m_generation});
+        std::push_heap(m_time_events.begin(), m_time_events.end(),
+                       LaterEvent{});
+    }
+
+    //! Remove an announcement from the CANDIDATE_BEST ones of its peer, by
+    //! moving the last one in its place.
+    void RemoveCandidateBest(PeerData &data, AnnPos pos) {
+        Announcement &ann = m_announcements[pos];
+        const AnnPos last = data.m_best.back();
+        data.m_best[ann.m_best_pos] = last;
+        m_announcements[last].m_best_pos = ann.m_best_pos;
+        data.m_best.pop_back();
+        ann.m_best_pos = NO_ANNOUNCEMENT;
     }
 
-    //! Wrapper around Index::...::modify that keeps m_peerinfo up to date.
-    template <typename Tag, typename Modifier>
-    void Modify(Iter<Tag> it, Modifier modifier) {
-        auto peerit = m_peerinfo.find(it->m_peer);
-        peerit->second.m_completed -= it->GetState() == State::COMPLETED;
-        peerit->second.m_requested -= it->GetState() == State::REQUESTED;
-        m_index.get<Tag>().modify(it, std::move(modifier));
-        peerit->second.m_completed += it->GetState() == State::COMPLETED;
-        peerit->second.m_requested += it->GetState() == State::REQUESTED;
+    //! Change the state of an announcement, keeping the statistics and the
+    //! time events up to date.
+    void SetState(AnnPos pos, InvIdAnnouncements &anns, State state) {
+        Announcement &ann = m_announcements[pos];
+        PeerData &data = m_peers.find(ann.m_peer)->second;
+        PeerInfo &info = data.m_info;
+        info.m_completed -= ann.GetState() == State::COMPLETED;
+        info.m_requested -= ann.GetState() == State::REQUESTED;
+        info.m_candidate_best -= ann.GetState() == State::CANDIDATE_BEST;
+        if (ann.GetState() == State::CANDIDATE_BEST) {
+            RemoveCandidateBest(data, pos);
+        }
+        anns.m_non_completed -= ann.GetState() != State::COMPLETED;
+        if (ann.IsWaiting()) {
+            ++ann.m_generation;
+            --m_waiting;
+        }
+
+        ann.SetState(state);
+
+        info.m_completed += ann.GetState() == State::COMPLETED;
+        info.m_requested += ann.GetState() == State::REQUESTED;
+        info.m_candidate_best += ann.GetState() == State::CANDIDATE_BEST;
+        if (ann.GetState() == State::CANDIDATE_BEST) {
+            ann.m_best_pos = data.m_best.size();
+            data.m_best.push_back(pos);
+        }
+        anns.m_non_completed += ann.GetState() != State::COMPLETED;
+        if (ann.IsWaiting()) {
+            AddTimeEvent(pos);
+        } else if (ann.IsSelectable()) {
+            m_max_selectable_time = std::max(m_max_selectable_time, ann.m_time);
+        }
+    }
+
+    //! Erase an announcement from its peer and release its storage slot. It
+    //! must already be removed from, or about to be erased with, the
+    //! announcements of its invid.
+    void FreeAnnouncement(AnnPos pos) {
+        Announcement &ann = m_announcements[pos];
+        auto peer_it = m_peers.find(ann.m_peer);
+        PeerData &data = peer_it->second;
+        // Move the last announcement of the peer in its place.
+        const AnnPos last = data.m_anns.back();
+        data.m_anns[ann.m_peer_pos] = last;
+        m_announcements[last].m_peer_pos = ann.m_peer_pos;
+        data.m_anns.pop_back();
+
+        data.m_info.m_completed -= ann.GetState() == State::COMPLETED;
+        data.m_info.m_requested -= ann.GetState() == State::REQUESTED;
+        data.m_info.m_candidate_best -=
+            ann.GetState() == State::CANDIDATE_BEST;
+        if (ann.GetState() == State::CANDIDATE_BEST) {
+            RemoveCandidateBest(data, pos);
+        }
+        if (--data.m_info.m_total == 0) {
+            m_peers.erase(peer_it);
+        }
+        if (ann.IsWaiting()) {
+            ++ann.m_generation;
+            --m_waiting;
+        }
+        ann.m_peer_pos = NO_ANNOUNCEMENT;
+        m_free.push_back(pos);
+    }
+
+    //! Erase all the announcements of an invid.
+    void EraseInvId(InvIdMap::iterator it) {
+        for (const PeerAnnouncement &peer_ann : it->second.m_anns) {
+            FreeAnnouncement(peer_ann.m_pos);
+        }
+        m_invids.erase(it);
+    }
+
+    //! Erase a COMPLETED announcement, which can't be the last one of its
+    //! invid.
+    void EraseCompleted(AnnPos pos, InvIdAnnouncements &anns) {
+        assert(m_announcements[pos].GetState() == State::COMPLETED);
+        auto it = std::find_if(anns.m_anns.begin(), anns.m_anns.end(),
+                               [pos](const PeerAnnouncement &peer_ann) {
+                                   return peer_ann.m_pos == pos;
+                               });
+        *it = anns.m_anns.back();
+        anns.m_anns.pop_back();
+        assert(!anns.m_anns.empty());
+        FreeAnnouncement(pos);
+    }
+
+    //! Move the announcements to the front of the storage and release the free
+    //! slots, once they are the majority.
+    void MaybeCompact() {
+        if (m_free.size() < MIN_COMPACTION ||
+            m_free.size() * 2 < m_announcements.size()) {
+            return;
+        }
+        PruneTimeEvents();
+
+        std::vector<AnnPos> new_pos(m_announcements.size(), NO_ANNOUNCEMENT);
+        AnnPos count = 0;
+        for (AnnPos pos = 0; pos < m_announcements.size(); ++pos) {
+            if (!m_announcements[pos].IsFree()) {
+                new_pos[pos] = count;
+                m_announcements[count++] = m_announcements[pos];
+            }
+        }
+        m_announcements.erase(m_announcements.begin() + count,
+                              m_announcements.end());
+        m_announcements.shrink_to_fit();
+        m_free.clear();
+        m_free.shrink_to_fit();
+
+        for (auto &[peer, data] : m_peers) {
+            for (AnnPos &pos : data.m_anns) {
+                pos = new_pos[pos];
+            }
+            for (AnnPos &pos : data.m_best) {
+                pos = new_pos[pos];
+            }
+        }
+        for (auto &[invid, anns] : m_invids) {
+            for (PeerAnnouncement &peer_ann : anns.m_anns) {
+                peer_ann.m_pos = new_pos[peer_ann.m_pos];
+            }
+            if (anns.m_selected != NO_ANNOUNCEMENT) {
+                anns.m_selected = new_pos[anns.m_selected];
+            }
+        }
+        // Only the up to date events are left, and the order of the heap only
+        // depends on the times.
+        for (TimeEvent &event : m_time_events) {
+            event.m_pos = new_pos[event.m_pos];
+        }
     }
 
     //! Convert a CANDIDATE_DELAYED announcement into a CANDIDATE_READY. If this
     //! makes it the new best CANDIDATE_READY (and no REQUESTED exists) and
     //! better than the CANDIDATE_BEST (if any), it becomes the new
     //! CANDIDATE_BEST.
-    void PromoteCandidateReady(Iter<ByInvId> it) {
-        assert(it != m_index.get<ByInvId>().end());
-        assert(it->GetState() == State::CANDIDATE_DELAYED);
-        // Convert CANDIDATE_DELAYED to CANDIDATE_READY first.
-        Modify<ByInvId>(it, [](Announcement &ann) {
-            ann.SetState(State::CANDIDATE_READY);
-        });
-        // The following code relies on the fact that the ByInvId is sorted by
-        // invid, and then by state (first _DELAYED, then _READY, then
-        // _BEST/REQUESTED). Within the _READY announcements, the best one
-        // (highest priority) comes last. Thus, if an existing _BEST exists for
-        // the same invid that this announcement may be preferred over, it must
-        // immediately follow the newly created _READY.
-        auto it_next = std::next(it);
-        if (it_next == m_index.get<ByInvId>().end() ||
-            it_next->m_invid != it->m_invid ||
-            it_next->GetState() == State::COMPLETED) {
-            // This is the new best CANDIDATE_READY, and there is no
-            // IsSelected() announcement for this invid already.
-            Modify<ByInvId>(it, [](Announcement &ann) {
-                ann.SetState(State::CANDIDATE_BEST);
-            });
-        } else if (it_next->GetState() == State::CANDIDATE_BEST) {
-            Priority priority_old = m_computer(*it_next);
-            Priority priority_new = m_computer(*it);
-            if (priority_new > priority_old) {
-                // There is a CANDIDATE_BEST announcement already, but this one
-                // is better.
-                Modify<ByInvId>(it_next, [](Announcement &ann) {
-                    ann.SetState(State::CANDIDATE_READY);
-                });
-                Modify<ByInvId>(it, [](Announcement &ann) {
-                    ann.SetState(State::CANDIDATE_BEST);
-                });
-            }
+    void PromoteCandidateReady(AnnPos pos, InvIdAnnouncements &anns) {
+        assert(m_announcements[pos].GetState() == State::CANDIDATE_DELAYED);
+        State state = State::CANDIDATE_READY;
+        if (anns.m_selected == NO_ANNOUNCEMENT) {
+            // There is no IsSelected() announcement for this invid, so there is
+            // no CANDIDATE_READY either: this is the new best one.
+            state = State::CANDIDATE_BEST;
+        } else if (m_announcements[anns.m_selected].GetState() ==
+                       State::CANDIDATE_BEST &&
+                   m_announcements[pos].m_priority >
+                       m_announcements[anns.m_selected].m_priority) {
+            // There is a CANDIDATE_BEST announcement already, but this one is
+            // better.
+            SetState(anns.m_selected, anns, State::CANDIDATE_READY);
+            state = State::CANDIDATE_BEST;
+        }
+        SetState(pos, anns, state);
+        if (state == State::CANDIDATE_BEST) {
+            anns.m_selected = pos;
         }
     }
 
     //! Change the state of an announcement to something non-IsSelected(). If it
     //! was IsSelected(), the next best announcement will be marked
     //! CANDIDATE_BEST.
-    void ChangeAndReselect(Iter<ByInvId> it, State new_state) {
+    void ChangeAndReselect(AnnPos pos, InvIdAnnouncements &anns,
+                           State new_state) {
         assert(new_state == State::COMPLETED ||
                new_state == State::CANDIDATE_DELAYED);
-        assert(it != m_index.get<ByInvId>().end());
-        if (it->IsSelected() && it != m_index.get<ByInvId>().begin()) {
-            auto it_prev = std::prev(it);
-            // The next best CANDIDATE_READY, if any, immediately precedes the
-            // REQUESTED or CANDIDATE_BEST announcement in the ByInvId index.
-            if (it_prev->m_invid == it->m_invid &&
-                it_prev->GetState() == State::CANDIDATE_READY) {
-                // If one such CANDIDATE_READY exists (for this invid), convert
-                // it to CANDIDATE_BEST.
-                Modify<ByInvId>(it_prev, [](Announcement &ann) {
-                    ann.SetState(State::CANDIDATE_BEST);
-                });
+        if (m_announcements[pos].IsSelected()) {
+            // If any CANDIDATE_READY exists for this invid, convert the one
+            // with the highest priority to CANDIDATE_BEST.
+            AnnPos best = NO_ANNOUNCEMENT;
+            for (const PeerAnnouncement &peer_ann : anns.m_anns) {
+                const Announcement &ann = m_announcements[peer_ann.m_pos];
+                if (ann.GetState() == State::CANDIDATE_READY &&
+                    (best == NO_ANNOUNCEMENT ||
+                     ann.m_priority > m_announcements[best].m_priority)) {
+                    best = peer_ann.m_pos;
+                }
+            }
+            anns.m_selected = best;
+            if (best != NO_ANNOUNCEMENT) {
+                SetState(best, anns, State::CANDIDATE_BEST);
             }
         }
-        Modify<ByInvId>(
-            it, [new_state](Announcement &ann) { ann.SetState(new_state); });
-    }
-
-    //! Check if 'it' is the only announcement for a given invid that isn't
-    //! COMPLETED.
-    bool IsOnlyNonCompleted(Iter<ByInvId> it) {
-        assert(it != m_index.get<ByInvId>().end());
-        // Not allowed to call this on COMPLETED announcements.
-        assert(it->GetState() != State::COMPLETED);
-
-        // This announcement has a predecessor that belongs to the same invid.
-        // Due to ordering, and the fact that 'it' is not COMPLETED, its
-        // predecessor cannot be COMPLETED here.
-        if (it != m_index.get<ByInvId>().begin() &&
-            std::prev(it)->m_invid == it->m_invid) {
-            return false;
-        }
-
-        // This announcement has a successor that belongs to the same invid,
-        // and is not COMPLETED.
-        if (std::next(it) != m_index.get<ByInvId>().end() &&
-            std::next(it)->m_invid == it->m_invid &&
-            std::next(it)->GetState() != State::COMPLETED) {
-            return false;
-        }
-
-        return true;
+        SetState(pos, anns, new_state);
     }
 
     /**
@@ -550,28 +769,22 @@ private:
      * the best one is made CANDIDATE_BEST. Returns whether the announcement
      * still exists.
      */
-    bool MakeCompleted(Iter<ByInvId> it) {
-        assert(it != m_index.get<ByInvId>().end());
-
+    bool MakeCompleted(AnnPos pos, InvIdMap::iterator it) {
         // Nothing to be done if it's already COMPLETED.
-        if (it->GetState() == State::COMPLETED) {
+        if (m_announcements[pos].GetState() == State::COMPLETED) {
             return true;
         }
 
-        if (IsOnlyNonCompleted(it)) {
+        if (it->second.m_non_completed == 1) {
             // This is the last non-COMPLETED announcement for this invid.
             // Delete all.
-            uint256 invid = it->m_invid;
-            do {
-                it = Erase<ByInvId>(it);
-            } while (it != m_index.get<ByInvId>().end() &&
-                     it->m_invid == invid);
+            EraseInvId(it);
             return false;
         }
 
         // Mark the announcement COMPLETED, and select the next best
         // announcement (the first CANDIDATE_READY) if needed.
-        ChangeAndReselect(it, State::COMPLETED);
+        ChangeAndReselect(pos, it->second, State::COMPLETED);
 
         return true;
     }
@@ -587,131 +800,150 @@ private:
                       EmplaceExpiredFun emplaceExpired) {
         clearExpired();
         // Iterate over all CANDIDATE_DELAYED and REQUESTED from old to new, as
-        // long as they're in the past, and convert them to CANDIDATE_READY andc
+        // long as they're in the past, and convert them to CANDIDATE_READY and
         // COMPLETED respectively.
-        while (!m_index.empty()) {
-            auto it = m_index.get<ByTime>().begin();
-            if (it->GetState() == State::CANDIDATE_DELAYED &&
-                it->m_time <= now) {
-                PromoteCandidateReady(m_index.project<ByInvId>(it));
-            } else if (it->GetState() == State::REQUESTED &&
-                       it->m_time <= now) {
-                emplaceExpired(it->m_peer, it->m_invid);
-                MakeCompleted(m_index.project<ByInvId>(it));
+        while (!m_time_events.empty() && m_time_events.front().m_time <= now) {
+            const TimeEvent event = m_time_events.front();
+            std::pop_heap(m_time_events.begin(), m_time_events.end(),
+                          LaterEvent{});
+            m_time_events.pop_back();
+
+            const Announcement &ann = m_announcements[event.m_pos];
+            if (ann.m_generation != event.m_generation) {
+                continue;
+            }
+            auto it = m_invids.find(ann.m_invid);
+            if (ann.GetState() == State::CANDIDATE_DELAYED) {
+                PromoteCandidateReady(event.m_pos, it->second);
             } else {
-                break;
+                assert(ann.GetState() == State::REQUESTED);
+                emplaceExpired(ann.m_peer, ann.m_invid);
+                MakeCompleted(event.m_pos, it);
             }
         }
 
-        while (!m_index.empty()) {
-            // If time went backwards, we may need to demote CANDIDATE_BEST and
-            // CANDIDATE_READY announcements back to CANDIDATE_DELAYED. This is
-            // an unusual edge case, and unlikely to matter in production.
-            // However, it makes it much easier to specify and test
-            // InvRequestTracker::Impl's behaviour.
-            auto it = std::prev(m_index.get<ByTime>().end());
-            if (it->IsSelectable() && it->m_time > now) {
-                ChangeAndReselect(m_index.project<ByInvId>(it),
-                                  State::CANDIDATE_DELAYED);
-            } else {
-                break;
+        // If time went backwards, we may need to demote CANDIDATE_BEST and
+        // CANDIDATE_READY announcements back to CANDIDATE_DELAYED. This is an
+        // unusual edge case, and unlikely to matter in production. However, it
+        // makes it much easier to specify and test InvRequestTracker::Impl's
+        // behaviour.
+        if (now < m_max_selectable_time) {
+            for (AnnPos pos = 0; pos < m_announcements.size(); ++pos) {
+                const Announcement &ann = m_announcements[pos];
+                if (!ann.IsFree() && ann.IsSelectable() && ann.m_time > now) {
+                    ChangeAndReselect(pos, m_invids.find(ann.m_invid)->second,
+                                      State::CANDIDATE_DELAYED);
+                }
             }
+            m_max_selectable_time = now;
+        }
+
+        MaybeCompact();
+    }
+
+    //! Find the CANDIDATE_BEST announcements of a peer, in announcement order.
+    std::vector<uint256> GetCandidateBest(const PeerData &data) const {
+        std::vector<const Announcement *> selected;
+        selected.reserve(data.m_best.size());
+        for (AnnPos pos : data.m_best) {
+            selected.push_back(&m_announcements[pos]);
         }
+
+        // Sort by sequence number.
+        std::sort(selected.begin(), selected.end(),
+                  [](const Announcement *a, const Announcement *b) {
+                      return a->m_sequence < b->m_sequence;
+                  });
+
+        // Convert to InvId and return.
+        std::vector<uint256> ret;
+        ret.reserve(selected.size());
+        std::transform(selected.begin(), selected.end(),
+                       std::back_inserter(ret),
+                       [](const Announcement *ann) { return ann->m_invid; });
+        return ret;
     }
 
 public:
     explicit InvRequestTrackerImpl(bool deterministic)
-        : m_computer(deterministic),
-          // Explicitly initialize m_index as we need to pass a reference to
-          // m_computer to ByInvIdViewExtractor.
-          m_index(boost::make_tuple(
-              boost::make_tuple(ByPeerViewExtractor(), std::less<ByPeerView>()),
-              boost::make_tuple(ByInvIdViewExtractor(m_computer),
-                                std::less<ByInvIdView>()),
-              boost::make_tuple(ByTimeViewExtractor(),
-                                std::less<ByTimeView>()))) {}
-
-    // Disable copying and assigning (a default copy won't work due the stateful
-    // ByInvIdViewExtractor).
+        : m_computer(deterministic) {}
+
     InvRequestTrackerImpl(const InvRequestTrackerImpl &) = delete;
     InvRequestTrackerImpl &operator=(const InvRequestTrackerImpl &) = delete;
 
     ~InvRequestTrackerImpl() = default;
 
     void DisconnectedPeer(NodeId peer) {
-        auto &index = m_index.get<ByPeer>();
-        auto it =
-            index.lower_bound(ByPeerView{peer, false, uint256(uint256::ZERO)});
-        while (it != index.end() && it->m_peer == peer) {
-            // Check what to continue with after this iteration. 'it' will be
-            // deleted in what follows, so we need to decide what to continue
-            // with afterwards. There are a number of cases to consider:
-            // - std::next(it) is end() or belongs to a different peer. In that
-            //   case, this is the last iteration of the loop (denote this by
-            //   setting it_next to end()).
-            // - 'it' is not the only non-COMPLETED announcement for its invid.
-            //   This means it will be deleted, but no other Announcement
-            //   objects will be modified. Continue with std::next(it) if it
-            //   belongs to the same peer, but decide this ahead of time (as
-            //   'it' may change position in what follows).
-            // - 'it' is the only non-COMPLETED announcement for its invid. This
-            //   means it will be deleted along with all other announcements for
-            //   the same invid - which may include std::next(it). However,
-            //   other than 'it', no announcements for the same peer can be
-            //   affected (due to (peer, invid) uniqueness). In other words, the
-            //   situation where std::next(it) is deleted can only occur if
-            //   std::next(it) belongs to a different peer but the same invid as
-            //   'it'. This is covered by the first bulletpoint already, and
-            //   we'll have set it_next to end().
-            auto it_next =
-                (std::next(it) == index.end() || std::next(it)->m_peer != peer)
-                    ? index.end()
-                    : std::next(it);
+        auto peer_it = m_peers.find(peer);
+        if (peer_it == m_peers.end()) {
+            return;
+        }
+        // The positions are copied as the array of the peer shrinks in what
+        // follows. Every position stays valid until it is visited: when
+        // MakeCompleted deletes all the announcements of an invid, the only
+        // one belonging to this peer is the one being visited, due to (peer,
+        // invid) uniqueness.
+        const std::vector<AnnPos> positions = peer_it->second.m_anns;
+        for (AnnPos pos : positions) {
+            auto it = m_invids.find(m_announcements[pos].m_invid);
             // If the announcement isn't already COMPLETED, first make it
             // COMPLETED (which will mark other CANDIDATEs as CANDIDATE_BEST, or
             // delete all of a invid's announcements if no non-COMPLETED ones
             // are left).
-            if (MakeCompleted(m_index.project<ByInvId>(it))) {
+            if (MakeCompleted(pos, it)) {
                 // Then actually delete the announcement (unless it was already
                 // deleted by MakeCompleted).
-                Erase<ByPeer>(it);
+                EraseCompleted(pos, it->second);
             }
-            it = it_next;
         }
+        MaybeCompact();
     }
 
     void ForgetInvId(const uint256 &invid) {
-        auto it = m_index.get<ByInvId>().lower_bound(
-            ByInvIdView{invid, State::CANDIDATE_DELAYED, 0});
-        while (it != m_index.get<ByInvId>().end() && it->m_invid == invid) {
-            it = Erase<ByInvId>(it);
+        auto it = m_invids.find(invid);
+        if (it != m_invids.end()) {
+            EraseInvId(it);
+            MaybeCompact();
         }
     }
 
     void ReceivedInv(NodeId peer, const uint256 &invid, bool preferred,
                      std::chrono::microseconds reqtime) {
-        // Bail out if we already have a CANDIDATE_BEST announcement for this
-        // (invid, peer) combination. The case where there is a
-        // non-CANDIDATE_BEST announcement already will be caught by the
-        // uniqueness property of the ByPeer index when we try to emplace the
-        // new object below.
-        if (m_index.get<ByPeer>().count(ByPeerView{peer, true, invid})) {
+        // Bail out if we already have an announcement for this (invid, peer)
+        // combination.
+        auto [it, inserted] = m_invids.try_emplace(invid);
+        if (!inserted &&
+            FindAnnouncement(it->second, peer) != NO_ANNOUNCEMENT) {
             return;
         }
 
-        // Try creating the announcement with CANDIDATE_DELAYED state (which
-        // will fail due to the uniqueness of the ByPeer index if a
-        // non-CANDIDATE_BEST announcement already exists with the same invid
-        // and peer). Bail out in that case.
-        auto ret = m_index.get<ByPeer>().emplace(invid, peer, preferred,
-                                                 reqtime, m_current_sequence);
-        if (!ret.second) {
-            return;
+        // Create the announcement with CANDIDATE_DELAYED state, in a free slot
+        // if there is one.
+        const Announcement ann(invid, peer, preferred, reqtime,
+                               m_current_sequence,
+                               m_computer(invid, peer, preferred));
+        AnnPos pos;
+        if (m_free.empty()) {
+            pos = m_announcements.size();
+            m_announcements.push_back(ann);
+        } else {
+            pos = m_free.back();
+            m_free.pop_back();
+            const uint32_t generation = m_announcements[pos].m_generation;
+            m_announcements[pos] = ann;
+            m_announcements[pos].m_generation = generation;
         }
 
-        // Update accounting metadata.
-        ++m_peerinfo[peer].m_total;
+        PeerData &data = m_peers[peer];
+        m_announcements[pos].m_peer_pos = data.m_anns.size();
+        data.m_anns.push_back(pos);
+        it->second.m_anns.push_back({peer, pos});
+
+        // Update accounting metadata, and wait for the reqtime.
+        ++data.m_info.m_total;
+        ++it->second.m_non_completed;
         ++m_current_sequence;
+        AddTimeEvent(pos);
     }
 
     //! Find the InvIds to request now from peer.
@@ -722,36 +954,46 @@ public:
         // Move time.
         SetTimePoint(now, clearExpired, emplaceExpired);
 
-        // Find all CANDIDATE_BEST announcements for this peer.
-        std::vector<const Announcement *> selected;
-        auto it_peer = m_index.get<ByPeer>().lower_bound(
-            ByPeerView{peer, true, uint256(uint256::ZERO)});
-        while (it_peer != m_index.get<ByPeer>().end() &&
-               it_peer->m_peer == peer &&
-               it_peer->GetState() == State::CANDIDATE_BEST) {
-            selected.emplace_back(&*it_peer);
-            ++it_peer;
+        auto peer_it = m_peers.find(peer);
+        if (peer_it == m_peers.end()) {
+            return {};
         }
+        return GetCandidateBest(peer_it->second);
+    }
 
-        // Sort by sequence number.
-        std::sort(selected.begin(), selected.end(),
-                  [](const Announcement *a, const Announcement *b) {
-                      return a->m_sequence < b->m_sequence;
-                  });
+    //! Find the InvIds to request now from all peers.
+    std::vector<std::pair<NodeId, std::vector<uint256>>>
+    GetRequestable(std::chrono::microseconds now, ClearExpiredFun clearExpired,
+                   EmplaceExpiredFun emplaceExpired) {
+        // Move time once for all the peers.
+        SetTimePoint(now, clearExpired, emplaceExpired);
 
-        // Convert to InvId and return.
-        std::vector<uint256> ret;
-        ret.reserve(selected.size());
-        std::transform(selected.begin(), selected.end(),
-                       std::back_inserter(ret),
-                       [](const Announcement *ann) { return ann->m_invid; });
+        std::vector<std::pair<NodeId, std::vector<uint256>>> ret;
+        for (const auto &[peer, data] : m_peers) {
+            if (data.m_info.m_candidate_best > 0) {
+                ret.emplace_back(peer, GetCandidateBest(data));
+            }
+        }
+        std::sort(ret.begin(), ret.end(), [](const auto &a, const auto &b) {
+            return a.first < b.first;
+        });
         return ret;
     }
 
     void RequestedData(NodeId peer, const uint256 &invid,
                        std::chrono::microseconds expiry) {
-        auto it = m_index.get<ByPeer>().find(ByPeerView{peer, true, invid});
-        if (it == m_index.get<ByPeer>().end()) {
+        auto it = m_invids.find(invid);
+        if (it == m_invids.end()) {
+            return;
+        }
+        InvIdAnnouncements &anns = it->second;
+        const AnnPos pos = FindAnnouncement(anns, peer);
+        if (pos == NO_ANNOUNCEMENT) {
+            return;
+        }
+
+        const State state = m_announcements[pos].GetState();
+        if (state != State::CANDIDATE_BEST) {
             // There is no CANDIDATE_BEST announcement, look for a _READY or
             // _DELAYED instead. If the caller only ever invokes RequestedData
             // with the values returned by GetRequestable, and no other
@@ -759,11 +1001,8 @@ public:
             // between, this branch will never execute (as invids returned by
             // GetRequestable always correspond to CANDIDATE_BEST
             // announcements).
-
-            it = m_index.get<ByPeer>().find(ByPeerView{peer, false, invid});
-            if (it == m_index.get<ByPeer>().end() ||
-                (it->GetState() != State::CANDIDATE_DELAYED &&
-                 it->GetState() != State::CANDIDATE_READY)) {
+            if (state != State::CANDIDATE_DELAYED &&
+                state != State::CANDIDATE_READY) {
                 // There is no CANDIDATE announcement tracked for this peer, so
                 // we have nothing to do. Either this invid wasn't tracked at
                 // all (and the caller should have called ReceivedInv), or it
@@ -773,14 +1012,10 @@ public:
             }
 
             // Look for an existing CANDIDATE_BEST or REQUESTED with the same
-            // invid. We only need to do this if the found announcement had a
-            // different state than CANDIDATE_BEST. If it did, invariants
-            // guarantee that no other CANDIDATE_BEST or REQUESTED can exist.
-            auto it_old = m_index.get<ByInvId>().lower_bound(
-                ByInvIdView{invid, State::CANDIDATE_BEST, 0});
-            if (it_old != m_index.get<ByInvId>().end() &&
-                it_old->m_invid == invid) {
-                if (it_old->GetState() == State::CANDIDATE_BEST) {
+            // invid.
+            if (anns.m_selected != NO_ANNOUNCEMENT) {
+                if (m_announcements[anns.m_selected].GetState() ==
+                    State::CANDIDATE_BEST) {
                     // The data structure's invariants require that there can be
                     // at most one CANDIDATE_BEST or one REQUESTED announcement
                     // per invid (but not both simultaneously), so we have to
@@ -791,66 +1026,61 @@ public:
                     // GetRequestable() time. If time only goes forward, it will
                     // always be _READY, so pick that to avoid extra work in
                     // SetTimePoint().
-                    Modify<ByInvId>(it_old, [](Announcement &ann) {
-                        ann.SetState(State::CANDIDATE_READY);
-                    });
-                } else if (it_old->GetState() == State::REQUESTED) {
+                    SetState(anns.m_selected, anns, State::CANDIDATE_READY);
+                } else {
                     // As we're no longer waiting for a response to the previous
                     // REQUESTED announcement, convert it to COMPLETED. This
                     // also helps guaranteeing progress.
-                    Modify<ByInvId>(it_old, [](Announcement &ann) {
-                        ann.SetState(State::COMPLETED);
-                    });
+                    SetState(anns.m_selected, anns, State::COMPLETED);
                 }
             }
         }
 
-        Modify<ByPeer>(it, [expiry](Announcement &ann) {
-            ann.SetState(State::REQUESTED);
-            ann.m_time = expiry;
-        });
+        m_announcements[pos].m_time = expiry;
+        SetState(pos, anns, State::REQUESTED);
+        anns.m_selected = pos;
     }
 
     void ReceivedResponse(NodeId peer, const uint256 &invid) {
-        // We need to search the ByPeer index for both (peer, false, invid) and
-        // (peer, true, invid).
-        auto it = m_index.get<ByPeer>().find(ByPeerView{peer, false, invid});
-        if (it == m_index.get<ByPeer>().end()) {
-            it = m_index.get<ByPeer>().find(ByPeerView{peer, true, invid});
+        auto it = m_invids.find(invid);
+        if (it == m_invids.end()) {
+            return;
         }
-        if (it != m_index.get<ByPeer>().end()) {
-            MakeCompleted(m_index.project<ByInvId>(it));
+        const AnnPos pos = FindAnnouncement(it->second, peer);
+        if (pos != NO_ANNOUNCEMENT) {
+            MakeCompleted(pos, it);
+            MaybeCompact();
         }
     }
 
     size_t CountInFlight(NodeId peer) const {
-        auto it = m_peerinfo.find(peer);
-        if (it != m_peerinfo.end()) {
-            return it->second.m_requested;
+        auto it = m_peers.find(peer);
+        if (it != m_peers.end()) {
+            return it->second.m_info.m_requested;
         }
         return 0;
     }
 
     size_t CountCandidates(NodeId peer) const {
-        auto it = m_peerinfo.find(peer);
-        if (it != m_peerinfo.end()) {
-            return it->second.m_total - it->second.m_requested -
-                   it->second.m_completed;
+        auto it = m_peers.find(peer);
+        if (it != m_peers.end()) {
+            return it->second.m_info.m_total - it->second.m_info.m_requested -
+                   it->second.m_info.m_completed;
         }
         return 0;
     }
 
     size_t Count(NodeId peer) const {
-        auto it = m_peerinfo.find(peer);
-        if (it != m_peerinfo.end()) {
-            return it->second.m_total;
+        auto it = m_peers.find(peer);
+        if (it != m_peers.end()) {
+            return it->second.m_info.m_total;
         }
         return 0;
     }
 
     //! Count how many announcements are being tracked in total across all peers
     //! and transactions.
-    size_t Size() const { return m_index.size(); }
+    size_t Size() const { return m_announcements.size() - m_free.size(); }
 
     uint64_t ComputePriority(const uint256 &invid, NodeId peer,
                              bool preferred) const {
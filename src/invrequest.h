@@ -10,6 +10,7 @@
 #include <chrono>
 #include <cstdint>
 #include <functional>
+#include <utility>
 #include <vector>
 
 /**
@@ -112,9 +113,11 @@
  * - Memory usage is proportional to the total number of tracked announcements
  *   (Size()) plus the number of peers with a nonzero number of tracked
  *   announcements.
- * - CPU usage is generally logarithmic in the total number of tracked
- *   announcements, plus the number of announcements affected by an operation
- *   (amortized O(1) per announcement).
+ * - CPU usage is generally linear in the number of announcements of the same
+ *   invid, plus logarithmic in the number of announcements waiting for their
+ *   reqtime or expiry, plus the number of announcements affected by an
+ *   operation (amortized O(1) per announcement). Finding the requestable
+ *   announcements of a peer only visits the ones returned.
  */
 
 // Avoid littering this header file with implementation details.
@@ -142,6 +145,9 @@ public:
     GetRequestable(NodeId peer, std::chrono::microseconds now,
                    ClearExpiredFun clearExpired,
                    EmplaceExpiredFun emplaceExpired) = 0;
+    virtual std::vector<std::pair<NodeId, std::vector<uint256>>>
+    GetRequestable(std::chrono::microseconds now, ClearExpiredFun clearExpired,
+                   EmplaceExpiredFun emplaceExpired) = 0;
     virtual void RequestedData(NodeId peer, const uint256 &invid,
                                std::chrono::microseconds expiry) = 0;
     virtual void ReceivedResponse(NodeId peer, const uint256 &invid) = 0;
@@ -261,6 +267,38 @@ public:
         return std::vector<InvId>(hashes.begin(), hashes.end());
     }
 
+    /**
+     * Find the invids to request now from all the peers at once.
+     *
+     * This is equivalent to calling GetRequestable for each peer with the same
+     * now, but moves time and goes through the peers in a single pass. The
+     * expired announcements are returned in expired as above. The peers with
+     * nothing to request are omitted, the others are sorted by NodeId.
+     */
+    std::vector<std::pair<NodeId, std::vector<InvId>>>
+    GetRequestable(std::chrono::microseconds now,
+                   std::vector<std::pair<NodeId, InvId>> *expired) {
+        InvRequestTrackerImplInterface::ClearExpiredFun clearExpired =
+            [expired]() {
+                if (expired) {
+                    expired->clear();
+                }
+            };
+        InvRequestTrackerImplInterface::EmplaceExpiredFun emplaceExpired =
+            [expired](const NodeId &nodeid, const uint256 &invid) {
+                if (expired) {
+                    expired->emplace_back(nodeid, InvId(invid));
+                }
+            };
+        std::vector<std::pair<NodeId, std::vector<InvId>>> ret;
+        for (const auto &[peer, hashes] :
+             m_impl->GetRequestable(now, clearExpired, emplaceExpired)) {
+            ret.emplace_back(peer,
+                             std::vector<InvId>(hashes.begin(), hashes.end()));
+        }
+        return ret;
+    }
+
     /**
      * Marks an inventory as requested, with a specified expiry.
      *
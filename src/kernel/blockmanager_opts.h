@@ -7,6 +7,7 @@
 
 #include <util/fs.h>
 
+#include <cstddef>
 #include <cstdint>
 
 class CChainParams;
@@ -14,6 +15,12 @@ class CChainParams;
 namespace kernel {
 
 static constexpr bool DEFAULT_STOPAFTERBLOCKIMPORT{false};
+/**
+ * Default for -serializedcachesize, in MiB, when the serialized blocks or
+ * transactions are published (-zmqpubrawblock, -zmqpubrawtx or -rest).
+ * Otherwise the cache is disabled by default.
+ */
+static constexpr int64_t DEFAULT_SERIALIZED_CACHE_SIZE{64};
 
 /**
  * An options struct for `BlockManager`, more ergonomically referred to as
@@ -24,6 +31,8 @@ struct BlockManagerOpts {
     uint64_t prune_target{0};
     bool fast_prune{false};
     bool stop_after_block_import{DEFAULT_STOPAFTERBLOCKIMPORT};
+    //! Memory used to cache the recently serialized blocks and transactions
+    size_t serialized_cache_bytes{0};
     const fs::path blocks_dir;
 };
 
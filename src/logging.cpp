@@ -13,6 +13,9 @@
 
 #include <algorithm>
 #include <array>
+#include <cassert>
+#include <chrono>
+#include <iterator>
 
 bool fLogIPs = DEFAULT_LOGIPS;
 const char *const DEFAULT_DEBUGLOGFILE = "debug.log";
@@ -87,6 +90,7 @@ bool BCLog::Logger::StartLogging() {
 }
 
 void BCLog::Logger::DisconnectTestLogger() {
+    StopAsyncLogging();
     StdLockGuard scoped_lock(m_cs);
     m_buffering = true;
     if (m_fileout != nullptr) {
@@ -135,6 +139,7 @@ const CLogCategoryDesc LogCategories[] = {
     {BCLog::BLOCKSTORE, "blockstorage"},
     {BCLog::NETDEBUG, "netdebug"},
     {BCLog::TXPACKAGES, "txpackages"},
+    {BCLog::SCAN, "scan"},
     {BCLog::ALL, "1"},
     {BCLog::ALL, "all"},
 };
@@ -176,19 +181,21 @@ std::vector<LogCategory> BCLog::Logger::LogCategoriesList() const {
 }
 
 BCLog::Logger::~Logger() {
+    StopAsyncLogging();
     if (m_fileout) {
         fclose(m_fileout);
     }
 }
 
-std::string BCLog::Logger::LogTimestampStr(const std::string &str) {
+std::string BCLog::Logger::LogTimestampStr(const std::string &str,
+                                           bool started_new_line) {
     std::string strStamped;
 
     if (!m_log_timestamps) {
         return str;
     }
 
-    if (m_started_new_line) {
+    if (started_new_line) {
         int64_t nTimeMicros = GetTimeMicros();
         strStamped = FormatISO8601DateTime(nTimeMicros / 1000000);
         if (m_log_time_micros) {
@@ -230,26 +237,65 @@ std::string LogEscapeMessage(const std::string &str) {
 }
 } // namespace BCLog
 
-void BCLog::Logger::LogPrintStr(const std::string &str,
-                                const std::string &logging_function,
-                                const std::string &source_file,
-                                const int source_line) {
-    StdLockGuard scoped_lock(m_cs);
+std::string BCLog::Logger::FormatLogStr(const std::string &str,
+                                        const std::string &logging_function,
+                                        const std::string &source_file,
+                                        const int source_line,
+                                        bool &started_new_line) {
     std::string str_prefixed = LogEscapeMessage(str);
 
-    if (m_log_sourcelocations && m_started_new_line) {
+    if (m_log_sourcelocations && started_new_line) {
         str_prefixed.insert(0, "[" + RemovePrefix(source_file, "./") + ":" +
                                    ToString(source_line) + "] [" +
                                    logging_function + "] ");
     }
 
-    if (m_log_threadnames && m_started_new_line) {
+    if (m_log_threadnames && started_new_line) {
         str_prefixed.insert(0, "[" + util::ThreadGetInternalName() + "] ");
     }
 
-    str_prefixed = LogTimestampStr(str_prefixed);
+    str_prefixed = LogTimestampStr(str_prefixed, started_new_line);
+
+    started_new_line = !str.empty() && str[str.size() - 1] == '\n';
+
+    return str_prefixed;
+}
+
+namespace {
+/**
+ * Buffer of the calling thread, and the asynchronous logging session it
+ * belongs to. The id is used rather than the logger address so a buffer is
+ * never reused by another logger allocated at the same address.
+ */
+struct ThreadAsyncBuffer {
+    uint64_t async_id{0};
+    std::shared_ptr<void> buffer;
+    //! Whether the last line logged asynchronously by the thread was complete
+    bool started_new_line{true};
+};
+thread_local ThreadAsyncBuffer t_async_buffer;
+std::atomic<uint64_t> g_next_async_id{1};
+} // namespace
+
+void BCLog::Logger::LogPrintStr(const std::string &str,
+                                const std::string &logging_function,
+                                const std::string &source_file,
+                                const int source_line) {
+    if (m_async.load(std::memory_order_acquire)) {
+        // The line is formatted and timestamped by the logging thread, but
+        // written by the writer thread. Partial lines are only continued by
+        // the same thread, so whether a prefix is needed is tracked per
+        // thread.
+        QueueAsync(FormatLogStr(str, logging_function, source_file,
+                                source_line, t_async_buffer.started_new_line));
+        return;
+    }
 
-    m_started_new_line = !str.empty() && str[str.size() - 1] == '\n';
+    StdLockGuard scoped_lock(m_cs);
+    bool started_new_line{m_started_new_line};
+    std::string str_prefixed = FormatLogStr(
+        str, logging_function, source_file, source_line, started_new_line);
+    m_started_new_line = started_new_line;
 
     if (m_buffering) {
         // buffer if we haven't started logging yet
@@ -265,21 +311,250 @@ void BCLog::Logger::LogPrintStr(const std::string &str,
     for (const auto &cb : m_print_callbacks) {
         cb(str_prefixed);
     }
-    if (m_print_to_file) {
-        assert(m_fileout != nullptr);
-
-        // Reopen the log file, if requested.
-        if (m_reopen_file) {
-            m_reopen_file = false;
-            FILE *new_fileout = fsbridge::fopen(m_file_path, "a");
-            if (new_fileout) {
-                // unbuffered.
-                setbuf(m_fileout, nullptr);
-                fclose(m_fileout);
-                m_fileout = new_fileout;
-            }
+    WriteToFile(str_prefixed);
+}
+
+void BCLog::Logger::WriteToFile(const std::string &str) {
+    if (!m_print_to_file) {
+        return;
+    }
+    assert(m_fileout != nullptr);
+
+    // Reopen the log file, if requested.
+    if (m_reopen_file) {
+        m_reopen_file = false;
+        FILE *new_fileout = fsbridge::fopen(m_file_path, "a");
+        if (new_fileout) {
+            // unbuffered.
+            setbuf(m_fileout, nullptr);
+            fclose(m_fileout);
+            m_fileout = new_fileout;
+        }
+    }
+    FileWriteStr(str, m_fileout);
+}
+
+/**
+ * Single producer, single consumer ring buffer of the lines logged by one
+ * thread. The lines are moved in by the logging thread and out by the writer
+ * thread, so no string is copied.
+ */
+class BCLog::Logger::AsyncBuffer {
+private:
+    std::vector<AsyncLine> m_lines;
+    //! Number of lines pushed, only written by the producer
+    alignas(64) std::atomic<uint64_t> m_head{0};
+    //! Number of lines popped, only written by the consumer
+    alignas(64) std::atomic<uint64_t> m_tail{0};
+
+public:
+    explicit AsyncBuffer(size_t size) : m_lines(size) {}
+
+    /** Only the consumer frees space, so a push can't fail once not full */
+    bool Full() const {
+        return m_head.load(std::memory_order_relaxed) -
+                   m_tail.load(std::memory_order_acquire) >=
+               m_lines.size();
+    }
+
+    void Push(AsyncLine &&line) {
+        const uint64_t head{m_head.load(std::memory_order_relaxed)};
+        assert(head - m_tail.load(std::memory_order_acquire) < m_lines.size());
+        m_lines[head % m_lines.size()] = std::move(line);
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    void PopAll(std::vector<AsyncLine> &lines) {
+        const uint64_t tail{m_tail.load(std::memory_order_relaxed)};
+        const uint64_t head{m_head.load(std::memory_order_acquire)};
+        for (uint64_t i = tail; i < head; i++) {
+            lines.push_back(std::move(m_lines[i % m_lines.size()]));
+        }
+        m_tail.store(head, std::memory_order_release);
+    }
+
+    bool Empty() const {
+        return m_head.load(std::memory_order_acquire) ==
+               m_tail.load(std::memory_order_relaxed);
+    }
+};
+
+void BCLog::Logger::QueueAsync(std::string &&str) {
+    // The buffer is registered on the first line logged by each thread. It
+    // stays registered after the thread exits, until the writer drained it.
+    const uint64_t async_id{m_async_id.load(std::memory_order_relaxed)};
+    if (t_async_buffer.async_id != async_id || !t_async_buffer.buffer) {
+        auto buffer = std::make_shared<AsyncBuffer>(m_async_buffer_size);
+        {
+            StdLockGuard scoped_lock(m_async_buffers_mutex);
+            m_async_buffers.push_back(buffer);
+        }
+        t_async_buffer.async_id = async_id;
+        t_async_buffer.buffer = std::move(buffer);
+    }
+    AsyncBuffer &buffer =
+        *static_cast<AsyncBuffer *>(t_async_buffer.buffer.get());
+
+    while (buffer.Full()) {
+        if (!m_async_block_when_full) {
+            m_dropped_lines.fetch_add(1, std::memory_order_relaxed);
+            return;
         }
-        FileWriteStr(str_prefixed, m_fileout);
+        if (!m_async.load(std::memory_order_acquire)) {
+            // The writer thread is gone, the line can't be written anymore
+            m_dropped_lines.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        m_async_wakeup.notify_one();
+        std::this_thread::yield();
+    }
+    // The sequence is only taken once there is room for the line, so every
+    // sequence is eventually queued and the writer can wait for the gaps.
+    buffer.Push({m_async_sequence.fetch_add(1, std::memory_order_relaxed),
+                 std::move(str)});
+
+    // Not holding the mutex, so the writer might miss this wakeup and only
+    // notice the line after its sleep times out.
+    if (m_async_idle.load(std::memory_order_relaxed)) {
+        m_async_wakeup.notify_one();
+    }
+}
+
+void BCLog::Logger::DrainAsyncBuffers(std::vector<AsyncLine> &batch) {
+    StdLockGuard scoped_lock(m_async_buffers_mutex);
+    for (auto it = m_async_buffers.begin(); it != m_async_buffers.end();) {
+        (*it)->PopAll(batch);
+        // Forget about the buffers of the threads which exited, they can't
+        // be used anymore.
+        if (it->use_count() == 1 && (*it)->Empty()) {
+            it = m_async_buffers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    // Interleave the lines of the different threads as they were logged.
+    // This only orders the lines drained so far, see AsyncWriterThread().
+    std::sort(batch.begin(), batch.end(),
+              [](const AsyncLine &a, const AsyncLine &b) {
+                  return a.sequence < b.sequence;
+              });
+}
+
+void BCLog::Logger::WriteAsyncBatch(const std::vector<AsyncLine> &batch,
+                                    uint64_t dropped) {
+    std::string dropped_str;
+    if (dropped > 0) {
+        dropped_str = strprintf("Dropped %u log lines because the logging "
+                                "buffers were full\n",
+                                dropped);
+        if (m_log_timestamps) {
+            dropped_str = FormatISO8601DateTime(GetTime()) + ' ' + dropped_str;
+        }
+    }
+
+    // All the lines are written at once to the console and the file, rather
+    // than with one system call per line.
+    std::string str{dropped_str};
+    for (const AsyncLine &line : batch) {
+        str += line.str;
+    }
+
+    StdLockGuard scoped_lock(m_cs);
+    if (m_print_to_console) {
+        fwrite(str.data(), 1, str.size(), stdout);
+        fflush(stdout);
+    }
+    for (const auto &cb : m_print_callbacks) {
+        if (!dropped_str.empty()) {
+            cb(dropped_str);
+        }
+        for (const AsyncLine &line : batch) {
+            cb(line.str);
+        }
+    }
+    WriteToFile(str);
+}
+
+void BCLog::Logger::AsyncWriterThread(uint64_t next_sequence) {
+    util::ThreadRename("logger");
+    // A thread can take a sequence and be preempted before queuing its line,
+    // so a drained line can come before lines which are not queued yet. The
+    // lines are held until all the previous sequences are drained, so they
+    // are written in the order they were logged.
+    std::vector<AsyncLine> pending;
+    std::vector<AsyncLine> batch;
+    uint64_t reported_dropped{m_dropped_lines.load()};
+    while (true) {
+        const bool stop{m_async_stop.load()};
+        DrainAsyncBuffers(pending);
+        size_t ready{0};
+        if (stop) {
+            // Nothing is waited for anymore
+            ready = pending.size();
+        }
+        // Lines of a previous session left in a buffer are older than all
+        // the lines of this session.
+        while (ready < pending.size() &&
+               pending[ready].sequence <= next_sequence) {
+            next_sequence =
+                std::max(next_sequence, pending[ready].sequence + 1);
+            ready++;
+        }
+        batch.assign(std::make_move_iterator(pending.begin()),
+                     std::make_move_iterator(pending.begin() + ready));
+        pending.erase(pending.begin(), pending.begin() + ready);
+
+        const uint64_t dropped{m_dropped_lines.load()};
+        if (!batch.empty() || dropped != reported_dropped) {
+            WriteAsyncBatch(batch, dropped - reported_dropped);
+            reported_dropped = dropped;
+            continue;
+        }
+        if (stop) {
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(m_async_wakeup_mutex);
+        m_async_idle = true;
+        m_async_wakeup.wait_for(lock, std::chrono::milliseconds{100});
+        m_async_idle = false;
+    }
+}
+
+bool BCLog::Logger::StartAsyncLogging(bool block_when_full,
+                                      size_t buffer_size) {
+    {
+        StdLockGuard scoped_lock(m_cs);
+        if (m_buffering || m_async || buffer_size == 0) {
+            return false;
+        }
+        m_async_block_when_full = block_when_full;
+        m_async_buffer_size = buffer_size;
+        m_async_stop = false;
+        m_async_id = g_next_async_id++;
+        m_async_writer = std::thread(&Logger::AsyncWriterThread, this,
+                                     m_async_sequence.load());
+    }
+    m_async.store(true, std::memory_order_release);
+    return true;
+}
+
+void BCLog::Logger::StopAsyncLogging() {
+    if (!m_async_writer.joinable()) {
+        return;
+    }
+    // The lines queued so far are still written by the writer thread before
+    // it exits.
+    m_async.store(false, std::memory_order_release);
+    m_async_stop = true;
+    m_async_wakeup.notify_one();
+    m_async_writer.join();
+
+    // A thread could have queued a line concurrently with the above
+    std::vector<AsyncLine> batch;
+    DrainAsyncBuffers(batch);
+    if (!batch.empty()) {
+        WriteAsyncBatch(batch, 0);
     }
 }
 
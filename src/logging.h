@@ -13,17 +13,26 @@
 #include <util/string.h>
 
 #include <atomic>
+#include <condition_variable>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <list>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 static const bool DEFAULT_LOGTIMEMICROS = false;
 static const bool DEFAULT_LOGIPS = false;
 static const bool DEFAULT_LOGTIMESTAMPS = true;
 static const bool DEFAULT_LOGTHREADNAMES = false;
 static const bool DEFAULT_LOGSOURCELOCATIONS = false;
+static const bool DEFAULT_LOGASYNC = false;
+static const bool DEFAULT_LOGASYNCBLOCK = false;
+//! Number of lines each thread can queue when logging asynchronously
+static constexpr size_t DEFAULT_LOGASYNC_BUFFER_SIZE = 4096;
 
 extern bool fLogIPs;
 extern const char *const DEFAULT_DEBUGLOGFILE;
@@ -68,6 +77,7 @@ enum LogFlags : uint32_t {
     BLOCKSTORE = (1 << 26),
     NETDEBUG = (1 << 27),
     TXPACKAGES = (1 << 28),
+    SCAN = (1 << 29),
     ALL = ~uint32_t(0),
 };
 
@@ -85,6 +95,8 @@ private:
     /**
      * m_started_new_line is a state variable that will suppress printing of the
      * timestamp when multiple calls are made that don't end in a newline.
+     * When logging asynchronously, the lines are formatted without holding
+     * m_cs, so each thread keeps its own state instead.
      */
     std::atomic_bool m_started_new_line{true};
 
@@ -93,12 +105,67 @@ private:
      */
     std::atomic<uint32_t> m_categories{0};
 
-    std::string LogTimestampStr(const std::string &str);
+    std::string LogTimestampStr(const std::string &str, bool started_new_line);
+
+    /**
+     * Escape and prefix a log message, and update the started_new_line state
+     * of the caller.
+     */
+    std::string FormatLogStr(const std::string &str,
+                             const std::string &logging_function,
+                             const std::string &source_file,
+                             const int source_line, bool &started_new_line);
 
     /** Slots that connect to the print signal */
     std::list<std::function<void(const std::string &)>>
         m_print_callbacks GUARDED_BY(m_cs){};
 
+    /** Write a formatted string to the file, if enabled */
+    void WriteToFile(const std::string &str) EXCLUSIVE_LOCKS_REQUIRED(m_cs);
+
+    /**
+     * Asynchronous logging: each thread queues its lines, already formatted
+     * and timestamped, into its own lock-free ring buffer. A single writer
+     * thread drains all the buffers and writes the lines in batches.
+     */
+    class AsyncBuffer;
+    struct AsyncLine {
+        //! Global order of the line
+        uint64_t sequence;
+        std::string str;
+    };
+
+    std::atomic<bool> m_async{false};
+    //! Unique for each StartAsyncLogging() call, identifies the buffers
+    std::atomic<uint64_t> m_async_id{0};
+    //! Whether to wait for space rather than drop lines when a buffer is full
+    bool m_async_block_when_full{DEFAULT_LOGASYNCBLOCK};
+    size_t m_async_buffer_size{DEFAULT_LOGASYNC_BUFFER_SIZE};
+    std::atomic<uint64_t> m_async_sequence{0};
+    std::atomic<uint64_t> m_dropped_lines{0};
+
+    mutable StdMutex m_async_buffers_mutex;
+    std::vector<std::shared_ptr<AsyncBuffer>>
+        m_async_buffers GUARDED_BY(m_async_buffers_mutex);
+
+    std::thread m_async_writer;
+    std::atomic<bool> m_async_stop{false};
+    //! Set while the writer thread sleeps because there is nothing to write
+    std::atomic<bool> m_async_idle{false};
+    std::mutex m_async_wakeup_mutex;
+    std::condition_variable m_async_wakeup;
+
+    /** Queue a formatted line from the calling thread */
+    void QueueAsync(std::string &&str);
+    /** Move the lines queued so far into batch, and sort it */
+    void DrainAsyncBuffers(std::vector<AsyncLine> &batch)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_async_buffers_mutex);
+    /** Write a batch of lines to all the outputs */
+    void WriteAsyncBatch(const std::vector<AsyncLine> &batch,
+                         uint64_t dropped) EXCLUSIVE_LOCKS_REQUIRED(!m_cs);
+    /** next_sequence is the sequence of the first line of this session */
+    void AsyncWriterThread(uint64_t next_sequence);
+
 public:
     bool m_print_to_console = false;
     bool m_print_to_file = false;
@@ -145,6 +212,23 @@ public:
     /** Only for testing */
     void DisconnectTestLogger();
 
+    /**
+     * Write the logs from a background thread rather than from the logging
+     * threads, which then never wait on I/O. Must be called after
+     * StartLogging(). When the buffer of a thread is full, its next lines are
+     * dropped and counted, unless block_when_full is set in which case it
+     * waits for the writer thread to make room.
+     */
+    bool StartAsyncLogging(
+        bool block_when_full,
+        size_t buffer_size = DEFAULT_LOGASYNC_BUFFER_SIZE)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_cs);
+    /** Write all the queued lines and go back to synchronous logging */
+    void StopAsyncLogging() EXCLUSIVE_LOCKS_REQUIRED(!m_cs);
+    bool IsAsync() const { return m_async.load(std::memory_order_relaxed); }
+    /** Number of lines dropped because a buffer was full */
+    uint64_t GetDroppedLines() const { return m_dropped_lines.load(); }
+
     void ShrinkDebugFile();
 
     uint32_t GetCategoryMask() const { return m_categories.load(); }
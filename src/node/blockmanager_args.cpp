@@ -42,6 +42,20 @@ std::optional<bilingual_str> ApplyArgsManOptions(const ArgsManager &args,
         opts.stop_after_block_import = *value;
     }
 
+    // The cache only saves work when the serialized data is published. REST
+    // is disabled by default.
+    const bool publishes_serialized{args.IsArgSet("-zmqpubrawblock") ||
+                                    args.IsArgSet("-zmqpubrawtx") ||
+                                    args.GetBoolArg("-rest", false)};
+    const int64_t serialized_cache_size{args.GetIntArg(
+        "-serializedcachesize",
+        publishes_serialized ? kernel::DEFAULT_SERIALIZED_CACHE_SIZE : 0)};
+    if (serialized_cache_size < 0) {
+        return _("Serialized cache size cannot be configured with a "
+                 "negative value.");
+    }
+    opts.serialized_cache_bytes = size_t(serialized_cache_size) << 20;
+
     return std::nullopt;
 }
 } // namespace node
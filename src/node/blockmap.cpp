@@ -0,0 +1,150 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockmap.h>
+
+#include <crypto/common.h>
+#include <memusage.h>
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace node {
+
+//! The block hashes are the result of proof of work, so their bits are
+//! uniformly distributed and can be used directly.
+static uint64_t SlotHash(const BlockHash &hash) {
+    return ReadLE64(hash.begin());
+}
+static uint32_t SlotTag(const BlockHash &hash) {
+    return ReadLE32(hash.begin() + 8);
+}
+
+size_t BlockMap::Find(const BlockHash &hash) const {
+    if (m_table.empty()) {
+        return m_size;
+    }
+    const size_t mask{m_table.size() - 1};
+    const uint32_t tag{SlotTag(hash)};
+    for (size_t i = SlotHash(hash) & mask; m_table[i].index != 0;
+         i = (i + 1) & mask) {
+        const size_t pos{m_table[i].index - 1u};
+        if (m_table[i].tag == tag && Entry(pos).first == hash) {
+            return pos;
+        }
+    }
+    return m_size;
+}
+
+void BlockMap::InsertInTable(const BlockHash &hash, size_t pos) {
+    const size_t mask{m_table.size() - 1};
+    size_t i = SlotHash(hash) & mask;
+    while (m_table[i].index != 0) {
+        i = (i + 1) & mask;
+    }
+    m_table[i] = {SlotTag(hash), uint32_t(pos + 1)};
+}
+
+void BlockMap::AddToTable(const BlockHash &hash, size_t pos) {
+    assert(pos < std::numeric_limits<uint32_t>::max());
+    if (m_size * 4 > m_table.size() * 3) {
+        Rehash(std::max<size_t>(m_table.size() * 2, 16));
+    }
+    InsertInTable(hash, pos);
+}
+
+void BlockMap::Rehash(size_t table_size) {
+    m_table.assign(table_size, Slot{0, 0});
+    for (size_t pos = 0; pos < m_size; pos++) {
+        InsertInTable(Entry(pos).first, pos);
+    }
+}
+
+void BlockMap::reserve(size_t count) {
+    size_t table_size{std::max<size_t>(m_table.size(), 16)};
+    while (count * 4 > table_size * 3) {
+        table_size *= 2;
+    }
+    if (table_size != m_table.size()) {
+        Rehash(table_size);
+    }
+    m_chunks.reserve((count + CHUNK_SIZE - 1) / CHUNK_SIZE);
+}
+
+void BlockMap::clear() {
+    for (size_t pos = 0; pos < m_size; pos++) {
+        Entry(pos).~value_type();
+    }
+    m_chunks.clear();
+    m_table.clear();
+    m_size = 0;
+}
+
+void BlockMap::SortByHeight() {
+    // Counting sort, the order of the entries at the same height is kept
+    std::vector<size_t> height_begin;
+    for (size_t pos = 0; pos < m_size; pos++) {
+        const size_t height = Entry(pos).second.nHeight;
+        if (height_begin.size() < height + 2) {
+            height_begin.resize(height + 2);
+        }
+        height_begin[height + 1]++;
+    }
+    for (size_t i = 1; i < height_begin.size(); i++) {
+        height_begin[i] += height_begin[i - 1];
+    }
+    std::vector<uint32_t> new_pos(m_size);
+    for (size_t pos = 0; pos < m_size; pos++) {
+        new_pos[pos] = height_begin[Entry(pos).second.nHeight]++;
+    }
+
+    std::vector<std::unique_ptr<Storage[]>> new_chunks;
+    new_chunks.reserve(m_chunks.size());
+    for (size_t i = 0; i < m_chunks.size(); i++) {
+        new_chunks.push_back(std::make_unique<Storage[]>(CHUNK_SIZE));
+    }
+    for (size_t pos = 0; pos < m_size; pos++) {
+        const value_type &entry = Entry(pos);
+        new (&new_chunks[new_pos[pos] / CHUNK_SIZE][new_pos[pos] % CHUNK_SIZE])
+            value_type(entry.first, entry.second);
+    }
+    auto new_entry = [&](size_t pos) -> value_type & {
+        return *std::launder(reinterpret_cast<value_type *>(
+            &new_chunks[pos / CHUNK_SIZE][pos % CHUNK_SIZE]));
+    };
+
+    // The copied entries still point to the old ones, which are found
+    // through the hash table as it still refers to the old positions.
+    auto translate = [&](const CBlockIndex *pindex) -> CBlockIndex * {
+        if (!pindex) {
+            return nullptr;
+        }
+        const size_t pos{Find(pindex->GetBlockHash())};
+        assert(pos < m_size);
+        return &new_entry(new_pos[pos]).second;
+    };
+    for (size_t pos = 0; pos < m_size; pos++) {
+        value_type &entry = new_entry(pos);
+        entry.second.pprev = translate(entry.second.pprev);
+        entry.second.pskip = translate(entry.second.pskip);
+        if (entry.second.phashBlock) {
+            entry.second.phashBlock = &entry.first;
+        }
+    }
+
+    const size_t size{m_size};
+    clear();
+    m_chunks = std::move(new_chunks);
+    m_size = size;
+    reserve(size);
+}
+
+size_t BlockMap::DynamicMemoryUsage() const {
+    return m_chunks.size() *
+               memusage::MallocUsage(CHUNK_SIZE * sizeof(Storage)) +
+           memusage::DynamicUsage(m_chunks) + memusage::DynamicUsage(m_table);
+}
+
+} // namespace node
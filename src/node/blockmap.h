@@ -0,0 +1,188 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_BLOCKMAP_H
+#define BITCOIN_NODE_BLOCKMAP_H
+
+#include <blockindex.h>
+#include <primitives/blockhash.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace node {
+
+/**
+ * Storage of the block index entries, with the subset of the
+ * std::unordered_map interface used by the node.
+ *
+ * The entries are allocated in large chunks, in insertion order, and never
+ * move since validation keeps pointers to them. The block index is loaded in
+ * height order (see SortByHeight()) and the headers are mostly received in
+ * height order, so the ancestors of a block are close to each other in memory
+ * and walking them (GetAncestor(), LocatorEntries(), LastCommonAncestor())
+ * mostly stays within a few chunks.
+ *
+ * The hashes are mapped to the entries by a separate open addressing table of
+ * 8 bytes per slot, which holds part of the hash so a lookup only reads the
+ * entry it finds. Compared to a node based map, this saves an allocation, a
+ * bucket and a list pointer per entry.
+ *
+ * Entries can't be erased.
+ */
+class BlockMap {
+public:
+    using value_type = std::pair<const BlockHash, CBlockIndex>;
+
+    template <bool is_const> class Iterator {
+    private:
+        using Map = std::conditional_t<is_const, const BlockMap, BlockMap>;
+        Map *m_map{nullptr};
+        size_t m_pos{0};
+
+        friend class BlockMap;
+        Iterator(Map *map, size_t pos) : m_map(map), m_pos(pos) {}
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = BlockMap::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer =
+            std::conditional_t<is_const, const value_type *, value_type *>;
+        using reference =
+            std::conditional_t<is_const, const value_type &, value_type &>;
+
+        Iterator() = default;
+        /** A const iterator can be obtained from a mutable one */
+        template <bool other_const,
+                  typename = std::enable_if_t<is_const && !other_const>>
+        Iterator(const Iterator<other_const> &other)
+            : m_map(other.m_map), m_pos(other.m_pos) {}
+
+        reference operator*() const { return m_map->Entry(m_pos); }
+        pointer operator->() const { return &m_map->Entry(m_pos); }
+        Iterator &operator++() {
+            m_pos++;
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator copy{*this};
+            m_pos++;
+            return copy;
+        }
+        friend bool operator==(const Iterator &a, const Iterator &b) {
+            return a.m_pos == b.m_pos;
+        }
+        friend bool operator!=(const Iterator &a, const Iterator &b) {
+            return a.m_pos != b.m_pos;
+        }
+
+        template <bool> friend class Iterator;
+    };
+    using iterator = Iterator<false>;
+    using const_iterator = Iterator<true>;
+
+    BlockMap() = default;
+    ~BlockMap() { clear(); }
+    BlockMap(const BlockMap &) = delete;
+    BlockMap &operator=(const BlockMap &) = delete;
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    iterator begin() { return {this, 0}; }
+    iterator end() { return {this, m_size}; }
+    const_iterator begin() const { return {this, 0}; }
+    const_iterator end() const { return {this, m_size}; }
+
+    iterator find(const BlockHash &hash) { return {this, Find(hash)}; }
+    const_iterator find(const BlockHash &hash) const {
+        return {this, Find(hash)};
+    }
+    size_t count(const BlockHash &hash) const {
+        return Find(hash) != m_size ? 1 : 0;
+    }
+
+    /**
+     * Insert an entry constructed from args if the hash is not present yet.
+     * Returns the entry for this hash and whether it was inserted.
+     */
+    template <typename... Args>
+    std::pair<iterator, bool> try_emplace(const BlockHash &hash,
+                                          Args &&...args) {
+        const size_t pos{Find(hash)};
+        if (pos != m_size) {
+            return {{this, pos}, false};
+        }
+        if (m_size % CHUNK_SIZE == 0) {
+            m_chunks.push_back(std::make_unique<Storage[]>(CHUNK_SIZE));
+        }
+        new (&m_chunks.back()[m_size % CHUNK_SIZE])
+            value_type(std::piecewise_construct, std::forward_as_tuple(hash),
+                       std::forward_as_tuple(std::forward<Args>(args)...));
+        m_size++;
+        AddToTable(hash, m_size - 1);
+        return {{this, m_size - 1}, true};
+    }
+
+    CBlockIndex &operator[](const BlockHash &hash) {
+        return try_emplace(hash).first->second;
+    }
+
+    void reserve(size_t count);
+    void clear();
+
+    /**
+     * Reorder the entries by height, fixing their pprev, pskip and
+     * phashBlock pointers. This invalidates all the other pointers to the
+     * entries, so it can only be called while loading the block index.
+     */
+    void SortByHeight();
+
+    size_t DynamicMemoryUsage() const;
+
+private:
+    //! Number of entries allocated at once, so about 150kB
+    static constexpr size_t CHUNK_SIZE{1024};
+
+    using Storage =
+        std::aligned_storage_t<sizeof(value_type), alignof(value_type)>;
+    std::vector<std::unique_ptr<Storage[]>> m_chunks;
+    size_t m_size{0};
+
+    /** Hash table slot, the index is 0 when the slot is empty */
+    struct Slot {
+        //! Bits of the hash not used to find the slot
+        uint32_t tag;
+        //! Position of the entry + 1
+        uint32_t index;
+    };
+    //! Power of 2 size, at most 3/4 full
+    std::vector<Slot> m_table;
+
+    value_type &Entry(size_t pos) {
+        return *std::launder(reinterpret_cast<value_type *>(
+            &m_chunks[pos / CHUNK_SIZE][pos % CHUNK_SIZE]));
+    }
+    const value_type &Entry(size_t pos) const {
+        return *std::launder(reinterpret_cast<const value_type *>(
+            &m_chunks[pos / CHUNK_SIZE][pos % CHUNK_SIZE]));
+    }
+
+    /** Position of the entry with this hash, or size() if there is none */
+    size_t Find(const BlockHash &hash) const;
+    void AddToTable(const BlockHash &hash, size_t pos);
+    void InsertInTable(const BlockHash &hash, size_t pos);
+    void Rehash(size_t table_size);
+};
+
+} // namespace node
+
+#endif // BITCOIN_NODE_BLOCKMAP_H
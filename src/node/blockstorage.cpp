@@ -22,9 +22,12 @@
 #include <undo.h>
 #include <util/batchpriority.h>
 #include <util/fs.h>
+#include <util/parallel.h>
 #include <validation.h>
 
+#include <algorithm>
 #include <map>
+#include <thread>
 #include <unordered_map>
 
 namespace node {
@@ -246,25 +249,51 @@ CBlockIndex *BlockManager::InsertBlockIndex(const BlockHash &hash) {
 
 bool BlockManager::LoadBlockIndex() {
     AssertLockHeld(cs_main);
+    const size_t threads{std::clamp<size_t>(std::thread::hardware_concurrency(),
+                                            1, MAX_BLOCK_INDEX_LOAD_THREADS)};
+
+    // Avoid rehashing the map over and over while it is filled
+    const bool first_load{m_block_index.empty()};
+    m_block_index.reserve(m_block_tree_db->EstimateBlockIndexCount());
     if (!m_block_tree_db->LoadBlockIndexGuts(
             GetConsensus(),
             [this](const BlockHash &hash) EXCLUSIVE_LOCKS_REQUIRED(cs_main) {
                 return this->InsertBlockIndex(hash);
-            })) {
+            },
+            threads)) {
         return false;
     }
 
-    // Calculate nChainWork
+    // Lay the entries out in height order, so the ancestors of a block are
+    // close to it in memory. This is only possible if nothing else points to
+    // the entries yet, i.e. unless the block index is being reloaded.
+    if (first_load) {
+        m_block_index.SortByHeight();
+    }
     std::vector<CBlockIndex *> vSortedByHeight{GetAllBlockIndices()};
-    std::sort(vSortedByHeight.begin(), vSortedByHeight.end(),
-              CBlockIndexHeightOnlyComparator());
+    if (!first_load) {
+        std::sort(vSortedByHeight.begin(), vSortedByHeight.end(),
+                  CBlockIndexHeightOnlyComparator());
+    }
+
+    // The proof of each block only depends on its own header, compute them
+    // in parallel before accumulating them along the chain.
+    util::ParallelForRanges(
+        vSortedByHeight.size(), threads, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                CBlockIndex &index = *vSortedByHeight[i];
+                index.nChainWork = GetBlockProof(index);
+            }
+        });
 
+    // Calculate nChainWork
     for (CBlockIndex *pindex : vSortedByHeight) {
         if (ShutdownRequested()) {
             return false;
         }
-        pindex->nChainWork = (pindex->pprev ? pindex->pprev->nChainWork : 0) +
-                             GetBlockProof(*pindex);
+        if (pindex->pprev) {
+            pindex->nChainWork += pindex->pprev->nChainWork;
+        }
         pindex->nTimeMax =
             (pindex->pprev ? std::max(pindex->pprev->nTimeMax, pindex->nTime)
                            : pindex->nTime);
@@ -719,8 +748,8 @@ bool BlockManager::FindUndoPos(BlockValidationState &state, int nFile,
 }
 
 bool BlockManager::WriteBlockToDisk(
-    const CBlock &block, FlatFilePos &pos,
-    const CMessageHeader::MessageMagic &messageStart) const {
+    const CBlock &block, const std::vector<uint8_t> *serialized,
+    FlatFilePos &pos, const CMessageHeader::MessageMagic &messageStart) const {
     // Open history file to append
     CAutoFile fileout(OpenBlockFile(pos), SER_DISK, CLIENT_VERSION);
     if (fileout.IsNull()) {
@@ -728,7 +757,9 @@ bool BlockManager::WriteBlockToDisk(
     }
 
     // Write index header
-    unsigned int nSize = GetSerializeSize(block, fileout.GetVersion());
+    unsigned int nSize = serialized
+                             ? serialized->size()
+                             : GetSerializeSize(block, fileout.GetVersion());
     fileout << messageStart << nSize;
 
     // Write block
@@ -738,7 +769,11 @@ bool BlockManager::WriteBlockToDisk(
     }
 
     pos.nPos = (unsigned int)fileOutPos;
-    fileout << block;
+    if (serialized) {
+        fileout.write(MakeByteSpan(*serialized));
+    } else {
+        fileout << block;
+    }
 
     return true;
 }
@@ -784,16 +819,14 @@ bool BlockManager::ReadBlockFromDisk(CBlock &block,
                                      const FlatFilePos &pos) const {
     block.SetNull();
 
-    // Open history file to read
-    CAutoFile filein(OpenBlockFile(pos, true), SER_DISK, CLIENT_VERSION);
-    if (filein.IsNull()) {
-        return error("ReadBlockFromDisk: OpenBlockFile failed for %s",
-                     pos.ToString());
+    // Read the whole block then deserialize it from memory, so the txids are
+    // computed from the bytes read
+    std::vector<uint8_t> data;
+    if (!ReadRawBlockFromDisk(data, pos)) {
+        return false;
     }
-
-    // Read block
     try {
-        filein >> block;
+        SpanReader{SER_DISK, CLIENT_VERSION, data} >> block;
     } catch (const std::exception &e) {
         return error("%s: Deserialize or I/O error - %s at %s", __func__,
                      e.what(), pos.ToString());
@@ -825,6 +858,89 @@ bool BlockManager::ReadBlockFromDisk(CBlock &block,
     return true;
 }
 
+bool BlockManager::ReadRawBlockFromDisk(std::vector<uint8_t> &data,
+                                        const FlatFilePos &pos) const {
+    if (pos.nPos < BLOCK_SERIALIZATION_HEADER_SIZE) {
+        return error("%s: Invalid position %s", __func__, pos.ToString());
+    }
+
+    // Open history file at the index header to read the block size
+    FlatFilePos header_pos{pos};
+    header_pos.nPos -= BLOCK_SERIALIZATION_HEADER_SIZE;
+    CAutoFile filein(OpenBlockFile(header_pos, true), SER_DISK,
+                     CLIENT_VERSION);
+    if (filein.IsNull()) {
+        return error("%s: OpenBlockFile failed for %s", __func__,
+                     pos.ToString());
+    }
+
+    try {
+        CMessageHeader::MessageMagic blk_start;
+        unsigned int blk_size;
+        filein >> blk_start >> blk_size;
+        if (blk_start != GetParams().DiskMagic()) {
+            return error("%s: Block magic mismatch for %s", __func__,
+                         pos.ToString());
+        }
+        // Don't trust the size blindly before allocating the buffer
+        std::error_code ec;
+        const auto file_size{fs::file_size(GetBlockPosFilename(pos), ec)};
+        if (ec || uint64_t(pos.nPos) + blk_size > file_size) {
+            return error("%s: Block size out of the file for %s", __func__,
+                         pos.ToString());
+        }
+        data.resize(blk_size);
+        filein.read(MakeWritableByteSpan(data));
+    } catch (const std::exception &e) {
+        return error("%s: Read error - %s at %s", __func__, e.what(),
+                     pos.ToString());
+    }
+
+    return true;
+}
+
+SerializedData BlockManager::ReadRawBlock(const CBlockIndex &index) const {
+    if (SerializedData cached = m_serialized_cache.GetBlock(
+            index.GetBlockHash())) {
+        return cached;
+    }
+
+    const FlatFilePos block_pos{WITH_LOCK(cs_main, return index.GetBlockPos())};
+    auto data = std::make_shared<std::vector<uint8_t>>();
+    if (!ReadRawBlockFromDisk(*data, block_pos)) {
+        return nullptr;
+    }
+
+    // The first bytes are the block header
+    constexpr size_t header_size{80};
+    if (data->size() < header_size ||
+        BlockHash(Hash(Span{*data}.first(header_size))) !=
+            index.GetBlockHash()) {
+        error("%s: Hash doesn't match index for %s at %s", __func__,
+              index.ToString(), block_pos.ToString());
+        return nullptr;
+    }
+
+    // Not cached: only the blocks written recently are likely to be read
+    // again, and reading old blocks must not evict them.
+    return data;
+}
+
+SerializedData
+BlockManager::GetSerializedTransaction(const CTransaction &tx) const {
+    if (SerializedData cached = m_serialized_cache.GetTransaction(tx.GetId())) {
+        return cached;
+    }
+    // Cached on first use rather than on acceptance to the mempool, so the
+    // transactions are only serialized when they are published, outside of
+    // the validation locks.
+    SerializedData data{SerializeTransaction(tx)};
+    if (m_serialized_cache.IsEnabled()) {
+        m_serialized_cache.AddTransaction(tx.GetId(), data);
+    }
+    return data;
+}
+
 bool BlockManager::ReadTxFromDisk(CMutableTransaction &tx,
                                   const FlatFilePos &pos) const {
     // Open history file to read
@@ -868,9 +984,19 @@ bool BlockManager::ReadTxUndoFromDisk(CTxUndo &tx_undo,
 FlatFilePos BlockManager::SaveBlockToDisk(const CBlock &block, int nHeight,
                                           CChain &active_chain,
                                           const FlatFilePos *dbp) {
-    unsigned int nBlockSize = ::GetSerializeSize(block, CLIENT_VERSION);
     FlatFilePos blockPos;
     const auto position_known{dbp != nullptr};
+    // New blocks are serialized once when they are cached for publishing, the
+    // same bytes are written to disk.
+    std::shared_ptr<std::vector<uint8_t>> serialized;
+    unsigned int nBlockSize;
+    if (!position_known && m_serialized_cache.IsEnabled()) {
+        serialized = std::make_shared<std::vector<uint8_t>>();
+        CVectorWriter{SER_DISK, CLIENT_VERSION, *serialized, 0} << block;
+        nBlockSize = serialized->size();
+    } else {
+        nBlockSize = ::GetSerializeSize(block, CLIENT_VERSION);
+    }
     if (position_known) {
         blockPos = *dbp;
     } else {
@@ -889,10 +1015,15 @@ FlatFilePos BlockManager::SaveBlockToDisk(const CBlock &block, int nHeight,
         return FlatFilePos();
     }
     if (!position_known) {
-        if (!WriteBlockToDisk(block, blockPos, GetParams().DiskMagic())) {
+        if (!WriteBlockToDisk(block, serialized.get(), blockPos,
+                              GetParams().DiskMagic())) {
             AbortNode("Failed to write block");
             return FlatFilePos();
         }
+        if (serialized) {
+            m_serialized_cache.AddBlock(block.GetHash(),
+                                        std::move(serialized));
+        }
     }
     return blockPos;
 }
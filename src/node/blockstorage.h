@@ -13,7 +13,10 @@
 #include <chainparams.h>
 #include <kernel/blockmanager_opts.h>
 #include <kernel/cs_main.h>
+#include <node/blockmap.h>
+#include <node/serializedcache.h>
 #include <protocol.h> // For CMessageHeader::MessageStartChars
+#include <span.h>
 #include <sync.h>
 #include <txdb.h>
 #include <util/fs.h>
@@ -25,6 +28,7 @@ class CBlockHeader;
 class CBlockUndo;
 class CChain;
 class CChainParams;
+class CTransaction;
 class CTxUndo;
 class Chainstate;
 class ChainstateManager;
@@ -51,13 +55,10 @@ static const unsigned int MAX_BLOCKFILE_SIZE = 0x8000000; // 128 MiB
 static constexpr size_t BLOCK_SERIALIZATION_HEADER_SIZE =
     CMessageHeader::MESSAGE_START_SIZE + sizeof(unsigned int);
 
-extern std::atomic_bool fReindex;
+/** Maximum number of threads used to load the block index at startup */
+static constexpr size_t MAX_BLOCK_INDEX_LOAD_THREADS{8};
 
-// Because validation code takes pointers to the map's CBlockIndex objects, if
-// we ever switch to another associative container, we need to either use a
-// container that has stable addressing (true of all std associative
-// containers), or make the key a `std::unique_ptr<CBlockIndex>`
-using BlockMap = std::unordered_map<BlockHash, CBlockIndex, BlockHasher>;
+extern std::atomic_bool fReindex;
 
 struct PruneLockInfo {
     //! Height of earliest block that should be kept and not pruned
@@ -99,8 +100,13 @@ private:
 
     FILE *OpenUndoFile(const FlatFilePos &pos, bool fReadOnly = false) const;
 
+    /**
+     * Write the block, from its serialization when the caller already has
+     * it, so it is not serialized again.
+     */
     bool
-    WriteBlockToDisk(const CBlock &block, FlatFilePos &pos,
+    WriteBlockToDisk(const CBlock &block,
+                     const std::vector<uint8_t> *serialized, FlatFilePos &pos,
                      const CMessageHeader::MessageMagic &messageStart) const;
     bool
     UndoWriteToDisk(const CBlockUndo &blockundo, FlatFilePos &pos,
@@ -169,11 +175,18 @@ private:
 
     const kernel::BlockManagerOpts m_opts;
 
+    /**
+     * Blocks written and transactions accepted recently, kept serialized for
+     * publishing them without disk I/O.
+     */
+    mutable SerializedCache m_serialized_cache;
+
 public:
     using Options = kernel::BlockManagerOpts;
 
     explicit BlockManager(Options opts)
-        : m_prune_mode{opts.prune_target > 0}, m_opts{std::move(opts)} {};
+        : m_prune_mode{opts.prune_target > 0}, m_opts{std::move(opts)},
+          m_serialized_cache{m_opts.serialized_cache_bytes} {};
 
     std::atomic<bool> m_importing{false};
 
@@ -287,6 +300,18 @@ public:
     /** Functions for disk access for blocks */
     bool ReadBlockFromDisk(CBlock &block, const FlatFilePos &pos) const;
     bool ReadBlockFromDisk(CBlock &block, const CBlockIndex &index) const;
+    /**
+     * Read the serialization of the block at pos, checking the size written
+     * before it against the size of the file.
+     */
+    bool ReadRawBlockFromDisk(std::vector<uint8_t> &data,
+                              const FlatFilePos &pos) const;
+    /**
+     * Return the network serialization of a block, from the cache of the
+     * recently written blocks if possible, or nullptr if it can't be read.
+     * The blocks read from disk are not added to the cache.
+     */
+    SerializedData ReadRawBlock(const CBlockIndex &index) const;
     bool UndoReadFromDisk(CBlockUndo &blockundo,
                           const CBlockIndex &index) const;
 
@@ -294,6 +319,17 @@ public:
     bool ReadTxFromDisk(CMutableTransaction &tx, const FlatFilePos &pos) const;
     bool ReadTxUndoFromDisk(CTxUndo &tx, const FlatFilePos &pos) const;
 
+    /**
+     * Return the network serialization of a transaction. It is cached, so a
+     * transaction published when it is accepted to the mempool is not
+     * serialized again when it is published as part of a block.
+     */
+    SerializedData GetSerializedTransaction(const CTransaction &tx) const;
+
+    const SerializedCache &GetSerializedCache() const {
+        return m_serialized_cache;
+    }
+
     void CleanupBlockRevFiles() const;
 };
 
@@ -48,8 +48,11 @@ ApplyArgsManOptions(const ArgsManager &args, ChainstateManager::Options &opts) {
         opts.max_tip_age = std::chrono::seconds{*value};
     }
 
-    ReadDatabaseArgs(args, opts.block_tree_db);
-    ReadDatabaseArgs(args, opts.coins_db);
+    if (auto error{CheckDatabaseArgs(args)}) {
+        return error;
+    }
+    ReadDatabaseArgs(args, opts.block_tree_db, "blocks");
+    ReadDatabaseArgs(args, opts.coins_db, "chainstate");
     ReadCoinsViewArgs(args, opts.coins_view);
 
     return std::nullopt;
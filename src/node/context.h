@@ -57,6 +57,9 @@ struct NodeContext {
     //! opened by the gui.
     interfaces::WalletClient *wallet_client{nullptr};
     std::unique_ptr<CScheduler> scheduler;
+    //! Runs the validation interface callbacks when -schedulerthreads is more
+    //! than 1, otherwise they run on the scheduler.
+    std::unique_ptr<CScheduler> validation_signals_scheduler;
     std::function<void()> rpc_interruption_point = [] {};
     std::unique_ptr<KernelNotifications> notifications;
 
@@ -6,14 +6,71 @@
 
 #include <common/args.h>
 #include <dbwrapper.h>
+#include <tinyformat.h>
+#include <util/translation.h>
+
+#include <algorithm>
+#include <array>
+#include <string_view>
 
 namespace node {
-void ReadDatabaseArgs(const ArgsManager &args, DBOptions &options) {
-    // Settings here apply to all databases (chainstate, blocks, and index
-    // databases), but it'd be easy to parse database-specific options by adding
-    // a database_type string or enum parameter to this function.
+static constexpr std::array<std::string_view, 5> DB_NAMES{
+    {"blocks", "chainstate", "txindex", "coinstatsindex", "blockfilterindex"}};
+
+/**
+ * Split a -dbprofile value into the name of the database it applies to, empty
+ * for all of them, and the name of the profile.
+ */
+static std::pair<std::string, std::string>
+SplitProfileArg(const std::string &value) {
+    const size_t sep{value.find(':')};
+    if (sep == std::string::npos) {
+        return {"", value};
+    }
+    return {value.substr(0, sep), value.substr(sep + 1)};
+}
+
+void ReadDatabaseArgs(const ArgsManager &args, DBOptions &options,
+                      const std::string &db_name) {
     if (auto value = args.GetBoolArg("-forcecompactdb")) {
         options.force_compact = *value;
     }
+
+    // The profiles given for this database take precedence over the ones
+    // given for all of them, and the last one given is used.
+    std::optional<DBStorageProfile> all_profile;
+    std::optional<DBStorageProfile> db_profile;
+    for (const std::string &value : args.GetArgs("-dbprofile")) {
+        const auto [name, profile_name] = SplitProfileArg(value);
+        if (auto profile = GetDBStorageProfile(profile_name)) {
+            if (name.empty()) {
+                all_profile = profile;
+            } else if (name == db_name) {
+                db_profile = profile;
+            }
+        }
+    }
+    if (db_profile) {
+        options.storage = *db_profile;
+    } else if (all_profile) {
+        options.storage = *all_profile;
+    }
+}
+
+std::optional<bilingual_str> CheckDatabaseArgs(const ArgsManager &args) {
+    for (const std::string &value : args.GetArgs("-dbprofile")) {
+        const auto [name, profile_name] = SplitProfileArg(value);
+        if (!name.empty() &&
+            std::find(DB_NAMES.begin(), DB_NAMES.end(), name) ==
+                DB_NAMES.end()) {
+            return strprintf(Untranslated("Unknown database in -dbprofile=%s"),
+                             value);
+        }
+        if (!GetDBStorageProfile(profile_name)) {
+            return strprintf(Untranslated("Unknown profile in -dbprofile=%s"),
+                             value);
+        }
+    }
+    return std::nullopt;
 }
 } // namespace node
@@ -5,11 +5,24 @@
 #ifndef BITCOIN_NODE_DATABASE_ARGS_H
 #define BITCOIN_NODE_DATABASE_ARGS_H
 
+#include <optional>
+#include <string>
+
 class ArgsManager;
+struct bilingual_str;
 struct DBOptions;
 
 namespace node {
-void ReadDatabaseArgs(const ArgsManager &args, DBOptions &options);
+/**
+ * Read the options of a database. db_name is the name used to select it in
+ * the -dbprofile arguments: blocks, chainstate, txindex, coinstatsindex or
+ * blockfilterindex.
+ */
+void ReadDatabaseArgs(const ArgsManager &args, DBOptions &options,
+                      const std::string &db_name);
+
+/** Check the database options, returning an error message if invalid */
+std::optional<bilingual_str> CheckDatabaseArgs(const ArgsManager &args);
 } // namespace node
 
 #endif // BITCOIN_NODE_DATABASE_ARGS_H
@@ -4,10 +4,12 @@
 
 #include <addrdb.h>
 #include <banman.h>
+#include <blockfilter.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <common/args.h>
 #include <config.h>
+#include <index/blockfilterindex.h>
 #include <init.h>
 #include <interfaces/chain.h>
 #include <interfaces/handler.h>
@@ -554,6 +556,27 @@ namespace {
             }
             return std::nullopt;
         }
+        bool hasBlockFilterIndex(BlockFilterType filter_type) override {
+            return GetBlockFilterIndex(filter_type) != nullptr;
+        }
+        std::optional<bool>
+        blockFilterMatchesAny(BlockFilterType filter_type,
+                              const BlockHash &block_hash,
+                              const GCSFilter::ElementSet &filter_set) override {
+            const BlockFilterIndex *block_filter_index{
+                GetBlockFilterIndex(filter_type)};
+            if (!block_filter_index) {
+                return std::nullopt;
+            }
+
+            const CBlockIndex *index{WITH_LOCK(
+                ::cs_main,
+                return chainman().m_blockman.LookupBlockIndex(block_hash))};
+            if (index == nullptr) {
+                return std::nullopt;
+            }
+            return block_filter_index->MatchAny(index, filter_set);
+        }
         bool findBlock(const BlockHash &hash,
                        const FoundBlock &block) override {
             WAIT_LOCK(cs_main, lock);
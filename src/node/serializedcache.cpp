@@ -0,0 +1,63 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/serializedcache.h>
+
+#include <primitives/transaction.h>
+#include <streams.h>
+#include <version.h>
+
+namespace node {
+
+SerializedData SerializeTransaction(const CTransaction &tx) {
+    auto data = std::make_shared<std::vector<uint8_t>>();
+    CVectorWriter{SER_NETWORK, PROTOCOL_VERSION, *data, 0} << tx;
+    return data;
+}
+
+SerializedCache::SerializedCache(size_t max_bytes)
+    : m_blocks(max_bytes - max_bytes / 4), m_txs(max_bytes / 4) {}
+
+void SerializedCache::LRU::Add(const uint256 &hash, SerializedData data) {
+    // Don't let a single entry evict everything else
+    if (!data || data->size() > m_max_bytes / 2) {
+        return;
+    }
+
+    LOCK(m_mutex);
+    auto it = m_map.find(hash);
+    if (it != m_map.end()) {
+        m_entries.splice(m_entries.begin(), m_entries, it->second);
+        return;
+    }
+
+    m_bytes += data->size();
+    m_entries.emplace_front(hash, std::move(data));
+    m_map.emplace(hash, m_entries.begin());
+    while (m_bytes > m_max_bytes) {
+        const auto &oldest = m_entries.back();
+        m_bytes -= oldest.second->size();
+        m_map.erase(oldest.first);
+        m_entries.pop_back();
+    }
+}
+
+SerializedData SerializedCache::LRU::Get(const uint256 &hash) {
+    LOCK(m_mutex);
+    auto it = m_map.find(hash);
+    if (it == m_map.end()) {
+        m_misses++;
+        return nullptr;
+    }
+    m_hits++;
+    m_entries.splice(m_entries.begin(), m_entries, it->second);
+    return it->second->second;
+}
+
+SerializedCache::Stats SerializedCache::LRU::GetStats() const {
+    LOCK(m_mutex);
+    return {m_hits, m_misses, m_map.size(), m_bytes};
+}
+
+} // namespace node
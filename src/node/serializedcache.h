@@ -0,0 +1,106 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_SERIALIZEDCACHE_H
+#define BITCOIN_NODE_SERIALIZEDCACHE_H
+
+#include <primitives/blockhash.h>
+#include <primitives/txid.h>
+#include <sync.h>
+#include <uint256.h>
+#include <util/hasher.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class CTransaction;
+
+namespace node {
+
+/** Network serialization of a block or a transaction, shared by its users */
+using SerializedData = std::shared_ptr<const std::vector<uint8_t>>;
+
+SerializedData SerializeTransaction(const CTransaction &tx);
+
+/**
+ * Cache of the serialized blocks and transactions most recently seen by the
+ * node.
+ *
+ * The blocks are added when they are written to disk, so publishing them
+ * (ZMQ, REST, RPC) shortly after doesn't need to read them back from disk.
+ * The transactions are added when they are first published, so they are not
+ * serialized again when published as part of a block. A quarter of the memory
+ * is dedicated to the transactions, so a large block can't evict all of them.
+ * Each part is a LRU cache bounded by the size of the data it holds.
+ */
+class SerializedCache {
+public:
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        size_t entries;
+        size_t bytes;
+    };
+
+    explicit SerializedCache(size_t max_bytes);
+
+    bool IsEnabled() const { return m_blocks.GetMaxBytes() > 0; }
+
+    void AddBlock(const BlockHash &hash, SerializedData data) {
+        m_blocks.Add(hash, std::move(data));
+    }
+    /** Return the serialized block, or nullptr if it is not cached */
+    SerializedData GetBlock(const BlockHash &hash) {
+        return m_blocks.Get(hash);
+    }
+
+    void AddTransaction(const TxId &txid, SerializedData data) {
+        m_txs.Add(txid, std::move(data));
+    }
+    /** Return the serialized transaction, or nullptr if it is not cached */
+    SerializedData GetTransaction(const TxId &txid) { return m_txs.Get(txid); }
+
+    Stats GetBlockStats() const { return m_blocks.GetStats(); }
+    Stats GetTransactionStats() const { return m_txs.GetStats(); }
+
+private:
+    class LRU {
+    private:
+        const size_t m_max_bytes;
+
+        mutable Mutex m_mutex;
+        //! Most recently used first
+        std::list<std::pair<uint256, SerializedData>>
+            m_entries GUARDED_BY(m_mutex);
+        std::unordered_map<uint256, decltype(m_entries)::iterator,
+                           SaltedUint256Hasher>
+            m_map GUARDED_BY(m_mutex);
+        size_t m_bytes GUARDED_BY(m_mutex){0};
+        uint64_t m_hits GUARDED_BY(m_mutex){0};
+        uint64_t m_misses GUARDED_BY(m_mutex){0};
+
+    public:
+        explicit LRU(size_t max_bytes) : m_max_bytes(max_bytes) {}
+
+        size_t GetMaxBytes() const { return m_max_bytes; }
+
+        void Add(const uint256 &hash, SerializedData data)
+            EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+        SerializedData Get(const uint256 &hash)
+            EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+        Stats GetStats() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    };
+
+    LRU m_blocks;
+    LRU m_txs;
+};
+
+} // namespace node
+
+#endif // BITCOIN_NODE_SERIALIZEDCACHE_H
@@ -0,0 +1,219 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/txoutsetscan.h>
+
+#include <kernel/cs_main.h>
+#include <txdb.h>
+#include <util/parallel.h>
+#include <validation.h>
+
+#include <algorithm>
+#include <unordered_map>
+
+namespace node {
+
+namespace {
+//! Number of distinct first bytes of the txids, by which the coins are split
+constexpr size_t NUM_PREFIXES{256};
+
+struct Match {
+    size_t request;
+    COutPoint outpoint;
+    Coin coin;
+};
+
+/** The coins scanned by a thread, with txids in [prefix_begin, prefix_end) */
+struct Partition {
+    size_t prefix_begin;
+    size_t prefix_end;
+    std::unique_ptr<CCoinsViewCursor> cursor;
+
+    std::atomic<int> progress{0};
+    int64_t count{0};
+    bool completed{false};
+    std::vector<Match> matches;
+    std::exception_ptr error;
+};
+} // namespace
+
+TxOutSetScanner::Result
+TxOutSetScanner::Scan(ChainstateManager &chainman,
+                      const std::shared_ptr<Request> &request,
+                      const std::function<void()> &interruption_point) {
+    WAIT_LOCK(m_mutex, lock);
+    m_requests.push_back(request);
+
+    std::exception_ptr error;
+    while (!request->m_done) {
+        if (m_pass_running) {
+            // The request is answered by the running pass or the next one
+            m_cv.wait(lock);
+            continue;
+        }
+
+        std::vector<std::shared_ptr<Request>> pass;
+        for (const auto &queued : m_requests) {
+            if (!queued->m_started) {
+                queued->m_started = true;
+                pass.push_back(queued);
+            }
+        }
+        m_pass_running = true;
+
+        std::vector<Result> results;
+        {
+            REVERSE_LOCK(lock);
+            results = RunPass(chainman, pass, interruption_point, error);
+        }
+        for (size_t i = 0; i < pass.size(); i++) {
+            pass[i]->m_result = std::move(results[i]);
+            pass[i]->m_done = true;
+        }
+        m_pass_running = false;
+        m_cv.notify_all();
+    }
+
+    m_requests.erase(
+        std::find(m_requests.begin(), m_requests.end(), request));
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return std::move(request->m_result);
+}
+
+std::vector<std::shared_ptr<TxOutSetScanner::Request>>
+TxOutSetScanner::GetRequests() const {
+    LOCK(m_mutex);
+    return m_requests;
+}
+
+std::vector<TxOutSetScanner::Result>
+TxOutSetScanner::RunPass(ChainstateManager &chainman,
+                         const std::vector<std::shared_ptr<Request>> &requests,
+                         const std::function<void()> &interruption_point,
+                         std::exception_ptr &error) {
+    // Map each script to the requests looking for it
+    std::unordered_map<CScript, std::vector<size_t>, SaltedSipHasher> needles;
+    for (size_t i = 0; i < requests.size(); i++) {
+        for (const CScript &script : requests[i]->m_scripts) {
+            needles[script].push_back(i);
+        }
+    }
+
+    const size_t num_threads{
+        std::clamp<size_t>(m_max_threads, 1, NUM_PREFIXES)};
+    std::vector<Partition> partitions(num_threads);
+    const CBlockIndex *tip;
+    {
+        // All the cursors see the same state of the UTXO set
+        LOCK(cs_main);
+        Chainstate &chainstate = chainman.ActiveChainstate();
+        chainstate.ForceFlushStateToDisk();
+        for (size_t i = 0; i < num_threads; i++) {
+            Partition &partition = partitions[i];
+            partition.prefix_begin = NUM_PREFIXES * i / num_threads;
+            partition.prefix_end = NUM_PREFIXES * (i + 1) / num_threads;
+            uint256 start;
+            *start.begin() = partition.prefix_begin;
+            partition.cursor.reset(
+                chainstate.CoinsDB().Cursor(COutPoint(TxId(start), 0)));
+        }
+        tip = chainstate.m_chain.Tip();
+    }
+
+    auto updateProgress = [&] {
+        int total{0};
+        for (const Partition &partition : partitions) {
+            total += partition.progress;
+        }
+        for (const auto &request : requests) {
+            request->m_progress = total / int(num_threads);
+        }
+    };
+    auto allAborted = [&] {
+        return std::all_of(
+            requests.begin(), requests.end(),
+            [](const auto &request) { return request->m_should_abort.load(); });
+    };
+
+    std::atomic<bool> should_stop{false};
+    auto scanPartition = [&](Partition &partition) {
+        CCoinsViewCursor &cursor = *partition.cursor;
+        const size_t range{0x100 * (partition.prefix_end -
+                                    partition.prefix_begin)};
+        for (; cursor.Valid(); cursor.Next()) {
+            COutPoint key;
+            Coin coin;
+            if (!cursor.GetKey(key) || !cursor.GetValue(coin)) {
+                return;
+            }
+            const uint8_t *txid = key.GetTxId().begin();
+            if (txid[0] >= partition.prefix_end) {
+                break;
+            }
+            if (++partition.count % 8192 == 0) {
+                if (interruption_point) {
+                    try {
+                        interruption_point();
+                    } catch (...) {
+                        partition.error = std::current_exception();
+                        should_stop = true;
+                    }
+                }
+                if (should_stop || allAborted()) {
+                    should_stop = true;
+                    return;
+                }
+            }
+            if (partition.count % 256 == 0) {
+                // update progress reference every 256 item
+                const size_t high = 0x100 * txid[0] + txid[1] -
+                                    0x100 * partition.prefix_begin;
+                partition.progress = int(high * 100.0 / range + 0.5);
+                updateProgress();
+            }
+            auto it = needles.find(coin.GetTxOut().scriptPubKey);
+            if (it != needles.end()) {
+                for (size_t request : it->second) {
+                    partition.matches.push_back({request, key, coin});
+                }
+            }
+        }
+        partition.progress = 100;
+        updateProgress();
+        partition.completed = true;
+    };
+    util::ParallelForRanges(
+        num_threads, num_threads, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                scanPartition(partitions[i]);
+            }
+        });
+
+    int64_t count{0};
+    bool completed{true};
+    for (const Partition &partition : partitions) {
+        count += partition.count;
+        completed &= partition.completed;
+        if (partition.error && !error) {
+            error = partition.error;
+        }
+    }
+    std::vector<Result> results(requests.size());
+    for (size_t i = 0; i < requests.size(); i++) {
+        results[i].success = completed && !requests[i]->m_should_abort;
+        results[i].count = count;
+        results[i].tip = tip;
+    }
+    for (Partition &partition : partitions) {
+        for (Match &match : partition.matches) {
+            results[match.request].coins.emplace(match.outpoint,
+                                                 std::move(match.coin));
+        }
+    }
+    return results;
+}
+
+} // namespace node
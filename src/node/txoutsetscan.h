@@ -0,0 +1,114 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_NODE_TXOUTSETSCAN_H
+#define BITCOIN_NODE_TXOUTSETSCAN_H
+
+#include <coins.h>
+#include <primitives/transaction.h>
+#include <script/script.h>
+#include <sync.h>
+#include <util/hasher.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <unordered_set>
+#include <vector>
+
+class CBlockIndex;
+class ChainstateManager;
+
+namespace node {
+
+/**
+ * Scanner of the UTXO set for the coins matching sets of scripts
+ * (scantxoutset).
+ *
+ * The requests made while a scan is running are queued, then answered
+ * together by a single pass over the UTXO set once it completes. A pass
+ * splits the coins database by txid prefix between several threads, each
+ * matching the coins against the scripts of all the requests.
+ */
+class TxOutSetScanner {
+public:
+    using Scripts = std::unordered_set<CScript, SaltedSipHasher>;
+
+    struct Result {
+        //! Whether the scan was completed
+        bool success{false};
+        //! Number of coins scanned
+        int64_t count{0};
+        //! Tip of the chain at the time of the scan
+        const CBlockIndex *tip{nullptr};
+        std::map<COutPoint, Coin> coins;
+    };
+
+    class Request {
+    private:
+        const Scripts m_scripts;
+        std::atomic<int> m_progress{0};
+        std::atomic<bool> m_should_abort{false};
+
+        //! Guarded by the mutex of the scanner
+        bool m_started{false};
+        bool m_done{false};
+        Result m_result;
+
+        friend class TxOutSetScanner;
+
+    public:
+        explicit Request(Scripts scripts) : m_scripts(std::move(scripts)) {}
+
+        /** Progress of the scan in %, 0 while it is queued */
+        int GetProgress() const { return m_progress; }
+        /** Stop scanning for this request, its result is unsuccessful */
+        void Abort() { m_should_abort = true; }
+    };
+
+    explicit TxOutSetScanner(size_t max_threads) : m_max_threads(max_threads) {}
+
+    /**
+     * Queue the request then wait for its result. The calling thread runs the
+     * pass if none is running, answering all the queued requests.
+     *
+     * interruption_point is called periodically by the threads of a pass run
+     * from this call. If it throws, the pass is aborted and the exception is
+     * rethrown once the queued requests are answered.
+     */
+    Result Scan(ChainstateManager &chainman,
+                const std::shared_ptr<Request> &request,
+                const std::function<void()> &interruption_point = {})
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** The requests not answered yet, oldest first */
+    std::vector<std::shared_ptr<Request>> GetRequests() const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+private:
+    const size_t m_max_threads;
+
+    mutable Mutex m_mutex;
+    std::condition_variable m_cv;
+    std::vector<std::shared_ptr<Request>> m_requests GUARDED_BY(m_mutex);
+    bool m_pass_running GUARDED_BY(m_mutex){false};
+
+    /**
+     * Scan the UTXO set for the given requests, returning their results in
+     * the same order. error is set if interruption_point threw.
+     */
+    std::vector<Result>
+    RunPass(ChainstateManager &chainman,
+            const std::vector<std::shared_ptr<Request>> &requests,
+            const std::function<void()> &interruption_point,
+            std::exception_ptr &error) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+};
+
+} // namespace node
+
+#endif // BITCOIN_NODE_TXOUTSETSCAN_H
@@ -7,6 +7,18 @@
 #include <avalanche/avalanche.h>
 #include <blockindex.h>
 #include <common/args.h>
+#include <common/system.h>
+#include <util/parallel.h>
+
+#include <algorithm>
+#include <atomic>
+
+/**
+ * The block transactions are checked by up to MAX_PRECONSENSUS_THREADS
+ * threads, each handling at least PRECONSENSUS_TXS_PER_THREAD transactions.
+ */
+static constexpr size_t MAX_PRECONSENSUS_THREADS{4};
+static constexpr size_t PRECONSENSUS_TXS_PER_THREAD{4096};
 
 bool PreConsensusPolicy::operator()(BlockPolicyValidationState &state) {
     if (!m_mempool || !m_blockIndex.pprev ||
@@ -15,28 +27,57 @@ bool PreConsensusPolicy::operator()(BlockPolicyValidationState &state) {
         return true;
     }
 
-    AssertLockHeld(m_mempool->cs);
-
-    // TODO Use a CoinViewCache
-    for (const auto &tx : m_block.vtx) {
-        for (const auto &txin : tx->vin) {
-            const CTransaction *ptxConflicting =
-                m_mempool->GetConflictTx(txin.prevout);
+    const auto &vtx = m_block.vtx;
+    return m_mempool->withFinalizedSpenders(
+        [&](const CTxMemPool::FinalizedSpenders &spenders) {
+            if (spenders.empty()) {
+                return true;
+            }
 
             // Only allow for the exact txid for each coin spent
-            if (ptxConflicting && ptxConflicting->GetId() != tx->GetId() &&
-                m_mempool->isAvalancheFinalized(ptxConflicting->GetId())) {
-                return state.Invalid(
-                    BlockPolicyValidationResult::POLICY_VIOLATION,
-                    "finalized-tx-conflict",
-                    strprintf("Block %s contains tx %s that conflicts with "
-                              "finalized tx %s",
-                              m_block.GetHash().ToString(),
-                              tx->GetId().ToString(),
-                              ptxConflicting->GetId().ToString()));
+            auto findConflict = [&](const CTransaction &tx) {
+                for (const auto &txin : tx.vin) {
+                    auto it = spenders.find(txin.prevout);
+                    if (it != spenders.end() && it->second != tx.GetId()) {
+                        return it;
+                    }
+                }
+                return spenders.end();
+            };
+
+            // Report the first conflicting tx of the block, whatever the
+            // thread that finds it
+            std::atomic<size_t> firstConflict{vtx.size()};
+            const size_t numThreads = std::min<size_t>(
+                {MAX_PRECONSENSUS_THREADS, size_t(GetNumCores()),
+                 vtx.size() / PRECONSENSUS_TXS_PER_THREAD + 1});
+            util::g_worker_pool.ForRanges(
+                vtx.size(), numThreads, [&](size_t begin, size_t end) {
+                    for (size_t i = begin;
+                         i < end && i < firstConflict.load(); i++) {
+                        if (findConflict(*vtx[i]) == spenders.end()) {
+                            continue;
+                        }
+                        size_t current = firstConflict.load();
+                        while (i < current &&
+                               !firstConflict.compare_exchange_weak(current,
+                                                                    i)) {
+                        }
+                        return;
+                    }
+                });
+
+            if (firstConflict == vtx.size()) {
+                return true;
             }
-        }
-    }
 
-    return true;
+            const CTransaction &tx = *vtx[firstConflict];
+            return state.Invalid(
+                BlockPolicyValidationResult::POLICY_VIOLATION,
+                "finalized-tx-conflict",
+                strprintf("Block %s contains tx %s that conflicts with "
+                          "finalized tx %s",
+                          m_block.GetHash().ToString(), tx.GetId().ToString(),
+                          findConflict(tx)->second.ToString()));
+        });
 }
@@ -23,8 +23,12 @@ public:
                        const CTxMemPool *mempool)
         : m_block(block), m_blockIndex(blockIndex), m_mempool(mempool) {}
 
-    bool operator()(BlockPolicyValidationState &state) override
-        EXCLUSIVE_LOCKS_REQUIRED(m_mempool->cs);
+    /**
+     * Check that the block doesn't conflict with the finalized transactions
+     * of the mempool. This only uses the finalized spenders index of the
+     * mempool, so it doesn't require the mempool lock.
+     */
+    bool operator()(BlockPolicyValidationState &state) override;
 };
 
 #endif // BITCOIN_POLICY_BLOCK_PRECONSENSUS_H
@@ -74,7 +74,7 @@ public:
 
     SERIALIZE_METHODS(CBlock, obj) {
         READWRITEAS(CBlockHeader, obj);
-        READWRITE(obj.vtx);
+        READWRITE(Using<BlockTransactionsFormatter>(obj.vtx));
     }
 
     void SetNull() {
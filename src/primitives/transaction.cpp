@@ -74,6 +74,11 @@ CTransaction::CTransaction(const CMutableTransaction &tx)
 CTransaction::CTransaction(CMutableTransaction &&tx)
     : vin(std::move(tx.vin)), vout(std::move(tx.vout)), nVersion(tx.nVersion),
       nLockTime(tx.nLockTime), hash(ComputeHash()) {}
+CTransaction::CTransaction(Unserialized &&unserialized)
+    : vin(std::move(unserialized.tx.vin)),
+      vout(std::move(unserialized.tx.vout)),
+      nVersion(unserialized.tx.nVersion),
+      nLockTime(unserialized.tx.nLockTime), hash(unserialized.hash) {}
 
 Amount CTransaction::GetValueOut() const {
     Amount nValueOut = Amount::zero();
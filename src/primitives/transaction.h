@@ -9,9 +9,17 @@
 
 #include <consensus/amount.h>
 #include <feerate.h>
+#include <hash.h>
 #include <primitives/txid.h>
 #include <script/script.h>
 #include <serialize.h>
+#include <span.h>
+#include <streams.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <vector>
 
 /**
  * An outpoint - a combination of a transaction hash and an index n into its
@@ -214,6 +222,18 @@ private:
 
     uint256 ComputeHash() const;
 
+    struct Unserialized;
+    /**
+     * Construct from a deserialized transaction and the hash of the bytes it
+     * was read from. The hash is trusted, so this is only available to the
+     * deserialization code.
+     */
+    explicit CTransaction(Unserialized &&unserialized);
+    template <typename Stream>
+    static Unserialized UnserializeAndHash(Stream &s);
+
+    friend struct BlockTransactionsFormatter;
+
 public:
     /** Construct a CTransaction that qualifies as IsNull() */
     CTransaction();
@@ -233,7 +253,7 @@ public:
      */
     template <typename Stream>
     CTransaction(deserialize_type, Stream &s)
-        : CTransaction(CMutableTransaction(deserialize, s)) {}
+        : CTransaction(UnserializeAndHash(s)) {}
 
     bool IsNull() const { return vin.empty() && vout.empty(); }
 
@@ -321,6 +341,88 @@ static inline CTransactionRef MakeTransactionRef(Tx &&txIn) {
     return std::make_shared<const CTransaction>(std::forward<Tx>(txIn));
 }
 
+/** A transaction read from a stream, and the hash of the bytes read */
+struct CTransaction::Unserialized {
+    CMutableTransaction tx;
+    uint256 hash;
+};
+
+template <typename Stream>
+CTransaction::Unserialized CTransaction::UnserializeAndHash(Stream &s) {
+    Unserialized result;
+    if constexpr (IsContiguousStream<Stream>) {
+        // Hash the bytes in the stream buffer rather than serializing the
+        // transaction again.
+        const Span<const uint8_t> data{UCharCast(s.data()), s.size()};
+        SpanReader reader{s.GetType(), s.GetVersion(), data};
+        UnserializeTransaction(result.tx, reader);
+        const size_t size{data.size() - reader.size()};
+        result.hash = Hash(data.first(size));
+        s.ignore(size);
+    } else {
+        UnserializeTransaction(result.tx, s);
+        result.hash = SerializeHash(result.tx, SER_GETHASH, 0);
+    }
+    return result;
+}
+
+/**
+ * Formatter for the transactions of a block. When reading from a contiguous
+ * stream, the txids of all the transactions are computed at once from the
+ * bytes they are deserialized from, so several transactions are hashed in
+ * parallel (see SHA256DMulti()).
+ */
+struct BlockTransactionsFormatter {
+    template <typename Stream>
+    void Ser(Stream &s, const std::vector<CTransactionRef> &vtx) {
+        s << vtx;
+    }
+
+    template <typename Stream>
+    void Unser(Stream &s, std::vector<CTransactionRef> &vtx) {
+        if constexpr (!IsContiguousStream<Stream>) {
+            s >> vtx;
+        } else {
+            const Span<const uint8_t> data{UCharCast(s.data()), s.size()};
+            SpanReader reader{s.GetType(), s.GetVersion(), data};
+            const uint64_t count{ReadCompactSize(reader)};
+
+            // Don't trust the count for the allocation, a transaction takes
+            // at least 10 bytes.
+            const size_t reserved = std::min<uint64_t>(count, data.size() / 10);
+            std::vector<CTransaction::Unserialized> txs;
+            std::vector<const uint8_t *> inputs;
+            std::vector<size_t> sizes;
+            txs.reserve(reserved);
+            inputs.reserve(reserved);
+            sizes.reserve(reserved);
+            while (txs.size() < count) {
+                const size_t remaining{reader.size()};
+                inputs.push_back(reader.data());
+                UnserializeTransaction(txs.emplace_back().tx, reader);
+                sizes.push_back(remaining - reader.size());
+            }
+
+            std::vector<uint8_t> hashes(txs.size() * CSHA256::OUTPUT_SIZE);
+            SHA256DMulti(hashes.data(), inputs.data(), sizes.data(),
+                         txs.size());
+
+            vtx.clear();
+            vtx.reserve(txs.size());
+            for (size_t i = 0; i < txs.size(); i++) {
+                std::copy_n(hashes.begin() + i * CSHA256::OUTPUT_SIZE,
+                            CSHA256::OUTPUT_SIZE, txs[i].hash.begin());
+                // The constructor is private, so std::make_shared can't be
+                // used. Own the transaction before growing vtx, so it is not
+                // leaked if that throws.
+                CTransactionRef tx{new CTransaction(std::move(txs[i]))};
+                vtx.push_back(std::move(tx));
+            }
+            s.ignore(data.size() - reader.size());
+        }
+    }
+};
+
 /** Precompute sighash midstate to avoid quadratic hashing */
 struct PrecomputedTransactionData {
     uint256 hashPrevouts, hashSequence, hashOutputs;
@@ -8,11 +8,15 @@
 #include <common/system.h>
 #include <rcu.h>
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <cstdint>
+#include <iterator>
 #include <memory>
 #include <type_traits>
+#include <utility>
+#include <vector>
 
 template <typename T> struct PassthroughAdapter {
     auto &&getId(const T &e) const { return e.getId(); }
@@ -35,6 +39,10 @@ template <typename T> struct PassthroughAdapter {
  * is reading the tree, which allows deletion to wait for other readers to be up
  * to speed before destroying anything. It is therefore crucial that the lock be
  * taken before reading anything in the tree.
+ *
+ * The leaves are ordered by key, considered as an unsigned integer, so ranges
+ * of keys can be visited in order. Batches of keys can be inserted or removed
+ * in a single walk of the tree.
  */
 template <typename T, typename Adapter = PassthroughAdapter<T>>
 struct RadixTree : private Adapter {
@@ -141,11 +149,113 @@ public:
         return RCUPtr<const T>::acquire(ptr);
     }
 
+    /**
+     * Call func on each leaf, in key order, until it returns false.
+     * Returns false if the iteration was interrupted.
+     */
     template <typename Callable> bool forEachLeaf(Callable &&func) const {
         RCULock lock;
         return forEachLeaf(root.load(), std::move(func));
     }
 
+    /**
+     * Same as forEachLeaf, but only for the leaves whose key is in the range
+     * [first, last]. The subtrees outside of the range are not visited, so
+     * this can be used to iterate over the keys sharing a given prefix.
+     */
+    template <typename Callable>
+    bool forEachLeafInRange(const KeyType &first, const KeyType &last,
+                            Callable &&func) const {
+        RCULock lock;
+        return forEachLeafInRange(root.load(), TOP_LEVEL, first, last, true,
+                                  true, func);
+    }
+
+    /**
+     * Iterator over the leaves in key order.
+     *
+     * It holds a copy of the tree taken when the iteration starts. Because the
+     * nodes are copied on write, the tree can be modified concurrently without
+     * affecting the iteration, and the leaves are kept alive by the copy.
+     * Starting an iteration synchronizes RCU, so it must not be done while
+     * holding a RCULock.
+     */
+    class const_iterator {
+    private:
+        std::shared_ptr<const RadixTree> snapshot;
+        std::vector<std::pair<const RadixNode *, size_t>> stack;
+        T *leaf = nullptr;
+
+        friend struct RadixTree;
+        explicit const_iterator(std::shared_ptr<const RadixTree> snapshotIn)
+            : snapshot(std::move(snapshotIn)) {
+            RadixElement e = snapshot->root.load();
+            if (e.isLeaf()) {
+                leaf = e.getLeaf();
+                return;
+            }
+
+            stack.emplace_back(e.getNode(), 0);
+            next();
+        }
+
+        void next() {
+            leaf = nullptr;
+            while (!stack.empty()) {
+                auto &[node, index] = stack.back();
+                if (index == CHILD_PER_LEVEL) {
+                    stack.pop_back();
+                    continue;
+                }
+
+                RadixElement e = node->getChild(index++);
+                if (e.isNode()) {
+                    stack.emplace_back(e.getNode(), 0);
+                    continue;
+                }
+
+                if (e.getLeaf() != nullptr) {
+                    leaf = e.getLeaf();
+                    return;
+                }
+            }
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = T;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const T *;
+        using reference = const T &;
+
+        const_iterator() = default;
+
+        reference operator*() const { return *leaf; }
+        pointer operator->() const { return leaf; }
+        const_iterator &operator++() {
+            next();
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator copy{*this};
+            next();
+            return copy;
+        }
+        friend bool operator==(const const_iterator &a,
+                               const const_iterator &b) {
+            return a.leaf == b.leaf;
+        }
+        friend bool operator!=(const const_iterator &a,
+                               const const_iterator &b) {
+            return a.leaf != b.leaf;
+        }
+    };
+
+    const_iterator begin() const {
+        return const_iterator(std::make_shared<const RadixTree>(*this));
+    }
+    const_iterator end() const { return const_iterator(); }
+
 #define SEEK_LEAF_LOOP()                                                       \
     RadixElement e = eptr->load();                                             \
                                                                                \
@@ -179,11 +289,173 @@ public:
      * Returns the removed element, or nullptr if there isn't one.
      */
     RCUPtr<T> remove(const KeyType &key) {
-        uint32_t level = TOP_LEVEL;
+        RCULock lock;
+        return remove(&root, TOP_LEVEL, key);
+    }
+
+    /**
+     * Insert a batch of values. The tree is walked once for the whole batch,
+     * which is faster than inserting the values one by one when many of them
+     * share the top levels of the tree.
+     * Returns the number of values inserted, the values which were already
+     * present are skipped.
+     */
+    size_t insertBatch(std::vector<RCUPtr<T>> values) {
+        return forEachInBatch(
+            values, [&](const RCUPtr<T> &value) { return getId(*value); },
+            [&](std::atomic<RadixElement> *eptr, uint32_t level,
+                RCUPtr<T> &value) {
+                const KeyType key = getId(*value);
+                return insert(eptr, level, key, std::move(value));
+            });
+    }
+
+    /**
+     * Remove a batch of keys, walking the tree once for the whole batch.
+     * Returns the number of elements removed.
+     */
+    size_t removeBatch(std::vector<std::remove_const_t<KeyType>> keys) {
+        return forEachInBatch(
+            keys, [](const KeyType &key) -> const KeyType & { return key; },
+            [&](std::atomic<RadixElement> *eptr, uint32_t level,
+                const KeyType &key) {
+                return remove(eptr, level, key) != nullptr;
+            });
+    }
+
+private:
+    KeyType getId(const T &value) const { return Adapter::getId(value); }
+
+    /** Order of the keys in the tree, signed keys are compared as unsigned */
+    static bool keyLess(const KeyType &a, const KeyType &b) {
+        if constexpr (std::is_integral_v<KeyType>) {
+            using UnsignedKey = std::make_unsigned_t<KeyType>;
+            return UnsignedKey(a) < UnsignedKey(b);
+        } else {
+            return a < b;
+        }
+    }
+
+    static size_t childIndex(uint32_t level, const KeyType &key) {
+        return (key >> uint32_t(level * BITS)) & MASK;
+    }
+
+    /**
+     * The top 64 bits of a key, which are enough to find its place in the top
+     * levels of the tree with cheap integer operations.
+     */
+    static const uint32_t PREFIX_SHIFT = KEY_BITS > 64 ? KEY_BITS - 64 : 0;
+    static uint64_t keyPrefix(const KeyType &key) {
+        if constexpr (std::is_integral_v<KeyType>) {
+            return std::make_unsigned_t<KeyType>(key);
+        } else {
+            return size_t(key >> PREFIX_SHIFT);
+        }
+    }
+
+    template <typename Item> struct BatchEntry {
+        uint64_t prefix;
+        Item *item;
+    };
+
+    /** Walk the tree once along all the items, under a single RCULock */
+    template <typename Item, typename GetKey, typename Callable>
+    size_t forEachInBatch(std::vector<Item> &items, GetKey &&getKey,
+                          Callable &&func) {
+        std::vector<BatchEntry<Item>> batch;
+        batch.reserve(items.size());
+        for (Item &item : items) {
+            batch.push_back({keyPrefix(getKey(item)), &item});
+        }
+        std::vector<BatchEntry<Item>> buffer(batch.size());
 
         RCULock lock;
-        std::atomic<RadixElement> *eptr = &root;
+        return forEachInBatch(&root, TOP_LEVEL, batch.data(),
+                              batch.data() + batch.size(), buffer.data(),
+                              getKey, func);
+    }
+
+    /**
+     * Walk down the tree along the batch entries in [begin, end), and call
+     * func(eptr, level, item) for each of them from the deepest slot shared
+     * with the other entries. The shared nodes are copied on the way, the same
+     * way SEEK_LEAF_LOOP does it. Returns the number of calls to func which
+     * returned true.
+     *
+     * The entries are dispatched to the children of each node with a counting
+     * sort, using buffer as scratch space, so the batch doesn't need to be
+     * sorted beforehand.
+     */
+    template <typename Entry, typename GetKey, typename Callable>
+    size_t forEachInBatch(std::atomic<RadixElement> *eptr, uint32_t level,
+                          Entry *begin, Entry *end, Entry *buffer,
+                          GetKey &getKey, Callable &func) {
+        RadixElement e = eptr->load();
+        while (end - begin > 1 && e.isNode()) {
+            RadixNode *nptr = e.getNode();
+            if (nptr->isShared()) {
+                auto copy = std::make_unique<RadixNode>(*nptr);
+                if (!eptr->compare_exchange_strong(e,
+                                                   RadixElement(copy.get()))) {
+                    // We failed to insert our subtree, just try again.
+                    continue;
+                }
+
+                e.decrementRefCount();
+                nptr = copy.release();
+            }
+
+            auto entryChild = [&](const Entry &entry) -> size_t {
+                const uint32_t shift = level * BITS;
+                if (shift >= PREFIX_SHIFT) {
+                    return (entry.prefix >> (shift - PREFIX_SHIFT)) & MASK;
+                }
+                return childIndex(level, getKey(*entry.item));
+            };
+
+            std::array<size_t, CHILD_PER_LEVEL + 1> bounds{};
+            for (Entry *it = begin; it != end; ++it) {
+                bounds[entryChild(*it) + 1]++;
+            }
+            for (size_t i = 1; i <= CHILD_PER_LEVEL; i++) {
+                bounds[i] += bounds[i - 1];
+            }
+
+            std::array<size_t, CHILD_PER_LEVEL> next;
+            std::copy(bounds.begin(), bounds.begin() + CHILD_PER_LEVEL,
+                      next.begin());
+            for (Entry *it = begin; it != end; ++it) {
+                buffer[next[entryChild(*it)]++] = *it;
+            }
+            std::copy(buffer, buffer + (end - begin), begin);
+
+            size_t count = 0;
+            for (size_t i = 0; i < CHILD_PER_LEVEL; i++) {
+                if (bounds[i] == bounds[i + 1]) {
+                    continue;
+                }
+
+                count += forEachInBatch(nptr->getSlot(i), level - 1,
+                                        begin + bounds[i],
+                                        begin + bounds[i + 1], buffer, getKey,
+                                        func);
+            }
+            return count;
+        }
 
+        // There is at most one entry left, or the slot doesn't hold a subtree
+        // yet, so the remaining entries are processed one by one from there.
+        size_t count = 0;
+        for (; begin != end; ++begin) {
+            if (func(eptr, level, *begin->item)) {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    RCUPtr<T> remove(std::atomic<RadixElement> *eptr, uint32_t level,
+                     const KeyType &key) {
         SEEK_LEAF_LOOP();
 
         T *leaf = e.getLeaf();
@@ -206,15 +478,13 @@ public:
         return RCUPtr<T>();
     }
 
-private:
-    KeyType getId(const T &value) const { return Adapter::getId(value); }
-
     bool insert(const KeyType &key, RCUPtr<T> value) {
-        uint32_t level = TOP_LEVEL;
-
         RCULock lock;
-        std::atomic<RadixElement> *eptr = &root;
+        return insert(&root, TOP_LEVEL, key, std::move(value));
+    }
 
+    bool insert(std::atomic<RadixElement> *eptr, uint32_t level,
+                const KeyType &key, RCUPtr<T> value) {
         while (true) {
             SEEK_LEAF_LOOP();
 
@@ -271,6 +541,44 @@ private:
             });
     }
 
+    /**
+     * Visit the leaves of e which are in [first, last]. onFirst and onLast
+     * tell if the path to e is a prefix of first and last respectively, in
+     * which case only part of the children can be in the range.
+     */
+    template <typename Callable>
+    bool forEachLeafInRange(RadixElement e, uint32_t level,
+                            const KeyType &first, const KeyType &last,
+                            bool onFirst, bool onLast, Callable &func) const {
+        if (e.isLeaf()) {
+            T *leaf = e.getLeaf();
+            if (leaf == nullptr) {
+                return true;
+            }
+
+            // The leaf may sit above its full path, so check the whole key.
+            const KeyType key = getId(*leaf);
+            if (keyLess(key, first) || keyLess(last, key)) {
+                return true;
+            }
+
+            return func(RCUPtr<T>::copy(leaf));
+        }
+
+        const size_t firstChild = onFirst ? childIndex(level, first) : 0;
+        const size_t lastChild = onLast ? childIndex(level, last) : MASK;
+        const RadixNode *node = e.getNode();
+        for (size_t i = firstChild; i <= lastChild; i++) {
+            if (!forEachLeafInRange(node->getChild(i), level - 1, first, last,
+                                    onFirst && i == firstChild,
+                                    onLast && i == lastChild, func)) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
     struct RadixElement {
     private:
         union {
@@ -378,6 +686,9 @@ private:
             return &children[(key >> uint32_t(level * BITS)) & MASK];
         }
 
+        std::atomic<RadixElement> *getSlot(size_t i) { return &children[i]; }
+        RadixElement getChild(size_t i) const { return children[i].load(); }
+
         bool isShared() const { return refcount > 0; }
 
         template <typename Callable> bool forEachChild(Callable &&func) const {
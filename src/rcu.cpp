@@ -5,19 +5,31 @@
 #include <rcu.h>
 
 #include <sync.h>
+#include <util/threadnames.h>
 
 #include <algorithm>
 #include <chrono>
 #include <condition_variable>
+#include <deque>
+#include <thread>
+#include <vector>
 
 std::atomic<uint64_t> RCUInfos::revision{0};
 thread_local RCUInfos RCUInfos::infos{};
+std::atomic<bool> RCUInfos::reclaimerRunning{false};
 
 /**
  * How many time a busy loop runs before yelding.
  */
 static constexpr int RCU_ACTIVE_LOOP_COUNT = 10;
 
+/**
+ * How often the reclaimer seals the queued cleanups into a batch, unless
+ * RCU_RECLAIM_BATCH_SIZE cleanups are queued before.
+ */
+static constexpr auto RCU_RECLAIM_INTERVAL = std::chrono::milliseconds(10);
+static constexpr size_t RCU_RECLAIM_BATCH_SIZE = 4096;
+
 /**
  * We maintain a linked list of all the RCUInfos for each active thread. Upon
  * start, a new thread adds itself to the head of the liked list and the node is
@@ -117,9 +129,14 @@ RCUInfos::RCUInfos() : state(0), next(nullptr) {
 RCUInfos::~RCUInfos() {
     /**
      * Before the thread is removed from the list, make sure we cleanup
-     * everything.
+     * everything. If the reclaimer is running, it can take care of what is
+     * left without waiting for the readers.
      */
     runCleanups();
+    while (!cleanups.empty() && reclaimerRunning.load() &&
+           deferToReclaimer(cleanups.begin()->second)) {
+        cleanups.erase(cleanups.begin());
+    }
     while (cleanups.size() > 0) {
         synchronize();
     }
@@ -250,3 +267,114 @@ uint64_t RCUInfos::hasSyncedTo(uint64_t cutoff) {
 
     return syncedTo;
 }
+
+/**
+ * The reclaimer queues the cleanups of all the threads as they are
+ * registered. The queue is regularly sealed into a batch tagged with a new
+ * revision: the objects were unlinked before the revision was bumped, so once
+ * all the readers are past that revision none of them can still see the
+ * objects, and the whole batch can be run at once.
+ */
+namespace {
+struct RCUReclaimer {
+    Mutex cs;
+    std::condition_variable cond;
+    bool running GUARDED_BY(cs){false};
+    bool stopping GUARDED_BY(cs){false};
+    std::vector<std::function<void()>> pending GUARDED_BY(cs);
+    std::thread thread GUARDED_BY(cs);
+};
+
+RCUReclaimer &GetReclaimer() {
+    // Never destroyed, so it can outlive the threads using RCU.
+    static RCUReclaimer *reclaimer = new RCUReclaimer();
+    return *reclaimer;
+}
+} // namespace
+
+bool RCUInfos::deferToReclaimer(const std::function<void()> &f) {
+    RCUReclaimer &reclaimer = GetReclaimer();
+    LOCK(reclaimer.cs);
+    if (!reclaimer.running) {
+        return false;
+    }
+
+    reclaimer.pending.push_back(f);
+    if (reclaimer.pending.size() >= RCU_RECLAIM_BATCH_SIZE) {
+        reclaimer.cond.notify_one();
+    }
+    return true;
+}
+
+void RCUInfos::reclaimerThread() {
+    util::ThreadRename("rcureclaim");
+    RCUReclaimer &reclaimer = GetReclaimer();
+
+    std::deque<std::pair<uint64_t, std::vector<std::function<void()>>>>
+        batches;
+    while (true) {
+        {
+            WAIT_LOCK(reclaimer.cs, lock);
+            if (reclaimer.pending.empty() && !reclaimer.stopping) {
+                reclaimer.cond.wait_for(lock, RCU_RECLAIM_INTERVAL);
+            }
+
+            if (!reclaimer.pending.empty()) {
+                batches.emplace_back(++revision, std::move(reclaimer.pending));
+                reclaimer.pending.clear();
+            } else if (batches.empty() && reclaimer.stopping) {
+                // Nothing can be queued anymore.
+                reclaimer.running = false;
+                reclaimerRunning = false;
+                return;
+            }
+        }
+
+        if (batches.empty()) {
+            continue;
+        }
+
+        // The cleanups can register more cleanups, which are queued for a
+        // later batch.
+        const uint64_t syncedTo = infos.hasSyncedTo(batches.front().first);
+        while (!batches.empty() && batches.front().first <= syncedTo) {
+            for (const auto &f : batches.front().second) {
+                f();
+            }
+            batches.pop_front();
+        }
+
+        if (!batches.empty()) {
+            // Some reader is still behind, give it a chance to make progress.
+            std::this_thread::yield();
+        }
+    }
+}
+
+void RCUInfos::startReclaimer() {
+    RCUReclaimer &reclaimer = GetReclaimer();
+    LOCK(reclaimer.cs);
+    if (reclaimer.running) {
+        return;
+    }
+
+    reclaimer.running = true;
+    reclaimer.stopping = false;
+    reclaimerRunning = true;
+    reclaimer.thread = std::thread(&RCUInfos::reclaimerThread);
+}
+
+void RCUInfos::stopReclaimer() {
+    RCUReclaimer &reclaimer = GetReclaimer();
+    std::thread thread;
+    {
+        LOCK(reclaimer.cs);
+        reclaimer.stopping = true;
+        thread = std::move(reclaimer.thread);
+    }
+    reclaimer.cond.notify_one();
+
+    if (thread.joinable()) {
+        thread.join();
+    }
+}
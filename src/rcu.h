@@ -44,6 +44,9 @@ class RCUInfos {
 
     bool isLocked() const { return state.load() != UNLOCKED; }
     void registerCleanup(const std::function<void()> &f) {
+        if (reclaimerRunning.load() && deferToReclaimer(f)) {
+            return;
+        }
         cleanups.emplace(++revision, f);
     }
 
@@ -51,6 +54,17 @@ class RCUInfos {
     void runCleanups();
     uint64_t hasSyncedTo(uint64_t cutoff = UNLOCKED);
 
+    /**
+     * Background reclamation: the cleanups of all the threads are queued
+     * and run in batches from a dedicated thread.
+     */
+    static std::atomic<bool> reclaimerRunning;
+    /** Queue a cleanup, returns false if the reclaimer is not running */
+    static bool deferToReclaimer(const std::function<void()> &f);
+    static void startReclaimer();
+    static void stopReclaimer();
+    static void reclaimerThread();
+
     friend class RCULock;
     friend struct RCUTest;
 
@@ -80,6 +94,27 @@ public:
     }
 
     static void synchronize() { RCUInfos::infos.synchronize(); }
+
+    /**
+     * Free an object once no reader can be using it anymore. This never
+     * waits for the readers.
+     */
+    template <typename T> static void deferDelete(T *ptr) {
+        registerCleanup([ptr] { delete ptr; });
+    }
+
+    /**
+     * Run the cleanups from a background thread, in batches, rather than
+     * from the thread which registered them once it stops reading. The
+     * writers then never wait for the readers to free memory, which matters
+     * when many objects are released at once.
+     */
+    static void startReclaimer() { RCUInfos::startReclaimer(); }
+    /** Run all the pending cleanups and stop the background thread */
+    static void stopReclaimer() { RCUInfos::stopReclaimer(); }
+    static bool isReclaimerRunning() {
+        return RCUInfos::reclaimerRunning.load();
+    }
 };
 
 template <typename T> class RCUPtr {
@@ -14,6 +14,7 @@
 #include <primitives/block.h>
 #include <primitives/transaction.h>
 #include <rpc/blockchain.h>
+#include <rpc/jsonwriter.h>
 #include <rpc/mempool.h>
 #include <rpc/protocol.h>
 #include <rpc/server.h>
@@ -27,13 +28,20 @@
 
 #include <univalue.h>
 
+#include <algorithm>
 #include <any>
+#include <functional>
+#include <numeric>
+#include <optional>
 
 using node::GetTransaction;
 using node::NodeContext;
 
 // Allow a max of 15 outpoints to be queried at once.
 static const size_t MAX_GETUTXOS_OUTPOINTS = 15;
+// Maximum number of outpoints and transactions for the batch endpoints.
+static const size_t MAX_BATCH_GETUTXOS_OUTPOINTS = 10000;
+static const size_t MAX_BATCH_TXS = 1000;
 
 enum class RetFormat {
     UNDEF,
@@ -180,6 +188,34 @@ static bool CheckWarmup(HTTPRequest *req) {
     return true;
 }
 
+/**
+ * Send a JSON reply while it is being written, so large replies are never held
+ * in memory as a whole.
+ *
+ * If fn fails after the reply started, the error can't be reported to the
+ * client anymore. The connection is then closed without terminating the
+ * reply, so the client gets a transport error rather than truncated JSON.
+ */
+static bool StreamJSONReply(HTTPRequest *req,
+                            const std::function<void(JSONStreamWriter &)> &fn) {
+    req->WriteHeader("Content-Type", "application/json");
+    req->StartReply(HTTP_OK);
+    JSONStreamWriter writer(
+        [req](std::string &&chunk) { req->WriteReplyChunk(std::move(chunk)); });
+    try {
+        fn(writer);
+        writer.Flush();
+    } catch (const std::exception &e) {
+        LogPrintf("REST request %s failed while streaming its result: %s\n",
+                  req->GetURI(), e.what());
+        req->AbortReply();
+        return false;
+    }
+    req->WriteReplyChunk("\n");
+    req->EndReply();
+    return true;
+}
+
 static bool rest_headers(Config &config, const std::any &context,
                          HTTPRequest *req, const std::string &strURIPart) {
     if (!CheckWarmup(req)) {
@@ -241,7 +277,7 @@ static bool rest_headers(Config &config, const std::any &context,
 
             std::string binaryHeader = ssHeader.str();
             req->WriteHeader("Content-Type", "application/octet-stream");
-            req->WriteReply(HTTP_OK, binaryHeader);
+            req->WriteReply(HTTP_OK, std::move(binaryHeader));
             return true;
         }
 
@@ -253,7 +289,7 @@ static bool rest_headers(Config &config, const std::any &context,
 
             std::string strHex = HexStr(ssHeader) + "\n";
             req->WriteHeader("Content-Type", "text/plain");
-            req->WriteReply(HTTP_OK, strHex);
+            req->WriteReply(HTTP_OK, std::move(strHex));
             return true;
         }
         case RetFormat::JSON: {
@@ -263,7 +299,7 @@ static bool rest_headers(Config &config, const std::any &context,
             }
             std::string strJSON = jsonHeaders.write() + "\n";
             req->WriteHeader("Content-Type", "application/json");
-            req->WriteReply(HTTP_OK, strJSON);
+            req->WriteReply(HTTP_OK, std::move(strJSON));
             return true;
         }
         default: {
@@ -312,38 +348,41 @@ static bool rest_block(const Config &config, const std::any &context,
                            hashStr + " not available (pruned data)");
         }
     }
-    if (!chainman.m_blockman.ReadBlockFromDisk(block, *pblockindex)) {
-        return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
-    }
 
     switch (rf) {
         case RetFormat::BINARY: {
-            CDataStream ssBlock(SER_NETWORK,
-                                PROTOCOL_VERSION | RPCSerializationFlags());
-            ssBlock << block;
-            std::string binaryBlock = ssBlock.str();
+            // The raw formats don't need to deserialize the block, and are
+            // usually served from the cache of recently written blocks.
+            const node::SerializedData raw_block{
+                chainman.m_blockman.ReadRawBlock(*pblockindex)};
+            if (!raw_block) {
+                return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+            }
             req->WriteHeader("Content-Type", "application/octet-stream");
-            req->WriteReply(HTTP_OK, binaryBlock);
+            req->WriteReply(HTTP_OK, raw_block);
             return true;
         }
 
         case RetFormat::HEX: {
-            CDataStream ssBlock(SER_NETWORK,
-                                PROTOCOL_VERSION | RPCSerializationFlags());
-            ssBlock << block;
-            std::string strHex = HexStr(ssBlock) + "\n";
+            const node::SerializedData raw_block{
+                chainman.m_blockman.ReadRawBlock(*pblockindex)};
+            if (!raw_block) {
+                return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+            }
+            std::string strHex = HexStr(*raw_block) + "\n";
             req->WriteHeader("Content-Type", "text/plain");
-            req->WriteReply(HTTP_OK, strHex);
+            req->WriteReply(HTTP_OK, std::move(strHex));
             return true;
         }
 
         case RetFormat::JSON: {
-            UniValue objBlock = blockToJSON(chainman.m_blockman, block, tip,
-                                            pblockindex, showTxDetails);
-            std::string strJSON = objBlock.write() + "\n";
-            req->WriteHeader("Content-Type", "application/json");
-            req->WriteReply(HTTP_OK, strJSON);
-            return true;
+            if (!chainman.m_blockman.ReadBlockFromDisk(block, *pblockindex)) {
+                return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+            }
+            return StreamJSONReply(req, [&](JSONStreamWriter &writer) {
+                blockToJSON(chainman.m_blockman, block, tip, pblockindex,
+                            showTxDetails, writer);
+            });
         }
 
         default: {
@@ -384,7 +423,7 @@ static bool rest_chaininfo(Config &config, const std::any &context,
                 getblockchaininfo().HandleRequest(config, jsonRequest);
             std::string strJSON = chainInfoObject.write() + "\n";
             req->WriteHeader("Content-Type", "application/json");
-            req->WriteReply(HTTP_OK, strJSON);
+            req->WriteReply(HTTP_OK, std::move(strJSON));
             return true;
         }
         default: {
@@ -414,7 +453,7 @@ static bool rest_mempool_info(Config &config, const std::any &context,
 
             std::string strJSON = mempoolInfoObject.write() + "\n";
             req->WriteHeader("Content-Type", "application/json");
-            req->WriteReply(HTTP_OK, strJSON);
+            req->WriteReply(HTTP_OK, std::move(strJSON));
             return true;
         }
         default: {
@@ -441,12 +480,9 @@ static bool rest_mempool_contents(Config &config, const std::any &context,
 
     switch (rf) {
         case RetFormat::JSON: {
-            UniValue mempoolObject = MempoolToJSON(*mempool, true);
-
-            std::string strJSON = mempoolObject.write() + "\n";
-            req->WriteHeader("Content-Type", "application/json");
-            req->WriteReply(HTTP_OK, strJSON);
-            return true;
+            return StreamJSONReply(req, [mempool](JSONStreamWriter &writer) {
+                MempoolToJSON(*mempool, writer);
+            });
         }
         default: {
             return RESTERR(req, HTTP_NOT_FOUND,
@@ -495,7 +531,7 @@ static bool rest_tx(Config &config, const std::any &context, HTTPRequest *req,
 
             std::string binaryTx = ssTx.str();
             req->WriteHeader("Content-Type", "application/octet-stream");
-            req->WriteReply(HTTP_OK, binaryTx);
+            req->WriteReply(HTTP_OK, std::move(binaryTx));
             return true;
         }
 
@@ -506,7 +542,7 @@ static bool rest_tx(Config &config, const std::any &context, HTTPRequest *req,
 
             std::string strHex = HexStr(ssTx) + "\n";
             req->WriteHeader("Content-Type", "text/plain");
-            req->WriteReply(HTTP_OK, strHex);
+            req->WriteReply(HTTP_OK, std::move(strHex));
             return true;
         }
 
@@ -515,7 +551,7 @@ static bool rest_tx(Config &config, const std::any &context, HTTPRequest *req,
             TxToUniv(*tx, hashBlock, objTx);
             std::string strJSON = objTx.write() + "\n";
             req->WriteHeader("Content-Type", "application/json");
-            req->WriteReply(HTTP_OK, strJSON);
+            req->WriteReply(HTTP_OK, std::move(strJSON));
             return true;
         }
 
@@ -527,6 +563,56 @@ static bool rest_tx(Config &config, const std::any &context, HTTPRequest *req,
     }
 }
 
+/**
+ * Look the outpoints up in the UTXO set, and in the mempool if check_mempool
+ * is set, all against the same chain tip. The coins missing from the cache of
+ * the chain tip are read from the database with a single batched read.
+ */
+static bool LookupCoins(const std::any &context, HTTPRequest *req,
+                        ChainstateManager &chainman,
+                        const std::vector<COutPoint> &outpoints,
+                        bool check_mempool,
+                        std::vector<std::optional<Coin>> &coins,
+                        int &active_height, BlockHash &active_hash) {
+    coins.assign(outpoints.size(), std::nullopt);
+    auto process_utxos =
+        [&](const CCoinsView &view, const CTxMemPool *mempool)
+            EXCLUSIVE_LOCKS_REQUIRED(chainman.GetMutex()) {
+                chainman.ActiveChainstate().CoinsTip().PrefetchCoins(
+                    outpoints);
+                for (size_t i = 0; i < outpoints.size(); i++) {
+                    const COutPoint &outpoint = outpoints[i];
+                    if (mempool && mempool->isSpent(outpoint)) {
+                        continue;
+                    }
+                    Coin coin;
+                    if (view.GetCoin(outpoint, coin)) {
+                        coins[i] = std::move(coin);
+                    }
+                }
+                active_height = chainman.ActiveHeight();
+                active_hash = chainman.ActiveTip()->GetBlockHash();
+            };
+
+    if (check_mempool) {
+        const CTxMemPool *mempool = GetMemPool(context, req);
+        if (!mempool) {
+            return false;
+        }
+
+        // use db+mempool as cache backend in case user likes to query mempool
+        LOCK2(cs_main, mempool->cs);
+        CCoinsViewCache &viewChain = chainman.ActiveChainstate().CoinsTip();
+        CCoinsViewMemPool viewMempool(&viewChain, *mempool);
+        process_utxos(viewMempool, mempool);
+    } else {
+        // no need to lock mempool!
+        LOCK(cs_main);
+        process_utxos(chainman.ActiveChainstate().CoinsTip(), nullptr);
+    }
+    return true;
+}
+
 static bool rest_getutxos(Config &config, const std::any &context,
                           HTTPRequest *req, const std::string &strURIPart) {
     if (!CheckWarmup(req)) {
@@ -648,42 +734,19 @@ static bool rest_getutxos(Config &config, const std::any &context,
         return false;
     }
     ChainstateManager &chainman = *maybe_chainman;
-    decltype(chainman.ActiveHeight()) active_height;
+    int active_height;
     BlockHash active_hash;
     {
-        auto process_utxos =
-            [&vOutPoints, &outs, &hits, &active_height, &active_hash,
-             &chainman](const CCoinsView &view, const CTxMemPool *mempool)
-                EXCLUSIVE_LOCKS_REQUIRED(chainman.GetMutex()) {
-                    for (const COutPoint &vOutPoint : vOutPoints) {
-                        Coin coin;
-                        bool hit = (!mempool || !mempool->isSpent(vOutPoint)) &&
-                                   view.GetCoin(vOutPoint, coin);
-                        hits.push_back(hit);
-                        if (hit) {
-                            outs.emplace_back(std::move(coin));
-                        }
-                    }
-                    active_height = chainman.ActiveHeight();
-                    active_hash = chainman.ActiveTip()->GetBlockHash();
-                };
-
-        if (fCheckMemPool) {
-            const CTxMemPool *mempool = GetMemPool(context, req);
-            if (!mempool) {
-                return false;
+        std::vector<std::optional<Coin>> coins;
+        if (!LookupCoins(context, req, chainman, vOutPoints, fCheckMemPool,
+                         coins, active_height, active_hash)) {
+            return false;
+        }
+        for (std::optional<Coin> &coin : coins) {
+            hits.push_back(coin.has_value());
+            if (coin) {
+                outs.emplace_back(std::move(*coin));
             }
-
-            // use db+mempool as cache backend in case user likes to query
-            // mempool
-            LOCK2(cs_main, mempool->cs);
-            CCoinsViewCache &viewChain = chainman.ActiveChainstate().CoinsTip();
-            CCoinsViewMemPool viewMempool(&viewChain, *mempool);
-            process_utxos(viewMempool, mempool);
-        } else {
-            // no need to lock mempool!
-            LOCK(cs_main);
-            process_utxos(chainman.ActiveChainstate().CoinsTip(), nullptr);
         }
 
         for (size_t i = 0; i < hits.size(); ++i) {
@@ -704,7 +767,7 @@ static bool rest_getutxos(Config &config, const std::any &context,
             std::string ssGetUTXOResponseString = ssGetUTXOResponse.str();
 
             req->WriteHeader("Content-Type", "application/octet-stream");
-            req->WriteReply(HTTP_OK, ssGetUTXOResponseString);
+            req->WriteReply(HTTP_OK, std::move(ssGetUTXOResponseString));
             return true;
         }
 
@@ -714,7 +777,7 @@ static bool rest_getutxos(Config &config, const std::any &context,
             std::string strHex = HexStr(ssGetUTXOResponse) + "\n";
 
             req->WriteHeader("Content-Type", "text/plain");
-            req->WriteReply(HTTP_OK, strHex);
+            req->WriteReply(HTTP_OK, std::move(strHex));
             return true;
         }
 
@@ -744,7 +807,7 @@ static bool rest_getutxos(Config &config, const std::any &context,
             // return json string
             std::string strJSON = objGetUTXOResponse.write() + "\n";
             req->WriteHeader("Content-Type", "application/json");
-            req->WriteReply(HTTP_OK, strJSON);
+            req->WriteReply(HTTP_OK, std::move(strJSON));
             return true;
         }
         default: {
@@ -755,6 +818,189 @@ static bool rest_getutxos(Config &config, const std::any &context,
     }
 }
 
+/**
+ * Parse the body of a batch request: a compact size count followed by the
+ * serialized items, hex encoded if the hex format is requested. The batch
+ * requests must be POST requests.
+ */
+template <typename T>
+static bool ReadBatchRequest(HTTPRequest *req, RetFormat rf, size_t max_items,
+                             std::vector<T> &items) {
+    if (req->GetRequestMethod() != HTTPRequest::POST) {
+        return RESTERR(req, HTTP_BAD_METHOD,
+                       "Batch requests must use the POST method");
+    }
+    std::string body = req->ReadBody();
+    std::vector<uint8_t> data;
+    switch (rf) {
+        case RetFormat::HEX: {
+            data = ParseHex(body);
+            break;
+        }
+        case RetFormat::BINARY: {
+            data.assign(body.begin(), body.end());
+            break;
+        }
+        default: {
+            return RESTERR(req, HTTP_NOT_FOUND,
+                           "output format not found (available: .bin, .hex)");
+        }
+    }
+
+    try {
+        CDataStream ds(data, SER_NETWORK, PROTOCOL_VERSION);
+        const uint64_t count = ReadCompactSize(ds);
+        if (count == 0) {
+            return RESTERR(req, HTTP_BAD_REQUEST, "Error: empty request");
+        }
+        if (count > max_items) {
+            return RESTERR(
+                req, HTTP_BAD_REQUEST,
+                strprintf("Error: max items exceeded (max: %d, tried: %d)",
+                          max_items, count));
+        }
+        items.resize(count);
+        for (T &item : items) {
+            ds >> item;
+        }
+        if (!ds.empty()) {
+            return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+        }
+    } catch (const std::ios_base::failure &) {
+        return RESTERR(req, HTTP_BAD_REQUEST, "Parse error");
+    }
+    return true;
+}
+
+static void WriteBatchReply(HTTPRequest *req, RetFormat rf,
+                            const CDataStream &ss) {
+    if (rf == RetFormat::HEX) {
+        req->WriteHeader("Content-Type", "text/plain");
+        req->WriteReply(HTTP_OK, HexStr(ss) + "\n");
+    } else {
+        req->WriteHeader("Content-Type", "application/octet-stream");
+        req->WriteReply(HTTP_OK, ss.str());
+    }
+}
+
+/**
+ * Serialize obj prefixed with its size, so clients can skip over the results
+ * they are not interested in. Missing results are written as an empty item.
+ */
+template <typename T>
+static void WriteBatchItem(CDataStream &ss, const T *obj) {
+    if (!obj) {
+        WriteCompactSize(ss, 0);
+        return;
+    }
+    WriteCompactSize(ss, ::GetSerializeSize(*obj, ss.GetVersion()));
+    ss << *obj;
+}
+
+static bool rest_batch_getutxos(Config &config, const std::any &context,
+                                HTTPRequest *req,
+                                const std::string &strURIPart) {
+    if (!CheckWarmup(req)) {
+        return false;
+    }
+
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    if (!param.empty() && param != "/checkmempool") {
+        return RESTERR(req, HTTP_BAD_REQUEST,
+                       "Invalid URI format. Expected "
+                       "/rest/batch/getutxos[/checkmempool].<bin|hex>");
+    }
+    const bool check_mempool = !param.empty();
+
+    std::vector<COutPoint> outpoints;
+    if (!ReadBatchRequest(req, rf, MAX_BATCH_GETUTXOS_OUTPOINTS, outpoints)) {
+        return false;
+    }
+
+    ChainstateManager *maybe_chainman = GetChainman(context, req);
+    if (!maybe_chainman) {
+        return false;
+    }
+    std::vector<std::optional<Coin>> coins;
+    int active_height;
+    BlockHash active_hash;
+    if (!LookupCoins(context, req, *maybe_chainman, outpoints, check_mempool,
+                     coins, active_height, active_hash)) {
+        return false;
+    }
+
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << active_height << active_hash;
+    WriteCompactSize(ss, coins.size());
+    for (std::optional<Coin> &coin : coins) {
+        if (coin) {
+            const CCoin out(std::move(*coin));
+            WriteBatchItem(ss, &out);
+        } else {
+            WriteBatchItem<CCoin>(ss, nullptr);
+        }
+    }
+    WriteBatchReply(req, rf, ss);
+    return true;
+}
+
+static bool rest_batch_tx(Config &config, const std::any &context,
+                          HTTPRequest *req, const std::string &strURIPart) {
+    if (!CheckWarmup(req)) {
+        return false;
+    }
+
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    if (!param.empty()) {
+        return RESTERR(req, HTTP_BAD_REQUEST,
+                       "Invalid URI format. Expected /rest/batch/tx.<bin|hex>");
+    }
+
+    std::vector<TxId> txids;
+    if (!ReadBatchRequest(req, rf, MAX_BATCH_TXS, txids)) {
+        return false;
+    }
+
+    const NodeContext *const node = GetNodeContext(context, req);
+    if (!node) {
+        return false;
+    }
+
+    // Do the lookups in txid order, which is the order of the keys in the
+    // transaction index.
+    std::vector<size_t> order(txids.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&txids](size_t a, size_t b) { return txids[a] < txids[b]; });
+
+    std::vector<CTransactionRef> txs(txids.size());
+    if (node->mempool) {
+        LOCK(node->mempool->cs);
+        for (const size_t i : order) {
+            txs[i] = node->mempool->get(txids[i]);
+        }
+    }
+    if (g_txindex) {
+        g_txindex->BlockUntilSyncedToCurrentChain();
+        for (const size_t i : order) {
+            BlockHash block_hash;
+            if (!txs[i]) {
+                g_txindex->FindTx(txids[i], block_hash, txs[i]);
+            }
+        }
+    }
+
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
+    WriteCompactSize(ss, txs.size());
+    for (const CTransactionRef &tx : txs) {
+        WriteBatchItem(ss, tx.get());
+    }
+    WriteBatchReply(req, rf, ss);
+    return true;
+}
+
 static bool rest_blockhash_by_height(Config &config, const std::any &context,
                                      HTTPRequest *req,
                                      const std::string &str_uri_part) {
@@ -826,6 +1072,8 @@ static const struct {
     {"/rest/mempool/contents", rest_mempool_contents},
     {"/rest/headers/", rest_headers},
     {"/rest/getutxos", rest_getutxos},
+    {"/rest/batch/getutxos", rest_batch_getutxos},
+    {"/rest/batch/tx", rest_batch_tx},
     {"/rest/blockhashbyheight/", rest_blockhash_by_height},
 };
 
@@ -24,8 +24,10 @@
 #include <node/blockstorage.h>
 #include <node/coinstats.h>
 #include <node/context.h>
+#include <node/txoutsetscan.h>
 #include <node/utxo_snapshot.h>
 #include <primitives/transaction.h>
+#include <rpc/jsonwriter.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
 #include <rpc/util.h>
@@ -162,13 +164,14 @@ UniValue blockheaderToJSON(const CBlockIndex *tip,
     return result;
 }
 
-UniValue blockToJSON(BlockManager &blockman, const CBlock &block,
-                     const CBlockIndex *tip, const CBlockIndex *blockindex,
-                     bool txDetails) {
-    UniValue result = blockheaderToJSON(tip, blockindex);
-
-    result.pushKV("size", (int)::GetSerializeSize(block, PROTOCOL_VERSION));
-    UniValue txs(UniValue::VARR);
+/**
+ * Call fn with the JSON representation of each of the block transactions, in
+ * the order they appear in the block.
+ */
+template <typename Fn>
+static void BlockTxsToJSON(BlockManager &blockman, const CBlock &block,
+                           const CBlockIndex *blockindex, bool txDetails,
+                           Fn &&fn) {
     if (txDetails) {
         CBlockUndo blockUndo;
         const bool is_not_pruned{
@@ -183,18 +186,49 @@ UniValue blockToJSON(BlockManager &blockman, const CBlock &block,
             UniValue objTx(UniValue::VOBJ);
             TxToUniv(*tx, BlockHash(), objTx, true, RPCSerializationFlags(),
                      txundo);
-            txs.push_back(objTx);
+            fn(std::move(objTx));
         }
     } else {
         for (const CTransactionRef &tx : block.vtx) {
-            txs.push_back(tx->GetId().GetHex());
+            fn(UniValue(tx->GetId().GetHex()));
         }
     }
+}
+
+UniValue blockToJSON(BlockManager &blockman, const CBlock &block,
+                     const CBlockIndex *tip, const CBlockIndex *blockindex,
+                     bool txDetails) {
+    UniValue result = blockheaderToJSON(tip, blockindex);
+
+    result.pushKV("size", (int)::GetSerializeSize(block, PROTOCOL_VERSION));
+    UniValue txs(UniValue::VARR);
+    BlockTxsToJSON(blockman, block, blockindex, txDetails,
+                   [&txs](UniValue &&tx) { txs.push_back(std::move(tx)); });
     result.pushKV("tx", txs);
 
     return result;
 }
 
+void blockToJSON(BlockManager &blockman, const CBlock &block,
+                 const CBlockIndex *tip, const CBlockIndex *blockindex,
+                 bool txDetails, JSONStreamWriter &writer) {
+    const UniValue header = blockheaderToJSON(tip, blockindex);
+
+    writer.BeginObject();
+    const std::vector<std::string> &keys = header.getKeys();
+    for (size_t i = 0; i < keys.size(); ++i) {
+        writer.KeyValue(keys[i], header[i]);
+    }
+    writer.KeyValue("size",
+                    (int)::GetSerializeSize(block, PROTOCOL_VERSION));
+    writer.Key("tx");
+    writer.BeginArray();
+    BlockTxsToJSON(blockman, block, blockindex, txDetails,
+                   [&writer](UniValue &&tx) { writer.Value(tx); });
+    writer.EndArray();
+    writer.EndObject();
+}
+
 static RPCHelpMan getblockcount() {
     return RPCHelpMan{
         "getblockcount",
@@ -655,6 +689,25 @@ static CBlock GetBlockChecked(BlockManager &blockman,
     return block;
 }
 
+static node::SerializedData GetRawBlockChecked(BlockManager &blockman,
+                                               const CBlockIndex *pblockindex) {
+    {
+        LOCK(cs_main);
+        if (blockman.IsBlockPruned(pblockindex)) {
+            throw JSONRPCError(RPC_MISC_ERROR,
+                               "Block not available (pruned data)");
+        }
+    }
+
+    node::SerializedData data{blockman.ReadRawBlock(*pblockindex)};
+    if (!data) {
+        // Same as GetBlockChecked()
+        throw JSONRPCError(RPC_MISC_ERROR, "Block not found on disk");
+    }
+
+    return data;
+}
+
 static CBlockUndo GetUndoChecked(BlockManager &blockman,
                                  const CBlockIndex *pblockindex) {
     CBlockUndo blockUndo;
@@ -796,15 +849,22 @@ static RPCHelpMan getblock() {
                 }
             }
 
+            if (verbosity <= 0) {
+                // No need to deserialize the block, and recent blocks are
+                // served from the cache without disk I/O.
+                return HexStr(
+                    *GetRawBlockChecked(chainman.m_blockman, pblockindex));
+            }
+
             const CBlock block =
                 GetBlockChecked(chainman.m_blockman, pblockindex);
 
-            if (verbosity <= 0) {
-                CDataStream ssBlock(SER_NETWORK,
-                                    PROTOCOL_VERSION | RPCSerializationFlags());
-                ssBlock << block;
-                std::string strHex = HexStr(ssBlock);
-                return strHex;
+            if (request.result_writer) {
+                // Large blocks are streamed to the client rather than built as
+                // a whole in memory.
+                blockToJSON(chainman.m_blockman, block, tip, pblockindex,
+                            verbosity >= 2, *request.result_writer);
+                return NullUniValue;
             }
 
             return blockToJSON(chainman.m_blockman, block, tip, pblockindex,
@@ -2190,71 +2250,9 @@ static RPCHelpMan getblockstats() {
     };
 }
 
-namespace {
-//! Search for a given set of pubkey scripts
-static bool FindScriptPubKey(std::atomic<int> &scan_progress,
-                             const std::atomic<bool> &should_abort,
-                             int64_t &count, CCoinsViewCursor *cursor,
-                             const std::set<CScript> &needles,
-                             std::map<COutPoint, Coin> &out_results,
-                             std::function<void()> &interruption_point) {
-    scan_progress = 0;
-    count = 0;
-    while (cursor->Valid()) {
-        COutPoint key;
-        Coin coin;
-        if (!cursor->GetKey(key) || !cursor->GetValue(coin)) {
-            return false;
-        }
-        if (++count % 8192 == 0) {
-            interruption_point();
-            if (should_abort) {
-                // allow to abort the scan via the abort reference
-                return false;
-            }
-        }
-        if (count % 256 == 0) {
-            // update progress reference every 256 item
-            const TxId &txid = key.GetTxId();
-            uint32_t high = 0x100 * *txid.begin() + *(txid.begin() + 1);
-            scan_progress = int(high * 100.0 / 65536.0 + 0.5);
-        }
-        if (needles.count(coin.GetTxOut().scriptPubKey)) {
-            out_results.emplace(key, coin);
-        }
-        cursor->Next();
-    }
-    scan_progress = 100;
-    return true;
-}
-} // namespace
-
-/** RAII object to prevent concurrency issue when scanning the txout set */
-static std::atomic<int> g_scan_progress;
-static std::atomic<bool> g_scan_in_progress;
-static std::atomic<bool> g_should_abort_scan;
-class CoinsViewScanReserver {
-private:
-    bool m_could_reserve;
-
-public:
-    explicit CoinsViewScanReserver() : m_could_reserve(false) {}
-
-    bool reserve() {
-        CHECK_NONFATAL(!m_could_reserve);
-        if (g_scan_in_progress.exchange(true)) {
-            return false;
-        }
-        m_could_reserve = true;
-        return true;
-    }
-
-    ~CoinsViewScanReserver() {
-        if (m_could_reserve) {
-            g_scan_in_progress = false;
-        }
-    }
-};
+//! Maximum number of threads scanning the UTXO set for scantxoutset
+static constexpr size_t MAX_SCAN_TXOUTSET_THREADS{4};
+static node::TxOutSetScanner g_txoutset_scanner{MAX_SCAN_TXOUTSET_THREADS};
 
 static RPCHelpMan scantxoutset() {
     const auto &ticker = Currency::get().ticker;
@@ -2281,16 +2279,18 @@ static RPCHelpMan scantxoutset() {
         "In the latter case, a range needs to be specified by below if "
         "different from 1000.\n"
         "For more information on output descriptors, see the documentation in "
-        "the doc/descriptors.md file.\n",
+        "the doc/descriptors.md file.\n"
+        "Scans started while another one is running are queued, then answered "
+        "together by a single pass over the unspent transaction output set.\n",
         {
             {"action", RPCArg::Type::STR, RPCArg::Optional::NO,
              "The action to execute\n"
              "                                      \"start\" for starting a "
              "scan\n"
              "                                      \"abort\" for aborting the "
-             "current scan (returns true when abort was successful)\n"
+             "current scans (returns true when abort was successful)\n"
              "                                      \"status\" for "
-             "progress report (in %) of the current scan"},
+             "progress report (in %) of the current scans"},
             {"scanobjects",
              RPCArg::Type::ARR,
              RPCArg::Optional::OMITTED,
@@ -2326,7 +2326,15 @@ static RPCHelpMan scantxoutset() {
                 "",
                 "",
                 {
-                    {RPCResult::Type::NUM, "progress", "The scan progress"},
+                    {RPCResult::Type::NUM, "progress",
+                     "The progress of the oldest scan"},
+                    {RPCResult::Type::ARR,
+                     "scans",
+                     "The progress of each scan, oldest first. The queued "
+                     "scans are at 0",
+                     {
+                         {RPCResult::Type::NUM, "", "The scan progress"},
+                     }},
                 }},
             RPCResult{
                 "When action=='start'",
@@ -2377,37 +2385,36 @@ static RPCHelpMan scantxoutset() {
             const JSONRPCRequest &request) -> UniValue {
             UniValue result(UniValue::VOBJ);
             if (request.params[0].get_str() == "status") {
-                CoinsViewScanReserver reserver;
-                if (reserver.reserve()) {
+                const auto scans{g_txoutset_scanner.GetRequests()};
+                if (scans.empty()) {
                     // no scan in progress
                     return NullUniValue;
                 }
-                result.pushKV("progress", g_scan_progress.load());
+                UniValue progress(UniValue::VARR);
+                for (const auto &scan : scans) {
+                    progress.push_back(scan->GetProgress());
+                }
+                result.pushKV("progress", scans.front()->GetProgress());
+                result.pushKV("scans", progress);
                 return result;
             } else if (request.params[0].get_str() == "abort") {
-                CoinsViewScanReserver reserver;
-                if (reserver.reserve()) {
-                    // reserve was possible which means no scan was running
+                const auto scans{g_txoutset_scanner.GetRequests()};
+                if (scans.empty()) {
+                    // no scan was running
                     return false;
                 }
-                // set the abort flag
-                g_should_abort_scan = true;
+                for (const auto &scan : scans) {
+                    scan->Abort();
+                }
                 return true;
             } else if (request.params[0].get_str() == "start") {
-                CoinsViewScanReserver reserver;
-                if (!reserver.reserve()) {
-                    throw JSONRPCError(RPC_INVALID_PARAMETER,
-                                       "Scan already in progress, use action "
-                                       "\"abort\" or \"status\"");
-                }
-
                 if (request.params.size() < 2) {
                     throw JSONRPCError(RPC_MISC_ERROR,
                                        "scanobjects argument is required for "
                                        "the start action");
                 }
 
-                std::set<CScript> needles;
+                node::TxOutSetScanner::Scripts needles;
                 std::map<CScript, std::string> descriptors;
                 Amount total_in = Amount::zero();
 
@@ -2429,31 +2436,20 @@ static RPCHelpMan scantxoutset() {
                 // Scan the unspent transaction output set for inputs
                 UniValue unspents(UniValue::VARR);
                 std::vector<CTxOut> input_txos;
-                std::map<COutPoint, Coin> coins;
-                g_should_abort_scan = false;
-                g_scan_progress = 0;
-                int64_t count = 0;
-                std::unique_ptr<CCoinsViewCursor> pcursor;
-                const CBlockIndex *tip;
                 NodeContext &node = EnsureAnyNodeContext(request.context);
-                {
-                    ChainstateManager &chainman = EnsureChainman(node);
-                    LOCK(cs_main);
-                    Chainstate &active_chainstate = chainman.ActiveChainstate();
-                    active_chainstate.ForceFlushStateToDisk();
-                    pcursor = CHECK_NONFATAL(std::unique_ptr<CCoinsViewCursor>(
-                        active_chainstate.CoinsDB().Cursor()));
-                    tip = CHECK_NONFATAL(active_chainstate.m_chain.Tip());
-                }
-                bool res = FindScriptPubKey(
-                    g_scan_progress, g_should_abort_scan, count, pcursor.get(),
-                    needles, coins, node.rpc_interruption_point);
-                result.pushKV("success", res);
-                result.pushKV("txouts", count);
+                const auto scan{
+                    std::make_shared<node::TxOutSetScanner::Request>(
+                        std::move(needles))};
+                const node::TxOutSetScanner::Result scan_result{
+                    g_txoutset_scanner.Scan(EnsureChainman(node), scan,
+                                            node.rpc_interruption_point)};
+                const CBlockIndex *tip{CHECK_NONFATAL(scan_result.tip)};
+                result.pushKV("success", scan_result.success);
+                result.pushKV("txouts", scan_result.count);
                 result.pushKV("height", tip->nHeight);
                 result.pushKV("bestblock", tip->GetBlockHash().GetHex());
 
-                for (const auto &it : coins) {
+                for (const auto &it : scan_result.coins) {
                     const COutPoint &outpoint = it.first;
                     const Coin &coin = it.second;
                     const CTxOut &txo = coin.GetTxOut();
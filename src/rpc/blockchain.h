@@ -17,6 +17,7 @@
 class CBlock;
 class CBlockIndex;
 class Chainstate;
+class JSONStreamWriter;
 class RPCHelpMan;
 namespace node {
 struct NodeContext;
@@ -40,6 +41,16 @@ UniValue blockToJSON(node::BlockManager &blockman, const CBlock &block,
                      const CBlockIndex *tip, const CBlockIndex *blockindex,
                      bool txDetails = false) LOCKS_EXCLUDED(cs_main);
 
+/**
+ * Block description to JSON, written incrementally to the writer so the
+ * transactions are serialized one at a time. The output is the same as
+ * blockToJSON().
+ */
+void blockToJSON(node::BlockManager &blockman, const CBlock &block,
+                 const CBlockIndex *tip, const CBlockIndex *blockindex,
+                 bool txDetails, JSONStreamWriter &writer)
+    LOCKS_EXCLUDED(cs_main);
+
 /** Block header to JSON */
 UniValue blockheaderToJSON(const CBlockIndex *tip,
                            const CBlockIndex *blockindex)
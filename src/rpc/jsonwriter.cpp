@@ -0,0 +1,125 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <rpc/jsonwriter.h>
+
+#include <univalue_escapes.h>
+
+#include <cassert>
+#include <cstdint>
+#include <utility>
+
+JSONStreamWriter::JSONStreamWriter(Sink sink, size_t chunk_size)
+    : m_sink(std::move(sink)), m_chunk_size(chunk_size) {
+    m_buffer.reserve(m_chunk_size);
+}
+
+void JSONStreamWriter::BeginValue() {
+    assert(!m_complete);
+    if (m_scopes.empty()) {
+        return;
+    }
+    if (m_after_key) {
+        m_after_key = false;
+        return;
+    }
+    // Values inside an object must be preceded by a key
+    Scope &scope = m_scopes.back();
+    assert(!scope.is_object);
+    if (!scope.empty) {
+        m_buffer.push_back(',');
+    }
+    scope.empty = false;
+}
+
+void JSONStreamWriter::EndValue() {
+    if (m_scopes.empty()) {
+        m_complete = true;
+    }
+    if (m_buffer.size() >= m_chunk_size) {
+        Flush();
+    }
+}
+
+void JSONStreamWriter::EscapeString(const std::string &str) {
+    m_buffer.push_back('"');
+    for (const char ch : str) {
+        const char *const escaped = escapes[uint8_t(ch)];
+        if (escaped) {
+            m_buffer.append(escaped);
+        } else {
+            m_buffer.push_back(ch);
+        }
+    }
+    m_buffer.push_back('"');
+}
+
+void JSONStreamWriter::BeginScope(bool is_object) {
+    BeginValue();
+    m_buffer.push_back(is_object ? '{' : '[');
+    m_scopes.push_back({is_object});
+}
+
+void JSONStreamWriter::EndScope(bool is_object) {
+    assert(!m_scopes.empty() && m_scopes.back().is_object == is_object);
+    assert(!m_after_key);
+    m_scopes.pop_back();
+    m_buffer.push_back(is_object ? '}' : ']');
+    EndValue();
+}
+
+void JSONStreamWriter::BeginObject() {
+    BeginScope(true);
+}
+
+void JSONStreamWriter::EndObject() {
+    EndScope(true);
+}
+
+void JSONStreamWriter::BeginArray() {
+    BeginScope(false);
+}
+
+void JSONStreamWriter::EndArray() {
+    EndScope(false);
+}
+
+void JSONStreamWriter::Key(const std::string &key) {
+    assert(!m_scopes.empty() && m_scopes.back().is_object && !m_after_key);
+    Scope &scope = m_scopes.back();
+    if (!scope.empty) {
+        m_buffer.push_back(',');
+    }
+    scope.empty = false;
+    EscapeString(key);
+    m_buffer.push_back(':');
+    m_after_key = true;
+}
+
+void JSONStreamWriter::Value(const UniValue &value) {
+    if (value.isStr()) {
+        BeginValue();
+        EscapeString(value.get_str());
+        EndValue();
+        return;
+    }
+    RawValue(value.write());
+}
+
+void JSONStreamWriter::RawValue(const std::string &json) {
+    BeginValue();
+    m_buffer.append(json);
+    EndValue();
+}
+
+void JSONStreamWriter::Flush() {
+    if (m_buffer.empty()) {
+        return;
+    }
+    std::string chunk;
+    chunk.reserve(m_chunk_size);
+    std::swap(chunk, m_buffer);
+    m_flushed = true;
+    m_sink(std::move(chunk));
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_RPC_JSONWRITER_H
+#define BITCOIN_RPC_JSONWRITER_H
+
+#include <univalue.h>
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+/**
+ * Incremental JSON writer.
+ *
+ * Produces the same compact output as UniValue::write() without the need to
+ * build the whole UniValue tree first. The output is accumulated in a buffer
+ * which is handed over to the sink each time it grows past the chunk size, so
+ * the memory used to serialize a large result is bounded by the chunk size
+ * plus the largest value written at once.
+ */
+class JSONStreamWriter {
+public:
+    using Sink = std::function<void(std::string &&chunk)>;
+
+    static constexpr size_t DEFAULT_CHUNK_SIZE = 64 * 1024;
+
+    explicit JSONStreamWriter(Sink sink,
+                              size_t chunk_size = DEFAULT_CHUNK_SIZE);
+
+    void BeginObject();
+    void EndObject();
+    void BeginArray();
+    void EndArray();
+
+    /** Write an object key, it must be followed by a value */
+    void Key(const std::string &key);
+
+    /** Write a complete value, which can be an object or an array */
+    void Value(const UniValue &value);
+
+    void KeyValue(const std::string &key, const UniValue &value) {
+        Key(key);
+        Value(value);
+    }
+
+    /**
+     * Write a value already serialized as JSON. It is up to the caller to make
+     * sure it is valid.
+     */
+    void RawValue(const std::string &json);
+
+    /** Whether a complete top level value has been written */
+    bool IsComplete() const { return m_complete; }
+
+    /** Whether some output has already been handed over to the sink */
+    bool HasFlushed() const { return m_flushed; }
+
+    /** Hand the buffered output over to the sink, if any */
+    void Flush();
+
+private:
+    Sink m_sink;
+    const size_t m_chunk_size;
+    std::string m_buffer;
+    struct Scope {
+        bool is_object;
+        bool empty{true};
+    };
+    //! Objects and arrays currently open, innermost last
+    std::vector<Scope> m_scopes;
+    bool m_after_key{false};
+    bool m_complete{false};
+    bool m_flushed{false};
+
+    void BeginValue();
+    void EndValue();
+    void BeginScope(bool is_object);
+    void EndScope(bool is_object);
+    void EscapeString(const std::string &str);
+};
+
+#endif // BITCOIN_RPC_JSONWRITER_H
@@ -12,6 +12,7 @@
 #include <node/mempool_persist_args.h>
 #include <policy/settings.h>
 #include <primitives/transaction.h>
+#include <rpc/jsonwriter.h>
 #include <rpc/server.h>
 #include <rpc/server_util.h>
 #include <rpc/util.h>
@@ -355,26 +356,63 @@ static std::vector<RPCResult> MempoolEntryDescription() {
     };
 }
 
-static void entryToJSON(const CTxMemPool &pool, UniValue &info,
-                        const CTxMemPoolEntryRef &e)
+namespace {
+/**
+ * What is reported about a mempool entry, copied out of the mempool so it can
+ * be turned into JSON without holding its lock.
+ */
+struct MempoolEntryInfo {
+    TxId txid;
+    Amount fee;
+    Amount modified_fee;
+    size_t size;
+    std::chrono::seconds time;
+    unsigned int height;
+    //! In-mempool parents, with a parent listed once per input spending it
+    std::vector<TxId> depends;
+    std::vector<TxId> spentby;
+    bool unbroadcast;
+};
+} // namespace
+
+static MempoolEntryInfo GetEntryInfo(const CTxMemPool &pool,
+                                     const CTxMemPoolEntryRef &e)
     EXCLUSIVE_LOCKS_REQUIRED(pool.cs) {
     AssertLockHeld(pool.cs);
 
-    UniValue fees(UniValue::VOBJ);
-    fees.pushKV("base", e->GetFee());
-    fees.pushKV("modified", e->GetModifiedFee());
-    info.pushKV("fees", fees);
-
-    info.pushKV("size", (int)e->GetTxSize());
-    info.pushKV("time", count_seconds(e->GetTime()));
-    info.pushKV("height", (int)e->GetHeight());
     const CTransaction &tx = e->GetTx();
-    std::set<std::string> setDepends;
+    MempoolEntryInfo entry;
+    entry.txid = tx.GetId();
+    entry.fee = e->GetFee();
+    entry.modified_fee = e->GetModifiedFee();
+    entry.size = e->GetTxSize();
+    entry.time = e->GetTime();
+    entry.height = e->GetHeight();
+    entry.unbroadcast = pool.IsUnbroadcastTx(tx.GetId());
     for (const CTxIn &txin : tx.vin) {
         if (pool.exists(txin.prevout.GetTxId())) {
-            setDepends.insert(txin.prevout.GetTxId().ToString());
+            entry.depends.push_back(txin.prevout.GetTxId());
         }
     }
+    for (const auto &child : e->GetMemPoolChildrenConst()) {
+        entry.spentby.push_back(child.get()->GetTx().GetId());
+    }
+    return entry;
+}
+
+static void entryInfoToJSON(UniValue &info, const MempoolEntryInfo &entry) {
+    UniValue fees(UniValue::VOBJ);
+    fees.pushKV("base", entry.fee);
+    fees.pushKV("modified", entry.modified_fee);
+    info.pushKV("fees", fees);
+
+    info.pushKV("size", (int)entry.size);
+    info.pushKV("time", count_seconds(entry.time));
+    info.pushKV("height", (int)entry.height);
+    std::set<std::string> setDepends;
+    for (const TxId &txid : entry.depends) {
+        setDepends.insert(txid.ToString());
+    }
 
     UniValue depends(UniValue::VARR);
     for (const std::string &dep : setDepends) {
@@ -384,12 +422,19 @@ static void entryToJSON(const CTxMemPool &pool, UniValue &info,
     info.pushKV("depends", depends);
 
     UniValue spent(UniValue::VARR);
-    for (const auto &child : e->GetMemPoolChildrenConst()) {
-        spent.push_back(child.get()->GetTx().GetId().ToString());
+    for (const TxId &txid : entry.spentby) {
+        spent.push_back(txid.ToString());
     }
 
     info.pushKV("spentby", spent);
-    info.pushKV("unbroadcast", pool.IsUnbroadcastTx(tx.GetId()));
+    info.pushKV("unbroadcast", entry.unbroadcast);
+}
+
+static void entryToJSON(const CTxMemPool &pool, UniValue &info,
+                        const CTxMemPoolEntryRef &e)
+    EXCLUSIVE_LOCKS_REQUIRED(pool.cs) {
+    AssertLockHeld(pool.cs);
+    entryInfoToJSON(info, GetEntryInfo(pool, e));
 }
 
 UniValue MempoolToJSON(const CTxMemPool &pool, bool verbose,
@@ -436,6 +481,26 @@ UniValue MempoolToJSON(const CTxMemPool &pool, bool verbose,
     }
 }
 
+void MempoolToJSON(const CTxMemPool &pool, JSONStreamWriter &writer) {
+    // Writing blocks while the client catches up, so only the reported data
+    // is copied under the lock. It is much smaller than its JSON.
+    std::vector<MempoolEntryInfo> entries;
+    {
+        LOCK(pool.cs);
+        entries.reserve(pool.mapTx.size());
+        for (const CTxMemPoolEntryRef &e : pool.mapTx) {
+            entries.push_back(GetEntryInfo(pool, e));
+        }
+    }
+    writer.BeginObject();
+    for (const MempoolEntryInfo &entry : entries) {
+        UniValue info(UniValue::VOBJ);
+        entryInfoToJSON(info, entry);
+        writer.KeyValue(entry.txid.ToString(), info);
+    }
+    writer.EndObject();
+}
+
 static RPCHelpMan getrawmempool() {
     return RPCHelpMan{
         "getrawmempool",
@@ -496,8 +561,14 @@ static RPCHelpMan getrawmempool() {
                 include_mempool_sequence = request.params[1].get_bool();
             }
 
-            return MempoolToJSON(EnsureAnyMemPool(request.context), fVerbose,
-                                 include_mempool_sequence);
+            const CTxMemPool &mempool = EnsureAnyMemPool(request.context);
+            if (fVerbose && !include_mempool_sequence &&
+                request.result_writer) {
+                MempoolToJSON(mempool, *request.result_writer);
+                return NullUniValue;
+            }
+
+            return MempoolToJSON(mempool, fVerbose, include_mempool_sequence);
         },
     };
 }
@@ -6,6 +6,7 @@
 #define BITCOIN_RPC_MEMPOOL_H
 
 class CTxMemPool;
+class JSONStreamWriter;
 class UniValue;
 
 /** Mempool information to JSON */
@@ -15,4 +16,10 @@ UniValue MempoolInfoToJSON(const CTxMemPool &pool);
 UniValue MempoolToJSON(const CTxMemPool &pool, bool verbose = false,
                        bool include_mempool_sequence = false);
 
+/**
+ * Verbose mempool to JSON, written incrementally to the writer so the entries
+ * are serialized one at a time. The mempool is not locked while writing.
+ */
+void MempoolToJSON(const CTxMemPool &pool, JSONStreamWriter &writer);
+
 #endif // BITCOIN_RPC_MEMPOOL_H
@@ -27,6 +27,7 @@
 #include <util/message.h> // For MessageSign(), MessageVerify()
 #include <util/strencodings.h>
 #include <util/time.h>
+#include <validationinterface.h>
 
 #include <univalue.h>
 
@@ -621,6 +622,60 @@ static RPCHelpMan getmemoryinfo() {
     };
 }
 
+static RPCHelpMan getvalidationinterfaceinfo() {
+    return RPCHelpMan{
+        "getvalidationinterfaceinfo",
+        "Returns statistics about the background callbacks of each validation "
+        "interface subscriber.\n"
+        "Each subscriber processes its callbacks in order from its own queue, "
+        "so a slow subscriber does not delay the others.\n",
+        {},
+        RPCResult{
+            RPCResult::Type::ARR,
+            "",
+            "",
+            {
+                {RPCResult::Type::OBJ,
+                 "",
+                 "",
+                 {
+                     {RPCResult::Type::STR, "name", "Type of the subscriber"},
+                     {RPCResult::Type::NUM, "pending",
+                      "Number of callbacks waiting to be processed"},
+                     {RPCResult::Type::NUM, "processed",
+                      "Number of callbacks processed so far"},
+                     {RPCResult::Type::NUM, "avg_latency",
+                      "Average time between queuing and completing a "
+                      "callback, in microseconds"},
+                     {RPCResult::Type::NUM, "max_latency",
+                      "Maximum time between queuing and completing a "
+                      "callback, in microseconds"},
+                 }},
+            }},
+        RPCExamples{HelpExampleCli("getvalidationinterfaceinfo", "") +
+                    HelpExampleRpc("getvalidationinterfaceinfo", "")},
+        [&](const RPCHelpMan &self, const Config &config,
+            const JSONRPCRequest &request) -> UniValue {
+            UniValue ret(UniValue::VARR);
+            for (const auto &stats : GetMainSignals().GetQueueStats()) {
+                UniValue obj(UniValue::VOBJ);
+                obj.pushKV("name", stats.name);
+                obj.pushKV("pending", uint64_t(stats.pending));
+                obj.pushKV("processed", stats.processed);
+                obj.pushKV("avg_latency",
+                           stats.processed > 0
+                               ? int64_t(stats.total_latency.count() /
+                                         stats.processed)
+                               : int64_t(0));
+                obj.pushKV("max_latency",
+                           int64_t(stats.max_latency.count()));
+                ret.push_back(obj);
+            }
+            return ret;
+        },
+    };
+}
+
 static void EnableOrDisableLogCategories(UniValue cats, bool enable) {
     cats = cats.get_array();
     for (size_t i = 0; i < cats.size(); ++i) {
@@ -928,6 +983,7 @@ void RegisterMiscRPCCommands(CRPCTable &t) {
         //  ------------------  ----------------------
         { "control",            getmemoryinfo,           },
         { "control",            logging,                 },
+        { "control",            getvalidationinterfaceinfo, },
         { "util",               validateaddress,         },
         { "util",               createmultisig,          },
         { "util",               deriveaddresses,         },
@@ -10,6 +10,8 @@
 #include <any>
 #include <string>
 
+class JSONStreamWriter;
+
 UniValue JSONRPCRequestObj(const std::string &strMethod, const UniValue &params,
                            const UniValue &id);
 UniValue JSONRPCReplyObj(const UniValue &result, const UniValue &error,
@@ -37,6 +39,12 @@ public:
     std::string authUser;
     std::string peerAddr;
     std::any context;
+    /**
+     * If set, commands able to do so can write their result to this writer
+     * as it is being built instead of returning it. The result of the call is
+     * ignored in this case, see JSONStreamWriter::IsComplete().
+     */
+    JSONStreamWriter *result_writer{nullptr};
 
     void parse(const UniValue &valRequest);
 };
@@ -8,6 +8,7 @@
 #include <common/args.h>
 #include <consensus/amount.h>
 #include <key_io.h>
+#include <rpc/jsonwriter.h>
 #include <script/descriptor.h>
 #include <script/signingprovider.h>
 #include <tinyformat.h>
@@ -611,8 +612,19 @@ UniValue RPCHelpMan::HandleRequest(const Config &config,
         throw JSONRPCError(RPC_TYPE_ERROR, strprintf("Wrong type passed:\n%s",
                                                      arg_mismatch.write(4)));
     }
-    const UniValue ret = m_fun(*this, config, request);
-    if (gArgs.GetBoolArg("-rpcdoccheck", DEFAULT_RPC_DOC_CHECK)) {
+    const bool doc_check{
+        gArgs.GetBoolArg("-rpcdoccheck", DEFAULT_RPC_DOC_CHECK)};
+    UniValue ret;
+    if (doc_check && request.result_writer) {
+        // A streamed result can't be checked, so build it instead. It is
+        // then returned and sent as a whole.
+        JSONRPCRequest request_unstreamed{request};
+        request_unstreamed.result_writer = nullptr;
+        ret = m_fun(*this, config, request_unstreamed);
+    } else {
+        ret = m_fun(*this, config, request);
+    }
+    if (doc_check) {
         UniValue mismatch{UniValue::VARR};
         for (const auto &res : m_results.m_results) {
             UniValue match{res.MatchesType(ret)};
@@ -17,6 +17,10 @@
 #include <map>
 #include <thread>
 #include <utility>
+#include <vector>
+
+/** Default number of threads delivering the validation notifications */
+static constexpr int DEFAULT_SCHEDULER_THREADS{1};
 
 /**
  * Simple class for background tasks that should be run periodically or once
@@ -43,7 +47,8 @@ public:
     CScheduler();
     ~CScheduler();
 
-    std::thread m_service_thread;
+    //! Threads running serviceQueue(), joined when the scheduler stops
+    std::vector<std::thread> m_service_threads;
 
     typedef std::function<void()> Function;
     typedef std::function<bool()> Predicate;
@@ -88,9 +93,7 @@ public:
     void stop() EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex) {
         WITH_LOCK(newTaskMutex, stopRequested = true);
         newTaskScheduled.notify_all();
-        if (m_service_thread.joinable()) {
-            m_service_thread.join();
-        }
+        JoinServiceThreads();
     }
 
     /**
@@ -100,9 +103,7 @@ public:
     void StopWhenDrained() EXCLUSIVE_LOCKS_REQUIRED(!newTaskMutex) {
         WITH_LOCK(newTaskMutex, stopWhenEmpty = true);
         newTaskScheduled.notify_all();
-        if (m_service_thread.joinable()) {
-            m_service_thread.join();
-        }
+        JoinServiceThreads();
     }
 
     /**
@@ -125,6 +126,15 @@ private:
     int nThreadsServicingQueue GUARDED_BY(newTaskMutex){0};
     bool stopRequested GUARDED_BY(newTaskMutex){false};
     bool stopWhenEmpty GUARDED_BY(newTaskMutex){false};
+    void JoinServiceThreads() {
+        for (std::thread &thread : m_service_threads) {
+            if (thread.joinable()) {
+                thread.join();
+            }
+        }
+        m_service_threads.clear();
+    }
+
     bool shouldStop() const EXCLUSIVE_LOCKS_REQUIRED(newTaskMutex) {
         return stopRequested || (stopWhenEmpty && taskQueue.empty());
     }
@@ -12,10 +12,13 @@
 #include <pubkey.h>
 #include <script/bitfield.h>
 #include <script/script.h>
+#include <script/script_stack.h>
 #include <script/sigencoding.h>
 #include <uint256.h>
 #include <util/bitmanip.h>
 
+#include <optional>
+
 bool CastToBool(const valtype &vch) {
     for (size_t i = 0; i < vch.size(); i++) {
         if (vch[i] != 0) {
@@ -35,7 +38,7 @@ bool CastToBool(const valtype &vch) {
  */
 #define stacktop(i) (stack.at(stack.size() + (i)))
 #define altstacktop(i) (altstack.at(altstack.size() + (i)))
-static inline void popstack(std::vector<valtype> &stack) {
+static inline void popstack(ScriptStack &stack) {
     if (stack.empty()) {
         throw std::runtime_error("popstack(): stack empty");
     }
@@ -200,9 +203,10 @@ static bool EvalChecksig(const valtype &vchSig, const valtype &vchPubKey,
     return true;
 }
 
-bool EvalScript(std::vector<valtype> &stack, const CScript &script,
-                uint32_t flags, const BaseSignatureChecker &checker,
-                ScriptExecutionMetrics &metrics, ScriptError *serror) {
+static bool EvalScript(ScriptStack &stack, ScriptStack &altstack,
+                       const CScript &script, uint32_t flags,
+                       const BaseSignatureChecker &checker,
+                       ScriptExecutionMetrics &metrics, ScriptError *serror) {
     static const CScriptNum bnZero(0);
     static const CScriptNum bnOne(1);
     static const valtype vchFalse(0);
@@ -214,7 +218,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
     opcodetype opcode;
     valtype vchPushValue;
     ConditionStack vfExec;
-    std::vector<valtype> altstack;
+    altstack.clear();
     set_error(serror, ScriptError::UNKNOWN);
     if (script.size() > MAX_SCRIPT_SIZE) {
         return set_error(serror, ScriptError::SCRIPT_SIZE);
@@ -464,7 +468,8 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        altstack.push_back(stacktop(-1));
+                        // Move the element without copying it
+                        altstack.emplace_back().swap(stacktop(-1));
                         popstack(stack);
                     } break;
 
@@ -474,7 +479,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                                 serror,
                                 ScriptError::INVALID_ALTSTACK_OPERATION);
                         }
-                        stack.push_back(altstacktop(-1));
+                        stack.emplace_back().swap(altstacktop(-1));
                         popstack(altstack);
                     } break;
 
@@ -494,10 +499,8 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        valtype vch1 = stacktop(-2);
-                        valtype vch2 = stacktop(-1);
-                        stack.push_back(vch1);
-                        stack.push_back(vch2);
+                        stack.push_back(stacktop(-2));
+                        stack.push_back(stacktop(-2));
                     } break;
 
                     case OP_3DUP: {
@@ -506,12 +509,9 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        valtype vch1 = stacktop(-3);
-                        valtype vch2 = stacktop(-2);
-                        valtype vch3 = stacktop(-1);
-                        stack.push_back(vch1);
-                        stack.push_back(vch2);
-                        stack.push_back(vch3);
+                        stack.push_back(stacktop(-3));
+                        stack.push_back(stacktop(-3));
+                        stack.push_back(stacktop(-3));
                     } break;
 
                     case OP_2OVER: {
@@ -520,10 +520,8 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        valtype vch1 = stacktop(-4);
-                        valtype vch2 = stacktop(-3);
-                        stack.push_back(vch1);
-                        stack.push_back(vch2);
+                        stack.push_back(stacktop(-4));
+                        stack.push_back(stacktop(-4));
                     } break;
 
                     case OP_2ROT: {
@@ -532,11 +530,8 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        valtype vch1 = stacktop(-6);
-                        valtype vch2 = stacktop(-5);
-                        stack.erase(stack.end() - 6, stack.end() - 4);
-                        stack.push_back(vch1);
-                        stack.push_back(vch2);
+                        std::rotate(stack.end() - 6, stack.end() - 4,
+                                    stack.end());
                     } break;
 
                     case OP_2SWAP: {
@@ -555,9 +550,8 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        valtype vch = stacktop(-1);
-                        if (CastToBool(vch)) {
-                            stack.push_back(vch);
+                        if (CastToBool(stacktop(-1))) {
+                            stack.push_back(stacktop(-1));
                         }
                     } break;
 
@@ -582,8 +576,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        valtype vch = stacktop(-1);
-                        stack.push_back(vch);
+                        stack.push_back(stacktop(-1));
                     } break;
 
                     case OP_NIP: {
@@ -601,8 +594,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        valtype vch = stacktop(-2);
-                        stack.push_back(vch);
+                        stack.push_back(stacktop(-2));
                     } break;
 
                     case OP_PICK:
@@ -620,11 +612,13 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        valtype vch = stacktop(-n - 1);
                         if (opcode == OP_ROLL) {
-                            stack.erase(stack.end() - n - 1);
+                            // Move the element to the top without copying it
+                            std::rotate(stack.end() - n - 1, stack.end() - n,
+                                        stack.end());
+                        } else {
+                            stack.push_back(stacktop(-n - 1));
                         }
-                        stack.push_back(vch);
                     } break;
 
                     case OP_ROT: {
@@ -654,8 +648,7 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                             return set_error(
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
-                        valtype vch = stacktop(-1);
-                        stack.insert(stack.end() - 2, vch);
+                        stack.insert(stack.end() - 2, stacktop(-1));
                     } break;
 
                     case OP_SIZE: {
@@ -922,30 +915,33 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                                 serror, ScriptError::INVALID_STACK_OPERATION);
                         }
                         valtype &vch = stacktop(-1);
-                        valtype vchHash((opcode == OP_RIPEMD160 ||
-                                         opcode == OP_SHA1 ||
-                                         opcode == OP_HASH160)
-                                            ? 20
-                                            : 32);
+                        uint8_t hash[32];
+                        const size_t hashSize = (opcode == OP_RIPEMD160 ||
+                                                 opcode == OP_SHA1 ||
+                                                 opcode == OP_HASH160)
+                                                    ? 20
+                                                    : 32;
                         if (opcode == OP_RIPEMD160) {
                             CRIPEMD160()
                                 .Write(vch.data(), vch.size())
-                                .Finalize(vchHash.data());
+                                .Finalize(hash);
                         } else if (opcode == OP_SHA1) {
                             CSHA1()
                                 .Write(vch.data(), vch.size())
-                                .Finalize(vchHash.data());
+                                .Finalize(hash);
                         } else if (opcode == OP_SHA256) {
                             CSHA256()
                                 .Write(vch.data(), vch.size())
-                                .Finalize(vchHash.data());
+                                .Finalize(hash);
                         } else if (opcode == OP_HASH160) {
-                            CHash160().Write(vch).Finalize(vchHash);
+                            CHash160().Write(vch).Finalize(
+                                Span<uint8_t>{hash, hashSize});
                         } else if (opcode == OP_HASH256) {
-                            CHash256().Write(vch).Finalize(vchHash);
+                            CHash256().Write(vch).Finalize(
+                                Span<uint8_t>{hash, hashSize});
                         }
-                        popstack(stack);
-                        stack.push_back(vchHash);
+                        // Replace the element in place, reusing its buffer
+                        vch.assign(hash, hash + hashSize);
                     } break;
 
                     case OP_CODESEPARATOR: {
@@ -1301,14 +1297,11 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
                                              ScriptError::INVALID_SPLIT_RANGE);
                         }
 
-                        // Prepare the results in their own buffer as `data`
-                        // will be invalidated.
-                        valtype n1(data.begin(), data.begin() + position);
-                        valtype n2(data.begin() + position, data.end());
-
-                        // Replace existing stack values by the new values.
-                        stacktop(-2) = std::move(n1);
-                        stacktop(-1) = std::move(n2);
+                        // Replace existing stack values by the new values,
+                        // without allocating.
+                        stacktop(-1).assign(data.begin() + position,
+                                            data.end());
+                        stacktop(-2).resize(position);
                     } break;
 
                     case OP_REVERSEBYTES: {
@@ -1408,6 +1401,17 @@ bool EvalScript(std::vector<valtype> &stack, const CScript &script,
     return set_success(serror);
 }
 
+bool EvalScript(std::vector<valtype> &stack, const CScript &script,
+                uint32_t flags, const BaseSignatureChecker &checker,
+                ScriptExecutionMetrics &metrics, ScriptError *serror) {
+    ScriptStack scriptStack{std::move(stack)};
+    ScriptStack altstack;
+    const bool ret = EvalScript(scriptStack, altstack, script, flags, checker,
+                                metrics, serror);
+    stack = scriptStack.release();
+    return ret;
+}
+
 namespace {
 
 /**
@@ -1774,9 +1778,147 @@ bool GenericTransactionSignatureChecker<T>::CheckSequence(
 template class GenericTransactionSignatureChecker<CTransaction>;
 template class GenericTransactionSignatureChecker<CMutableTransaction>;
 
+/**
+ * Push the data pushed by a scriptSig onto the stack, as EvalScript would.
+ * Returns false if the scriptSig contains anything else than minimal data
+ * pushes, or if it could exceed the interpreter limits.
+ */
+static bool PushScriptSigData(const CScript &scriptSig, ScriptStack &stack) {
+    if (scriptSig.size() > MAX_SCRIPT_SIZE) {
+        return false;
+    }
+    const uint8_t *pc = scriptSig.data();
+    const uint8_t *const pend = pc + scriptSig.size();
+    while (pc < pend) {
+        const uint8_t opcode = *pc++;
+        size_t size;
+        if (opcode < OP_PUSHDATA1) {
+            size = opcode;
+        } else if (opcode == OP_PUSHDATA1 && pend - pc >= 1) {
+            size = *pc++;
+        } else if (opcode == OP_PUSHDATA2 && pend - pc >= 2) {
+            size = ReadLE16(pc);
+            pc += 2;
+        } else {
+            return false;
+        }
+        if (size_t(pend - pc) < size || size > MAX_SCRIPT_ELEMENT_SIZE) {
+            return false;
+        }
+        valtype &element = stack.emplace_back();
+        element.assign(pc, pc + size);
+        pc += size;
+        // Leave room for the elements pushed by the scriptPubKey
+        if (!CheckMinimalPush(element, opcodetype(opcode)) ||
+            stack.size() + 2 > MAX_STACK_SIZE) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Evaluate the scriptSig then the scriptPubKey without parsing them, when the
+ * scriptPubKey is a P2PKH, P2PK or P2SH template and the scriptSig only pushes
+ * data, which is the case of almost all the inputs.
+ *
+ * The result, the error, the metrics and the stacks are the same as the ones
+ * of EvalScript for both scripts followed by the check of the top of the
+ * stack. Returns std::nullopt when the scripts don't match the templates, in
+ * which case they must be evaluated by the interpreter.
+ */
+static std::optional<bool>
+EvalStandardScripts(const CScript &scriptSig, const CScript &scriptPubKey,
+                    uint32_t flags, const BaseSignatureChecker &checker,
+                    ScriptStackArena &arena, ScriptExecutionMetrics &metrics,
+                    ScriptError *serror) {
+    const size_t size = scriptPubKey.size();
+    // OP_DUP OP_HASH160 <20 bytes> OP_EQUALVERIFY OP_CHECKSIG
+    const bool isP2PKH = size == 25 && scriptPubKey[0] == OP_DUP &&
+                         scriptPubKey[1] == OP_HASH160 &&
+                         scriptPubKey[2] == 20 &&
+                         scriptPubKey[23] == OP_EQUALVERIFY &&
+                         scriptPubKey[24] == OP_CHECKSIG;
+    // <33 or 65 bytes> OP_CHECKSIG
+    const bool isP2PK = (size == 35 || size == 67) &&
+                        scriptPubKey[0] == size - 2 &&
+                        scriptPubKey[size - 1] == OP_CHECKSIG;
+    const bool isP2SH = scriptPubKey.IsPayToScriptHash();
+    if (!isP2PKH && !isP2PK && !isP2SH) {
+        return std::nullopt;
+    }
+
+    ScriptStack &stack = arena.stack;
+    stack.clear();
+    if (!PushScriptSigData(scriptSig, stack) ||
+        stack.size() < (isP2PKH ? 2 : 1)) {
+        return std::nullopt;
+    }
+
+    try {
+        if (isP2SH) {
+            // Copy of the stack for the P2SH evaluation
+            if (flags & SCRIPT_VERIFY_P2SH) {
+                arena.stackCopy.assign(stack);
+            }
+            // OP_HASH160 <20 bytes> OP_EQUAL
+            uint8_t hash[CHash160::OUTPUT_SIZE];
+            CHash160().Write(stack.back()).Finalize(hash);
+            if (!std::equal(hash, hash + sizeof(hash),
+                            scriptPubKey.begin() + 2)) {
+                stack.back().clear();
+                return set_error(serror, ScriptError::EVAL_FALSE);
+            }
+            stack.back().assign(1, 1);
+            return true;
+        }
+
+        if (isP2PKH) {
+            // OP_DUP OP_HASH160 <20 bytes> OP_EQUALVERIFY
+            uint8_t hash[CHash160::OUTPUT_SIZE];
+            CHash160().Write(stack.back()).Finalize(hash);
+            if (!std::equal(hash, hash + sizeof(hash),
+                            scriptPubKey.begin() + 3)) {
+                return set_error(serror, ScriptError::EQUALVERIFY);
+            }
+        } else {
+            // <pubkey>
+            stack.emplace_back().assign(scriptPubKey.begin() + 1,
+                                        scriptPubKey.end() - 1);
+        }
+
+        // OP_CHECKSIG
+        bool fSuccess = false;
+        if (!EvalChecksig(stacktop(-2), stacktop(-1), scriptPubKey.begin(),
+                          scriptPubKey.end(), flags, checker, metrics, serror,
+                          fSuccess)) {
+            return false;
+        }
+        popstack(stack);
+        popstack(stack);
+        valtype &result = stack.emplace_back();
+        if (!fSuccess) {
+            return set_error(serror, ScriptError::EVAL_FALSE);
+        }
+        result.assign(1, 1);
+        return true;
+    } catch (...) {
+        return set_error(serror, ScriptError::UNKNOWN);
+    }
+}
+
 bool VerifyScript(const CScript &scriptSig, const CScript &scriptPubKey,
                   uint32_t flags, const BaseSignatureChecker &checker,
                   ScriptExecutionMetrics &metricsOut, ScriptError *serror) {
+    ScriptStackArena arena;
+    return VerifyScript(scriptSig, scriptPubKey, flags, checker, metricsOut,
+                        arena, serror);
+}
+
+bool VerifyScript(const CScript &scriptSig, const CScript &scriptPubKey,
+                  uint32_t flags, const BaseSignatureChecker &checker,
+                  ScriptExecutionMetrics &metricsOut, ScriptStackArena &arena,
+                  ScriptError *serror) {
     set_error(serror, ScriptError::UNKNOWN);
 
     // If FORKID is enabled, we also ensure strict encoding.
@@ -1792,23 +1934,35 @@ bool VerifyScript(const CScript &scriptSig, const CScript &scriptPubKey,
 
     // scriptSig and scriptPubKey must be evaluated sequentially on the same
     // stack rather than being simply concatenated (see CVE-2010-5141)
-    std::vector<valtype> stack, stackCopy;
-    if (!EvalScript(stack, scriptSig, flags, checker, metrics, serror)) {
-        // serror is set
-        return false;
-    }
-    if (flags & SCRIPT_VERIFY_P2SH) {
-        stackCopy = stack;
-    }
-    if (!EvalScript(stack, scriptPubKey, flags, checker, metrics, serror)) {
-        // serror is set
-        return false;
-    }
-    if (stack.empty()) {
-        return set_error(serror, ScriptError::EVAL_FALSE);
-    }
-    if (CastToBool(stack.back()) == false) {
-        return set_error(serror, ScriptError::EVAL_FALSE);
+    ScriptStack &stack = arena.stack;
+    ScriptStack &stackCopy = arena.stackCopy;
+    if (const std::optional<bool> evaluated = EvalStandardScripts(
+            scriptSig, scriptPubKey, flags, checker, arena, metrics, serror)) {
+        if (!*evaluated) {
+            // serror is set
+            return false;
+        }
+    } else {
+        stack.clear();
+        if (!EvalScript(stack, arena.altstack, scriptSig, flags, checker,
+                        metrics, serror)) {
+            // serror is set
+            return false;
+        }
+        if (flags & SCRIPT_VERIFY_P2SH) {
+            stackCopy.assign(stack);
+        }
+        if (!EvalScript(stack, arena.altstack, scriptPubKey, flags, checker,
+                        metrics, serror)) {
+            // serror is set
+            return false;
+        }
+        if (stack.empty()) {
+            return set_error(serror, ScriptError::EVAL_FALSE);
+        }
+        if (CastToBool(stack.back()) == false) {
+            return set_error(serror, ScriptError::EVAL_FALSE);
+        }
     }
 
     // Additional validation for spend-to-script-hash transactions:
@@ -1840,7 +1994,8 @@ bool VerifyScript(const CScript &scriptSig, const CScript &scriptPubKey,
             return set_success(serror);
         }
 
-        if (!EvalScript(stack, pubKey2, flags, checker, metrics, serror)) {
+        if (!EvalScript(stack, arena.altstack, pubKey2, flags, checker,
+                        metrics, serror)) {
             // serror is set
             return false;
         }
@@ -19,6 +19,7 @@
 class CPubKey;
 class CScript;
 class CTransaction;
+struct ScriptStackArena;
 class uint256;
 
 template <class T>
@@ -103,6 +104,14 @@ bool VerifyScript(const CScript &scriptSig, const CScript &scriptPubKey,
                   uint32_t flags, const BaseSignatureChecker &checker,
                   ScriptExecutionMetrics &metricsOut,
                   ScriptError *serror = nullptr);
+/**
+ * Same as above, using the stacks of arena. Reusing the arena for successive
+ * verifications saves most of the allocations of the stack elements.
+ */
+bool VerifyScript(const CScript &scriptSig, const CScript &scriptPubKey,
+                  uint32_t flags, const BaseSignatureChecker &checker,
+                  ScriptExecutionMetrics &metricsOut, ScriptStackArena &arena,
+                  ScriptError *serror = nullptr);
 static inline bool VerifyScript(const CScript &scriptSig,
                                 const CScript &scriptPubKey, uint32_t flags,
                                 const BaseSignatureChecker &checker,
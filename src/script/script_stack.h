@@ -0,0 +1,143 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SCRIPT_SCRIPT_STACK_H
+#define BITCOIN_SCRIPT_SCRIPT_STACK_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * Stack of the script interpreter, with the subset of the std::vector
+ * interface it uses.
+ *
+ * The elements removed from the stack are not freed: their buffer is kept
+ * past the end of the stack and reused by the next elements pushed. Once the
+ * stack has been used for a few scripts, pushing, duplicating or hashing an
+ * element doesn't allocate anymore.
+ */
+class ScriptStack {
+public:
+    using value_type = std::vector<uint8_t>;
+    using iterator = std::vector<value_type>::iterator;
+    using const_iterator = std::vector<value_type>::const_iterator;
+
+    ScriptStack() = default;
+    explicit ScriptStack(std::vector<value_type> elements)
+        : m_elements(std::move(elements)), m_size(m_elements.size()) {}
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+
+    iterator begin() { return m_elements.begin(); }
+    iterator end() { return m_elements.begin() + m_size; }
+    const_iterator begin() const { return m_elements.begin(); }
+    const_iterator end() const { return m_elements.begin() + m_size; }
+
+    value_type &operator[](size_t pos) { return m_elements[pos]; }
+    const value_type &operator[](size_t pos) const { return m_elements[pos]; }
+    value_type &at(size_t pos) {
+        if (pos >= m_size) {
+            throw std::out_of_range("ScriptStack::at(): out of range");
+        }
+        return m_elements[pos];
+    }
+    value_type &back() { return m_elements[m_size - 1]; }
+    const value_type &back() const { return m_elements[m_size - 1]; }
+
+    /** Push an empty element, which reuses the buffer of a removed one */
+    value_type &emplace_back() {
+        if (m_size == m_elements.size()) {
+            m_elements.emplace_back();
+        }
+        value_type &element = m_elements[m_size++];
+        element.clear();
+        return element;
+    }
+    /** Push a copy of value, which may be an element of this stack */
+    void push_back(const value_type &value) {
+        if (m_size == m_elements.size()) {
+            // This is safe even if value is an element of this stack
+            m_elements.push_back(value);
+            m_size++;
+            return;
+        }
+        m_elements[m_size++].assign(value.begin(), value.end());
+    }
+    void pop_back() {
+        assert(m_size > 0);
+        m_size--;
+    }
+
+    void erase(iterator first, iterator last) {
+        // Move the buffers of the erased elements past the end
+        std::rotate(first, last, end());
+        m_size -= last - first;
+    }
+    void erase(iterator pos) { erase(pos, pos + 1); }
+    void insert(iterator pos, const value_type &value) {
+        const auto offset = pos - begin();
+        push_back(value);
+        std::rotate(begin() + offset, end() - 1, end());
+    }
+
+    /**
+     * Remove all the elements. Only the buffers of the bottom elements are
+     * kept, so a large stack doesn't hold on its memory forever.
+     */
+    void clear() {
+        m_size = 0;
+        if (m_elements.size() > MAX_KEPT_BUFFERS) {
+            m_elements.resize(MAX_KEPT_BUFFERS);
+        }
+    }
+
+    /** Replace the elements by a copy of other's, reusing the buffers */
+    void assign(const ScriptStack &other) {
+        clear();
+        for (const value_type &element : other) {
+            push_back(element);
+        }
+    }
+
+    /** Take the elements out of the stack, which is left empty */
+    std::vector<value_type> release() {
+        m_elements.resize(m_size);
+        m_size = 0;
+        return std::move(m_elements);
+    }
+
+    void swap(ScriptStack &other) {
+        m_elements.swap(other.m_elements);
+        std::swap(m_size, other.m_size);
+    }
+    friend void swap(ScriptStack &a, ScriptStack &b) { a.swap(b); }
+
+private:
+    //! Enough for the standard scripts
+    static constexpr size_t MAX_KEPT_BUFFERS{64};
+
+    //! The elements of the stack, then the buffers kept for reuse
+    std::vector<value_type> m_elements;
+    size_t m_size{0};
+};
+
+/**
+ * The stacks used to verify a script. Reusing the same arena for successive
+ * verifications, e.g. for all the inputs checked by a thread, saves the
+ * allocation of most stack elements. Not thread safe.
+ */
+struct ScriptStackArena {
+    ScriptStack stack;
+    ScriptStack altstack;
+    //! Copy of the stack after evaluating the scriptSig, for P2SH
+    ScriptStack stackCopy;
+};
+
+#endif // BITCOIN_SCRIPT_SCRIPT_STACK_H
@@ -20,6 +20,7 @@
 #include <validation.h>
 
 #include <algorithm>
+#include <cassert>
 
 #define BITCOIN_SEED_NONCE 0x0539a019ca550825ULL
 
@@ -224,6 +225,36 @@ bool CSeederNode::ProcessMessages() {
     return false;
 }
 
+void CSeederNode::PushVersion() {
+    // Don't include the time in CAddress serialization. See D14753.
+    uint64_t nLocalServices = 0;
+    uint64_t nLocalNonce = BITCOIN_SEED_NONCE;
+    uint64_t your_services{yourServices};
+    uint64_t my_services{ServiceFlags(NODE_NETWORK)};
+    uint8_t fRelayTxs = 0;
+
+    const std::string clientName = gArgs.GetArg("-uaclientname", CLIENT_NAME);
+    const std::string clientVersion =
+        gArgs.GetArg("-uaclientversion", FormatVersion(CLIENT_VERSION));
+    const std::string userAgent =
+        FormatUserAgent(clientName, clientVersion, {"seeder"});
+
+    MessageWriter::WriteMessage(vSend, NetMsgType::VERSION, PROTOCOL_VERSION,
+                                nLocalServices, GetTime(), your_services, you,
+                                my_services, CService(), nLocalNonce, userAgent,
+                                GetRequireHeight(), fRelayTxs);
+}
+
+void CSeederNode::MarkSent(size_t nBytes) {
+    assert(nBytes <= vSend.size());
+    vSend.erase(vSend.begin(), vSend.begin() + nBytes);
+}
+
+void CSeederNode::ReceiveData(Span<const std::byte> data) {
+    vRecv.write(data);
+    ProcessMessages();
+}
+
 CSeederNode::CSeederNode(const CService &ip, std::vector<CAddress> *vAddrIn)
     : vSend(SER_NETWORK, 0), vRecv(SER_NETWORK, 0), vAddr(vAddrIn), you(ip) {
     if (GetTime() > 1329696000) {
@@ -268,24 +299,7 @@ bool CSeederNode::Run() {
         return false;
     }
 
-    // Write version message
-    // Don't include the time in CAddress serialization. See D14753.
-    uint64_t nLocalServices = 0;
-    uint64_t nLocalNonce = BITCOIN_SEED_NONCE;
-    uint64_t your_services{yourServices};
-    uint64_t my_services{ServiceFlags(NODE_NETWORK)};
-    uint8_t fRelayTxs = 0;
-
-    const std::string clientName = gArgs.GetArg("-uaclientname", CLIENT_NAME);
-    const std::string clientVersion =
-        gArgs.GetArg("-uaclientversion", FormatVersion(CLIENT_VERSION));
-    const std::string userAgent =
-        FormatUserAgent(clientName, clientVersion, {"seeder"});
-
-    MessageWriter::WriteMessage(vSend, NetMsgType::VERSION, PROTOCOL_VERSION,
-                                nLocalServices, GetTime(), your_services, you,
-                                my_services, CService(), nLocalNonce, userAgent,
-                                GetRequireHeight(), fRelayTxs);
+    PushVersion();
     Send();
 
     bool res = true;
@@ -7,10 +7,12 @@
 
 #include <chainparams.h>
 #include <protocol.h>
+#include <span.h>
 #include <streams.h>
 #include <util/time.h>
 
 #include <chrono>
+#include <cstddef>
 #include <cstdint>
 #include <string>
 #include <vector>
@@ -50,7 +52,7 @@ private:
     CService you;
     ServiceFlags yourServices{ServiceFlags(NODE_NETWORK)};
 
-    std::chrono::seconds GetTimeout() { return you.IsTor() ? 120s : 30s; }
+    std::chrono::seconds GetTimeout() const { return you.IsTor() ? 120s : 30s; }
 
     void BeginMessage(const char *pszCommand);
 
@@ -60,8 +62,6 @@ private:
 
     void Send();
 
-    void PushVersion();
-
     bool ProcessMessages();
 
 protected:
@@ -73,15 +73,63 @@ public:
 
     bool Run();
 
-    int GetBan() { return ban; }
-
-    int GetClientVersion() { return nVersion; }
+    /**
+     * The methods below allow an external event loop to drive the exchange
+     * with the peer over a socket it owns, instead of the blocking Run().
+     */
 
-    std::string GetClientSubVersion() { return strSubVer; }
-
-    int GetStartingHeight() { return nStartingHeight; }
+    /** Queue the version message, to be called once connected */
+    void PushVersion();
 
-    uint64_t GetServices() { return yourServices; }
+    /** Data waiting to be sent to the peer */
+    Span<const std::byte> GetSendData() const {
+        return {vSend.data(), vSend.size()};
+    }
+
+    /** Remove the first nBytes sent to the peer from the send buffer */
+    void MarkSent(size_t nBytes);
+
+    /**
+     * Process the data received from the peer, the messages sent in reply
+     * are appended to the send buffer.
+     */
+    void ReceiveData(Span<const std::byte> data);
+
+    /** Whether the exchange with the peer is over */
+    bool IsDone(NodeSeconds now) const {
+        return ban != 0 ||
+               (TicksSinceEpoch<std::chrono::seconds>(doneAfter) != 0 &&
+                doneAfter <= now);
+    }
+
+    /**
+     * Time at which to stop waiting for the peer, given the time it last
+     * sent some data.
+     */
+    NodeSeconds GetDeadline(NodeSeconds lastReceived) const {
+        return TicksSinceEpoch<std::chrono::seconds>(doneAfter) != 0
+                   ? doneAfter
+                   : lastReceived + GetTimeout();
+    }
+
+    /**
+     * Whether the peer is good once the exchange is over, with the same
+     * semantics as the return value of Run().
+     */
+    bool IsGood(bool fDisconnected) const {
+        return !fDisconnected && ban == 0 &&
+               TicksSinceEpoch<std::chrono::seconds>(doneAfter) != 0;
+    }
+
+    int GetBan() const { return ban; }
+
+    int GetClientVersion() const { return nVersion; }
+
+    std::string GetClientSubVersion() const { return strSubVer; }
+
+    int GetStartingHeight() const { return nStartingHeight; }
+
+    uint64_t GetServices() const { return yourServices; }
 };
 
 #endif // BITCOIN_SEEDER_BITCOIN_H
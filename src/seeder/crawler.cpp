@@ -0,0 +1,309 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <seeder/crawler.h>
+
+#ifdef USE_EPOLL_CRAWLER
+
+#include <compat.h>
+#include <netbase.h>
+#include <protocol.h>
+#include <seeder/bitcoin.h>
+#include <util/sock.h>
+#include <util/time.h>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cassert>
+#include <ios>
+
+namespace seeder {
+
+/** Maximum number of events handled per call to epoll_wait */
+static constexpr int MAX_EPOLL_EVENTS = 256;
+/** Size of the buffer used to read from the sockets */
+static constexpr size_t RECV_BUFFER_SIZE = 0x10000;
+/** Interval between two checks for the probes that timed out */
+static constexpr auto TIMEOUT_CHECK_INTERVAL = 100ms;
+
+struct CAsyncCrawler::Probe {
+    CServiceResult result;
+    std::vector<CAddress> addrs;
+    std::unique_ptr<CSeederNode> node;
+    std::unique_ptr<Sock> sock;
+    std::chrono::steady_clock::time_point connectDeadline;
+    NodeSeconds lastReceived;
+    //! Events the socket is registered for
+    uint32_t nEvents{EPOLLOUT};
+    bool fConnected{false};
+    bool fFinished{false};
+    bool fGood{false};
+    //! The peer sent a message that could not be deserialized
+    bool fMalformed{false};
+};
+
+CAsyncCrawler::CAsyncCrawler(size_t maxInFlightIn)
+    : maxInFlight(maxInFlightIn), recvBuffer(RECV_BUFFER_SIZE) {
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+}
+
+CAsyncCrawler::~CAsyncCrawler() {
+    // Closing the sockets is enough to remove them from the epoll set
+    probes.clear();
+    if (epollFd >= 0) {
+        close(epollFd);
+    }
+}
+
+void CAsyncCrawler::Add(const CServiceResult &ip, bool fGetAddr) {
+    assert(nInFlight < maxInFlight);
+
+    size_t slot;
+    if (freeSlots.empty()) {
+        slot = probes.size();
+        probes.emplace_back();
+    } else {
+        slot = freeSlots.back();
+        freeSlots.pop_back();
+    }
+
+    auto probe = std::make_unique<Probe>();
+    probe->result = ip;
+    probe->node = std::make_unique<CSeederNode>(
+        ip.service, fGetAddr ? &probe->addrs : nullptr);
+    probes[slot] = std::move(probe);
+    nInFlight++;
+
+    if (!Connect(slot)) {
+        Finish(slot, false);
+    }
+}
+
+bool CAsyncCrawler::Connect(size_t slot) {
+    Probe &probe = *probes[slot];
+
+    struct sockaddr_storage sockaddr;
+    socklen_t len = sizeof(sockaddr);
+    if (!probe.result.service.GetSockAddr((struct sockaddr *)&sockaddr,
+                                          &len)) {
+        return false;
+    }
+
+    // The socket is non-blocking, so the connection completes in the
+    // background and the socket becomes writable once it's done.
+    probe.sock = CreateSock(probe.result.service);
+    if (!probe.sock) {
+        return false;
+    }
+    if (probe.sock->Connect((struct sockaddr *)&sockaddr, len) ==
+        SOCKET_ERROR) {
+        int nErr = WSAGetLastError();
+        if (nErr != WSAEINPROGRESS && nErr != WSAEWOULDBLOCK &&
+            nErr != WSAEINVAL) {
+            return false;
+        }
+    }
+    probe.connectDeadline = std::chrono::steady_clock::now() +
+                            std::chrono::milliseconds(nConnectTimeout);
+
+    struct epoll_event event = {};
+    event.events = probe.nEvents;
+    event.data.u64 = slot;
+    return epoll_ctl(epollFd, EPOLL_CTL_ADD, probe.sock->Get(), &event) == 0;
+}
+
+void CAsyncCrawler::OnConnected(size_t slot) {
+    Probe &probe = *probes[slot];
+
+    int nErr = 0;
+    socklen_t nErrLen = sizeof(nErr);
+    if (probe.sock->GetSockOpt(SOL_SOCKET, SO_ERROR, &nErr, &nErrLen) ==
+            SOCKET_ERROR ||
+        nErr != 0) {
+        Finish(slot, false);
+        return;
+    }
+
+    probe.fConnected = true;
+    probe.lastReceived = Now<NodeSeconds>();
+    probe.node->PushVersion();
+    SendPending(slot);
+}
+
+void CAsyncCrawler::OnReadable(size_t slot) {
+    Probe &probe = *probes[slot];
+
+    while (true) {
+        ssize_t nBytes =
+            probe.sock->Recv(recvBuffer.data(), recvBuffer.size(), 0);
+        if (nBytes == 0) {
+            // Connection closed prematurely
+            Finish(slot, false);
+            return;
+        }
+        if (nBytes < 0) {
+            int nErr = WSAGetLastError();
+            if (nErr == WSAEWOULDBLOCK || nErr == WSAEINTR) {
+                break;
+            }
+            Finish(slot, false);
+            return;
+        }
+
+        probe.lastReceived = Now<NodeSeconds>();
+        try {
+            probe.node->ReceiveData(Span{recvBuffer}.first(nBytes));
+        } catch (std::ios_base::failure &e) {
+            probe.fMalformed = true;
+            Finish(slot, false);
+            return;
+        }
+        if (size_t(nBytes) < recvBuffer.size()) {
+            break;
+        }
+    }
+
+    SendPending(slot);
+    if (!probe.fFinished && probe.node->IsDone(Now<NodeSeconds>())) {
+        Finish(slot, probe.node->IsGood(false));
+    }
+}
+
+void CAsyncCrawler::SendPending(size_t slot) {
+    Probe &probe = *probes[slot];
+    if (probe.fFinished) {
+        return;
+    }
+
+    Span<const std::byte> data = probe.node->GetSendData();
+    while (!data.empty()) {
+        ssize_t nBytes =
+            probe.sock->Send(data.data(), data.size(), MSG_NOSIGNAL);
+        if (nBytes < 0) {
+            int nErr = WSAGetLastError();
+            if (nErr == WSAEWOULDBLOCK || nErr == WSAEINTR) {
+                break;
+            }
+        }
+        if (nBytes <= 0) {
+            Finish(slot, false);
+            return;
+        }
+        probe.node->MarkSent(nBytes);
+        data = probe.node->GetSendData();
+    }
+
+    // Only wait for the socket to be writable if there is something left to
+    // send, or it would wake us up constantly.
+    const uint32_t nEvents = data.empty() ? EPOLLIN : EPOLLIN | EPOLLOUT;
+    if (nEvents != probe.nEvents) {
+        struct epoll_event event = {};
+        event.events = nEvents;
+        event.data.u64 = slot;
+        if (epoll_ctl(epollFd, EPOLL_CTL_MOD, probe.sock->Get(), &event) !=
+            0) {
+            Finish(slot, false);
+            return;
+        }
+        probe.nEvents = nEvents;
+    }
+}
+
+void CAsyncCrawler::CheckTimeouts() {
+    const auto steadyNow = std::chrono::steady_clock::now();
+    const auto now = Now<NodeSeconds>();
+    for (size_t slot = 0; slot < probes.size(); slot++) {
+        const Probe *probe = probes[slot].get();
+        if (!probe || probe->fFinished) {
+            continue;
+        }
+        if (!probe->fConnected) {
+            if (steadyNow >= probe->connectDeadline) {
+                Finish(slot, false);
+            }
+            continue;
+        }
+        if (probe->node->IsDone(now) ||
+            now >= probe->node->GetDeadline(probe->lastReceived)) {
+            Finish(slot, probe->node->IsGood(false));
+        }
+    }
+}
+
+void CAsyncCrawler::Finish(size_t slot, bool fGood) {
+    Probe &probe = *probes[slot];
+    assert(!probe.fFinished);
+    probe.fFinished = true;
+    probe.fGood = fGood;
+    probe.sock.reset();
+    finished.push_back(slot);
+}
+
+void CAsyncCrawler::Complete(size_t slot, std::vector<CServiceResult> &results,
+                             std::vector<CAddress> &addrs) {
+    std::unique_ptr<Probe> probe = std::move(probes[slot]);
+    freeSlots.push_back(slot);
+    nInFlight--;
+
+    CServiceResult &res = probe->result;
+    const CSeederNode &node = *probe->node;
+    res.fGood = probe->fGood;
+    res.nBanTime = probe->fGood || probe->fMalformed ? 0 : node.GetBan();
+    res.nClientV = node.GetClientVersion();
+    res.strClientV = node.GetClientSubVersion();
+    res.nHeight = node.GetStartingHeight();
+    res.services = node.GetServices();
+    results.push_back(std::move(res));
+    addrs.insert(addrs.end(), probe->addrs.begin(), probe->addrs.end());
+}
+
+void CAsyncCrawler::Poll(std::chrono::milliseconds timeout,
+                         std::vector<CServiceResult> &results,
+                         std::vector<CAddress> &addrs) {
+    // Don't wait if there are already some results to report
+    if (!finished.empty()) {
+        timeout = 0ms;
+    }
+
+    struct epoll_event events[MAX_EPOLL_EVENTS];
+    int nEvents = epoll_wait(epollFd, events, MAX_EPOLL_EVENTS,
+                             std::min(timeout, TIMEOUT_CHECK_INTERVAL).count());
+    for (int i = 0; i < nEvents; i++) {
+        const size_t slot = events[i].data.u64;
+        const uint32_t flags = events[i].events;
+        // The probe might have been finished by a previous event
+        Probe *probe = probes[slot].get();
+        if (!probe || probe->fFinished) {
+            continue;
+        }
+
+        if (!probe->fConnected) {
+            OnConnected(slot);
+            continue;
+        }
+        if (flags & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+            OnReadable(slot);
+        }
+        if (flags & EPOLLOUT) {
+            SendPending(slot);
+        }
+    }
+
+    const auto steadyNow = std::chrono::steady_clock::now();
+    if (steadyNow - lastTimeoutCheck >= TIMEOUT_CHECK_INTERVAL) {
+        lastTimeoutCheck = steadyNow;
+        CheckTimeouts();
+    }
+
+    for (const size_t slot : finished) {
+        Complete(slot, results, addrs);
+    }
+    finished.clear();
+}
+
+} // namespace seeder
+
+#endif // USE_EPOLL_CRAWLER
@@ -0,0 +1,97 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SEEDER_CRAWLER_H
+#define BITCOIN_SEEDER_CRAWLER_H
+
+#include <seeder/db.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#if defined(__linux__)
+#define USE_EPOLL_CRAWLER
+#endif
+
+class CAddress;
+
+#ifdef USE_EPOLL_CRAWLER
+
+namespace seeder {
+
+/**
+ * Event driven crawler.
+ *
+ * Probes many peers concurrently from a single thread: the connections are
+ * non-blocking and monitored with epoll, and the exchange with each peer is
+ * handled by a CSeederNode fed with the data received. This allows to keep
+ * thousands of handshakes in flight, where the blocking crawler threads can
+ * only probe one peer each at a time.
+ *
+ * Peers which are only reachable through a proxy are not supported, so the
+ * caller should probe them with CSeederNode::Run() instead.
+ */
+class CAsyncCrawler {
+public:
+    explicit CAsyncCrawler(size_t maxInFlightIn);
+    ~CAsyncCrawler();
+
+    /** Whether the crawler was initialized successfully */
+    bool IsValid() const { return epollFd >= 0; }
+
+    /** Number of peers being probed */
+    size_t GetInFlight() const { return nInFlight; }
+
+    /** Number of additional peers that can be probed right now */
+    size_t GetFreeSlots() const { return maxInFlight - nInFlight; }
+
+    /**
+     * Start probing a peer. The addresses it returns are only requested if
+     * fGetAddr is set. If the probe can't be started the result is reported
+     * as a failure by the next call to Poll().
+     */
+    void Add(const CServiceResult &ip, bool fGetAddr);
+
+    /**
+     * Wait up to timeout for some network activity and advance the probes.
+     * The results of the completed probes are appended to results, and the
+     * addresses the peers returned to addrs.
+     */
+    void Poll(std::chrono::milliseconds timeout,
+              std::vector<CServiceResult> &results,
+              std::vector<CAddress> &addrs);
+
+private:
+    struct Probe;
+
+    const size_t maxInFlight;
+    size_t nInFlight{0};
+    int epollFd{-1};
+    //! Probes indexed by slot, the slot number is the epoll user data
+    std::vector<std::unique_ptr<Probe>> probes;
+    std::vector<size_t> freeSlots;
+    //! Slots of the probes that are over and need to be reported
+    std::vector<size_t> finished;
+    std::vector<std::byte> recvBuffer;
+
+    std::chrono::steady_clock::time_point lastTimeoutCheck;
+
+    bool Connect(size_t slot);
+    void OnConnected(size_t slot);
+    void OnReadable(size_t slot);
+    void SendPending(size_t slot);
+    void CheckTimeouts();
+    void Finish(size_t slot, bool fGood);
+    void Complete(size_t slot, std::vector<CServiceResult> &results,
+                  std::vector<CAddress> &addrs);
+};
+
+} // namespace seeder
+
+#endif // USE_EPOLL_CRAWLER
+
+#endif // BITCOIN_SEEDER_CRAWLER_H
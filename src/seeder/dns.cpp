@@ -18,6 +18,7 @@
 #include <cstdlib>
 #include <cstring>
 #include <ctime>
+#include <vector>
 
 #define BUFLEN 512
 
@@ -591,41 +592,171 @@ error:
     return 12;
 }
 
+/**
+ * When SO_REUSEPORT is available, each DNS thread gets its own socket bound to
+ * the same address and the kernel spreads the incoming datagrams between them.
+ * Otherwise all the threads share a single socket.
+ */
+#if defined(__linux__) && defined(SO_REUSEPORT)
+#define USE_REUSEPORT 1
+#endif
+
+/** Whether recvmmsg/sendmmsg can be used to process datagrams in batches */
+#if defined(__linux__) && defined(MSG_WAITFORONE)
+#define USE_MMSG 1
+#endif
+
 static int listenSocket = -1;
 
-int dnsserver(dns_opt_t *opt) {
-    struct sockaddr_in6 si_other;
-    int senderSocket = -1;
-    senderSocket = socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
-    if (senderSocket == -1) {
-        return -3;
+static int OpenListenSocket(const dns_opt_t *opt) {
+    int sock = socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock == -1) {
+        return -1;
     }
+    int sockopt = 1;
+    setsockopt(sock, IPPROTO_IPV6, DSTADDR_SOCKOPT, &sockopt, sizeof sockopt);
+#ifdef USE_REUSEPORT
+    if (setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &sockopt, sizeof sockopt) ==
+        -1) {
+        close(sock);
+        return -1;
+    }
+#endif
+    struct sockaddr_in6 si_me;
+    memset((char *)&si_me, 0, sizeof(si_me));
+    si_me.sin6_family = AF_INET6;
+    si_me.sin6_port = htons(opt->port);
+    inet_pton(AF_INET6, opt->addr, &si_me.sin6_addr);
+    if (bind(sock, (struct sockaddr *)&si_me, sizeof(si_me)) == -1) {
+        close(sock);
+        return -2;
+    }
+    return sock;
+}
 
-    int replySocket;
-    if (listenSocket == -1) {
-        struct sockaddr_in6 si_me;
-        if ((listenSocket = socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP)) == -1) {
-            listenSocket = -1;
-            return -1;
+/**
+ * Whether the reply should be sent with the control data received along with
+ * the request, so it originates from the address the request was sent to.
+ */
+static bool HasDstAddr(msghdr *msg) {
+    for (struct cmsghdr *hdr = CMSG_FIRSTHDR(msg); hdr;
+         hdr = CMSG_NXTHDR(msg, hdr)) {
+        if (hdr->cmsg_level == IPPROTO_IP &&
+            hdr->cmsg_type == DSTADDR_SOCKOPT) {
+            return true;
         }
-        replySocket = socket(AF_INET6, SOCK_DGRAM, IPPROTO_UDP);
-        if (replySocket == -1) {
-            close(listenSocket);
-            return -1;
+    }
+    return false;
+}
+
+#ifdef USE_MMSG
+/** Maximum number of datagrams received or sent with a single system call */
+static constexpr unsigned int DNS_BATCH_SIZE = 64;
+
+/**
+ * Receive the requests in batches with recvmmsg and send all the replies of a
+ * batch with a single sendmmsg, which amortizes the cost of the system calls
+ * under load.
+ */
+static int ServeBatches(dns_opt_t *opt, int sock) {
+    struct Datagram {
+        uint8_t inbuf[BUFLEN];
+        uint8_t outbuf[BUFLEN];
+        struct sockaddr_in6 addr;
+        struct iovec iov_in;
+        struct iovec iov_out;
+    };
+    std::vector<Datagram> datagrams(DNS_BATCH_SIZE);
+    std::vector<union control_data> cmsgs(DNS_BATCH_SIZE);
+    std::vector<struct mmsghdr> requests(DNS_BATCH_SIZE);
+    std::vector<struct mmsghdr> replies(DNS_BATCH_SIZE);
+
+    while (true) {
+        for (unsigned int i = 0; i < DNS_BATCH_SIZE; ++i) {
+            Datagram &d = datagrams[i];
+            d.iov_in = {.iov_base = d.inbuf, .iov_len = sizeof(d.inbuf)};
+            msghdr &msg = requests[i].msg_hdr;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_name = &d.addr;
+            msg.msg_namelen = sizeof(d.addr);
+            msg.msg_iov = &d.iov_in;
+            msg.msg_iovlen = 1;
+            msg.msg_control = &cmsgs[i];
+            msg.msg_controllen = sizeof(cmsgs[i]);
         }
-        int sockopt = 1;
-        setsockopt(listenSocket, IPPROTO_IPV6, DSTADDR_SOCKOPT, &sockopt,
-                   sizeof sockopt);
-        memset((char *)&si_me, 0, sizeof(si_me));
-        si_me.sin6_family = AF_INET6;
-        si_me.sin6_port = htons(opt->port);
-        inet_pton(AF_INET6, opt->addr, &si_me.sin6_addr);
-        if (bind(listenSocket, (struct sockaddr *)&si_me, sizeof(si_me)) ==
-            -1) {
-            return -2;
+
+        // Block until at least one request is available, then grab whatever
+        // else is already queued.
+        int received = recvmmsg(sock, requests.data(), DNS_BATCH_SIZE,
+                                MSG_WAITFORONE, nullptr);
+        if (received <= 0) {
+            continue;
         }
+
+        unsigned int num_replies = 0;
+        for (int i = 0; i < received; ++i, ++(opt->nRequests)) {
+            Datagram &d = datagrams[i];
+            msghdr &request = requests[i].msg_hdr;
+            if (requests[i].msg_len == 0) {
+                continue;
+            }
+
+            ssize_t ret =
+                dnshandle(opt, d.inbuf, requests[i].msg_len, d.outbuf);
+            if (ret <= 0) {
+                continue;
+            }
+
+            d.iov_out = {.iov_base = d.outbuf, .iov_len = size_t(ret)};
+            msghdr &reply = replies[num_replies++].msg_hdr;
+            memset(&reply, 0, sizeof(reply));
+            reply.msg_name = &d.addr;
+            reply.msg_namelen = request.msg_namelen;
+            reply.msg_iov = &d.iov_out;
+            reply.msg_iovlen = 1;
+            if (HasDstAddr(&request)) {
+                reply.msg_control = request.msg_control;
+                reply.msg_controllen = request.msg_controllen;
+            }
+        }
+
+        for (unsigned int sent = 0; sent < num_replies;) {
+            int ret = sendmmsg(sock, replies.data() + sent, num_replies - sent,
+                               0);
+            if (ret <= 0) {
+                // Drop the reply which could not be sent, like a failed sendto
+                // would.
+                ++sent;
+                continue;
+            }
+            sent += ret;
+        }
+    }
+    return 0;
+}
+#endif
+
+int dnsserver(dns_opt_t *opt) {
+#ifdef USE_REUSEPORT
+    const int sock = OpenListenSocket(opt);
+    if (sock < 0) {
+        return sock;
+    }
+#else
+    if (listenSocket == -1) {
+        const int ret = OpenListenSocket(opt);
+        if (ret < 0) {
+            return ret;
+        }
+        listenSocket = ret;
     }
+    const int sock = listenSocket;
+#endif
 
+#ifdef USE_MMSG
+    return ServeBatches(opt, sock);
+#else
+    struct sockaddr_in6 si_other;
     uint8_t inbuf[BUFLEN], outbuf[BUFLEN];
     struct iovec iov[1] = {
         {
@@ -644,11 +775,7 @@ int dnsserver(dns_opt_t *opt) {
     msg.msg_controllen = sizeof(cmsg);
 
     for (; 1; ++(opt->nRequests)) {
-        ssize_t insize = recvmsg(listenSocket, &msg, 0);
-        //    uint8_t *addr = (uint8_t*)&si_other.sin_addr.s_addr;
-        //    tfm::format(std::cout, "DNS: Request %llu from %i.%i.%i.%i:%i of
-        //    %i bytes\n", (unsigned long long)(opt->nRequests), addr[0],
-        //    addr[1], addr[2], addr[3], ntohs(si_other.sin_port), (int)insize);
+        ssize_t insize = recvmsg(sock, &msg, 0);
         if (insize <= 0) {
             continue;
         }
@@ -658,23 +785,17 @@ int dnsserver(dns_opt_t *opt) {
             continue;
         }
 
-        bool handled = false;
-        for (struct cmsghdr *hdr = CMSG_FIRSTHDR(&msg); hdr;
-             hdr = CMSG_NXTHDR(&msg, hdr)) {
-            if (hdr->cmsg_level == IPPROTO_IP &&
-                hdr->cmsg_type == DSTADDR_SOCKOPT) {
-                msg.msg_iov[0].iov_base = outbuf;
-                msg.msg_iov[0].iov_len = ret;
-                sendmsg(listenSocket, &msg, 0);
-                msg.msg_iov[0].iov_base = inbuf;
-                msg.msg_iov[0].iov_len = sizeof(inbuf);
-                handled = true;
-            }
-        }
-        if (!handled) {
-            sendto(listenSocket, outbuf, ret, 0, (struct sockaddr *)&si_other,
+        if (HasDstAddr(&msg)) {
+            msg.msg_iov[0].iov_base = outbuf;
+            msg.msg_iov[0].iov_len = ret;
+            sendmsg(sock, &msg, 0);
+            msg.msg_iov[0].iov_base = inbuf;
+            msg.msg_iov[0].iov_len = sizeof(inbuf);
+        } else {
+            sendto(sock, outbuf, ret, 0, (struct sockaddr *)&si_other,
                    sizeof(si_other));
         }
     }
     return 0;
+#endif
 }
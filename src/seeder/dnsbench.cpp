@@ -0,0 +1,140 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/**
+ * Local UDP load generator for the seeder DNS server.
+ *
+ * Each client thread keeps a window of queries in flight against the server
+ * and the total number of answers received is reported as queries/sec.
+ *
+ * Usage: seeder-dnsbench <hostname> [port] [threads] [seconds] [window]
+ */
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+/** Build a DNS query for the A records of hostname */
+static std::vector<uint8_t> BuildQuery(const std::string &hostname,
+                                       uint16_t id) {
+    std::vector<uint8_t> query{
+        uint8_t(id >> 8), uint8_t(id & 0xff),
+        // Standard query, recursion desired, one question
+        0x01, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+    size_t begin = 0;
+    while (begin <= hostname.size()) {
+        size_t end = hostname.find('.', begin);
+        if (end == std::string::npos) {
+            end = hostname.size();
+        }
+        if (end > begin) {
+            query.push_back(uint8_t(end - begin));
+            query.insert(query.end(), hostname.begin() + begin,
+                         hostname.begin() + end);
+        }
+        begin = end + 1;
+    }
+    // Root label, QTYPE A, QCLASS IN
+    query.insert(query.end(), {0x00, 0x00, 0x01, 0x00, 0x01});
+    return query;
+}
+
+static std::atomic<uint64_t> g_answers{0};
+static std::atomic<uint64_t> g_timeouts{0};
+static std::atomic<bool> g_stop{false};
+
+static void ClientThread(const sockaddr_in &server, const std::string &hostname,
+                         int window, int threadId) {
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0) {
+        perror("socket");
+        return;
+    }
+    // Avoid stalling forever if a datagram gets lost
+    struct timeval timeout = {0, 100 * 1000};
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+    if (connect(sock, (const sockaddr *)&server, sizeof(server)) < 0) {
+        perror("connect");
+        close(sock);
+        return;
+    }
+
+    const std::vector<uint8_t> query = BuildQuery(hostname, threadId);
+    uint8_t answer[512];
+    int inflight = 0;
+    while (!g_stop) {
+        while (inflight < window &&
+               send(sock, query.data(), query.size(), 0) >= 0) {
+            inflight++;
+        }
+        if (recv(sock, answer, sizeof(answer), 0) >= 0) {
+            g_answers++;
+            inflight--;
+        } else {
+            // Consider the whole window lost and start over
+            g_timeouts++;
+            inflight = 0;
+        }
+    }
+    close(sock);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr,
+                "Usage: %s <hostname> [port] [threads] [seconds] [window]\n",
+                argv[0]);
+        return EXIT_FAILURE;
+    }
+    const std::string hostname = argv[1];
+    const int port = argc > 2 ? atoi(argv[2]) : 53;
+    const int nThreads = argc > 3 ? atoi(argv[3]) : 4;
+    const int seconds = argc > 4 ? atoi(argv[4]) : 10;
+    const int window = argc > 5 ? atoi(argv[5]) : 32;
+    if (port <= 0 || port > 65535 || nThreads <= 0 || seconds <= 0 ||
+        window <= 0) {
+        fprintf(stderr, "Invalid arguments\n");
+        return EXIT_FAILURE;
+    }
+
+    sockaddr_in server;
+    memset(&server, 0, sizeof(server));
+    server.sin_family = AF_INET;
+    server.sin_port = htons(port);
+    server.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nThreads; i++) {
+        threads.emplace_back(ClientThread, std::cref(server),
+                             std::cref(hostname), window, i);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(std::chrono::seconds(seconds));
+    g_stop = true;
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    const double elapsed = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+
+    printf("%llu answers, %llu timeouts in %.2fs: %.0f queries/sec\n",
+           (unsigned long long)g_answers.load(),
+           (unsigned long long)g_timeouts.load(), elapsed,
+           g_answers / elapsed);
+    return EXIT_SUCCESS;
+}
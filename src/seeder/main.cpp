@@ -6,12 +6,15 @@
 #include <common/args.h>
 #include <dnsseeds.h>
 #include <logging.h>
+#include <netbase.h>
 #include <protocol.h>
 #include <seeder/bitcoin.h>
+#include <seeder/crawler.h>
 #include <seeder/db.h>
 #include <seeder/dns.h>
 #include <seeder/options.h>
 #include <streams.h>
+#include <sync.h>
 #include <util/fs.h>
 #include <util/strencodings.h>
 #include <util/time.h>
@@ -20,10 +23,13 @@
 #include <algorithm>
 #include <atomic>
 #include <cinttypes>
+#include <condition_variable>
 #include <csignal>
 #include <cstdlib>
 #include <fstream>
 #include <functional>
+#include <map>
+#include <memory>
 #include <pthread.h>
 
 const std::function<std::string(const char *)> G_TRANSLATION_FUN = nullptr;
@@ -34,49 +40,75 @@ extern "C" {
 
 CAddrDb db;
 
+/** Probe the peers one after the other with blocking connections */
+static void ProbeBlocking(std::vector<CServiceResult> &ips,
+                          std::vector<CAddress> &addr) {
+    int64_t now = GetTime();
+    for (size_t i = 0; i < ips.size(); i++) {
+        CServiceResult &res = ips[i];
+        res.nBanTime = 0;
+        res.nClientV = 0;
+        res.nHeight = 0;
+        res.strClientV = "";
+        res.services = 0;
+        bool getaddr = res.ourLastSuccess + 86400 < now;
+        try {
+            CSeederNode node(res.service, getaddr ? &addr : nullptr);
+            bool ret = node.Run();
+            if (!ret) {
+                res.nBanTime = node.GetBan();
+            } else {
+                res.nBanTime = 0;
+            }
+            res.nClientV = node.GetClientVersion();
+            res.strClientV = node.GetClientSubVersion();
+            res.nHeight = node.GetStartingHeight();
+            res.services = node.GetServices();
+            // tfm::format(std::cout, "%s: %s!!!\n", cip.ToString(),
+            // ret ? "GOOD" : "BAD");
+            res.fGood = ret;
+        } catch (std::ios_base::failure &e) {
+            res.nBanTime = 0;
+            res.fGood = false;
+        }
+    }
+}
+
+/**
+ * Peers that can only be reached through a proxy, handed over to the crawler
+ * threads by the event driven crawler.
+ */
+static Mutex g_proxied_mutex;
+static std::condition_variable g_proxied_cv;
+static std::vector<CServiceResult> g_proxied GUARDED_BY(g_proxied_mutex);
+
 extern "C" void *ThreadCrawler(void *data) {
-    int *nThreads = (int *)data;
+    const auto &opts = *(const seeder::CDnsSeedOpts *)data;
     do {
         std::vector<CServiceResult> ips;
-        int wait = 5;
-        db.GetMany(ips, 16, wait);
-        int64_t now = GetTime();
-        if (ips.empty()) {
-            wait *= 1000;
-            wait += rand() % (500 * *nThreads);
-            UninterruptibleSleep(std::chrono::milliseconds(wait));
-            continue;
+        if (opts.nMaxProbes > 0) {
+            // The event driven crawler pulls the peers from the database
+            WAIT_LOCK(g_proxied_mutex, lock);
+            g_proxied_cv.wait(lock, []() EXCLUSIVE_LOCKS_REQUIRED(
+                                        g_proxied_mutex) {
+                return !g_proxied.empty();
+            });
+            const size_t count = std::min<size_t>(g_proxied.size(), 16);
+            ips.assign(g_proxied.end() - count, g_proxied.end());
+            g_proxied.resize(g_proxied.size() - count);
+        } else {
+            int wait = 5;
+            db.GetMany(ips, 16, wait);
+            if (ips.empty()) {
+                wait *= 1000;
+                wait += rand() % (500 * opts.nThreads);
+                UninterruptibleSleep(std::chrono::milliseconds(wait));
+                continue;
+            }
         }
 
         std::vector<CAddress> addr;
-        for (size_t i = 0; i < ips.size(); i++) {
-            CServiceResult &res = ips[i];
-            res.nBanTime = 0;
-            res.nClientV = 0;
-            res.nHeight = 0;
-            res.strClientV = "";
-            res.services = 0;
-            bool getaddr = res.ourLastSuccess + 86400 < now;
-            try {
-                CSeederNode node(res.service, getaddr ? &addr : nullptr);
-                bool ret = node.Run();
-                if (!ret) {
-                    res.nBanTime = node.GetBan();
-                } else {
-                    res.nBanTime = 0;
-                }
-                res.nClientV = node.GetClientVersion();
-                res.strClientV = node.GetClientSubVersion();
-                res.nHeight = node.GetStartingHeight();
-                res.services = node.GetServices();
-                // tfm::format(std::cout, "%s: %s!!!\n", cip.ToString(),
-                // ret ? "GOOD" : "BAD");
-                res.fGood = ret;
-            } catch (std::ios_base::failure &e) {
-                res.nBanTime = 0;
-                res.fGood = false;
-            }
-        }
+        ProbeBlocking(ips, addr);
 
         db.ResultMany(ips);
         db.Add(addr);
@@ -84,67 +116,140 @@ extern "C" void *ThreadCrawler(void *data) {
     return nullptr;
 }
 
+#ifdef USE_EPOLL_CRAWLER
+/** Maximum number of peers pulled from the database at once */
+static constexpr int ASYNC_CRAWLER_BATCH_SIZE = 256;
+/** Maximum time the probe results are held before updating the database */
+static constexpr auto ASYNC_CRAWLER_FLUSH_INTERVAL = 1s;
+
+extern "C" void *ThreadAsyncCrawler(void *data) {
+    auto &crawler = *(seeder::CAsyncCrawler *)data;
+    std::vector<CServiceResult> results;
+    std::vector<CAddress> addrs;
+    auto nextFlush = Now<SteadyMilliseconds>() + ASYNC_CRAWLER_FLUSH_INTERVAL;
+    do {
+        int wait = 5;
+        std::vector<CServiceResult> ips;
+        if (crawler.GetFreeSlots() > 0) {
+            db.GetMany(ips,
+                       std::min<int>(crawler.GetFreeSlots(),
+                                     ASYNC_CRAWLER_BATCH_SIZE),
+                       wait);
+        }
+
+        int64_t now = GetTime();
+        std::vector<CServiceResult> proxied;
+        for (const CServiceResult &ip : ips) {
+            proxyType proxy;
+            if (GetProxy(ip.service.GetNetwork(), proxy)) {
+                proxied.push_back(ip);
+                continue;
+            }
+            crawler.Add(ip, ip.ourLastSuccess + 86400 < now);
+        }
+        if (!proxied.empty()) {
+            WITH_LOCK(g_proxied_mutex, g_proxied.insert(g_proxied.end(),
+                                                        proxied.begin(),
+                                                        proxied.end()));
+            g_proxied_cv.notify_all();
+        }
+
+        if (crawler.GetInFlight() == 0 && ips.empty()) {
+            UninterruptibleSleep(std::chrono::seconds(wait));
+            continue;
+        }
+
+        crawler.Poll(100ms, results, addrs);
+        if (results.size() >= ASYNC_CRAWLER_BATCH_SIZE ||
+            (!results.empty() && Now<SteadyMilliseconds>() >= nextFlush)) {
+            db.ResultMany(results);
+            db.Add(addrs);
+            results.clear();
+            addrs.clear();
+            nextFlush =
+                Now<SteadyMilliseconds>() + ASYNC_CRAWLER_FLUSH_INTERVAL;
+        }
+    } while (1);
+    return nullptr;
+}
+#endif // USE_EPOLL_CRAWLER
+
 extern "C" uint32_t GetIPList(void *thread, char *requestedHostname,
                               addr_t *addr, uint32_t max, uint32_t ipv4,
                               uint32_t ipv6);
 
+struct FlagSpecificData {
+    int nIPv4{0}, nIPv6{0};
+    std::vector<addr_t> cache;
+};
+
+/**
+ * Addresses served for each of the supported service flags filters. A new
+ * snapshot is built periodically by ThreadDumper and published atomically, so
+ * the DNS threads never wait on the database while answering queries.
+ */
+struct DnsAddressSnapshot {
+    std::map<uint64_t, FlagSpecificData> perflag;
+};
+
+static std::shared_ptr<const DnsAddressSnapshot> g_dns_snapshot;
+static std::atomic<uint64_t> g_dns_db_queries{0};
+
+/** Interval between two refreshes of the DNS address snapshot */
+static constexpr std::chrono::seconds DNS_SNAPSHOT_REFRESH_INTERVAL{5};
+
+static void RefreshDnsSnapshot(const std::set<uint64_t> &filterWhitelist) {
+    static bool nets[NET_MAX] = {};
+    nets[NET_IPV4] = true;
+    nets[NET_IPV6] = true;
+
+    auto snapshot = std::make_shared<DnsAddressSnapshot>();
+    // The flags 0 are used when no filter is requested.
+    std::set<uint64_t> filters = filterWhitelist;
+    filters.insert(0);
+    for (const uint64_t requestedFlags : filters) {
+        std::set<CNetAddr> ips;
+        db.GetIPs(ips, requestedFlags, 1000, nets);
+        g_dns_db_queries++;
+        FlagSpecificData &thisflag = snapshot->perflag[requestedFlags];
+        thisflag.cache.reserve(ips.size());
+        for (auto &ip : ips) {
+            struct in_addr addr;
+            struct in6_addr addr6;
+            if (ip.GetInAddr(&addr)) {
+                addr_t a;
+                a.v = 4;
+                memcpy(&a.data.v4, &addr, 4);
+                thisflag.cache.push_back(a);
+                thisflag.nIPv4++;
+            } else if (ip.GetIn6Addr(&addr6)) {
+                addr_t a;
+                a.v = 6;
+                memcpy(&a.data.v6, &addr6, 16);
+                thisflag.cache.push_back(a);
+                thisflag.nIPv6++;
+            }
+        }
+    }
+    std::atomic_store(&g_dns_snapshot,
+                      std::shared_ptr<const DnsAddressSnapshot>(snapshot));
+}
+
 class CDnsThread {
 public:
-    struct FlagSpecificData {
-        int nIPv4, nIPv6;
-        std::vector<addr_t> cache;
-        time_t cacheTime;
-        unsigned int cacheHits;
-        FlagSpecificData() : nIPv4(0), nIPv6(0), cacheTime(0), cacheHits(0) {}
-    };
-
     dns_opt_t dns_opt; // must be first
     const int id;
+    //! Copy of the latest snapshot, shuffled in place while serving queries
     std::map<uint64_t, FlagSpecificData> perflag;
-    std::atomic<uint64_t> dbQueries;
+    std::shared_ptr<const DnsAddressSnapshot> snapshot;
     std::set<uint64_t> filterWhitelist;
 
-    void cacheHit(uint64_t requestedFlags, bool force = false) {
-        static bool nets[NET_MAX] = {};
-        if (!nets[NET_IPV4]) {
-            nets[NET_IPV4] = true;
-            nets[NET_IPV6] = true;
-        }
-        int64_t now = GetTime();
-        FlagSpecificData &thisflag = perflag[requestedFlags];
-        thisflag.cacheHits++;
-        if (force ||
-            thisflag.cacheHits * 400 >
-                (thisflag.cache.size() * thisflag.cache.size()) ||
-            (thisflag.cacheHits * thisflag.cacheHits * 20 >
-                 thisflag.cache.size() &&
-             (now - thisflag.cacheTime > 5))) {
-            std::set<CNetAddr> ips;
-            db.GetIPs(ips, requestedFlags, 1000, nets);
-            dbQueries++;
-            thisflag.cache.clear();
-            thisflag.nIPv4 = 0;
-            thisflag.nIPv6 = 0;
-            thisflag.cache.reserve(ips.size());
-            for (auto &ip : ips) {
-                struct in_addr addr;
-                struct in6_addr addr6;
-                if (ip.GetInAddr(&addr)) {
-                    addr_t a;
-                    a.v = 4;
-                    memcpy(&a.data.v4, &addr, 4);
-                    thisflag.cache.push_back(a);
-                    thisflag.nIPv4++;
-                } else if (ip.GetIn6Addr(&addr6)) {
-                    addr_t a;
-                    a.v = 6;
-                    memcpy(&a.data.v6, &addr6, 16);
-                    thisflag.cache.push_back(a);
-                    thisflag.nIPv6++;
-                }
-            }
-            thisflag.cacheHits = 0;
-            thisflag.cacheTime = now;
+    void cacheHit() {
+        auto latest = std::atomic_load(&g_dns_snapshot);
+        if (latest != snapshot) {
+            snapshot = std::move(latest);
+            perflag = snapshot ? snapshot->perflag
+                               : std::map<uint64_t, FlagSpecificData>{};
         }
     }
 
@@ -158,7 +263,6 @@ public:
         dns_opt.addr = opts->ip_addr.c_str();
         dns_opt.port = opts->nPort;
         dns_opt.nRequests = 0;
-        dbQueries = 0;
         perflag.clear();
         filterWhitelist = opts->filter_whitelist;
     }
@@ -187,7 +291,7 @@ extern "C" uint32_t GetIPList(void *data, char *requestedHostname, addr_t *addr,
     } else if (strcasecmp(requestedHostname, thread->dns_opt.host)) {
         return 0;
     }
-    thread->cacheHit(requestedFlags);
+    thread->cacheHit();
     auto &thisflag = thread->perflag[requestedFlags];
     uint32_t size = thisflag.cache.size();
     uint32_t maxmax = (ipv4 ? thisflag.nIPv4 : 0) + (ipv6 ? thisflag.nIPv6 : 0);
@@ -239,55 +343,61 @@ int StatCompare(const CAddrReport &a, const CAddrReport &b) {
     }
 }
 
+static void DumpDb() {
+    std::vector<CAddrReport> v = db.GetAll();
+    sort(v.begin(), v.end(), StatCompare);
+    FILE *f = fsbridge::fopen("dnsseed.dat.new", "w+");
+    if (f) {
+        {
+            CAutoFile cf(f, SER_DISK, CLIENT_VERSION);
+            cf << db;
+        }
+        rename("dnsseed.dat.new", "dnsseed.dat");
+    }
+    std::ofstream d{"dnsseed.dump"};
+    tfm::format(
+        d, "# address                                        good  "
+           "lastSuccess    %%(2h)   %%(8h)   %%(1d)   %%(7d)  "
+           "%%(30d)  blocks      svcs  version\n");
+    double stat[5] = {0, 0, 0, 0, 0};
+    for (CAddrReport rep : v) {
+        tfm::format(
+            d,
+            "%-47s  %4d  %11" PRId64
+            "  %6.2f%% %6.2f%% %6.2f%% %6.2f%% %6.2f%%  %6i  %08" PRIx64
+            "  %5i \"%s\"\n",
+            rep.ip.ToString(), (int)rep.fGood, rep.lastSuccess,
+            100.0 * rep.uptime[0], 100.0 * rep.uptime[1],
+            100.0 * rep.uptime[2], 100.0 * rep.uptime[3],
+            100.0 * rep.uptime[4], rep.blocks, rep.services,
+            rep.clientVersion, rep.clientSubVersion);
+        stat[0] += rep.uptime[0];
+        stat[1] += rep.uptime[1];
+        stat[2] += rep.uptime[2];
+        stat[3] += rep.uptime[3];
+        stat[4] += rep.uptime[4];
+    }
+    std::ofstream ff{"dnsstats.log", std::ios_base::app};
+    tfm::format(ff, "%llu %g %g %g %g %g\n", GetTime(), stat[0],
+                stat[1], stat[2], stat[3], stat[4]);
+}
+
 extern "C" void *ThreadDumper(void *data) {
     assert(data);
-    const auto dumpInterval(*(const std::chrono::seconds *)data);
+    const auto &opts = *(const seeder::CDnsSeedOpts *)data;
+    const auto dumpInterval(opts.dumpInterval);
 
     // First dump should occur no later than 10 seconds. Successive dumps will
-    // occur every dump interval.
-    UninterruptibleSleep(std::min(10s, dumpInterval));
+    // occur every dump interval. The addresses served by the DNS threads are
+    // refreshed more often in between.
+    auto nextDump = Now<SteadySeconds>() + std::min(10s, dumpInterval);
     do {
-        {
-            std::vector<CAddrReport> v = db.GetAll();
-            sort(v.begin(), v.end(), StatCompare);
-            FILE *f = fsbridge::fopen("dnsseed.dat.new", "w+");
-            if (f) {
-                {
-                    CAutoFile cf(f, SER_DISK, CLIENT_VERSION);
-                    cf << db;
-                }
-                rename("dnsseed.dat.new", "dnsseed.dat");
-            }
-            std::ofstream d{"dnsseed.dump"};
-            tfm::format(
-                d, "# address                                        good  "
-                   "lastSuccess    %%(2h)   %%(8h)   %%(1d)   %%(7d)  "
-                   "%%(30d)  blocks      svcs  version\n");
-            double stat[5] = {0, 0, 0, 0, 0};
-            for (CAddrReport rep : v) {
-                tfm::format(
-                    d,
-                    "%-47s  %4d  %11" PRId64
-                    "  %6.2f%% %6.2f%% %6.2f%% %6.2f%% %6.2f%%  %6i  %08" PRIx64
-                    "  %5i \"%s\"\n",
-                    rep.ip.ToString(), (int)rep.fGood, rep.lastSuccess,
-                    100.0 * rep.uptime[0], 100.0 * rep.uptime[1],
-                    100.0 * rep.uptime[2], 100.0 * rep.uptime[3],
-                    100.0 * rep.uptime[4], rep.blocks, rep.services,
-                    rep.clientVersion, rep.clientSubVersion);
-                stat[0] += rep.uptime[0];
-                stat[1] += rep.uptime[1];
-                stat[2] += rep.uptime[2];
-                stat[3] += rep.uptime[3];
-                stat[4] += rep.uptime[4];
-            }
-            std::ofstream ff{"dnsstats.log", std::ios_base::app};
-            tfm::format(ff, "%llu %g %g %g %g %g\n", GetTime(), stat[0],
-                        stat[1], stat[2], stat[3], stat[4]);
-            // End scope so all streams flush before sleeping
+        UninterruptibleSleep(DNS_SNAPSHOT_REFRESH_INTERVAL);
+        RefreshDnsSnapshot(opts.filter_whitelist);
+        if (Now<SteadySeconds>() >= nextDump) {
+            DumpDb();
+            nextDump = Now<SteadySeconds>() + dumpInterval;
         }
-
-        UninterruptibleSleep(dumpInterval);
     } while (1);
     return nullptr;
 }
@@ -309,10 +419,9 @@ extern "C" void *ThreadStats(void *) {
         }
         tfm::format(std::cout, "\x1b[s");
         uint64_t requests = 0;
-        uint64_t queries = 0;
+        uint64_t queries = g_dns_db_queries;
         for (unsigned int i = 0; i < dnsThread.size(); i++) {
             requests += dnsThread[i]->dns_opt.nRequests;
-            queries += dnsThread[i]->dbQueries;
         }
         tfm::format(
             std::cout,
@@ -425,6 +534,7 @@ int main(int argc, char **argv) {
         tfm::format(std::cout,
                     "Starting %i DNS threads for %s on %s (port %i)...",
                     opts.nDnsThreads, opts.host, opts.ns, opts.nPort);
+        RefreshDnsSnapshot(opts.filter_whitelist);
         dnsThread.clear();
         for (int i = 0; i < opts.nDnsThreads; i++) {
             dnsThread.push_back(new CDnsThread(&opts, i));
@@ -443,12 +553,29 @@ int main(int argc, char **argv) {
     pthread_attr_setstacksize(&attr_crawler, 0x20000);
     for (int i = 0; i < opts.nThreads; i++) {
         pthread_t thread;
-        pthread_create(&thread, &attr_crawler, ThreadCrawler, &opts.nThreads);
+        pthread_create(&thread, &attr_crawler, ThreadCrawler, &opts);
     }
     pthread_attr_destroy(&attr_crawler);
     tfm::format(std::cout, "done\n");
+#ifdef USE_EPOLL_CRAWLER
+    std::unique_ptr<seeder::CAsyncCrawler> asyncCrawler;
+    if (opts.nMaxProbes > 0) {
+        tfm::format(std::cout,
+                    "Starting event driven crawler (up to %i probes)...",
+                    opts.nMaxProbes);
+        asyncCrawler = std::make_unique<seeder::CAsyncCrawler>(opts.nMaxProbes);
+        if (!asyncCrawler->IsValid()) {
+            tfm::format(std::cerr, "Error: cannot create the epoll instance\n");
+            return EXIT_FAILURE;
+        }
+        pthread_t threadAsyncCrawler;
+        pthread_create(&threadAsyncCrawler, nullptr, ThreadAsyncCrawler,
+                       asyncCrawler.get());
+        tfm::format(std::cout, "done\n");
+    }
+#endif
     pthread_create(&threadStats, nullptr, ThreadStats, nullptr);
-    pthread_create(&threadDump, nullptr, ThreadDumper, &opts.dumpInterval);
+    pthread_create(&threadDump, nullptr, ThreadDumper, &opts);
     void *res;
     pthread_join(threadDump, &res);
     return EXIT_SUCCESS;
@@ -7,6 +7,7 @@
 #include <chainparams.h>
 #include <clientversion.h>
 #include <common/args.h>
+#include <seeder/crawler.h>
 
 #include <string>
 
@@ -68,6 +69,21 @@ int CDnsSeedOpts::ParseCommandLine(int argc, const char **argv) {
         return EXIT_FAILURE;
     }
 
+    nMaxProbes = argsManager->GetIntArg("-maxprobes", DEFAULT_MAX_PROBES);
+    if (nMaxProbes < 0) {
+        tfm::format(
+            std::cerr,
+            "Error: -maxprobes argument expects only non-negative integers\n");
+        return EXIT_FAILURE;
+    }
+#ifndef USE_EPOLL_CRAWLER
+    if (nMaxProbes > 0) {
+        tfm::format(std::cerr, "Error: -maxprobes is not supported on this "
+                               "platform\n");
+        return EXIT_FAILURE;
+    }
+#endif
+
     fWipeBan = argsManager->GetBoolArg("-wipeban", DEFAULT_WIPE_BAN);
     fWipeIgnore = argsManager->GetBoolArg("-wipeignore", DEFAULT_WIPE_IGNORE);
     mbox = argsManager->GetArg("-mbox", DEFAULT_EMAIL);
@@ -141,6 +157,14 @@ void CDnsSeedOpts::SetupSeederArgs() {
                         strprintf("Number of DNS server threads (default: %d)",
                                   DEFAULT_NUM_DNS_THREADS),
                         ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
+    argsManager->AddArg(
+        "-maxprobes=<n>",
+        strprintf("Maximum number of peers probed concurrently from a single "
+                  "event driven crawler thread. The crawler threads are then "
+                  "only used for the peers reached through a proxy. Set to 0 "
+                  "to disable (default: %d)",
+                  DEFAULT_MAX_PROBES),
+        ArgsManager::ALLOW_ANY, OptionsCategory::OPTIONS);
     argsManager->AddArg("-address=<address>",
                         strprintf("Address to listen on (default: '%s')",
                                   DEFAULT_LISTEN_ADDRESS),
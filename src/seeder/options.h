@@ -19,6 +19,7 @@ static const int DEFAULT_DUMP_INTERVAL_SECONDS = 60 * 60;
 static const int DEFAULT_NUM_THREADS = 96;
 static const int DEFAULT_PORT = 53;
 static const int DEFAULT_NUM_DNS_THREADS = 4;
+static const int DEFAULT_MAX_PROBES = 0;
 static const bool DEFAULT_WIPE_BAN = false;
 static const bool DEFAULT_WIPE_IGNORE = false;
 static const std::string DEFAULT_EMAIL = "";
@@ -36,6 +37,7 @@ public:
     int nThreads;
     int nPort;
     int nDnsThreads;
+    int nMaxProbes;
     bool fWipeBan;
     bool fWipeIgnore;
     std::string mbox;
@@ -51,7 +53,8 @@ public:
         : argsManager(argsMan),
           dumpInterval(std::chrono::seconds(DEFAULT_DUMP_INTERVAL_SECONDS)),
           nThreads(DEFAULT_NUM_THREADS), nPort(DEFAULT_PORT),
-          nDnsThreads(DEFAULT_NUM_DNS_THREADS), fWipeBan(DEFAULT_WIPE_BAN),
+          nDnsThreads(DEFAULT_NUM_DNS_THREADS),
+          nMaxProbes(DEFAULT_MAX_PROBES), fWipeBan(DEFAULT_WIPE_BAN),
           fWipeIgnore(DEFAULT_WIPE_IGNORE), mbox(DEFAULT_EMAIL),
           ns(DEFAULT_NAMESERVER), host(DEFAULT_HOST), tor(DEFAULT_TOR_PROXY),
           ip_addr(DEFAULT_LISTEN_ADDRESS), ipv4_proxy(DEFAULT_IPV4_PROXY),
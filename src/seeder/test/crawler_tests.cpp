@@ -0,0 +1,104 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <seeder/crawler.h>
+
+#include <chainparams.h>
+#include <compat.h>
+#include <netbase.h>
+#include <protocol.h>
+#include <seeder/db.h>
+#include <seeder/test/fakepeer.h>
+#include <version.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <chrono>
+#include <vector>
+
+#ifdef USE_EPOLL_CRAWLER
+
+struct CrawlerTestingSetup {
+    CrawlerTestingSetup() { SelectParams(CBaseChainParams::REGTEST); }
+};
+
+/** Probe the services and wait for all the results */
+static std::vector<CServiceResult> Crawl(const std::vector<CService> &services,
+                                         bool fGetAddr,
+                                         std::vector<CAddress> &addrs) {
+    seeder::CAsyncCrawler crawler(services.size());
+    BOOST_REQUIRE(crawler.IsValid());
+    for (const CService &service : services) {
+        CServiceResult ip = {};
+        ip.service = service;
+        crawler.Add(ip, fGetAddr);
+    }
+    BOOST_CHECK_EQUAL(crawler.GetInFlight(), services.size());
+    BOOST_CHECK_EQUAL(crawler.GetFreeSlots(), 0);
+
+    std::vector<CServiceResult> results;
+    const auto deadline = std::chrono::steady_clock::now() + 60s;
+    while (results.size() < services.size() &&
+           std::chrono::steady_clock::now() < deadline) {
+        crawler.Poll(100ms, results, addrs);
+    }
+    BOOST_CHECK_EQUAL(crawler.GetInFlight(), 0);
+    BOOST_CHECK_EQUAL(results.size(), services.size());
+    return results;
+}
+
+BOOST_FIXTURE_TEST_SUITE(crawler_tests, CrawlerTestingSetup)
+
+BOOST_AUTO_TEST_CASE(probe_good_peers) {
+    FakePeerServer server;
+    BOOST_REQUIRE(server.GetService().IsValid());
+
+    std::vector<CAddress> addrs;
+    const std::vector<CService> services(8, server.GetService());
+    for (const CServiceResult &res : Crawl(services, false, addrs)) {
+        BOOST_CHECK(res.service == server.GetService());
+        BOOST_CHECK(res.fGood);
+        BOOST_CHECK_EQUAL(res.nBanTime, 0);
+        BOOST_CHECK_EQUAL(res.nClientV, PROTOCOL_VERSION);
+        BOOST_CHECK_EQUAL(res.strClientV, "/FakePeer:0.0.0/");
+        BOOST_CHECK_EQUAL(res.nHeight, GetRequireHeight());
+        BOOST_CHECK_EQUAL(res.services, NODE_NETWORK);
+    }
+    BOOST_CHECK(addrs.empty());
+    BOOST_CHECK_EQUAL(server.GetNumConnections(), services.size());
+}
+
+BOOST_AUTO_TEST_CASE(probe_getaddr) {
+    FakePeerServer server(10);
+    BOOST_REQUIRE(server.GetService().IsValid());
+
+    std::vector<CAddress> addrs;
+    const std::vector<CService> services(2, server.GetService());
+    for (const CServiceResult &res : Crawl(services, true, addrs)) {
+        BOOST_CHECK(res.fGood);
+    }
+    BOOST_CHECK_EQUAL(addrs.size(), 2 * 10);
+}
+
+BOOST_AUTO_TEST_CASE(probe_unreachable_peer) {
+    // Find a port nobody listens to
+    CService unreachable;
+    {
+        FakePeerServer server;
+        unreachable = server.GetService();
+    }
+    BOOST_REQUIRE(unreachable.IsValid());
+
+    std::vector<CAddress> addrs;
+    for (const CServiceResult &res : Crawl({unreachable}, true, addrs)) {
+        BOOST_CHECK(!res.fGood);
+        BOOST_CHECK_EQUAL(res.nBanTime, 0);
+        BOOST_CHECK_EQUAL(res.nClientV, 0);
+    }
+    BOOST_CHECK(addrs.empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+#endif // USE_EPOLL_CRAWLER
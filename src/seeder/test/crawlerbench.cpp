@@ -0,0 +1,125 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+/**
+ * Measure the number of peers the seeder crawlers can probe per second,
+ * against fake peers listening on the loopback interface.
+ *
+ * Usage: seeder-crawlerbench [probes] [maxprobes] [threads]
+ *
+ * The event driven crawler is run with up to maxprobes concurrent probes,
+ * then the blocking crawler with the given number of threads for comparison
+ * (use 0 threads to skip it).
+ */
+
+#include <chainparams.h>
+#include <seeder/bitcoin.h>
+#include <seeder/crawler.h>
+#include <seeder/db.h>
+#include <seeder/test/fakepeer.h>
+#include <util/translation.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+const std::function<std::string(const char *)> G_TRANSLATION_FUN = nullptr;
+
+#ifdef USE_EPOLL_CRAWLER
+
+static void Report(const char *name, size_t nProbes, size_t nGood,
+                   std::chrono::steady_clock::time_point start) {
+    const double elapsed = std::chrono::duration<double>(
+                               std::chrono::steady_clock::now() - start)
+                               .count();
+    printf("%s: %zu probes (%zu good) in %.2fs: %.0f probes/sec\n", name,
+           nProbes, nGood, elapsed, nProbes / elapsed);
+}
+
+static void BenchAsync(const CService &service, size_t nProbes,
+                       size_t nMaxProbes) {
+    seeder::CAsyncCrawler crawler(nMaxProbes);
+    if (!crawler.IsValid()) {
+        fprintf(stderr, "Cannot create the epoll instance\n");
+        return;
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    size_t nAdded = 0;
+    size_t nGood = 0;
+    std::vector<CServiceResult> results;
+    std::vector<CAddress> addrs;
+    while (nAdded < nProbes || crawler.GetInFlight() > 0) {
+        while (nAdded < nProbes && crawler.GetFreeSlots() > 0) {
+            CServiceResult ip = {};
+            ip.service = service;
+            crawler.Add(ip, false);
+            nAdded++;
+        }
+        crawler.Poll(100ms, results, addrs);
+        for (const CServiceResult &res : results) {
+            nGood += res.fGood;
+        }
+        results.clear();
+    }
+    Report("event driven crawler", nProbes, nGood, start);
+}
+
+static void BenchBlocking(const CService &service, size_t nProbes,
+                          int nThreads) {
+    const auto start = std::chrono::steady_clock::now();
+    std::atomic<size_t> nStarted{0};
+    std::atomic<size_t> nGood{0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nThreads; i++) {
+        threads.emplace_back([&]() {
+            while (nStarted++ < nProbes) {
+                CSeederNode node(service, nullptr);
+                nGood += node.Run();
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    Report("blocking crawler", nProbes, nGood, start);
+}
+
+int main(int argc, char **argv) {
+    const size_t nProbes = argc > 1 ? atoi(argv[1]) : 10000;
+    const size_t nMaxProbes = argc > 2 ? atoi(argv[2]) : 2000;
+    const int nThreads = argc > 3 ? atoi(argv[3]) : 96;
+    if (nProbes == 0 || nMaxProbes == 0 || nThreads < 0) {
+        fprintf(stderr, "Usage: %s [probes] [maxprobes] [threads]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    SelectParams(CBaseChainParams::MAIN);
+    FakePeerServer server;
+    if (!server.GetService().IsValid()) {
+        fprintf(stderr, "Cannot start the fake peers\n");
+        return EXIT_FAILURE;
+    }
+
+    BenchAsync(server.GetService(), nProbes, nMaxProbes);
+    if (nThreads > 0) {
+        BenchBlocking(server.GetService(), nProbes, nThreads);
+    }
+    return EXIT_SUCCESS;
+}
+
+#else
+
+int main() {
+    fprintf(stderr, "The event driven crawler is not supported on this "
+                    "platform\n");
+    return EXIT_FAILURE;
+}
+
+#endif // USE_EPOLL_CRAWLER
@@ -0,0 +1,129 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <seeder/test/fakepeer.h>
+
+#ifdef USE_EPOLL_CRAWLER
+
+#include <compat.h>
+#include <netbase.h>
+#include <protocol.h>
+#include <seeder/db.h>
+#include <seeder/messagewriter.h>
+#include <streams.h>
+#include <util/time.h>
+#include <version.h>
+
+#include <sys/epoll.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <set>
+
+FakePeerServer::FakePeerServer(size_t nAddrs) {
+    // Build the messages sent to every seeder connecting, they are the same
+    // for all the peers.
+    CDataStream stream(SER_NETWORK, PROTOCOL_VERSION);
+    const uint64_t services{ServiceFlags(NODE_NETWORK)};
+    MessageWriter::WriteMessage(stream, NetMsgType::VERSION, PROTOCOL_VERSION,
+                                services, GetTime(), services, CService(),
+                                services, CService(), uint64_t(1),
+                                std::string("/FakePeer:0.0.0/"),
+                                GetRequireHeight(), uint8_t(0));
+    MessageWriter::WriteMessage(stream, NetMsgType::VERACK);
+    if (nAddrs > 0) {
+        std::vector<CAddress> vAddr;
+        for (size_t i = 0; i < nAddrs; i++) {
+            struct in_addr addr;
+            addr.s_addr = htonl(0x0a000000 | (i + 1));
+            vAddr.emplace_back(CService(CNetAddr(addr), 8333),
+                               ServiceFlags(NODE_NETWORK), Now<NodeSeconds>());
+        }
+        MessageWriter::WriteMessage(stream, NetMsgType::ADDR, vAddr);
+    }
+    greeting.assign(stream.begin(), stream.end());
+
+    listenFd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                      IPPROTO_TCP);
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (listenFd < 0 || epollFd < 0) {
+        return;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    struct epoll_event event = {};
+    event.events = EPOLLIN;
+    event.data.fd = listenFd;
+    if (bind(listenFd, (struct sockaddr *)&addr, len) != 0 ||
+        getsockname(listenFd, (struct sockaddr *)&addr, &len) != 0 ||
+        listen(listenFd, SOMAXCONN) != 0 ||
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event) != 0) {
+        return;
+    }
+
+    service.SetSockAddr((struct sockaddr *)&addr);
+    thread = std::thread(&FakePeerServer::Run, this);
+}
+
+FakePeerServer::~FakePeerServer() {
+    fStop = true;
+    if (thread.joinable()) {
+        thread.join();
+    }
+    if (listenFd >= 0) {
+        close(listenFd);
+    }
+    if (epollFd >= 0) {
+        close(epollFd);
+    }
+}
+
+void FakePeerServer::Run() {
+    std::set<int> clients;
+    char buffer[0x10000];
+    struct epoll_event events[256];
+    while (!fStop) {
+        int nEvents = epoll_wait(epollFd, events, 256, 100);
+        for (int i = 0; i < nEvents; i++) {
+            const int fd = events[i].data.fd;
+            if (fd != listenFd) {
+                // Discard everything the seeder sends until it disconnects
+                ssize_t nBytes = recv(fd, buffer, sizeof(buffer), 0);
+                if (nBytes == 0 ||
+                    (nBytes < 0 && WSAGetLastError() != WSAEWOULDBLOCK)) {
+                    // Closing the socket removes it from the epoll set
+                    close(fd);
+                    clients.erase(fd);
+                }
+                continue;
+            }
+
+            int client;
+            while ((client = accept4(listenFd, nullptr, nullptr,
+                                     SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                nConnections++;
+                // The greeting fits in the socket buffer of a fresh
+                // connection, so it is sent at once.
+                send(client, greeting.data(), greeting.size(), MSG_NOSIGNAL);
+                struct epoll_event event = {};
+                event.events = EPOLLIN;
+                event.data.fd = client;
+                if (epoll_ctl(epollFd, EPOLL_CTL_ADD, client, &event) != 0) {
+                    close(client);
+                    continue;
+                }
+                clients.insert(client);
+            }
+        }
+    }
+    for (const int fd : clients) {
+        close(fd);
+    }
+}
+
+#endif // USE_EPOLL_CRAWLER
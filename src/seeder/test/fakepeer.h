@@ -0,0 +1,57 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_SEEDER_TEST_FAKEPEER_H
+#define BITCOIN_SEEDER_TEST_FAKEPEER_H
+
+#include <netaddress.h>
+#include <seeder/crawler.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+// The fake peers are only used to exercise the event driven crawler
+#ifdef USE_EPOLL_CRAWLER
+
+/**
+ * Local peers speaking just enough of the protocol to be probed by the
+ * seeder, for testing and benchmarking the crawlers without network access.
+ *
+ * A single thread accepts the connections on a free port of the loopback
+ * interface. Each peer sends the version and verack messages as soon as it is
+ * connected, followed by an addr message if some addresses are configured,
+ * then ignores everything it receives.
+ */
+class FakePeerServer {
+public:
+    /** nAddrs is the number of addresses sent by each peer */
+    explicit FakePeerServer(size_t nAddrs = 0);
+    ~FakePeerServer();
+
+    FakePeerServer(const FakePeerServer &) = delete;
+    FakePeerServer &operator=(const FakePeerServer &) = delete;
+
+    /** Address to connect to, invalid if the server failed to start */
+    const CService &GetService() const { return service; }
+
+    uint64_t GetNumConnections() const { return nConnections; }
+
+private:
+    CService service;
+    std::vector<std::byte> greeting;
+    int listenFd{-1};
+    int epollFd{-1};
+    std::atomic<bool> fStop{false};
+    std::atomic<uint64_t> nConnections{0};
+    std::thread thread;
+
+    void Run();
+};
+
+#endif // USE_EPOLL_CRAWLER
+
+#endif // BITCOIN_SEEDER_TEST_FAKEPEER_H
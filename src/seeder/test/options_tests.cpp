@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <common/args.h>
+#include <seeder/crawler.h>
 #include <seeder/options.h>
 #include <util/string.h>
 
@@ -30,6 +31,7 @@ BOOST_FIXTURE_TEST_CASE(options_defaults_test, ArgsTestingSetup) {
     BOOST_CHECK(opts.nPort == seeder::DEFAULT_PORT);
     BOOST_CHECK(opts.nThreads == seeder::DEFAULT_NUM_THREADS);
     BOOST_CHECK(opts.nDnsThreads == seeder::DEFAULT_NUM_DNS_THREADS);
+    BOOST_CHECK(opts.nMaxProbes == seeder::DEFAULT_MAX_PROBES);
     BOOST_CHECK(opts.fWipeBan == seeder::DEFAULT_WIPE_BAN);
     BOOST_CHECK(opts.fWipeIgnore == seeder::DEFAULT_WIPE_IGNORE);
 }
@@ -104,6 +106,30 @@ BOOST_FIXTURE_TEST_CASE(options_dns_threads_test, ArgsTestingSetup) {
     }
 }
 
+BOOST_FIXTURE_TEST_CASE(options_max_probes_test, ArgsTestingSetup) {
+#ifdef USE_EPOLL_CRAWLER
+    const int enabledResult = seeder::CONTINUE_EXECUTION;
+#else
+    const int enabledResult = EXIT_FAILURE;
+#endif
+    const std::map<int, int> expectedResults = {
+        {-9999, EXIT_FAILURE},
+        {-1, EXIT_FAILURE},
+        {0, seeder::CONTINUE_EXECUTION},
+        {1, enabledResult},
+        {9999, enabledResult}};
+
+    for (const auto entry : expectedResults) {
+        const std::string testArg = "-maxprobes=" + ToString(entry.first);
+        const char *argv[] = {"ignored", TEST_HOST, TEST_NAMESERVER, TEST_EMAIL,
+                              testArg.c_str()};
+        BOOST_CHECK(opts.ParseCommandLine(5, argv) == entry.second);
+        if (entry.second == seeder::CONTINUE_EXECUTION) {
+            BOOST_CHECK(opts.nMaxProbes == entry.first);
+        }
+    }
+}
+
 BOOST_FIXTURE_TEST_CASE(options_port_test, ArgsTestingSetup) {
     const std::map<int, int> expectedResults = {
         {-9999, EXIT_FAILURE},
@@ -152,6 +152,7 @@ public:
 
     size_t size() const { return m_data.size(); }
     bool empty() const { return m_data.empty(); }
+    const uint8_t *data() const { return m_data.data(); }
 
     void read(Span<std::byte> dst) {
         if (dst.size() == 0) {
@@ -165,6 +166,13 @@ public:
         memcpy(dst.data(), m_data.data(), dst.size());
         m_data = m_data.subspan(dst.size());
     }
+
+    void ignore(size_t size) {
+        if (size > m_data.size()) {
+            throw std::ios_base::failure("SpanReader::ignore(): end of data");
+        }
+        m_data = m_data.subspan(size);
+    }
 };
 
 /**
@@ -422,6 +430,14 @@ public:
     }
 };
 
+/**
+ * Whether the unread bytes of a stream are contiguous in memory, exposed by
+ * data() and size(), so the objects read from it can be hashed in place.
+ */
+template <typename Stream> inline constexpr bool IsContiguousStream{false};
+template <> inline constexpr bool IsContiguousStream<SpanReader>{true};
+template <> inline constexpr bool IsContiguousStream<CDataStream>{true};
+
 template <typename IStream> class BitStreamReader {
 private:
     IStream &m_istream;
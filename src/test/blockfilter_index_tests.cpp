@@ -64,6 +64,19 @@ static bool CheckFilterLookups(BlockFilterIndex &filter_index,
     BOOST_CHECK_EQUAL(filters[0].GetHash(), expected_filter.GetHash());
     BOOST_CHECK_EQUAL(filter_hashes[0], expected_filter.GetHash());
 
+    // The coinbase output matches the filter, whether it is matched from its
+    // encoding the first time, decoded the second time or cached after that.
+    CBlock block;
+    BOOST_CHECK(blockman.ReadBlockFromDisk(block, *block_index));
+    const CScript &script = block.vtx[0]->vout[0].scriptPubKey;
+    const GCSFilter::ElementSet elements{
+        GCSFilter::Element(script.begin(), script.end())};
+    BOOST_CHECK(filter.GetFilter().MatchAny(elements));
+    for (int i = 0; i < 3; i++) {
+        BOOST_CHECK(filter_index.MatchAny(block_index, elements) ==
+                    std::optional<bool>{true});
+    }
+
     filters.clear();
     filter_hashes.clear();
     last_header = filter_header;
@@ -144,6 +157,7 @@ BOOST_FIXTURE_TEST_CASE(blockfilter_index_initial_sync,
                                                         block_index, filters));
             BOOST_CHECK(!filter_index.LookupFilterHashRange(
                 block_index->nHeight, block_index, filter_hashes));
+            BOOST_CHECK(!filter_index.MatchAny(block_index, {}));
         }
     }
 
@@ -5,11 +5,13 @@
 #include <blockfilter.h>
 
 #include <core_io.h>
+#include <random.h>
 #include <serialize.h>
 #include <streams.h>
 #include <util/strencodings.h>
 
 #include <test/data/blockfilters.json.h>
+#include <test/util/random.h>
 #include <test/util/setup_common.h>
 
 #include <univalue.h>
@@ -40,6 +42,78 @@ BOOST_AUTO_TEST_CASE(gcsfilter_test) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(gcsfilter_duplicate_elements) {
+    GCSFilter::ElementSet element_set;
+    std::vector<GCSFilter::Element> element_vector;
+    for (int i = 0; i < 100; ++i) {
+        GCSFilter::Element element(InsecureRandRange(40));
+        for (uint8_t &byte : element) {
+            byte = InsecureRandBits(8);
+        }
+        element_set.insert(element);
+        // Add some elements several times
+        for (int j = InsecureRandRange(3); j >= 0; --j) {
+            element_vector.push_back(element);
+        }
+    }
+    Shuffle(element_vector.begin(), element_vector.end(),
+            g_insecure_rand_ctx);
+
+    // A small M for some distinct elements to have the same hash
+    const GCSFilter::Params params(InsecureRand32(), InsecureRand32(), 5, 8);
+    const GCSFilter filter_from_set(params, element_set);
+    const GCSFilter filter_from_vector(
+        params, std::vector<Span<const uint8_t>>(element_vector.begin(),
+                                                 element_vector.end()));
+    BOOST_CHECK_EQUAL(filter_from_vector.GetN(), element_set.size());
+    BOOST_CHECK(filter_from_vector.GetEncoded() ==
+                filter_from_set.GetEncoded());
+}
+
+BOOST_AUTO_TEST_CASE(gcsfilter_decoded) {
+    GCSFilter::ElementSet included_elements, queries;
+    for (int i = 0; i < 200; ++i) {
+        GCSFilter::Element element(32);
+        element[0] = i;
+        included_elements.insert(element);
+        element[1] = 1;
+        queries.insert(std::move(element));
+    }
+
+    const GCSFilter filter({0, 0, 10, 1 << 6}, included_elements);
+    const DecodedGCSFilter decoded(filter);
+    BOOST_CHECK(decoded.DynamicMemoryUsage() >= 8 * filter.GetN());
+    BOOST_CHECK(decoded.MatchAny(included_elements));
+    for (const auto &element : included_elements) {
+        BOOST_CHECK(decoded.Match(element));
+    }
+    // With a high false positive rate, some of the queries match. The decoded
+    // filter matches the same ones.
+    for (const auto &element : queries) {
+        BOOST_CHECK_EQUAL(decoded.Match(element), filter.Match(element));
+        BOOST_CHECK_EQUAL(decoded.MatchAny({element}),
+                          filter.MatchAny({element}));
+    }
+    BOOST_CHECK(!DecodedGCSFilter(GCSFilter()).MatchAny(queries));
+
+    // A filter reconstructed without checking its encoding behaves the same
+    const GCSFilter unchecked(filter.GetParams(), filter.GetEncoded(),
+                              /*skip_decode_check=*/true);
+    BOOST_CHECK_EQUAL(unchecked.GetN(), filter.GetN());
+    BOOST_CHECK(unchecked.Decode() == filter.Decode());
+    BOOST_CHECK(unchecked.MatchAny(included_elements));
+
+    // Truncated filters are only rejected when checked
+    std::vector<uint8_t> truncated = filter.GetEncoded();
+    truncated.resize(truncated.size() / 2);
+    BOOST_CHECK_THROW(GCSFilter(filter.GetParams(), truncated),
+                      std::ios_base::failure);
+    const GCSFilter truncated_unchecked(filter.GetParams(), truncated,
+                                        /*skip_decode_check=*/true);
+    BOOST_CHECK_THROW(DecodedGCSFilter{truncated_unchecked},
+                      std::ios_base::failure);
+}
+
 BOOST_AUTO_TEST_CASE(gcsfilter_default_constructor) {
     GCSFilter filter;
     BOOST_CHECK_EQUAL(filter.GetN(), 0U);
@@ -3,8 +3,13 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <chainparams.h>
+#include <common/args.h>
+#include <kernel/blockmanager_opts.h>
+#include <node/blockmanager_args.h>
 #include <node/blockstorage.h>
 #include <node/context.h>
+#include <node/serializedcache.h>
+#include <streams.h>
 #include <validation.h>
 
 #include <boost/test/unit_test.hpp>
@@ -103,4 +108,158 @@ BOOST_FIXTURE_TEST_CASE(blockmanager_scan_unlink_already_pruned_files,
     BOOST_CHECK(!AutoFile(blockman.OpenBlockFile(new_pos, true)).IsNull());
 }
 
+/** The serialized cache is only enabled when the data is published */
+struct PublishingChain100Setup : public TestChain100Setup {
+    PublishingChain100Setup()
+        : TestChain100Setup{CBaseChainParams::REGTEST, {"-rest"}} {}
+};
+
+BOOST_FIXTURE_TEST_CASE(blockmanager_read_raw_block, PublishingChain100Setup) {
+    const auto &chainman = Assert(m_node.chainman);
+    auto &blockman = chainman->m_blockman;
+    const CBlockIndex *tip{
+        WITH_LOCK(chainman->GetMutex(), return chainman->ActiveChain().Tip())};
+    const CBlockIndex *genesis{WITH_LOCK(
+        chainman->GetMutex(), return chainman->ActiveChain().Genesis())};
+
+    // A block manager without a cache reads the blocks back from disk
+    const BlockManager::Options blockman_opts{
+        .chainparams = chainman->GetParams(),
+        .serialized_cache_bytes = 0,
+        .blocks_dir = m_args.GetBlocksDirPath(),
+    };
+    const BlockManager uncached_blockman{blockman_opts};
+
+    for (const CBlockIndex *pindex : {tip, genesis}) {
+        CBlock block;
+        BOOST_REQUIRE(blockman.ReadBlockFromDisk(block, *pindex));
+        CDataStream expected(SER_NETWORK, PROTOCOL_VERSION);
+        expected << block;
+
+        for (const BlockManager *manager :
+             std::vector<const BlockManager *>{&blockman, &uncached_blockman}) {
+            const node::SerializedData raw{manager->ReadRawBlock(*pindex)};
+            BOOST_REQUIRE(raw);
+            BOOST_CHECK(MakeByteSpan(*raw) == MakeByteSpan(expected));
+        }
+    }
+
+    // The blocks were cached when they were written
+    const auto stats{blockman.GetSerializedCache().GetBlockStats()};
+    BOOST_CHECK_EQUAL(stats.hits, 2);
+    BOOST_CHECK_EQUAL(stats.misses, 0);
+    BOOST_CHECK_EQUAL(
+        uncached_blockman.GetSerializedCache().GetBlockStats().entries, 0);
+
+    // Reading a block that was not written recently doesn't add it to the
+    // cache, so it can't evict the recent ones
+    BlockManager::Options reader_opts{blockman_opts};
+    reader_opts.serialized_cache_bytes = 1 << 20;
+    const BlockManager reader_blockman{reader_opts};
+    BOOST_CHECK(reader_blockman.ReadRawBlock(*genesis));
+    BOOST_CHECK(reader_blockman.ReadRawBlock(*genesis));
+    const auto reader_stats{
+        reader_blockman.GetSerializedCache().GetBlockStats()};
+    BOOST_CHECK_EQUAL(reader_stats.misses, 2);
+    BOOST_CHECK_EQUAL(reader_stats.entries, 0);
+
+    // The data on disk must match the block index
+    CBlockIndex corrupted{tip->GetBlockHeader()};
+    const BlockHash wrong_hash{uint256::ONE};
+    corrupted.phashBlock = &wrong_hash;
+    {
+        LOCK(cs_main);
+        corrupted.nFile = tip->nFile;
+        corrupted.nDataPos = tip->nDataPos;
+        corrupted.nStatus = tip->nStatus;
+    }
+    BOOST_CHECK(!uncached_blockman.ReadRawBlock(corrupted));
+
+    // The transactions are served from the cache once serialized
+    const CTransactionRef tx{m_coinbase_txns.at(0)};
+    CDataStream expected_tx(SER_NETWORK, PROTOCOL_VERSION);
+    expected_tx << tx;
+    const node::SerializedData cached_tx{
+        blockman.GetSerializedTransaction(*tx)};
+    BOOST_CHECK(MakeByteSpan(*cached_tx) == MakeByteSpan(expected_tx));
+    BOOST_CHECK_EQUAL(cached_tx, blockman.GetSerializedTransaction(*tx));
+    // Unless the cache is disabled
+    const node::SerializedData uncached_tx{
+        uncached_blockman.GetSerializedTransaction(*tx)};
+    BOOST_CHECK(MakeByteSpan(*uncached_tx) == MakeByteSpan(expected_tx));
+    BOOST_CHECK(uncached_tx != uncached_blockman.GetSerializedTransaction(*tx));
+}
+
+BOOST_AUTO_TEST_CASE(blockmanager_serialized_cache_size) {
+    const auto params{CreateChainParams(*m_node.args, CBaseChainParams::MAIN)};
+    const auto cache_bytes = [&](const std::vector<const char *> &args) {
+        ArgsManager argsman;
+        for (const char *name : {"-rest", "-serializedcachesize=<n>",
+                                 "-zmqpubrawblock=<address>",
+                                 "-zmqpubrawtx=<address>"}) {
+            argsman.AddArg(name, "", ArgsManager::ALLOW_ANY,
+                           OptionsCategory::OPTIONS);
+        }
+        std::vector<const char *> argv{"bitcoind"};
+        argv.insert(argv.end(), args.begin(), args.end());
+        std::string error;
+        BOOST_REQUIRE(argsman.ParseParameters(argv.size(), argv.data(), error));
+        BlockManager::Options opts{
+            .chainparams = *params,
+            .blocks_dir = m_args.GetBlocksDirPath(),
+        };
+        BOOST_REQUIRE(!node::ApplyArgsManOptions(argsman, opts));
+        return opts.serialized_cache_bytes;
+    };
+    const size_t default_bytes{kernel::DEFAULT_SERIALIZED_CACHE_SIZE << 20};
+
+    // Disabled unless something publishes the serialized data
+    BOOST_CHECK_EQUAL(cache_bytes({}), 0);
+    BOOST_CHECK_EQUAL(cache_bytes({"-rest"}), default_bytes);
+    BOOST_CHECK_EQUAL(cache_bytes({"-rest=0"}), 0);
+    BOOST_CHECK_EQUAL(cache_bytes({"-zmqpubrawtx=tcp://127.0.0.1:28332"}),
+                      default_bytes);
+    BOOST_CHECK_EQUAL(cache_bytes({"-zmqpubrawblock=tcp://127.0.0.1:28332"}),
+                      default_bytes);
+    BOOST_CHECK_EQUAL(cache_bytes({"-serializedcachesize=8"}), 8 << 20);
+    BOOST_CHECK_EQUAL(cache_bytes({"-rest", "-serializedcachesize=0"}), 0);
+}
+
+static BlockHash GetHashOrNull(const CBlockIndex *pindex) {
+    return pindex ? pindex->GetBlockHash() : BlockHash{};
+}
+
+BOOST_FIXTURE_TEST_CASE(blockmanager_load_block_index, TestChain100Setup) {
+    const auto &chainman = Assert(m_node.chainman);
+    auto &blockman = chainman->m_blockman;
+    chainman->ActiveChainstate().ForceFlushStateToDisk();
+
+    // Load the block index written to the database into another manager
+    BlockManager loaded_blockman{BlockManager::Options{
+        .chainparams = chainman->GetParams(),
+        .blocks_dir = m_args.GetBlocksDirPath(),
+    }};
+    LOCK(cs_main);
+    loaded_blockman.m_block_tree_db = std::move(blockman.m_block_tree_db);
+    const bool loaded{loaded_blockman.LoadBlockIndexDB()};
+    blockman.m_block_tree_db = std::move(loaded_blockman.m_block_tree_db);
+    BOOST_REQUIRE(loaded);
+
+    BOOST_CHECK_EQUAL(loaded_blockman.m_block_index.size(),
+                      blockman.m_block_index.size());
+    for (const auto &[hash, index] : blockman.m_block_index) {
+        const CBlockIndex *loaded_index{loaded_blockman.LookupBlockIndex(hash)};
+        BOOST_REQUIRE(loaded_index);
+        BOOST_CHECK_EQUAL(loaded_index->nHeight, index.nHeight);
+        BOOST_CHECK(loaded_index->nChainWork == index.nChainWork);
+        BOOST_CHECK_EQUAL(loaded_index->nTimeMax, index.nTimeMax);
+        BOOST_CHECK_EQUAL(loaded_index->GetChainTxCount(),
+                          index.GetChainTxCount());
+        BOOST_CHECK(GetHashOrNull(loaded_index->pprev) ==
+                    GetHashOrNull(index.pprev));
+        BOOST_CHECK(GetHashOrNull(loaded_index->pskip) ==
+                    GetHashOrNull(index.pskip));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,150 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/blockmap.h>
+
+#include <chain.h>
+#include <memusage.h>
+#include <random.h>
+#include <util/hasher.h>
+
+#include <test/util/random.h>
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+using node::BlockMap;
+
+BOOST_FIXTURE_TEST_SUITE(blockmap_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(insert_and_find) {
+    BlockMap map;
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK(map.find(BlockHash{}) == map.end());
+
+    // Enough entries to use several chunks and grow the table a few times
+    std::vector<BlockHash> hashes;
+    for (int i = 0; i < 5000; i++) {
+        hashes.emplace_back(InsecureRand256());
+    }
+    const auto [first, first_inserted] = map.try_emplace(hashes[0]);
+    BOOST_CHECK(first_inserted);
+    CBlockIndex *const first_index = &first->second;
+    for (size_t i = 0; i < hashes.size(); i++) {
+        CBlockIndex &index = map[hashes[i]];
+        index.nHeight = i;
+    }
+    BOOST_CHECK_EQUAL(map.size(), hashes.size());
+
+    // The entries don't move
+    BOOST_CHECK_EQUAL(&map.find(hashes[0])->second, first_index);
+    for (size_t i = 0; i < hashes.size(); i++) {
+        const auto it = map.find(hashes[i]);
+        BOOST_REQUIRE(it != map.end());
+        BOOST_CHECK(it->first == hashes[i]);
+        BOOST_CHECK_EQUAL(it->second.nHeight, i);
+        BOOST_CHECK_EQUAL(map.count(hashes[i]), 1);
+    }
+    BOOST_CHECK_EQUAL(map.count(BlockHash(InsecureRand256())), 0);
+
+    // An existing entry is not replaced
+    const auto [existing, inserted] =
+        map.try_emplace(hashes[42], CBlockHeader{});
+    BOOST_CHECK(!inserted);
+    BOOST_CHECK_EQUAL(existing->second.nHeight, 42);
+    BOOST_CHECK_EQUAL(map.size(), hashes.size());
+
+    // The entries are iterated in insertion order
+    size_t i = 0;
+    for (const auto &[hash, index] : map) {
+        BOOST_CHECK(hash == hashes[i++]);
+    }
+    BOOST_CHECK_EQUAL(i, hashes.size());
+
+    map.clear();
+    BOOST_CHECK(map.empty());
+    BOOST_CHECK(map.find(hashes[0]) == map.end());
+}
+
+BOOST_AUTO_TEST_CASE(sort_by_height) {
+    // Two branches forking at height 500, inserted in random order
+    std::vector<BlockHash> hashes;
+    std::vector<int> heights;
+    std::vector<int> parents;
+    for (int i = 0; i < 3000; i++) {
+        hashes.emplace_back(InsecureRand256());
+        const int parent = i == 0 ? -1 : i == 2000 ? 500 : i - 1;
+        parents.push_back(parent);
+        heights.push_back(parent < 0 ? 0 : heights[parent] + 1);
+    }
+    std::vector<int> order(hashes.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    Shuffle(order.begin(), order.end(), g_insecure_rand_ctx);
+
+    BlockMap map;
+    for (const int i : order) {
+        CBlockIndex &index = map[hashes[i]];
+        index.phashBlock = &map.find(hashes[i])->first;
+        index.nHeight = heights[i];
+        if (parents[i] >= 0) {
+            index.pprev = &map[hashes[parents[i]]];
+        }
+    }
+    std::vector<BlockHash> skip_hashes(hashes.size());
+    // The skip pointers are built in height order
+    for (size_t i = 0; i < hashes.size(); i++) {
+        CBlockIndex &index = map[hashes[i]];
+        index.BuildSkip();
+        if (index.pskip) {
+            skip_hashes[i] = index.pskip->GetBlockHash();
+        }
+    }
+    map.SortByHeight();
+
+    BOOST_CHECK_EQUAL(map.size(), hashes.size());
+    int height = 0;
+    for (const auto &[hash, index] : map) {
+        BOOST_CHECK_GE(index.nHeight, height);
+        height = index.nHeight;
+        BOOST_CHECK_EQUAL(index.phashBlock, &hash);
+    }
+    for (size_t i = 0; i < hashes.size(); i++) {
+        const CBlockIndex &index = map.find(hashes[i])->second;
+        BOOST_CHECK_EQUAL(index.nHeight, heights[i]);
+        if (parents[i] < 0) {
+            BOOST_CHECK(!index.pprev);
+            continue;
+        }
+        BOOST_CHECK_EQUAL(index.pprev, &map.find(hashes[parents[i]])->second);
+        BOOST_CHECK_EQUAL(index.pskip, &map.find(skip_hashes[i])->second);
+    }
+    const CBlockIndex &tip = map.find(hashes[1999])->second;
+    const CBlockIndex &fork_tip = map.find(hashes[2999])->second;
+    BOOST_CHECK_EQUAL(LastCommonAncestor(&tip, &fork_tip),
+                      &map.find(hashes[500])->second);
+}
+
+BOOST_AUTO_TEST_CASE(memory_usage) {
+    BlockMap map;
+    std::unordered_map<BlockHash, CBlockIndex, BlockHasher> node_map;
+    // Fill the chunks entirely and the hash table up to its 3/4 maximum load,
+    // so the comparison doesn't depend on where the last growth happened
+    const size_t count{12 * 1024};
+    for (size_t i = 0; i < count; i++) {
+        const BlockHash hash{InsecureRand256()};
+        map.try_emplace(hash);
+        node_map.try_emplace(hash);
+    }
+    // At least the allocation overhead and the node pointers are saved
+    BOOST_CHECK_LE(map.DynamicMemoryUsage() + count * 2 * sizeof(void *),
+                   memusage::DynamicUsage(node_map));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -18,6 +18,7 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <algorithm>
 #include <map>
 #include <vector>
 
@@ -1171,6 +1172,66 @@ BOOST_AUTO_TEST_CASE(ccoins_flush_behavior) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_prefetch) {
+    CCoinsViewDB base{
+        {.path = "test", .cache_bytes = 1 << 23, .memory_only = true}, {}};
+
+    // Enough coins for the database reads to be split between threads, on a
+    // machine with several cores
+    std::vector<COutPoint> outpoints;
+    {
+        CCoinsViewCache writer(&base);
+        for (int i = 0; i < 3000; i++) {
+            outpoints.emplace_back(TxId(InsecureRand256()), i % 3);
+            CScript script;
+            script << i;
+            writer.AddCoin(outpoints.back(),
+                           Coin(CTxOut((i + 1) * SATOSHI, script), 1, false),
+                           false);
+        }
+        writer.SetBestBlock(BlockHash(InsecureRand256()));
+        BOOST_CHECK(writer.Flush());
+    }
+
+    CCoinsViewCacheTest parent(&base);
+    CCoinsViewCacheTest child(&parent);
+    // Spent in the parent cache, but not in the database
+    parent.SpendCoin(outpoints[0]);
+
+    // With duplicates and outpoints that are not in the UTXO set
+    std::vector<COutPoint> lookups{outpoints};
+    lookups.push_back(outpoints[1]);
+    lookups.emplace_back(TxId(InsecureRand256()), 0);
+    lookups.emplace_back(outpoints[2].GetTxId(), 3);
+    Shuffle(lookups.begin(), lookups.end(), g_insecure_rand_ctx);
+
+    child.PrefetchCoins(lookups);
+    const std::vector<std::optional<Coin>> coins{child.GetCoins(lookups)};
+    BOOST_REQUIRE_EQUAL(coins.size(), lookups.size());
+    for (size_t i = 0; i < lookups.size(); i++) {
+        Coin coin;
+        const bool found{child.GetCoin(lookups[i], coin)};
+        BOOST_CHECK_EQUAL(found, lookups[i] != outpoints[0] &&
+                                     std::find(outpoints.begin(),
+                                               outpoints.end(),
+                                               lookups[i]) != outpoints.end());
+        BOOST_CHECK_EQUAL(child.HaveCoinInCache(lookups[i]), found);
+        BOOST_CHECK_EQUAL(coins[i].has_value(), found);
+        if (found && coins[i]) {
+            BOOST_CHECK(*coins[i] == coin);
+        }
+    }
+    child.SelfTest();
+    parent.SelfTest();
+
+    // The same coins are read from the database directly
+    const std::vector<std::optional<Coin>> db_coins{base.GetCoins(lookups)};
+    for (size_t i = 0; i < lookups.size(); i++) {
+        BOOST_CHECK_EQUAL(db_coins[i].has_value(),
+                          coins[i].has_value() || lookups[i] == outpoints[0]);
+    }
+}
+
 BOOST_AUTO_TEST_CASE(coins_resource_is_used) {
     CCoinsMapMemoryResource resource;
     PoolResourceTester::CheckAllDataAccountedFor(resource);
@@ -1076,6 +1076,28 @@ BOOST_AUTO_TEST_CASE(sha256d64) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(sha256d_multi) {
+    for (int i = 0; i <= 40; ++i) {
+        std::vector<std::vector<uint8_t>> in(i);
+        std::vector<const uint8_t *> inputs;
+        std::vector<size_t> sizes;
+        for (auto &msg : in) {
+            // Cover the sizes around the block boundaries and larger ones
+            const size_t size = InsecureRandBool() ? InsecureRandRange(130)
+                                                   : InsecureRandRange(2000);
+            msg = g_insecure_rand_ctx.randbytes(size);
+            inputs.push_back(msg.data());
+            sizes.push_back(msg.size());
+        }
+        std::vector<uint8_t> out1(32 * i), out2(32 * i);
+        for (int j = 0; j < i; ++j) {
+            CHash256().Write(in[j]).Finalize({out1.data() + 32 * j, 32});
+        }
+        SHA256DMulti(out2.data(), inputs.data(), sizes.data(), i);
+        BOOST_CHECK(out1 == out2);
+    }
+}
+
 static void TestSHA3_256(const std::string &input, const std::string &output) {
     const auto in_bytes = ParseHex(input);
     const auto out_bytes = ParseHex(output);
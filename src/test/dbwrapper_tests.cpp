@@ -2,16 +2,22 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include <common/args.h>
 #include <dbwrapper.h>
-
+#include <node/database_args.h>
 #include <uint256.h>
+#include <util/translation.h>
 
 #include <test/util/random.h>
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
 
+#include <iterator>
+#include <limits>
 #include <memory>
+#include <optional>
+#include <vector>
 
 // Test if a string consists entirely of null characters
 static bool is_null_key(const std::vector<uint8_t> &key) {
@@ -226,6 +232,120 @@ BOOST_AUTO_TEST_CASE(dbwrapper_iterator) {
     }
 }
 
+BOOST_AUTO_TEST_CASE(dbwrapper_multiread) {
+    for (const bool obfuscate : {false, true}) {
+        fs::path ph = m_args.GetDataDirBase() /
+                      (obfuscate ? "dbwrapper_multiread_obfuscate_true"
+                                 : "dbwrapper_multiread_obfuscate_false");
+        CDBWrapper dbw({.path = ph,
+                        .cache_bytes = 1 << 20,
+                        .memory_only = true,
+                        .wipe_data = false,
+                        .obfuscate = obfuscate});
+
+        // Only the even keys are present, and the key 1000 has a value that
+        // can't be read as an uint256.
+        CDBBatch batch(dbw);
+        for (uint32_t i = 0; i < 1000; i += 2) {
+            batch.Write(i, InsecureRand256());
+        }
+        batch.Write(uint32_t{1000}, uint8_t{0});
+        BOOST_CHECK(dbw.WriteBatch(batch));
+
+        // In random order, with duplicates and keys past the last one
+        std::vector<uint32_t> keys;
+        for (int i = 0; i < 2000; i++) {
+            keys.push_back(InsecureRandRange(1100));
+        }
+        keys.push_back(std::numeric_limits<uint32_t>::max());
+        keys.push_back(1000);
+
+        for (const size_t threads : {1, 3}) {
+            const std::vector<std::optional<uint256>> values{
+                dbw.MultiRead<uint256>(keys, threads)};
+            BOOST_REQUIRE_EQUAL(values.size(), keys.size());
+            for (size_t i = 0; i < keys.size(); i++) {
+                uint256 value;
+                const bool found{dbw.Read(keys[i], value)};
+                BOOST_CHECK_EQUAL(found, keys[i] < 1000 && keys[i] % 2 == 0);
+                BOOST_CHECK_EQUAL(values[i].has_value(), found);
+                if (found && values[i]) {
+                    BOOST_CHECK_EQUAL(*values[i], value);
+                }
+            }
+        }
+
+        BOOST_CHECK(dbw.MultiRead<uint256>(std::vector<uint32_t>{}).empty());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_storage_profiles) {
+    BOOST_CHECK(!GetDBStorageProfile(""));
+    BOOST_CHECK(!GetDBStorageProfile("fast"));
+
+    // Data written under a profile is readable under the others
+    fs::path ph = m_args.GetDataDirBase() / "dbwrapper_storage_profiles";
+    std::vector<uint256> values;
+    for (int i = 0; i < 100; i++) {
+        values.push_back(InsecureRand256());
+    }
+    int written{0};
+    for (const char *name : {"default", "archive", "scan", "default"}) {
+        const std::optional<DBStorageProfile> profile{
+            GetDBStorageProfile(name)};
+        BOOST_REQUIRE(profile);
+        CDBWrapper dbw({.path = ph,
+                        .cache_bytes = 1 << 20,
+                        .memory_only = false,
+                        .wipe_data = false,
+                        .obfuscate = true,
+                        .options = {.storage = *profile}});
+        CDBBatch batch(dbw);
+        for (int i = 0; i < 25; i++, written++) {
+            batch.Write(uint32_t(written), values[written]);
+        }
+        BOOST_CHECK(dbw.WriteBatch(batch));
+        dbw.CompactRange(uint32_t{0}, std::numeric_limits<uint32_t>::max());
+
+        for (int i = 0; i < written; i++) {
+            uint256 value;
+            BOOST_CHECK(dbw.Read(uint32_t(i), value));
+            BOOST_CHECK_EQUAL(value, values[i]);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(dbwrapper_profile_args) {
+    ArgsManager args;
+    args.AddArg("-dbprofile", "", ArgsManager::ALLOW_ANY,
+                OptionsCategory::OPTIONS);
+    const char *argv[] = {"ignored", "-dbprofile=txindex:scan",
+                          "-dbprofile=archive", "-dbprofile=txindex:default"};
+    std::string error;
+    BOOST_REQUIRE(args.ParseParameters(std::size(argv), argv, error));
+    BOOST_CHECK(!node::CheckDatabaseArgs(args));
+
+    // The last profile given for a database takes precedence over the ones
+    // given for all of them
+    DBOptions options;
+    node::ReadDatabaseArgs(args, options, "txindex");
+    BOOST_CHECK(!options.storage.compression);
+    node::ReadDatabaseArgs(args, options, "chainstate");
+    BOOST_CHECK(options.storage.compression);
+    BOOST_CHECK_EQUAL(options.storage.bloom_bits, 10);
+
+    for (const char *arg : {"-dbprofile=fast", "-dbprofile=wallet:archive",
+                            "-dbprofile=txindex:"}) {
+        ArgsManager bad_args;
+        bad_args.AddArg("-dbprofile", "", ArgsManager::ALLOW_ANY,
+                        OptionsCategory::OPTIONS);
+        const char *bad_argv[] = {"ignored", arg};
+        BOOST_REQUIRE(
+            bad_args.ParseParameters(std::size(bad_argv), bad_argv, error));
+        BOOST_CHECK(node::CheckDatabaseArgs(bad_args));
+    }
+}
+
 // Test that we do not obfuscation if there is existing data.
 BOOST_AUTO_TEST_CASE(existing_data_no_obfuscate) {
     // We're going to share this fs::path between two wrappers
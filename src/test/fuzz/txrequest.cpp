@@ -257,11 +257,32 @@ public:
         m_tracker.ReceivedResponse(peer, TXIDS[txid]);
     }
 
+    //! Find the txids to request from peer using the naive structure, once the
+    //! expired announcements are COMPLETED.
+    std::vector<TxId> GetExpectedRequestable(int peer) const {
+        //! list of (sequence number, txid) tuples.
+        std::vector<std::tuple<uint64_t, int>> result;
+        for (int txid = 0; txid < MAX_TXIDS; ++txid) {
+            // CANDIDATEs for which this announcement has the highest priority
+            // get returned.
+            const Announcement &ann = m_announcements[txid][peer];
+            if (ann.m_state == State::CANDIDATE && GetSelected(txid) == peer) {
+                result.emplace_back(ann.m_sequence, txid);
+            }
+        }
+        // Sort the results by sequence number.
+        std::sort(result.begin(), result.end());
+
+        std::vector<TxId> ret;
+        for (const auto &[sequence, txid] : result) {
+            ret.push_back(TXIDS[txid]);
+        }
+        return ret;
+    }
+
     void GetRequestable(int peer) {
         // Implement using naive structure:
 
-        //! list of (sequence number, txid) tuples.
-        std::vector<std::tuple<uint64_t, int>> result;
         std::vector<std::pair<NodeId, TxId>> expected_expired;
         for (int txid = 0; txid < MAX_TXIDS; ++txid) {
             // Mark any expired REQUESTED announcements as COMPLETED.
@@ -275,15 +296,7 @@ public:
             }
             // And delete txids with only COMPLETED announcements left.
             Cleanup(txid);
-            // CANDIDATEs for which this announcement has the highest priority
-            // get returned.
-            const Announcement &ann = m_announcements[txid][peer];
-            if (ann.m_state == State::CANDIDATE && GetSelected(txid) == peer) {
-                result.emplace_back(ann.m_sequence, txid);
-            }
         }
-        // Sort the results by sequence number.
-        std::sort(result.begin(), result.end());
         std::sort(expected_expired.begin(), expected_expired.end());
 
         // Compare with InvRequestTracker's implementation.
@@ -293,10 +306,22 @@ public:
         assert(expired == expected_expired);
 
         m_tracker.PostGetRequestableSanityCheck(m_now);
-        assert(result.size() == actual.size());
-        for (size_t pos = 0; pos < actual.size(); ++pos) {
-            assert(TXIDS[std::get<1>(result[pos])] == actual[pos]);
+        assert(actual == GetExpectedRequestable(peer));
+
+        // Querying all the peers at the same time expires nothing more, and
+        // returns what each of them would get.
+        const auto all = m_tracker.GetRequestable(m_now, &expired);
+        assert(expired.empty());
+        auto it = all.begin();
+        for (int peer2 = 0; peer2 < MAX_PEERS; ++peer2) {
+            const auto expected = GetExpectedRequestable(peer2);
+            if (!expected.empty()) {
+                assert(it != all.end() && it->first == peer2);
+                assert(it->second == expected);
+                ++it;
+            }
         }
+        assert(it == all.end());
     }
 
     void Check() {
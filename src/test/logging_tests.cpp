@@ -6,7 +6,12 @@
 #include <logging/timer.h>
 #include <test/util/setup_common.h>
 
+#include <algorithm>
 #include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <boost/test/unit_test.hpp>
 
@@ -34,4 +39,160 @@ BOOST_AUTO_TEST_CASE(logging_timer) {
     SetMockTime(0);
 }
 
+/** Logger writing to a callback only, without timestamps */
+struct AsyncTestLogger {
+    BCLog::Logger logger;
+    std::vector<std::string> lines;
+
+    AsyncTestLogger(std::function<void()> on_line = nullptr) {
+        logger.m_log_timestamps = false;
+        logger.PushBackCallback([this, on_line](const std::string &str) {
+            if (on_line) {
+                on_line();
+            }
+            lines.push_back(str);
+        });
+    }
+
+    void Log(const std::string &str) {
+        logger.LogPrintStr(str, __func__, __FILE__, __LINE__);
+    }
+};
+
+BOOST_AUTO_TEST_CASE(logging_async) {
+    AsyncTestLogger test;
+    // Logging can't be asynchronous until it is started
+    BOOST_CHECK(!test.logger.StartAsyncLogging(false));
+    BOOST_REQUIRE(test.logger.StartLogging());
+    BOOST_REQUIRE(test.logger.StartAsyncLogging(false));
+    BOOST_CHECK(test.logger.IsAsync());
+    BOOST_CHECK(!test.logger.StartAsyncLogging(false));
+
+    // The lines of the different threads are all written
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&test, t] {
+            for (int i = 0; i < 100; i++) {
+                test.Log(strprintf("thread %d line %d\n", t, i));
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    test.logger.StopAsyncLogging();
+    BOOST_CHECK(!test.logger.IsAsync());
+
+    BOOST_CHECK_EQUAL(test.lines.size(), 4 * 100);
+    // The lines of each thread are in order
+    std::vector<int> next_line(4, 0);
+    for (const std::string &line : test.lines) {
+        int t, i;
+        BOOST_REQUIRE_EQUAL(sscanf(line.c_str(), "thread %d line %d", &t, &i),
+                            2);
+        BOOST_CHECK_EQUAL(i, next_line[t]++);
+    }
+    BOOST_CHECK_EQUAL(test.logger.GetDroppedLines(), 0);
+
+    // Back to synchronous logging
+    test.Log("sync\n");
+    BOOST_CHECK_EQUAL(test.lines.back(), "sync\n");
+}
+
+BOOST_AUTO_TEST_CASE(logging_async_partial_lines) {
+    AsyncTestLogger test;
+    test.logger.m_log_sourcelocations = true;
+    BOOST_REQUIRE(test.logger.StartLogging());
+    BOOST_REQUIRE(test.logger.StartAsyncLogging(false));
+
+    // Each thread continues its own partial lines, whatever the other threads
+    // log in between
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&test] {
+            for (int i = 0; i < 100; i++) {
+                test.Log("begin ");
+                test.Log("end\n");
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    test.logger.StopAsyncLogging();
+
+    BOOST_CHECK_EQUAL(test.lines.size(), 4 * 100 * 2);
+    for (const std::string &line : test.lines) {
+        if (line != "end\n") {
+            BOOST_CHECK(line.front() == '[');
+            BOOST_CHECK(line.size() > 6 &&
+                        line.substr(line.size() - 6) == "begin ");
+        }
+    }
+    BOOST_CHECK_EQUAL(std::count(test.lines.begin(), test.lines.end(),
+                                 std::string{"end\n"}),
+                      4 * 100);
+}
+
+BOOST_AUTO_TEST_CASE(logging_async_overflow) {
+    // Stall the writer thread on the first line
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    std::atomic<bool> writing{false};
+    AsyncTestLogger test([&] {
+        writing = true;
+        released.wait();
+    });
+    BOOST_REQUIRE(test.logger.StartLogging());
+    BOOST_REQUIRE(test.logger.StartAsyncLogging(false, 4));
+
+    test.Log("first\n");
+    while (!writing) {
+        std::this_thread::yield();
+    }
+    // 4 lines fit in the buffer, the others are dropped
+    for (int i = 0; i < 10; i++) {
+        test.Log(strprintf("line %d\n", i));
+    }
+    BOOST_CHECK_EQUAL(test.logger.GetDroppedLines(), 6);
+
+    release.set_value();
+    test.logger.StopAsyncLogging();
+    const std::vector<std::string> expected{
+        "first\n",
+        "Dropped 6 log lines because the logging buffers were full\n",
+        "line 0\n",
+        "line 1\n",
+        "line 2\n",
+        "line 3\n",
+    };
+    BOOST_CHECK_EQUAL_COLLECTIONS(test.lines.begin(), test.lines.end(),
+                                  expected.begin(), expected.end());
+}
+
+BOOST_AUTO_TEST_CASE(logging_async_block) {
+    std::promise<void> release;
+    std::shared_future<void> released = release.get_future().share();
+    AsyncTestLogger test([&] { released.wait(); });
+    BOOST_REQUIRE(test.logger.StartLogging());
+    BOOST_REQUIRE(test.logger.StartAsyncLogging(true, 4));
+
+    // The logging thread waits for the writer instead of dropping lines
+    std::thread logging_thread([&] {
+        for (int i = 0; i < 20; i++) {
+            test.Log(strprintf("line %d\n", i));
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds{50});
+    release.set_value();
+    logging_thread.join();
+    test.logger.StopAsyncLogging();
+
+    BOOST_CHECK_EQUAL(test.logger.GetDroppedLines(), 0);
+    BOOST_REQUIRE_EQUAL(test.lines.size(), 20);
+    for (int i = 0; i < 20; i++) {
+        BOOST_CHECK_EQUAL(test.lines[i], strprintf("line %d\n", i));
+    }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
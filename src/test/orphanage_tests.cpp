@@ -15,7 +15,6 @@
 #include <test/util/setup_common.h>
 
 #include <cstdint>
-#include <map>
 
 #include <boost/test/unit_test.hpp>
 
@@ -30,12 +29,7 @@ public:
 
     CTransactionRef RandomOrphan() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
         LOCK(m_mutex);
-        std::map<TxId, PoolTx>::iterator it;
-        it = m_pool_txs.lower_bound(TxId{InsecureRand256()});
-        if (it == m_pool_txs.end()) {
-            it = m_pool_txs.begin();
-        }
-        return it->second.tx;
+        return m_pool_txs[InsecureRandRange(m_pool_txs.size())].tx;
     }
 };
 
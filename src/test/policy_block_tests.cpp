@@ -3,12 +3,14 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include <policy/block/minerfund.h>
+#include <policy/block/preconsensus.h>
 
 #include <blockindex.h>
 #include <chainparams.h>
 #include <consensus/activation.h>
 #include <key_io.h>
 #include <minerfund.h>
+#include <txmempool.h>
 #include <util/vector.h>
 #include <validation.h>
 
@@ -148,4 +150,105 @@ BOOST_AUTO_TEST_CASE(policy_minerfund) {
     }
 }
 
+static CTransactionRef SpendingTx(const std::vector<COutPoint> &outpoints,
+                                  uint8_t tag = 0) {
+    CMutableTransaction mtx;
+    for (const COutPoint &outpoint : outpoints) {
+        mtx.vin.emplace_back(outpoint);
+    }
+    mtx.vout.emplace_back(10 * COIN, CScript() << OP_TRUE << tag);
+    return MakeTransactionRef(std::move(mtx));
+}
+
+BOOST_FIXTURE_TEST_CASE(policy_preconsensus, TestingSetup) {
+    gArgs.ForceSetArg("-avalanchepreconsensus", "1");
+
+    CTxMemPool &pool = *Assert(m_node.mempool);
+    TestMemPoolEntryHelper entry;
+
+    CBlockIndex prevIndex;
+    CBlockIndex blockIndex;
+    blockIndex.pprev = &prevIndex;
+
+    auto checkPreConsensusPolicy = [&](const std::vector<CTransactionRef> &vtx,
+                                       const CTransactionRef &expectedTx =
+                                           nullptr) {
+        CBlock block;
+        block.vtx = vtx;
+        BlockPolicyValidationState state;
+        const bool expectedValid = !expectedTx;
+        BOOST_CHECK_EQUAL(
+            PreConsensusPolicy(blockIndex, block, &pool)(state),
+            expectedValid);
+        if (!expectedValid) {
+            BOOST_CHECK_EQUAL(state.GetRejectReason(), "finalized-tx-conflict");
+            BOOST_CHECK(state.GetDebugMessage().find(
+                            expectedTx->GetId().ToString()) !=
+                        std::string::npos);
+        }
+    };
+
+    auto outpoint = [](uint32_t n) {
+        return COutPoint(TxId(uint256S("abcd")), n);
+    };
+
+    const CTransactionRef finalizedTx = SpendingTx({outpoint(0), outpoint(1)});
+    const CTransactionRef otherTx = SpendingTx({outpoint(2)});
+    const CTransactionRef conflictTx = SpendingTx({outpoint(1)});
+    const CTransactionRef otherConflictTx = SpendingTx({outpoint(2)}, 1);
+    {
+        LOCK2(cs_main, pool.cs);
+        auto finalizedEntry = entry.FromTx(finalizedTx);
+        pool.addUnchecked(finalizedEntry);
+        pool.addUnchecked(entry.FromTx(otherTx));
+
+        // Nothing is finalized yet
+        checkPreConsensusPolicy({conflictTx, otherConflictTx});
+
+        BOOST_CHECK(pool.setAvalancheFinalized(finalizedEntry));
+    }
+
+    // The finalized tx itself and unrelated txs are fine
+    checkPreConsensusPolicy({finalizedTx});
+    checkPreConsensusPolicy({SpendingTx({outpoint(3)})});
+    // Only the finalized txs are protected
+    checkPreConsensusPolicy({otherConflictTx});
+    // A conflict with a finalized tx is rejected
+    checkPreConsensusPolicy({conflictTx}, conflictTx);
+    checkPreConsensusPolicy({otherConflictTx, conflictTx}, conflictTx);
+
+    // The first conflict of a large block is reported, whatever the thread
+    // that checks it
+    std::vector<CTransactionRef> vtx;
+    for (uint32_t i = 0; i < 20000; i++) {
+        vtx.push_back(SpendingTx({outpoint(100 + i)}));
+    }
+    const CTransactionRef lateConflictTx = SpendingTx({outpoint(0)}, 2);
+    vtx[19000] = conflictTx;
+    vtx[19999] = lateConflictTx;
+    checkPreConsensusPolicy(vtx, conflictTx);
+    vtx[19000] = finalizedTx;
+    checkPreConsensusPolicy(vtx, lateConflictTx);
+    vtx[19999] = otherTx;
+    checkPreConsensusPolicy(vtx);
+
+    // The finalized tx is forgotten once its block is finalized
+    {
+        LOCK2(cs_main, pool.cs);
+        pool.removeForFinalizedBlock({finalizedTx});
+    }
+    checkPreConsensusPolicy({conflictTx});
+
+    // Or once it is removed from the mempool
+    {
+        LOCK2(cs_main, pool.cs);
+        BOOST_CHECK(pool.setAvalancheFinalized(entry.FromTx(otherTx)));
+        checkPreConsensusPolicy({otherConflictTx}, otherConflictTx);
+        pool.removeRecursive(*otherTx, MemPoolRemovalReason::CONFLICT);
+    }
+    checkPreConsensusPolicy({otherConflictTx});
+
+    gArgs.ClearForcedArg("-avalanchepreconsensus");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
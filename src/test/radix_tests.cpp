@@ -14,6 +14,7 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <iterator>
 #include <limits>
 #include <type_traits>
 
@@ -531,6 +532,170 @@ BOOST_AUTO_TEST_CASE(tree_traversal) {
     BOOST_CHECK(!ret);
 }
 
+template <typename E> void testBatch() {
+    RadixTree<E> mytree;
+
+    // In the tree order, where the keys are compared as unsigned.
+    std::vector<RCUPtr<E>> elements;
+    for (uint64_t i : {0, 1, 2, 3, 90, 91, 92, 93}) {
+        elements.push_back(RCUPtr<E>::make(i));
+    }
+    elements.push_back(RCUPtr<E>::make(E::SignedMax()));
+    elements.push_back(RCUPtr<E>::make(E::SignedMin()));
+    elements.push_back(RCUPtr<E>::make(E::MinusTwo()));
+    elements.push_back(RCUPtr<E>::make(E::MinusOne()));
+
+    // The batch doesn't need to be sorted.
+    auto randomizedElements = elements;
+    Shuffle(randomizedElements.begin(), randomizedElements.end(),
+            FastRandomContext());
+    BOOST_CHECK_EQUAL(mytree.insertBatch(randomizedElements), elements.size());
+    BOOST_CHECK_EQUAL(mytree.insertBatch(randomizedElements), 0);
+
+    size_t count = 0;
+    mytree.forEachLeaf([&](RCUPtr<E> ptr) {
+        BOOST_CHECK_EQUAL(ptr, elements[count++]);
+        return true;
+    });
+    BOOST_CHECK_EQUAL(count, elements.size());
+
+    // Remove every other element, plus one which is not in the tree.
+    using K = std::remove_cv_t<
+        std::remove_reference_t<decltype(elements[0]->getId())>>;
+    std::vector<K> keys;
+    for (size_t i = 0; i < elements.size(); i += 2) {
+        keys.push_back(elements[i]->getId());
+    }
+    keys.push_back(RCUPtr<E>::make(42)->getId());
+    BOOST_CHECK_EQUAL(mytree.removeBatch(keys), elements.size() / 2);
+    BOOST_CHECK_EQUAL(mytree.removeBatch(keys), 0);
+
+    for (size_t i = 0; i < elements.size(); i++) {
+        BOOST_CHECK_EQUAL(mytree.get(elements[i]->getId()),
+                          i % 2 ? elements[i] : RCUPtr<E>());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(batch_test) {
+    testBatch<TestElementInt<int32_t>>();
+    testBatch<TestElementInt<uint32_t>>();
+    testBatch<TestElementInt<int64_t>>();
+    testBatch<TestElementInt<uint64_t>>();
+
+    testBatch<TestElementUint256>();
+
+    // The batches don't share the copied nodes with a copy of the tree.
+    using E = TestElementInt<uint32_t>;
+    RadixTree<E> mytree;
+    std::vector<RCUPtr<E>> elements;
+    std::vector<uint32_t> keys;
+    for (uint32_t i = 0; i < 1000; i++) {
+        elements.push_back(RCUPtr<E>::make(i * 7919));
+        keys.push_back(i * 7919);
+    }
+    BOOST_CHECK_EQUAL(mytree.insertBatch(elements), 1000);
+
+    RadixTree<E> copyTree = mytree;
+    BOOST_CHECK_EQUAL(mytree.removeBatch(keys), 1000);
+    for (const uint32_t key : keys) {
+        BOOST_CHECK(!mytree.get(key));
+        BOOST_CHECK(copyTree.get(key));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(range_traversal) {
+    using E = TestElement<uint32_t>;
+
+    RadixTree<E> mytree;
+    std::vector<RCUPtr<E>> elements;
+    for (uint32_t i = 0; i < 4096; i++) {
+        elements.push_back(RCUPtr<E>::make(i));
+    }
+    BOOST_CHECK_EQUAL(mytree.insertBatch(elements), elements.size());
+
+    auto checkRange = [&](uint32_t first, uint32_t last) {
+        uint32_t next = first;
+        bool ret = mytree.forEachLeafInRange(first, last, [&](RCUPtr<E> ptr) {
+            BOOST_CHECK_EQUAL(ptr, elements[next++]);
+            return true;
+        });
+        BOOST_CHECK(ret);
+        BOOST_CHECK_EQUAL(next, std::max(first, std::min(last + 1, 4096u)));
+    };
+
+    // All the keys with the 0x12 prefix.
+    checkRange(0x120, 0x12f);
+    checkRange(100, 2000);
+    checkRange(0, 0);
+    checkRange(4095, 4095);
+    checkRange(4000, 100000);
+    // Empty ranges
+    checkRange(2000, 100);
+    checkRange(5000, 6000);
+
+    // The traversal can be stopped.
+    size_t count = 0;
+    BOOST_CHECK(!mytree.forEachLeafInRange(10, 20, [&](RCUPtr<E> ptr) {
+        return ++count < 5;
+    }));
+    BOOST_CHECK_EQUAL(count, 5);
+}
+
+BOOST_AUTO_TEST_CASE(snapshot_iterator) {
+    using E = TestElement<uint32_t>;
+
+    // The elements can't be modified through the iterator.
+    using Traits = std::iterator_traits<RadixTree<E>::const_iterator>;
+    static_assert(std::is_same_v<Traits::pointer, const E *>);
+    static_assert(std::is_same_v<Traits::reference, const E &>);
+
+    RadixTree<E> mytree;
+    BOOST_CHECK(mytree.begin() == mytree.end());
+
+    // A single element is stored at the root.
+    auto one = RCUPtr<E>::make(1);
+    BOOST_CHECK(mytree.insert(one));
+    auto it = mytree.begin();
+    BOOST_CHECK(it != mytree.end());
+    BOOST_CHECK_EQUAL(&*it, one.get());
+    BOOST_CHECK(++it == mytree.end());
+    BOOST_CHECK(mytree.remove(1));
+
+    std::vector<RCUPtr<E>> elements;
+    std::vector<uint32_t> keys;
+    for (uint32_t i = 0; i < ELEMENTS; i += 3) {
+        elements.push_back(RCUPtr<E>::make(i));
+        keys.push_back(i);
+    }
+    BOOST_CHECK_EQUAL(mytree.insertBatch(elements), elements.size());
+
+    // Modify the tree while it is iterated over. The iteration only sees the
+    // elements present when it started.
+    it = mytree.begin();
+    std::thread writer([&] {
+        for (uint32_t i = 1; i < ELEMENTS; i += 3) {
+            mytree.insert(RCUPtr<E>::make(i));
+        }
+        mytree.removeBatch(keys);
+    });
+
+    size_t count = 0;
+    for (; it != mytree.end(); ++it) {
+        BOOST_CHECK_EQUAL(it->getId(), elements[count++]->getId());
+    }
+    BOOST_CHECK_EQUAL(count, elements.size());
+    writer.join();
+
+    count = 0;
+    for (const E &e : mytree) {
+        BOOST_CHECK_EQUAL(e.getId(), 3 * count++ + 1);
+    }
+    BOOST_CHECK_EQUAL(count, elements.size() - 1);
+
+    // Cleanup after ourselves.
+    RCULock::synchronize();
+}
+
 BOOST_AUTO_TEST_CASE(uint256_key_wrapper) {
     Uint256RadixKey key = uint256S(
         "AA00000000000000000000000000000000000000000000000000000000000000");
@@ -596,6 +761,16 @@ BOOST_AUTO_TEST_CASE(uint256_key_wrapper) {
     checkOperands(key >> 255u, uint256S("0000000000000000000000000000000000000000000000000000000000000001"), 0x0000000000000001);
     checkOperands(key >> 256u, uint256S("0000000000000000000000000000000000000000000000000000000000000000"), 0x0000000000000000);
     // clang-format on
+
+    // The keys are compared on all their bits.
+    const Uint256RadixKey low = uint256S(
+        "0000000000000000000000000000000000000000000000000000000000000001");
+    const Uint256RadixKey high = uint256S(
+        "0000000000000001000000000000000000000000000000000000000000000001");
+    BOOST_CHECK(low == low);
+    BOOST_CHECK(low != high);
+    BOOST_CHECK(low < high);
+    BOOST_CHECK(!(high < low));
 }
 
 BOOST_AUTO_TEST_CASE(radix_adapter) {
@@ -9,6 +9,8 @@
 #include <boost/test/unit_test.hpp>
 
 #include <chrono>
+#include <future>
+#include <thread>
 
 struct RCUTest {
     static uint64_t getRevision() { return RCUInfos::revision.load(); }
@@ -472,4 +474,64 @@ BOOST_AUTO_TEST_CASE(rcu_converting_assignment) {
     BOOST_CHECK(isDestroyed);
 }
 
+static bool WaitFor(const std::atomic<bool> &flag) {
+    const auto deadline =
+        std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!flag && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return flag;
+}
+
+BOOST_AUTO_TEST_CASE(background_reclamation) {
+    RCULock::synchronize();
+    RCULock::startReclaimer();
+    BOOST_CHECK(RCULock::isReclaimerRunning());
+
+    // Hold a read lock from another thread.
+    std::promise<void> locked;
+    std::promise<void> unlock;
+    std::thread reader([&] {
+        RCULock lock;
+        locked.set_value();
+        unlock.get_future().wait();
+    });
+    locked.get_future().wait();
+
+    // Registering a cleanup doesn't wait for the reader, and the cleanup is
+    // not kept by this thread.
+    std::atomic<bool> isClean1{false};
+    RCULock::registerCleanup([&] { isClean1 = true; });
+    BOOST_CHECK(RCUTest::getCleanups().empty());
+
+    std::atomic<bool> isDestroyed{false};
+    RCULock::deferDelete(new RCURefTestItem([&] { isDestroyed = true; }));
+
+    // Nothing is run while the reader may still see the objects.
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    BOOST_CHECK(!isClean1);
+    BOOST_CHECK(!isDestroyed);
+
+    unlock.set_value();
+    reader.join();
+    BOOST_CHECK(WaitFor(isClean1));
+    BOOST_CHECK(WaitFor(isDestroyed));
+
+    // Stopping the reclaimer runs the pending cleanups, including the nested
+    // ones.
+    std::atomic<bool> isClean2{false};
+    RCULock::registerCleanup(
+        [&] { RCULock::registerCleanup([&] { isClean2 = true; }); });
+    RCULock::stopReclaimer();
+    BOOST_CHECK(!RCULock::isReclaimerRunning());
+    BOOST_CHECK(isClean2);
+
+    // The cleanups are back to being run by the registering thread.
+    bool isClean3 = false;
+    RCULock::registerCleanup([&] { isClean3 = true; });
+    BOOST_CHECK_EQUAL(RCUTest::getCleanups().size(), 1);
+    RCULock::synchronize();
+    BOOST_CHECK(isClean3);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -4,6 +4,7 @@
 
 #include <rpc/blockchain.h>
 #include <rpc/client.h>
+#include <rpc/jsonwriter.h>
 #include <rpc/server.h>
 #include <rpc/util.h>
 
@@ -750,4 +751,79 @@ BOOST_AUTO_TEST_CASE(help_example) {
                    HelpExampleRpcNamed("foo", {{"arg", "true"}}));
 }
 
+BOOST_AUTO_TEST_CASE(json_stream_writer) {
+    UniValue nested(UniValue::VOBJ);
+    nested.pushKV("str", "esc\"aped\n\\");
+    nested.pushKV("n", -42);
+    nested.pushKV("b", true);
+    nested.pushKV("null", NullUniValue);
+    nested.pushKV("empty_arr", UniValue(UniValue::VARR));
+    nested.pushKV("empty_obj", UniValue(UniValue::VOBJ));
+
+    UniValue expected(UniValue::VOBJ);
+    expected.pushKV("key\twith\"escapes\"", "value");
+    UniValue arr(UniValue::VARR);
+    for (int i = 0; i < 50; ++i) {
+        arr.push_back(nested);
+        arr.push_back(i);
+    }
+    expected.pushKV("arr", arr);
+    expected.pushKV("last", 1.5);
+
+    // Exercise the chunking with several chunk sizes, including one which
+    // flushes after each value.
+    for (const size_t chunk_size : {size_t{1}, size_t{7}, size_t{1 << 16}}) {
+        std::string output;
+        size_t num_chunks{0};
+        JSONStreamWriter writer(
+            [&](std::string &&chunk) {
+                BOOST_CHECK(!chunk.empty());
+                output += chunk;
+                ++num_chunks;
+            },
+            chunk_size);
+
+        writer.BeginObject();
+        writer.KeyValue("key\twith\"escapes\"", "value");
+        writer.Key("arr");
+        writer.BeginArray();
+        for (int i = 0; i < 50; ++i) {
+            if (i % 2) {
+                writer.Value(nested);
+            } else {
+                // Same value built field by field
+                writer.BeginObject();
+                for (const std::string &key : nested.getKeys()) {
+                    writer.KeyValue(key, nested[key]);
+                }
+                writer.EndObject();
+            }
+            writer.RawValue(UniValue(i).write());
+        }
+        writer.EndArray();
+        BOOST_CHECK(!writer.IsComplete());
+        writer.KeyValue("last", 1.5);
+        writer.EndObject();
+        BOOST_CHECK(writer.IsComplete());
+        writer.Flush();
+
+        BOOST_CHECK_EQUAL(output, expected.write());
+        BOOST_CHECK(writer.HasFlushed());
+        if (chunk_size == 1 << 16) {
+            BOOST_CHECK_EQUAL(num_chunks, 1);
+        } else {
+            BOOST_CHECK(num_chunks > 100);
+        }
+    }
+
+    // Top level values other than objects
+    std::string output;
+    JSONStreamWriter writer([&](std::string &&chunk) { output += chunk; });
+    writer.Value("str");
+    BOOST_CHECK(writer.IsComplete());
+    BOOST_CHECK(!writer.HasFlushed());
+    writer.Flush();
+    BOOST_CHECK_EQUAL(output, "\"str\"");
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,106 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <script/script_stack.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+BOOST_FIXTURE_TEST_SUITE(script_stack_tests, BasicTestingSetup)
+
+using valtype = ScriptStack::value_type;
+
+static std::vector<valtype> Elements(const ScriptStack &stack) {
+    return {stack.begin(), stack.end()};
+}
+
+BOOST_AUTO_TEST_CASE(operations) {
+    const valtype a{1}, b{2, 2}, c{3, 3, 3}, d{4, 4, 4, 4};
+
+    ScriptStack stack;
+    BOOST_CHECK(stack.empty());
+    stack.push_back(a);
+    stack.push_back(b);
+    stack.push_back(c);
+    BOOST_CHECK_EQUAL(stack.size(), 3);
+    BOOST_CHECK(stack.back() == c);
+    BOOST_CHECK(stack.at(0) == a);
+    BOOST_CHECK_THROW(stack.at(3), std::out_of_range);
+
+    // Pushing an element of the stack itself
+    stack.push_back(stack[0]);
+    BOOST_CHECK(Elements(stack) == std::vector<valtype>({a, b, c, a}));
+
+    stack.erase(stack.begin() + 1);
+    BOOST_CHECK(Elements(stack) == std::vector<valtype>({a, c, a}));
+    // The erased element is kept past the end but not accessible
+    BOOST_CHECK_THROW(stack.at(3), std::out_of_range);
+
+    stack.insert(stack.begin() + 1, d);
+    BOOST_CHECK(Elements(stack) == std::vector<valtype>({a, d, c, a}));
+    stack.insert(stack.end() - 1, stack.back());
+    BOOST_CHECK(Elements(stack) == std::vector<valtype>({a, d, c, a, a}));
+
+    stack.erase(stack.begin(), stack.begin() + 2);
+    BOOST_CHECK(Elements(stack) == std::vector<valtype>({c, a, a}));
+
+    stack.pop_back();
+    BOOST_CHECK(Elements(stack) == std::vector<valtype>({c, a}));
+
+    // New elements are empty, even when they reuse a buffer
+    stack.emplace_back().push_back(5);
+    BOOST_CHECK(Elements(stack) == std::vector<valtype>({c, a, {5}}));
+    stack.emplace_back();
+    BOOST_CHECK(Elements(stack) == std::vector<valtype>({c, a, {5}, {}}));
+
+    ScriptStack copy;
+    copy.push_back(d);
+    copy.assign(stack);
+    BOOST_CHECK(Elements(copy) == Elements(stack));
+    swap(copy, stack);
+    copy.clear();
+    BOOST_CHECK(copy.empty());
+    BOOST_CHECK(Elements(stack) == std::vector<valtype>({c, a, {5}, {}}));
+
+    std::vector<valtype> released{stack.release()};
+    BOOST_CHECK(released == std::vector<valtype>({c, a, {5}, {}}));
+    BOOST_CHECK(stack.empty());
+
+    ScriptStack fromVector{released};
+    BOOST_CHECK(Elements(fromVector) == released);
+}
+
+BOOST_AUTO_TEST_CASE(buffer_reuse) {
+    ScriptStack stack;
+    for (int i = 0; i < 10; i++) {
+        stack.push_back(valtype(100, i));
+    }
+    std::vector<const uint8_t *> buffers;
+    for (const valtype &element : stack) {
+        buffers.push_back(element.data());
+    }
+
+    // Once removed, the buffers are reused by the next elements
+    stack.clear();
+    for (int i = 0; i < 10; i++) {
+        stack.push_back(valtype(50, i));
+        BOOST_CHECK_EQUAL(stack.back().data(), buffers[i]);
+    }
+    stack.erase(stack.begin(), stack.begin() + 5);
+    for (int i = 0; i < 5; i++) {
+        stack.push_back(valtype(50, i));
+    }
+    std::sort(buffers.begin(), buffers.end());
+    for (const valtype &element : stack) {
+        BOOST_CHECK(std::binary_search(buffers.begin(), buffers.end(),
+                                       element.data()));
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -12,6 +12,7 @@
 #include <common/system.h>
 #include <core_io.h>
 #include <key.h>
+#include <policy/policy.h>
 #include <rpc/util.h>
 #include <streams.h>
 #include <util/strencodings.h>
@@ -2893,6 +2894,128 @@ BOOST_AUTO_TEST_CASE(script_IsPushOnly_on_invalid_scripts) {
     BOOST_CHECK(!CScript(direct, direct + sizeof(direct)).IsPushOnly());
 }
 
+/** Accepts the signatures starting with 0x01, whatever the signed script */
+class ScriptCodeAgnosticChecker : public BaseSignatureChecker {
+public:
+    bool CheckSig(const std::vector<uint8_t> &vchSigIn,
+                  const std::vector<uint8_t> &vchPubKey,
+                  const CScript &scriptCode, uint32_t flags) const final {
+        return vchSigIn[0] == 0x01;
+    }
+};
+
+BOOST_AUTO_TEST_CASE(script_standard_templates) {
+    // The P2PKH and P2PK scripts are evaluated without the interpreter, which
+    // must give the same results as evaluating the same scripts prefixed by an
+    // OP_NOP, which doesn't match the templates.
+    CKey key, otherKey, uncompressedKey;
+    key.MakeNewKey(true);
+    otherKey.MakeNewKey(true);
+    uncompressedKey.MakeNewKey(false);
+    const std::vector<uint8_t> pubkey = ToByteVector(key.GetPubKey());
+
+    // Schnorr sized signatures with SIGHASH_ALL | SIGHASH_FORKID
+    std::vector<uint8_t> goodSig(65, 0x00);
+    goodSig[0] = 0x01;
+    goodSig[64] = 0x41;
+    std::vector<uint8_t> badSig{goodSig};
+    badSig[0] = 0x02;
+    const std::vector<uint8_t> badEncodingSig{0x30, 0x01, 0x41};
+
+    const std::vector<CScript> scriptPubKeys{
+        GetScriptForDestination(PKHash(key.GetPubKey())),
+        GetScriptForRawPubKey(key.GetPubKey()),
+        GetScriptForRawPubKey(uncompressedKey.GetPubKey()),
+    };
+    const std::vector<CScript> scriptSigs{
+        CScript() << goodSig << pubkey,
+        CScript() << badSig << pubkey,
+        CScript() << std::vector<uint8_t>() << pubkey,
+        CScript() << badEncodingSig << pubkey,
+        CScript() << goodSig << ToByteVector(otherKey.GetPubKey()),
+        CScript() << goodSig << ToByteVector(uncompressedKey.GetPubKey()),
+        CScript() << OP_0 << goodSig << pubkey,
+        CScript() << OP_1 << goodSig << pubkey,
+        CScript() << goodSig << OP_NOP << pubkey,
+        CScript() << OP_PUSHDATA1 << goodSig << pubkey,
+        CScript() << goodSig,
+        CScript() << badSig,
+        CScript() << std::vector<uint8_t>(),
+        CScript() << std::vector<uint8_t>{0x01} << goodSig,
+        CScript() << std::vector<uint8_t>{0x81} << goodSig,
+        CScript(),
+    };
+    const std::vector<uint32_t> flagsList{
+        SCRIPT_VERIFY_NONE,
+        SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_STRICTENC,
+        SCRIPT_VERIFY_P2SH | SCRIPT_VERIFY_STRICTENC |
+            SCRIPT_ENABLE_SIGHASH_FORKID,
+        STANDARD_SCRIPT_VERIFY_FLAGS,
+    };
+
+    ScriptCodeAgnosticChecker checker;
+    for (const CScript &scriptPubKey : scriptPubKeys) {
+        CScript interpretedScriptPubKey = CScript() << OP_NOP;
+        interpretedScriptPubKey.insert(interpretedScriptPubKey.end(),
+                                       scriptPubKey.begin(),
+                                       scriptPubKey.end());
+        for (const CScript &scriptSig : scriptSigs) {
+            for (const uint32_t flags : flagsList) {
+                ScriptExecutionMetrics metrics, interpretedMetrics;
+                ScriptError err, interpretedErr;
+                const bool ret = VerifyScript(scriptSig, scriptPubKey, flags,
+                                              checker, metrics, &err);
+                const bool interpretedRet =
+                    VerifyScript(scriptSig, interpretedScriptPubKey, flags,
+                                 checker, interpretedMetrics, &interpretedErr);
+                BOOST_CHECK_EQUAL(ret, interpretedRet);
+                BOOST_CHECK_EQUAL(ScriptErrorString(err),
+                                  ScriptErrorString(interpretedErr));
+                BOOST_CHECK_EQUAL(metrics.nSigChecks,
+                                  interpretedMetrics.nSigChecks);
+            }
+        }
+    }
+
+    // The P2SH scripts only skip the interpreter for the scriptPubKey
+    const CScript redeemScript = GetScriptForRawPubKey(key.GetPubKey());
+    const CScript scriptPubKey =
+        GetScriptForDestination(ScriptHash(redeemScript));
+    const uint32_t flags = STANDARD_SCRIPT_VERIFY_FLAGS;
+    ScriptExecutionMetrics metrics;
+    ScriptError err;
+    BOOST_CHECK(VerifyScript(CScript() << goodSig << ToByteVector(redeemScript),
+                             scriptPubKey, flags, checker, metrics, &err));
+    BOOST_CHECK_EQUAL(ScriptErrorString(err),
+                      ScriptErrorString(ScriptError::OK));
+    BOOST_CHECK_EQUAL(metrics.nSigChecks, 1);
+    BOOST_CHECK(!VerifyScript(CScript() << badSig << ToByteVector(redeemScript),
+                              scriptPubKey, flags, checker, metrics, &err));
+    BOOST_CHECK_EQUAL(ScriptErrorString(err),
+                      ScriptErrorString(ScriptError::SIG_NULLFAIL));
+    BOOST_CHECK(!VerifyScript(CScript() << goodSig << ToByteVector(pubkey),
+                              scriptPubKey, flags, checker, metrics, &err));
+    BOOST_CHECK_EQUAL(ScriptErrorString(err),
+                      ScriptErrorString(ScriptError::EVAL_FALSE));
+    BOOST_CHECK(!VerifyScript(CScript() << OP_0 << goodSig
+                                        << ToByteVector(redeemScript),
+                              scriptPubKey, flags, checker, metrics, &err));
+    BOOST_CHECK_EQUAL(ScriptErrorString(err),
+                      ScriptErrorString(ScriptError::CLEANSTACK));
+    // Not a minimal push, so evaluated by the interpreter
+    CScript nonMinimalScriptSig = CScript() << goodSig;
+    nonMinimalScriptSig << OP_PUSHDATA1;
+    nonMinimalScriptSig.push_back(uint8_t(redeemScript.size()));
+    nonMinimalScriptSig.insert(nonMinimalScriptSig.end(),
+                               redeemScript.begin(), redeemScript.end());
+    BOOST_CHECK(!VerifyScript(nonMinimalScriptSig, scriptPubKey, flags,
+                              checker, metrics, &err));
+    BOOST_CHECK_EQUAL(ScriptErrorString(err),
+                      ScriptErrorString(ScriptError::MINIMALDATA));
+    BOOST_CHECK(VerifyScript(nonMinimalScriptSig, scriptPubKey,
+                             SCRIPT_VERIFY_P2SH, checker, metrics, &err));
+}
+
 BOOST_AUTO_TEST_CASE(script_GetScriptAsm) {
     BOOST_CHECK_EQUAL("OP_CHECKLOCKTIMEVERIFY",
                       ScriptToAsmStr(CScript() << OP_NOP2, true));
@@ -0,0 +1,88 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/serializedcache.h>
+
+#include <arith_uint256.h>
+#include <primitives/transaction.h>
+#include <streams.h>
+#include <version.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+using node::SerializedCache;
+using node::SerializedData;
+
+static SerializedData MakeData(size_t size) {
+    return std::make_shared<const std::vector<uint8_t>>(size, 0x42);
+}
+
+static BlockHash MakeBlockHash(uint64_t n) {
+    return BlockHash{ArithToUint256(arith_uint256{n})};
+}
+
+BOOST_FIXTURE_TEST_SUITE(serializedcache_tests, BasicTestingSetup)
+
+BOOST_AUTO_TEST_CASE(lru_eviction) {
+    // 3000 bytes for the blocks, 1000 bytes for the transactions
+    SerializedCache cache{4000};
+    BOOST_CHECK(cache.IsEnabled());
+
+    for (uint64_t i = 0; i < 5; i++) {
+        cache.AddBlock(MakeBlockHash(i), MakeData(1000));
+    }
+    // Only the 3 most recent blocks fit
+    BOOST_CHECK(!cache.GetBlock(MakeBlockHash(0)));
+    BOOST_CHECK(!cache.GetBlock(MakeBlockHash(1)));
+    for (uint64_t i = 2; i < 5; i++) {
+        BOOST_CHECK(cache.GetBlock(MakeBlockHash(i)));
+    }
+    auto stats{cache.GetBlockStats()};
+    BOOST_CHECK_EQUAL(stats.hits, 3);
+    BOOST_CHECK_EQUAL(stats.misses, 2);
+    BOOST_CHECK_EQUAL(stats.entries, 3);
+    BOOST_CHECK_EQUAL(stats.bytes, 3000);
+
+    // Accessing a block makes it the most recently used one
+    BOOST_CHECK(cache.GetBlock(MakeBlockHash(2)));
+    cache.AddBlock(MakeBlockHash(5), MakeData(1000));
+    BOOST_CHECK(cache.GetBlock(MakeBlockHash(2)));
+    BOOST_CHECK(!cache.GetBlock(MakeBlockHash(3)));
+
+    // Adding an entry twice doesn't count it twice
+    cache.AddBlock(MakeBlockHash(5), MakeData(1000));
+    BOOST_CHECK_EQUAL(cache.GetBlockStats().bytes, 3000);
+
+    // An entry larger than half of the cache is not kept
+    cache.AddBlock(MakeBlockHash(6), MakeData(1501));
+    BOOST_CHECK(!cache.GetBlock(MakeBlockHash(6)));
+    BOOST_CHECK_EQUAL(cache.GetBlockStats().entries, 3);
+
+    // The transactions don't share the memory of the blocks
+    BOOST_CHECK_EQUAL(cache.GetTransactionStats().entries, 0);
+    CMutableTransaction mtx;
+    mtx.vin.resize(1);
+    mtx.vout.resize(1);
+    const CTransaction tx{mtx};
+    const SerializedData tx_data{node::SerializeTransaction(tx)};
+    CDataStream expected(SER_NETWORK, PROTOCOL_VERSION);
+    expected << tx;
+    BOOST_CHECK(MakeByteSpan(*tx_data) == MakeByteSpan(expected));
+    cache.AddTransaction(tx.GetId(), tx_data);
+    BOOST_CHECK_EQUAL(cache.GetTransaction(tx.GetId()), tx_data);
+    BOOST_CHECK_EQUAL(cache.GetTransactionStats().bytes, tx_data->size());
+    BOOST_CHECK_EQUAL(cache.GetBlockStats().entries, 3);
+}
+
+BOOST_AUTO_TEST_CASE(disabled) {
+    SerializedCache cache{0};
+    BOOST_CHECK(!cache.IsEnabled());
+    cache.AddBlock(MakeBlockHash(0), MakeData(1));
+    BOOST_CHECK(!cache.GetBlock(MakeBlockHash(0)));
+    BOOST_CHECK_EQUAL(cache.GetBlockStats().entries, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -278,6 +278,52 @@ BOOST_AUTO_TEST_CASE(basic_transaction_tests) {
                         "Transaction with duplicate txins should be invalid.");
 }
 
+BOOST_AUTO_TEST_CASE(unserialize_transaction_hash) {
+    CMutableTransaction mtx;
+    mtx.vin.resize(3);
+    for (size_t i = 0; i < mtx.vin.size(); i++) {
+        mtx.vin[i].prevout = COutPoint(TxId(InsecureRand256()), i);
+        mtx.vin[i].scriptSig << std::vector<uint8_t>(100 + i, 0x42);
+    }
+    mtx.vout.resize(2);
+    mtx.vout[0].nValue = COIN;
+    mtx.vout[0].scriptPubKey << OP_TRUE;
+    mtx.vout[1].nValue = 2 * COIN;
+    mtx.vout[1].scriptPubKey << std::vector<uint8_t>(300, 0x51);
+    CMutableTransaction other_mtx{mtx};
+    other_mtx.nLockTime = 1;
+
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << mtx << other_mtx << uint8_t(0xff);
+    const std::vector<uint8_t> data{UCharCast(ss.data()),
+                                    UCharCast(ss.data() + ss.size())};
+
+    // The transactions read from a buffer are hashed in place, the ones read
+    // from any other stream are serialized again to be hashed.
+    auto check = [&](auto &stream) {
+        CTransaction tx(deserialize, stream);
+        CTransaction other_tx(deserialize, stream);
+        BOOST_CHECK_EQUAL(tx.GetId(), mtx.GetId());
+        BOOST_CHECK_EQUAL(other_tx.GetId(), other_mtx.GetId());
+        BOOST_CHECK(CMutableTransaction(tx) == mtx);
+        BOOST_CHECK(CMutableTransaction(other_tx) == other_mtx);
+        uint8_t last;
+        stream >> last;
+        BOOST_CHECK_EQUAL(last, 0xff);
+        BOOST_CHECK_THROW(CTransaction(deserialize, stream),
+                          std::ios_base::failure);
+    };
+
+    CDataStream data_stream(data, SER_NETWORK, PROTOCOL_VERSION);
+    check(data_stream);
+    SpanReader span_reader(SER_NETWORK, PROTOCOL_VERSION, data);
+    check(span_reader);
+    CDataStream inner_stream(data, SER_NETWORK, PROTOCOL_VERSION);
+    OverrideStream<CDataStream> override_stream(&inner_stream, SER_NETWORK,
+                                                PROTOCOL_VERSION);
+    check(override_stream);
+}
+
 BOOST_AUTO_TEST_CASE(test_Get) {
     FillableSigningProvider keystore;
     CCoinsView coinsDummy;
@@ -0,0 +1,137 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <node/txoutsetscan.h>
+
+#include <txdb.h>
+#include <validation.h>
+
+#include <test/util/setup_common.h>
+
+#include <boost/test/unit_test.hpp>
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+using node::TxOutSetScanner;
+
+struct TxOutSetScanSetup : public TestChain100Setup {
+    std::vector<CScript> scripts;
+
+    TxOutSetScanSetup() {
+        // Mine a few more blocks, each to its own script
+        for (int64_t i = 0; i < 20; i++) {
+            scripts.push_back(CScript() << i << OP_DROP << OP_TRUE);
+            CreateAndProcessBlock({}, scripts.back());
+        }
+        scripts.push_back(CScript() << ToByteVector(coinbaseKey.GetPubKey())
+                                    << OP_CHECKSIG);
+    }
+
+    /** Scan the whole UTXO set from a single cursor */
+    TxOutSetScanner::Result
+    ExpectedResult(const TxOutSetScanner::Scripts &needles) {
+        LOCK(cs_main);
+        Chainstate &chainstate = m_node.chainman->ActiveChainstate();
+        chainstate.ForceFlushStateToDisk();
+
+        TxOutSetScanner::Result result;
+        result.success = true;
+        result.tip = chainstate.m_chain.Tip();
+        std::unique_ptr<CCoinsViewCursor> cursor{
+            chainstate.CoinsDB().Cursor()};
+        for (; cursor->Valid(); cursor->Next()) {
+            COutPoint key;
+            Coin coin;
+            BOOST_REQUIRE(cursor->GetKey(key) && cursor->GetValue(coin));
+            result.count++;
+            if (needles.count(coin.GetTxOut().scriptPubKey)) {
+                result.coins.emplace(key, coin);
+            }
+        }
+        return result;
+    }
+
+    void CheckResult(const TxOutSetScanner::Result &result,
+                     const TxOutSetScanner::Result &expected) {
+        BOOST_CHECK_EQUAL(result.success, expected.success);
+        BOOST_CHECK_EQUAL(result.count, expected.count);
+        BOOST_CHECK_EQUAL(result.tip, expected.tip);
+        BOOST_REQUIRE_EQUAL(result.coins.size(), expected.coins.size());
+        for (const auto &[outpoint, coin] : expected.coins) {
+            auto it = result.coins.find(outpoint);
+            BOOST_REQUIRE(it != result.coins.end());
+            BOOST_CHECK(it->second.GetTxOut() == coin.GetTxOut());
+            BOOST_CHECK_EQUAL(it->second.GetHeight(), coin.GetHeight());
+        }
+    }
+};
+
+BOOST_FIXTURE_TEST_SUITE(txoutsetscan_tests, TxOutSetScanSetup)
+
+BOOST_AUTO_TEST_CASE(scan) {
+    // Each request looks for a different subset of the scripts
+    std::vector<TxOutSetScanner::Scripts> requests{
+        {},
+        {CScript() << OP_RETURN},
+        {scripts[0]},
+        {scripts.begin(), scripts.begin() + 10},
+        {scripts.begin() + 5, scripts.end()},
+    };
+    std::vector<TxOutSetScanner::Result> expected;
+    for (const auto &needles : requests) {
+        expected.push_back(ExpectedResult(needles));
+    }
+    BOOST_CHECK_EQUAL(expected[2].coins.size(), 1);
+    BOOST_CHECK_GE(expected[4].coins.size(), 115);
+
+    // The coins are split between up to 256 threads
+    for (size_t max_threads : {1, 3, 8, 256, 1000}) {
+        TxOutSetScanner scanner{max_threads};
+
+        for (size_t i = 0; i < requests.size(); i++) {
+            auto request{std::make_shared<TxOutSetScanner::Request>(
+                requests[i])};
+            CheckResult(scanner.Scan(*m_node.chainman, request),
+                        expected[i]);
+            BOOST_CHECK_EQUAL(request->GetProgress(), 100);
+        }
+        BOOST_CHECK(scanner.GetRequests().empty());
+
+        // Concurrent requests are queued and answered by the same pass or the
+        // next one
+        std::vector<TxOutSetScanner::Result> results(requests.size());
+        std::vector<std::thread> threads;
+        for (size_t i = 0; i < requests.size(); i++) {
+            threads.emplace_back([&, i] {
+                results[i] = scanner.Scan(
+                    *m_node.chainman,
+                    std::make_shared<TxOutSetScanner::Request>(requests[i]));
+            });
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+        for (size_t i = 0; i < requests.size(); i++) {
+            CheckResult(results[i], expected[i]);
+        }
+        BOOST_CHECK(scanner.GetRequests().empty());
+    }
+}
+
+BOOST_AUTO_TEST_CASE(abort) {
+    TxOutSetScanner scanner{4};
+    auto request{std::make_shared<TxOutSetScanner::Request>(
+        TxOutSetScanner::Scripts{scripts.begin(), scripts.end()})};
+    request->Abort();
+    BOOST_CHECK(!scanner.Scan(*m_node.chainman, request).success);
+
+    // Aborting a request doesn't affect the next ones
+    request = std::make_shared<TxOutSetScanner::Request>(
+        TxOutSetScanner::Scripts{scripts.begin(), scripts.end()});
+    BOOST_CHECK(scanner.Scan(*m_node.chainman, request).success);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
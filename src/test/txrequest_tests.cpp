@@ -193,6 +193,18 @@ public:
                           real_candidates, candidates));
             BOOST_CHECK_MESSAGE(ret == expected,
                                 "[" + comment + "] mismatching requestables");
+
+            // Querying all the peers at the same time returns the same.
+            const auto all =
+                runner.txrequest.GetRequestable(now + offset, &expired_now);
+            BOOST_CHECK(expired_now.empty());
+            auto it = std::find_if(
+                all.begin(), all.end(),
+                [peer](const auto &entry) { return entry.first == peer; });
+            BOOST_CHECK_MESSAGE(
+                (it == all.end() ? std::vector<TxId>{} : it->second) ==
+                    expected,
+                "[" + comment + "] mismatching requestables of all peers");
         });
     }
 
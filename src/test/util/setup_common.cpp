@@ -22,6 +22,7 @@
 #include <mempool_args.h>
 #include <net.h>
 #include <net_processing.h>
+#include <node/blockmanager_args.h>
 #include <node/blockstorage.h>
 #include <node/chainstate.h>
 #include <node/chainstatemanager_args.h>
@@ -45,6 +46,7 @@
 #include <timedata.h>
 #include <txdb.h>
 #include <txmempool.h>
+#include <util/parallel.h>
 #include <util/strencodings.h>
 #include <util/thread.h>
 #include <util/threadnames.h>
@@ -179,9 +181,9 @@ ChainTestingSetup::ChainTestingSetup(
     // We have to run a scheduler thread to prevent ActivateBestChain
     // from blocking due to queue overrun.
     m_node.scheduler = std::make_unique<CScheduler>();
-    m_node.scheduler->m_service_thread =
-        std::thread(util::TraceThread, "scheduler",
-                    [&] { m_node.scheduler->serviceQueue(); });
+    m_node.scheduler->m_service_threads.emplace_back(
+        util::TraceThread, "scheduler",
+        [&] { m_node.scheduler->serviceQueue(); });
     GetMainSignals().RegisterBackgroundSignalScheduler(*m_node.scheduler);
 
     m_node.mempool =
@@ -199,10 +201,11 @@ ChainTestingSetup::ChainTestingSetup(
         .notifications = *m_node.notifications,
     };
     ApplyArgsManOptions(*m_node.args, chainman_opts);
-    const BlockManager::Options blockman_opts{
+    BlockManager::Options blockman_opts{
         .chainparams = chainman_opts.config.GetChainParams(),
         .blocks_dir = m_args.GetBlocksDirPath(),
     };
+    Assert(!ApplyArgsManOptions(*m_node.args, blockman_opts));
     m_node.chainman =
         std::make_unique<ChainstateManager>(chainman_opts, blockman_opts);
     m_node.chainman->m_blockman.m_block_tree_db =
@@ -216,6 +219,7 @@ ChainTestingSetup::ChainTestingSetup(
 
     constexpr int script_check_threads = 2;
     StartScriptCheckWorkerThreads(script_check_threads);
+    util::g_worker_pool.StartWorkerThreads(script_check_threads, "worker");
 }
 
 ChainTestingSetup::~ChainTestingSetup() {
@@ -223,6 +227,7 @@ ChainTestingSetup::~ChainTestingSetup() {
         m_node.scheduler->stop();
     }
     StopScriptCheckWorkerThreads();
+    util::g_worker_pool.StopWorkerThreads();
     GetMainSignals().FlushBackgroundCallbacks();
     GetMainSignals().UnregisterBackgroundSignalScheduler();
     m_node.connman.reset();
@@ -327,7 +332,7 @@ TestChain100Setup::TestChain100Setup(
         LOCK(::cs_main);
         assert(
             m_node.chainman->ActiveTip()->GetBlockHash().ToString() ==
-            "5afde277a26b6f36aee8f61a1dbf755587e1c6be63e654a88abe2a1ff0fbfb05");
+            "120a0953f80faa0dd59cac2309733f6287cd25374a64cc39588b8fdf87dcdbc2");
     }
 }
 
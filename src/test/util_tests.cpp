@@ -17,6 +17,7 @@
 #include <util/getuniquepath.h>
 #include <util/message.h> // For MessageSign(), MessageVerify(), MESSAGE_MAGIC
 #include <util/moneystr.h>
+#include <util/parallel.h>
 #include <util/spanparsing.h>
 #include <util/strencodings.h>
 #include <util/string.h>
@@ -2766,4 +2767,75 @@ BOOST_AUTO_TEST_CASE(remove_prefix) {
     BOOST_CHECK_EQUAL(RemovePrefix("", ""), "");
 }
 
+BOOST_AUTO_TEST_CASE(parallel_for_ranges) {
+    for (size_t count : {0, 1, 7, 1000}) {
+        for (size_t threads : {0, 1, 3, 16}) {
+            std::vector<std::atomic<int>> calls(count);
+            std::atomic<bool> empty_range{false};
+            util::ParallelForRanges(
+                count, threads, [&](size_t begin, size_t end) {
+                    empty_range = empty_range || begin >= end;
+                    for (size_t i = begin; i < end; i++) {
+                        calls[i]++;
+                    }
+                });
+            BOOST_CHECK(!empty_range);
+            // Each index is processed exactly once
+            for (const auto &call : calls) {
+                BOOST_CHECK_EQUAL(call, 1);
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(worker_pool) {
+    util::WorkerPool pool;
+    // Return whether each index is processed exactly once, by non-empty
+    // ranges. Boost checks are not thread-safe, so only check the result.
+    auto for_ranges_ok = [&pool](size_t count, size_t threads) {
+        std::vector<std::atomic<int>> calls(count);
+        std::atomic<bool> empty_range{false};
+        pool.ForRanges(count, threads, [&](size_t begin, size_t end) {
+            empty_range = empty_range || begin >= end;
+            for (size_t i = begin; i < end; i++) {
+                calls[i]++;
+            }
+        });
+        return !empty_range &&
+               std::all_of(calls.begin(), calls.end(),
+                           [](const auto &call) { return call == 1; });
+    };
+
+    // The calling thread does all the work until the pool is started
+    BOOST_CHECK(for_ranges_ok(1000, 16));
+
+    pool.StartWorkerThreads(3, "test");
+    BOOST_CHECK_EQUAL(pool.GetMaxParallelism(), 4);
+    for (size_t count : {0, 1, 7, 1000}) {
+        for (size_t threads : {0, 1, 3, 16}) {
+            BOOST_CHECK(for_ranges_ok(count, threads));
+        }
+    }
+
+    // Several callers can share the workers
+    std::atomic<bool> all_ok{true};
+    std::vector<std::thread> callers;
+    for (int i = 0; i < 4; i++) {
+        callers.emplace_back([&] {
+            for (int j = 0; j < 100; j++) {
+                if (!for_ranges_ok(1000, 4)) {
+                    all_ok = false;
+                }
+            }
+        });
+    }
+    for (std::thread &caller : callers) {
+        caller.join();
+    }
+    BOOST_CHECK(all_ok);
+
+    pool.StopWorkerThreads();
+    BOOST_CHECK(for_ranges_ok(1000, 16));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
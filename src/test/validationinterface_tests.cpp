@@ -8,12 +8,17 @@
 #include <scheduler.h>
 #include <util/check.h>
 #include <validation.h>
+#include <util/time.h>
 #include <validationinterface.h>
 
 #include <test/util/setup_common.h>
 
 #include <boost/test/unit_test.hpp>
 
+#include <atomic>
+#include <chrono>
+#include <future>
+
 BOOST_FIXTURE_TEST_SUITE(validationinterface_tests, ChainTestingSetup)
 
 struct TestSubscriberNoop final : public CValidationInterface {
@@ -109,6 +114,61 @@ BOOST_AUTO_TEST_CASE(unregister_all_during_call) {
     BOOST_CHECK(destroyed);
 }
 
+BOOST_AUTO_TEST_CASE(slow_subscriber_does_not_block_others) {
+    // The callbacks of the subscribers can only run concurrently if there are
+    // several scheduler threads.
+    m_node.scheduler->m_service_threads.emplace_back(
+        [&] { m_node.scheduler->serviceQueue(); });
+
+    std::promise<void> release_slow;
+    std::shared_future<void> slow_released = release_slow.get_future().share();
+    std::atomic<uint32_t> slow_calls{0};
+    std::atomic<uint32_t> fast_calls{0};
+    auto slow = std::make_shared<TestInterface>(
+        nullptr, [&](const CBlockIndex *) {
+            slow_released.wait();
+            slow_calls++;
+        });
+    auto fast = std::make_shared<TestInterface>(
+        nullptr, [&](const CBlockIndex *) { fast_calls++; });
+    RegisterSharedValidationInterface(slow);
+    RegisterSharedValidationInterface(fast);
+
+    for (size_t i = 0; i < 10; i++) {
+        TestInterface::CallBlockFinalized(nullptr);
+    }
+
+    // The fast subscriber gets all its notifications while the slow one is
+    // still stuck on the first of them.
+    const auto deadline = std::chrono::steady_clock::now() + 60s;
+    while (fast_calls < 10 && std::chrono::steady_clock::now() < deadline) {
+        UninterruptibleSleep(1ms);
+    }
+    BOOST_CHECK_EQUAL(fast_calls, 10);
+    BOOST_CHECK_EQUAL(slow_calls, 0);
+    BOOST_CHECK_EQUAL(GetMainSignals().CallbacksPending(), 9);
+
+    release_slow.set_value();
+    SyncWithValidationInterfaceQueue();
+    BOOST_CHECK_EQUAL(slow_calls, 10);
+    BOOST_CHECK_EQUAL(GetMainSignals().CallbacksPending(), 0);
+
+    const auto stats = GetMainSignals().GetQueueStats();
+    BOOST_CHECK_EQUAL(stats.size(), 2);
+    for (const auto &subscriber : stats) {
+        BOOST_CHECK_EQUAL(subscriber.name,
+                          "validationinterface_tests::TestInterface");
+        BOOST_CHECK_EQUAL(subscriber.pending, 0);
+        // The barrier of SyncWithValidationInterfaceQueue is counted too
+        BOOST_CHECK_EQUAL(subscriber.processed, 11);
+        BOOST_CHECK(subscriber.max_latency <= subscriber.total_latency);
+    }
+
+    UnregisterSharedValidationInterface(slow);
+    UnregisterSharedValidationInterface(fast);
+    BOOST_CHECK(GetMainSignals().GetQueueStats().empty());
+}
+
 BOOST_FIXTURE_TEST_CASE(block_finalized, TestChain100Setup) {
     uint32_t callCount = 0;
     const CBlockIndex *calledIndex;
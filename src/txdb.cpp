@@ -12,10 +12,12 @@
 #include <pow/pow.h>
 #include <random.h>
 #include <shutdown.h>
+#include <util/parallel.h>
 #include <util/translation.h>
 #include <util/vector.h>
 #include <version.h>
 
+#include <algorithm>
 #include <cstdint>
 #include <memory>
 
@@ -34,6 +36,12 @@ static constexpr uint8_t DB_LAST_BLOCK{'l'};
 static constexpr uint8_t DB_TXINDEX_BLOCK{'T'};
 //               uint8_t DB_TXINDEX{'t'}
 
+//! Number of block index records read before processing them in parallel
+static constexpr size_t BLOCK_INDEX_LOAD_BATCH_SIZE{16384};
+//! Number of coins read by each thread when reading a batch of coins
+static constexpr size_t MIN_COINS_PER_READ_THREAD{1000};
+static constexpr size_t MAX_COINS_READ_THREADS{4};
+
 util::Result<void> CheckLegacyTxindex(CBlockTreeDB &block_tree_db) {
     CBlockLocator ignored{};
     if (block_tree_db.Read(DB_TXINDEX_BLOCK, ignored)) {
@@ -96,6 +104,19 @@ bool CCoinsViewDB::GetCoin(const COutPoint &outpoint, Coin &coin) const {
     return m_db->Read(CoinEntry(&outpoint), coin);
 }
 
+std::vector<std::optional<Coin>>
+CCoinsViewDB::GetCoins(const std::vector<COutPoint> &outpoints) const {
+    std::vector<CoinEntry> keys;
+    keys.reserve(outpoints.size());
+    for (const COutPoint &outpoint : outpoints) {
+        keys.emplace_back(&outpoint);
+    }
+    const size_t threads{std::clamp<size_t>(
+        outpoints.size() / MIN_COINS_PER_READ_THREAD, 1,
+        std::min<size_t>(GetNumCores(), MAX_COINS_READ_THREADS))};
+    return m_db->MultiRead<Coin>(keys, threads);
+}
+
 bool CCoinsViewDB::HaveCoin(const COutPoint &outpoint) const {
     return m_db->Exists(CoinEntry(&outpoint));
 }
@@ -206,6 +227,11 @@ bool CBlockTreeDB::ReadLastBlockFile(int &nFile) {
 }
 
 CCoinsViewCursor *CCoinsViewDB::Cursor() const {
+    // This is the lowest coin key
+    return Cursor(COutPoint(TxId(), 0));
+}
+
+CCoinsViewCursor *CCoinsViewDB::Cursor(const COutPoint &start) const {
     CCoinsViewDBCursor *i = new CCoinsViewDBCursor(
         const_cast<CDBWrapper &>(*m_db).NewIterator(), GetBestBlock());
     /**
@@ -213,7 +239,7 @@ CCoinsViewCursor *CCoinsViewDB::Cursor() const {
      * need read operations on it, use a const-cast to get around that
      * restriction.
      */
-    i->pcursor->Seek(DB_COIN);
+    i->pcursor->Seek(CoinEntry(&start));
     // Cache key of first record
     if (i->pcursor->Valid()) {
         CoinEntry entry(&i->keyTmp.second);
@@ -294,7 +320,8 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
 
 bool CBlockTreeDB::LoadBlockIndexGuts(
     const Consensus::Params &params,
-    std::function<CBlockIndex *(const BlockHash &)> insertBlockIndex) {
+    std::function<CBlockIndex *(const BlockHash &)> insertBlockIndex,
+    size_t threads) {
     AssertLockHeld(::cs_main);
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
 
@@ -311,49 +338,100 @@ bool CBlockTreeDB::LoadBlockIndexGuts(
 
     pcursor->Seek(std::make_pair(DB_BLOCK_INDEX, uint256()));
 
+    // The records are read from the database in batches. Deserializing them,
+    // hashing the headers and checking their proof of work is done in
+    // parallel, then they are inserted in m_block_index in database order.
+    enum class RecordStatus : uint8_t { OK, READ_FAILED, POW_FAILED };
+    std::vector<uint8_t> raw_values;
+    std::vector<size_t> value_ends;
+    std::vector<CDiskBlockIndex> diskindexes;
+    std::vector<BlockHash> hashes;
+    std::vector<RecordStatus> statuses;
+
     // Load m_block_index
-    while (pcursor->Valid()) {
+    bool done = false;
+    while (!done) {
         if (ShutdownRequested()) {
             return false;
         }
-        std::pair<uint8_t, uint256> key;
-        if (!pcursor->GetKey(key) || key.first != DB_BLOCK_INDEX) {
-            break;
-        }
 
-        CDiskBlockIndex diskindex;
-        if (!pcursor->GetValue(diskindex)) {
-            return error("%s : failed to read value", __func__);
+        raw_values.clear();
+        value_ends.clear();
+        while (value_ends.size() < BLOCK_INDEX_LOAD_BATCH_SIZE) {
+            std::pair<uint8_t, uint256> key;
+            if (!pcursor->Valid() || !pcursor->GetKey(key) ||
+                key.first != DB_BLOCK_INDEX) {
+                done = true;
+                break;
+            }
+            const Span<const uint8_t> value{pcursor->GetRawValue()};
+            raw_values.insert(raw_values.end(), value.begin(), value.end());
+            value_ends.push_back(raw_values.size());
+            pcursor->Next();
         }
 
-        // Construct block index object
-        CBlockIndex *pindexNew =
-            insertBlockIndex(diskindex.ConstructBlockHash());
-        pindexNew->pprev = insertBlockIndex(diskindex.hashPrev);
-        pindexNew->nHeight = diskindex.nHeight;
-        pindexNew->nFile = diskindex.nFile;
-        pindexNew->nDataPos = diskindex.nDataPos;
-        pindexNew->nUndoPos = diskindex.nUndoPos;
-        pindexNew->nVersion = diskindex.nVersion;
-        pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
-        pindexNew->nTime = diskindex.nTime;
-        pindexNew->nBits = diskindex.nBits;
-        pindexNew->nNonce = diskindex.nNonce;
-        pindexNew->nStatus = diskindex.nStatus;
-        pindexNew->nTx = diskindex.nTx;
-
-        if (!CheckProofOfWork(pindexNew->GetBlockHash(), pindexNew->nBits,
-                              params)) {
-            return error("%s: CheckProofOfWork failed: %s", __func__,
-                         pindexNew->ToString());
-        }
+        const size_t count = value_ends.size();
+        diskindexes.assign(count, CDiskBlockIndex{});
+        hashes.resize(count);
+        statuses.resize(count);
+        util::ParallelForRanges(count, threads, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                const size_t value_begin = i > 0 ? value_ends[i - 1] : 0;
+                if (!DecodeValue(Span{raw_values}.subspan(
+                                     value_begin, value_ends[i] - value_begin),
+                                 diskindexes[i])) {
+                    statuses[i] = RecordStatus::READ_FAILED;
+                    continue;
+                }
+                hashes[i] = diskindexes[i].ConstructBlockHash();
+                statuses[i] =
+                    CheckProofOfWork(hashes[i], diskindexes[i].nBits, params)
+                        ? RecordStatus::OK
+                        : RecordStatus::POW_FAILED;
+            }
+        });
 
-        pcursor->Next();
+        for (size_t i = 0; i < count; i++) {
+            if (statuses[i] == RecordStatus::READ_FAILED) {
+                return error("%s : failed to read value", __func__);
+            }
+            const CDiskBlockIndex &diskindex = diskindexes[i];
+
+            // Construct block index object
+            CBlockIndex *pindexNew = insertBlockIndex(hashes[i]);
+            pindexNew->pprev = insertBlockIndex(diskindex.hashPrev);
+            pindexNew->nHeight = diskindex.nHeight;
+            pindexNew->nFile = diskindex.nFile;
+            pindexNew->nDataPos = diskindex.nDataPos;
+            pindexNew->nUndoPos = diskindex.nUndoPos;
+            pindexNew->nVersion = diskindex.nVersion;
+            pindexNew->hashMerkleRoot = diskindex.hashMerkleRoot;
+            pindexNew->nTime = diskindex.nTime;
+            pindexNew->nBits = diskindex.nBits;
+            pindexNew->nNonce = diskindex.nNonce;
+            pindexNew->nStatus = diskindex.nStatus;
+            pindexNew->nTx = diskindex.nTx;
+
+            if (statuses[i] == RecordStatus::POW_FAILED) {
+                return error("%s: CheckProofOfWork failed: %s", __func__,
+                             pindexNew->ToString());
+            }
+        }
     }
 
     return true;
 }
 
+size_t CBlockTreeDB::EstimateBlockIndexCount() const {
+    // The records are mostly made of hashes, which don't compress, so their
+    // size on disk is close to their serialized size.
+    static constexpr size_t APPROXIMATE_RECORD_SIZE{128};
+    return EstimateSize(std::make_pair(DB_BLOCK_INDEX, uint256()),
+                        std::make_pair(uint8_t(DB_BLOCK_INDEX + 1),
+                                       uint256())) /
+           APPROXIMATE_RECORD_SIZE;
+}
+
 namespace {
 //! Legacy class to deserialize pre-pertxout database entries without reindex.
 class CCoins {
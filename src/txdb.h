@@ -72,12 +72,18 @@ public:
     explicit CCoinsViewDB(DBParams db_params, CoinsViewOptions options);
 
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
+    //! Read the coins with CDBWrapper::MultiRead(), from several threads for
+    //! large batches
+    std::vector<std::optional<Coin>>
+    GetCoins(const std::vector<COutPoint> &outpoints) const override;
     bool HaveCoin(const COutPoint &outpoint) const override;
     BlockHash GetBestBlock() const override;
     std::vector<BlockHash> GetHeadBlocks() const override;
     bool BatchWrite(CCoinsMap &mapCoins, const BlockHash &hashBlock,
                     bool erase = true) override;
     CCoinsViewCursor *Cursor() const override;
+    //! Cursor positioned at the first coin not before start
+    CCoinsViewCursor *Cursor(const COutPoint &start) const;
 
     //! Attempt to update from an older database format.
     //! Returns whether an error occurred.
@@ -126,11 +132,16 @@ public:
     bool IsReindexing() const;
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
+    /**
+     * Load all the block index records, using up to the given number of
+     * threads to deserialize and check them.
+     */
     bool LoadBlockIndexGuts(
         const Consensus::Params &params,
-        std::function<CBlockIndex *(const BlockHash &)> insertBlockIndex)
-        EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
-    ;
+        std::function<CBlockIndex *(const BlockHash &)> insertBlockIndex,
+        size_t threads = 1) EXCLUSIVE_LOCKS_REQUIRED(::cs_main);
+    /** Approximate number of block index records, from their size on disk */
+    size_t EstimateBlockIndexCount() const;
 
     //! Attempt to update from an older database format.
     //! Returns whether an error occurred.
@@ -203,7 +203,9 @@ void CTxMemPool::removeUnchecked(txiter it, MemPoolRemovalReason reason) {
         GetMainSignals().TransactionRemovedFromMempool(
             (*it)->GetSharedTx(), reason, mempool_sequence);
 
-        finalizedTxs.remove(txid);
+        if (finalizedTxs.remove(txid)) {
+            removeFinalizedSpenders((*it)->GetTx());
+        }
     }
 
     for (const CTxIn &txin : (*it)->GetTx().vin) {
@@ -316,12 +318,41 @@ void CTxMemPool::removeForFinalizedBlock(
     const std::vector<CTransactionRef> &vtx) {
     AssertLockHeld(cs);
 
+    // If the tx has a parent, it will be in the block as well or the block is
+    // invalid. If the tx has a child, it can remain in the tree for the next
+    // block. So we can simply remove the txs from the block with no further
+    // check, all at once.
+    std::vector<Uint256RadixKey> txids;
+    txids.reserve(vtx.size());
     for (const auto &tx : vtx) {
-        // If the tx has a parent, it will be in the block as well or the block
-        // is invalid. If the tx has a child, it can remain in the tree for the
-        // next block. So we can simply remove the txs from the block with no
-        // further check.
-        finalizedTxs.remove(tx->GetId());
+        txids.emplace_back(tx->GetId());
+        removeFinalizedSpenders(*tx);
+    }
+    finalizedTxs.removeBatch(std::move(txids));
+}
+
+bool CTxMemPool::setAvalancheFinalized(const CTxMemPoolEntryRef &tx) {
+    AssertLockHeld(cs);
+    if (!finalizedTxs.insert(tx)) {
+        return false;
+    }
+
+    LOCK(m_finalized_spenders_mutex);
+    for (const CTxIn &txin : tx->GetTx().vin) {
+        m_finalized_spenders.insert_or_assign(txin.prevout,
+                                              tx->GetTx().GetId());
+    }
+    return true;
+}
+
+void CTxMemPool::removeFinalizedSpenders(const CTransaction &tx) {
+    LOCK(m_finalized_spenders_mutex);
+    for (const CTxIn &txin : tx.vin) {
+        auto it = m_finalized_spenders.find(txin.prevout);
+        // Don't remove the spender of another transaction
+        if (it != m_finalized_spenders.end() && it->second == tx.GetId()) {
+            m_finalized_spenders.erase(it);
+        }
     }
 }
 
@@ -302,7 +302,23 @@ public:
 
     RadixTree<CTxMemPoolEntry, MemPoolEntryRadixTreeAdapter> finalizedTxs;
 
+    /** The finalized transaction spending each outpoint */
+    using FinalizedSpenders =
+        std::unordered_map<COutPoint, TxId, SaltedOutpointHasher>;
+
 private:
+    /**
+     * Index of the inputs of the transactions in finalizedTxs. It has its own
+     * lock so a block can be checked against the finalized transactions
+     * without looking up mapNextTx and mapTx under cs.
+     */
+    mutable Mutex m_finalized_spenders_mutex;
+    FinalizedSpenders
+        m_finalized_spenders GUARDED_BY(m_finalized_spenders_mutex);
+
+    void removeFinalizedSpenders(const CTransaction &tx)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_finalized_spenders_mutex);
+
     void UpdateParent(txiter entry, txiter parent, bool add)
         EXCLUSIVE_LOCKS_REQUIRED(cs);
     void UpdateChild(txiter entry, txiter child, bool add)
@@ -495,15 +511,25 @@ public:
     }
 
     bool setAvalancheFinalized(const CTxMemPoolEntryRef &tx)
-        EXCLUSIVE_LOCKS_REQUIRED(cs) {
-        return finalizedTxs.insert(tx);
-    }
+        EXCLUSIVE_LOCKS_REQUIRED(cs, !m_finalized_spenders_mutex);
 
     bool isAvalancheFinalized(const TxId &txid) const {
         LOCK(cs);
         return finalizedTxs.get(txid) != nullptr;
     }
 
+    /**
+     * Call func with the finalized spender of each outpoint. The index can't
+     * change until func returns, so func may share it with other threads as
+     * long as they are done by then.
+     */
+    template <typename Callable>
+    auto withFinalizedSpenders(Callable &&func) const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_finalized_spenders_mutex) {
+        LOCK(m_finalized_spenders_mutex);
+        return func(std::as_const(m_finalized_spenders));
+    }
+
     CTransactionRef get(const TxId &txid) const;
     TxMempoolInfo info(const TxId &txid) const;
     std::vector<TxMempoolInfo> infoAll() const;
@@ -10,13 +10,37 @@
 #include <policy/policy.h>
 #include <util/time.h>
 
+#include <algorithm>
 #include <cassert>
 
+std::optional<uint32_t> TxPool::FindTx(const TxId &txid) const {
+    AssertLockHeld(m_mutex);
+    auto it = m_txid_to_pos.find(txid);
+    if (it == m_txid_to_pos.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::vector<uint32_t> TxPool::FindChildren(const CTransaction &parent) const {
+    AssertLockHeld(m_mutex);
+    std::vector<uint32_t> children;
+    for (uint32_t i = 0; i < parent.vout.size(); i++) {
+        const auto it =
+            m_outpoint_to_children.find(COutPoint(parent.GetId(), i));
+        if (it != m_outpoint_to_children.end()) {
+            children.insert(children.end(), it->second.begin(),
+                            it->second.end());
+        }
+    }
+    return children;
+}
+
 bool TxPool::AddTx(const CTransactionRef &tx, NodeId peer) {
     LOCK(m_mutex);
 
     const TxId &txid = tx->GetId();
-    if (m_pool_txs.count(txid)) {
+    if (m_txid_to_pos.count(txid)) {
         return false;
     }
 
@@ -31,19 +55,23 @@ bool TxPool::AddTx(const CTransactionRef &tx, NodeId peer) {
         return false;
     }
 
-    auto ret = m_pool_txs.emplace(
-        txid,
-        PoolTx{tx, peer, Now<NodeSeconds>() + expireTime, m_txs_list.size()});
-    assert(ret.second);
-    m_txs_list.push_back(ret.first);
+    const uint32_t pos = m_pool_txs.size();
+    m_pool_txs.push_back(PoolTx{tx, peer, Now<NodeSeconds>() + expireTime});
+    m_txid_to_pos.emplace(txid, pos);
     for (const CTxIn &txin : tx->vin) {
-        m_outpoint_to_tx_it[txin.prevout].insert(ret.first);
+        Children &children = m_outpoint_to_children[txin.prevout];
+        // A transaction spending the same outpoint twice is invalid, but
+        // would be indexed only once.
+        if (std::find(children.begin(), children.end(), pos) ==
+            children.end()) {
+            children.push_back(pos);
+        }
     }
 
     LogPrint(BCLog::TXPACKAGES,
              "stored %s tx %s, size: %u (mapsz %u outsz %u)\n", txKind,
              txid.ToString(), sz, m_pool_txs.size(),
-             m_outpoint_to_tx_it.size());
+             m_outpoint_to_children.size());
     return true;
 }
 
@@ -54,40 +82,54 @@ int TxPool::EraseTx(const TxId &txid) {
 
 int TxPool::EraseTxNoLock(const TxId &txid) {
     AssertLockHeld(m_mutex);
-    std::map<TxId, PoolTx>::iterator it = m_pool_txs.find(txid);
-    if (it == m_pool_txs.end()) {
+    auto it = m_txid_to_pos.find(txid);
+    if (it == m_txid_to_pos.end()) {
         return 0;
     }
-    for (const CTxIn &txin : it->second.tx->vin) {
-        auto itPrev = m_outpoint_to_tx_it.find(txin.prevout);
-        if (itPrev == m_outpoint_to_tx_it.end()) {
-            continue;
-        }
-        itPrev->second.erase(it);
-        if (itPrev->second.empty()) {
-            m_outpoint_to_tx_it.erase(itPrev);
+    const uint32_t pos = it->second;
+    m_txid_to_pos.erase(it);
+
+    // Replace from by to in the indexes of the outpoints spent by the
+    // transaction at position from, or remove it if to is nullopt.
+    auto reindex = [&](uint32_t from, std::optional<uint32_t> to) {
+        for (const CTxIn &txin : m_pool_txs[from].tx->vin) {
+            auto it_prev = m_outpoint_to_children.find(txin.prevout);
+            if (it_prev == m_outpoint_to_children.end()) {
+                continue;
+            }
+            Children &children = it_prev->second;
+            auto child = std::find(children.begin(), children.end(), from);
+            if (child == children.end()) {
+                continue;
+            }
+            if (to) {
+                *child = *to;
+            } else {
+                children.erase(child);
+                if (children.empty()) {
+                    m_outpoint_to_children.erase(it_prev);
+                }
+            }
         }
-    }
-
-    size_t old_pos = it->second.list_pos;
-    assert(m_txs_list[old_pos] == it);
-    if (old_pos + 1 != m_txs_list.size()) {
-        // Unless we're deleting the last entry in m_txs_list, move the last
-        // entry to the position we're deleting.
-        auto it_last = m_txs_list.back();
-        m_txs_list[old_pos] = it_last;
-        it_last->second.list_pos = old_pos;
-    }
+    };
+    reindex(pos, std::nullopt);
 
     // Time spent in pool = difference between current and entry time.
     // Entry time is equal to expireTime earlier than entry's expiry.
     LogPrint(BCLog::TXPACKAGES, "   removed %s tx %s after %ds\n", txKind,
              txid.ToString(),
              Ticks<std::chrono::seconds>(NodeClock::now() + expireTime -
-                                         it->second.nTimeExpire));
-    m_txs_list.pop_back();
-
-    m_pool_txs.erase(it);
+                                         m_pool_txs[pos].nTimeExpire));
+
+    // Unless we're deleting the last entry, move the last entry to the
+    // position we're deleting.
+    const uint32_t last_pos = m_pool_txs.size() - 1;
+    if (pos != last_pos) {
+        reindex(last_pos, pos);
+        m_txid_to_pos[m_pool_txs[last_pos].tx->GetId()] = pos;
+        m_pool_txs[pos] = std::move(m_pool_txs[last_pos]);
+    }
+    m_pool_txs.pop_back();
     return 1;
 }
 
@@ -97,12 +139,11 @@ void TxPool::EraseForPeer(NodeId peer) {
     m_peer_work_set.erase(peer);
 
     int nErased = 0;
-    std::map<TxId, PoolTx>::iterator iter = m_pool_txs.begin();
-    while (iter != m_pool_txs.end()) {
-        // increment to avoid iterator becoming invalid after erasure
-        const auto &[txid, orphan] = *iter++;
-        if (orphan.fromPeer == peer) {
-            nErased += EraseTxNoLock(txid);
+    // Walk backwards, as erasing a transaction moves the last one in its
+    // place
+    for (size_t pos = m_pool_txs.size(); pos-- > 0;) {
+        if (m_pool_txs[pos].fromPeer == peer) {
+            nErased += EraseTxNoLock(m_pool_txs[pos].tx->GetId());
         }
     }
     if (nErased > 0) {
@@ -121,14 +162,14 @@ unsigned int TxPool::LimitTxs(unsigned int max_txs, FastRandomContext &rng) {
         // Sweep out expired orphan pool entries:
         int nErased = 0;
         auto nMinExpTime{nNow + expireTime - expireInterval};
-        std::map<TxId, PoolTx>::iterator iter = m_pool_txs.begin();
-        while (iter != m_pool_txs.end()) {
-            std::map<TxId, PoolTx>::iterator maybeErase = iter++;
-            if (maybeErase->second.nTimeExpire <= nNow) {
-                nErased += EraseTxNoLock(maybeErase->second.tx->GetId());
+        // Walk backwards, as erasing a transaction moves the last one in its
+        // place
+        for (size_t pos = m_pool_txs.size(); pos-- > 0;) {
+            if (m_pool_txs[pos].nTimeExpire <= nNow) {
+                nErased += EraseTxNoLock(m_pool_txs[pos].tx->GetId());
             } else {
                 nMinExpTime =
-                    std::min(maybeErase->second.nTimeExpire, nMinExpTime);
+                    std::min(m_pool_txs[pos].nTimeExpire, nMinExpTime);
             }
         }
         // Sweep again 5 minutes after the next entry that expires in order to
@@ -141,8 +182,8 @@ unsigned int TxPool::LimitTxs(unsigned int max_txs, FastRandomContext &rng) {
     }
     while (m_pool_txs.size() > max_txs) {
         // Evict a random tx:
-        size_t randompos = rng.randrange(m_txs_list.size());
-        EraseTxNoLock(m_txs_list[randompos]->first);
+        size_t randompos = rng.randrange(m_pool_txs.size());
+        EraseTxNoLock(m_pool_txs[randompos].tx->GetId());
         ++nEvicted;
     }
     return nEvicted;
@@ -151,29 +192,22 @@ unsigned int TxPool::LimitTxs(unsigned int max_txs, FastRandomContext &rng) {
 void TxPool::AddChildrenToWorkSet(const CTransaction &tx) {
     LOCK(m_mutex);
 
-    for (size_t i = 0; i < tx.vout.size(); i++) {
-        const auto it_by_prev =
-            m_outpoint_to_tx_it.find(COutPoint(tx.GetId(), i));
-        if (it_by_prev != m_outpoint_to_tx_it.end()) {
-            for (const auto &elem : it_by_prev->second) {
-                // Get this peer's work set, emplacing an empty set if it didn't
-                // exist
-                std::set<TxId> &work_set =
-                    m_peer_work_set.try_emplace(elem->second.fromPeer)
-                        .first->second;
-                // Add this tx to the work set
-                work_set.insert(elem->first);
-                LogPrint(BCLog::TXPACKAGES,
-                         "added %s tx %s to peer %d workset\n", txKind,
-                         tx.GetId().ToString(), elem->second.fromPeer);
-            }
+    for (const uint32_t pos : FindChildren(tx)) {
+        PoolTx &child = m_pool_txs[pos];
+        if (child.in_work_set) {
+            continue;
         }
+        // Add this tx to the work set of its peer
+        m_peer_work_set[child.fromPeer].push_back(child.tx->GetId());
+        child.in_work_set = true;
+        LogPrint(BCLog::TXPACKAGES, "added %s tx %s to peer %d workset\n",
+                 txKind, tx.GetId().ToString(), child.fromPeer);
     }
 }
 
 bool TxPool::HaveTx(const TxId &txid) const {
     LOCK(m_mutex);
-    return m_pool_txs.count(txid);
+    return m_txid_to_pos.count(txid);
 }
 
 CTransactionRef TxPool::GetTxToReconsider(NodeId peer) {
@@ -183,12 +217,16 @@ CTransactionRef TxPool::GetTxToReconsider(NodeId peer) {
     if (work_set_it != m_peer_work_set.end()) {
         auto &work_set = work_set_it->second;
         while (!work_set.empty()) {
-            TxId txid = *work_set.begin();
-            work_set.erase(work_set.begin());
-
-            const auto tx_it = m_pool_txs.find(txid);
-            if (tx_it != m_pool_txs.end()) {
-                return tx_it->second.tx;
+            TxId txid = work_set.back();
+            work_set.pop_back();
+
+            if (const auto pos = FindTx(txid)) {
+                PoolTx &entry = m_pool_txs[*pos];
+                // Skip the txs erased then added again since they were queued
+                if (entry.in_work_set) {
+                    entry.in_work_set = false;
+                    return entry.tx;
+                }
             }
         }
     }
@@ -216,16 +254,13 @@ void TxPool::EraseForBlock(const CBlock &block) {
 
         // Which pool entries must we evict?
         for (const auto &txin : tx.vin) {
-            auto itByPrev = m_outpoint_to_tx_it.find(txin.prevout);
-            if (itByPrev == m_outpoint_to_tx_it.end()) {
+            auto itByPrev = m_outpoint_to_children.find(txin.prevout);
+            if (itByPrev == m_outpoint_to_children.end()) {
                 continue;
             }
 
-            for (auto mi = itByPrev->second.begin();
-                 mi != itByPrev->second.end(); ++mi) {
-                const CTransaction &orphanTx = *(*mi)->second.tx;
-                const TxId &txid = orphanTx.GetId();
-                vTxErase.push_back(txid);
+            for (const uint32_t pos : itByPrev->second) {
+                vTxErase.push_back(m_pool_txs[pos].tx->GetId());
             }
         }
     }
@@ -248,42 +283,37 @@ TxPool::GetChildrenFromSamePeer(const CTransactionRef &parent,
                                 NodeId nodeid) const {
     LOCK(m_mutex);
 
-    // First construct a vector of iterators to ensure we do not return
-    // duplicates of the same tx and so we can sort by nTimeExpire.
-    std::vector<PoolTxMap::iterator> iters;
-
     // For each output, get all entries spending this prevout, filtering for
     // ones from the specified peer.
-    for (unsigned int i = 0; i < parent->vout.size(); i++) {
-        const auto it_by_prev =
-            m_outpoint_to_tx_it.find(COutPoint(parent->GetId(), i));
-        if (it_by_prev != m_outpoint_to_tx_it.end()) {
-            for (const auto &elem : it_by_prev->second) {
-                if (elem->second.fromPeer == nodeid) {
-                    iters.emplace_back(elem);
-                }
-            }
-        }
-    }
-
-    // Sort by address so that duplicates can be deleted. At the same time, sort
-    // so that more recent txs (which expire later) come first. Break ties
-    // based on address, as nTimeExpire is quantified in seconds and it is
+    std::vector<uint32_t> children{FindChildren(*parent)};
+    children.erase(std::remove_if(children.begin(), children.end(),
+                                  [&](uint32_t pos) {
+                                      return m_pool_txs[pos].fromPeer != nodeid;
+                                  }),
+                   children.end());
+
+    // Sort by position so that duplicates can be deleted. At the same time,
+    // sort so that more recent txs (which expire later) come first. Break ties
+    // based on position, as nTimeExpire is quantified in seconds and it is
     // possible for txs to have the same expiry.
-    std::sort(iters.begin(), iters.end(), [](const auto &lhs, const auto &rhs) {
-        if (lhs->second.nTimeExpire == rhs->second.nTimeExpire) {
-            return &(*lhs) < &(*rhs);
-        }
-        return lhs->second.nTimeExpire > rhs->second.nTimeExpire;
-    });
+    std::sort(children.begin(), children.end(),
+              [&](uint32_t lhs, uint32_t rhs) {
+                  const PoolTx &a = m_pool_txs[lhs];
+                  const PoolTx &b = m_pool_txs[rhs];
+                  if (a.nTimeExpire == b.nTimeExpire) {
+                      return lhs < rhs;
+                  }
+                  return a.nTimeExpire > b.nTimeExpire;
+              });
     // Erase duplicates
-    iters.erase(std::unique(iters.begin(), iters.end()), iters.end());
+    children.erase(std::unique(children.begin(), children.end()),
+                   children.end());
 
     // Convert to a vector of CTransactionRef
     std::vector<CTransactionRef> children_found;
-    children_found.reserve(iters.size());
-    for (const auto &child_iter : iters) {
-        children_found.emplace_back(child_iter->second.tx);
+    children_found.reserve(children.size());
+    for (const uint32_t pos : children) {
+        children_found.emplace_back(m_pool_txs[pos].tx);
     }
     return children_found;
 }
@@ -293,34 +323,30 @@ TxPool::GetChildrenFromDifferentPeer(const CTransactionRef &parent,
                                      NodeId nodeid) const {
     LOCK(m_mutex);
 
-    // First construct vector of iterators to ensure we do not return duplicates
-    // of the same tx.
-    std::vector<PoolTxMap::iterator> iters;
-
     // For each output, get all entries spending this prevout, filtering for
     // ones not from the specified peer.
-    for (unsigned int i = 0; i < parent->vout.size(); i++) {
-        const auto it_by_prev =
-            m_outpoint_to_tx_it.find(COutPoint(parent->GetId(), i));
-        if (it_by_prev != m_outpoint_to_tx_it.end()) {
-            for (const auto &elem : it_by_prev->second) {
-                if (elem->second.fromPeer != nodeid) {
-                    iters.emplace_back(elem);
-                }
-            }
-        }
-    }
-
-    // Erase duplicates
-    std::sort(iters.begin(), iters.end(), IteratorComparator());
-    iters.erase(std::unique(iters.begin(), iters.end()), iters.end());
-
-    // Convert iterators to pair<CTransactionRef, NodeId>
+    std::vector<uint32_t> children{FindChildren(*parent)};
+    children.erase(std::remove_if(children.begin(), children.end(),
+                                  [&](uint32_t pos) {
+                                      return m_pool_txs[pos].fromPeer == nodeid;
+                                  }),
+                   children.end());
+
+    // Erase duplicates, sorting by txid
+    std::sort(children.begin(), children.end(),
+              [&](uint32_t lhs, uint32_t rhs) {
+                  return m_pool_txs[lhs].tx->GetId() <
+                         m_pool_txs[rhs].tx->GetId();
+              });
+    children.erase(std::unique(children.begin(), children.end()),
+                   children.end());
+
+    // Convert positions to pair<CTransactionRef, NodeId>
     std::vector<std::pair<CTransactionRef, NodeId>> children_found;
-    children_found.reserve(iters.size());
-    for (const auto &child_iter : iters) {
-        children_found.emplace_back(child_iter->second.tx,
-                                    child_iter->second.fromPeer);
+    children_found.reserve(children.size());
+    for (const uint32_t pos : children) {
+        children_found.emplace_back(m_pool_txs[pos].tx,
+                                    m_pool_txs[pos].fromPeer);
     }
     return children_found;
 }
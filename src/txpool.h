@@ -6,14 +6,21 @@
 #define BITCOIN_TXPOOL_H
 
 #include <net.h>
+#include <prevector.h>
 #include <primitives/block.h>
 #include <primitives/transaction.h>
+#include <support/allocators/pool.h>
 #include <sync.h>
+#include <util/hasher.h>
 #include <util/time.h>
 
 #include <chrono>
-#include <map>
-#include <set>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 /**
  * A class to store and track transactions by peers.
@@ -105,35 +112,70 @@ protected:
         CTransactionRef tx;
         NodeId fromPeer;
         NodeSeconds nTimeExpire;
-        size_t list_pos;
+        //! Whether the tx is queued in the work set of its peer
+        bool in_work_set{false};
     };
 
     /**
-     * Map from txid to pool transaction record. Should be size constrained by
-     * calling LimitTxs() with the desired max size.
+     * The pool transactions, contiguous so they can be walked quickly and
+     * picked at random for eviction. Erasing a transaction moves the last one
+     * in its place. Should be size constrained by calling LimitTxs() with the
+     * desired max size.
      */
-    std::map<TxId, PoolTx> m_pool_txs GUARDED_BY(m_mutex);
+    std::vector<PoolTx> m_pool_txs GUARDED_BY(m_mutex);
 
-    /** Which peer provided the transactions that need to be reconsidered */
-    std::map<NodeId, std::set<TxId>> m_peer_work_set GUARDED_BY(m_mutex);
-
-    using PoolTxMap = decltype(m_pool_txs);
+    /**
+     * The hash maps below allocate their nodes from pools, so adding and
+     * erasing transactions mostly reuses the memory of the previous ones. The
+     * node size is not known, see CCoinsMap for the margin.
+     */
+    template <typename K, typename V>
+    using PoolAllocatorFor = PoolAllocator<
+        std::pair<const K, V>,
+        (sizeof(std::pair<const K, V>) + sizeof(void *) * 5 - 1) /
+            sizeof(void *) * sizeof(void *)>;
+    using TxIdMap = std::unordered_map<TxId, uint32_t, SaltedTxIdHasher,
+                                       std::equal_to<TxId>,
+                                       PoolAllocatorFor<TxId, uint32_t>>;
+    /** Positions in m_pool_txs of the transactions spending an outpoint */
+    using Children = prevector<2, uint32_t>;
+    using OutpointMap =
+        std::unordered_map<COutPoint, Children, SaltedOutpointHasher,
+                           std::equal_to<COutPoint>,
+                           PoolAllocatorFor<COutPoint, Children>>;
+
+    TxIdMap::allocator_type::ResourceType m_txid_resource GUARDED_BY(m_mutex);
+    OutpointMap::allocator_type::ResourceType
+        m_outpoint_resource GUARDED_BY(m_mutex);
+
+    /** Map from txid to the position of the transaction in m_pool_txs */
+    TxIdMap m_txid_to_pos GUARDED_BY(m_mutex){0, SaltedTxIdHasher{},
+                                              std::equal_to<TxId>{},
+                                              &m_txid_resource};
 
-    struct IteratorComparator {
-        template <typename I> bool operator()(const I &a, const I &b) const {
-            return a->first < b->first;
-        }
-    };
+    /**
+     * Index from the parents' COutPoint to the transactions spending them.
+     * Used to find the children of a transaction and the transactions
+     * conflicting with a block.
+     */
+    OutpointMap m_outpoint_to_children GUARDED_BY(m_mutex){
+        0, SaltedOutpointHasher{}, std::equal_to<COutPoint>{},
+        &m_outpoint_resource};
 
     /**
-     * Index from the parents' COutPoint into the m_pool_txs. Used to remove
-     * transactions from the m_pool_txs
+     * Which peer provided the transactions that need to be reconsidered. The
+     * txids of the transactions erased since they were queued are skipped.
      */
-    std::map<COutPoint, std::set<PoolTxMap ::iterator, IteratorComparator>>
-        m_outpoint_to_tx_it GUARDED_BY(m_mutex);
+    std::unordered_map<NodeId, std::vector<TxId>>
+        m_peer_work_set GUARDED_BY(m_mutex);
+
+    /** Position of a transaction in m_pool_txs, if it is in the pool */
+    std::optional<uint32_t> FindTx(const TxId &txid) const
+        EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
 
-    /** Pool transactions in vector for quick random eviction */
-    std::vector<PoolTxMap::iterator> m_txs_list GUARDED_BY(m_mutex);
+    /** Positions of the transactions spending any output of the parent */
+    std::vector<uint32_t> FindChildren(const CTransaction &parent) const
+        EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
 
     /** Erase a transaction by txid */
     int EraseTxNoLock(const TxId &txid) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
@@ -25,6 +25,19 @@ struct Uint256RadixKey {
         return base & mask.base;
     }
     operator size_t() const { return size_t(base.GetLow64()); }
+
+    friend bool operator==(const Uint256RadixKey &a,
+                           const Uint256RadixKey &b) {
+        return a.base == b.base;
+    }
+    friend bool operator!=(const Uint256RadixKey &a,
+                           const Uint256RadixKey &b) {
+        return a.base != b.base;
+    }
+    friend bool operator<(const Uint256RadixKey &a,
+                          const Uint256RadixKey &b) {
+        return a.base < b.base;
+    }
 };
 
 // The radix tree relies on sizeof to gather the bit length of the key
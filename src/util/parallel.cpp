@@ -0,0 +1,69 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include <util/parallel.h>
+
+#include <tinyformat.h>
+#include <util/thread.h>
+
+namespace util {
+
+WorkerPool g_worker_pool;
+
+void WorkerPool::Finish(Job &job, size_t ran) {
+    job.done += ran;
+    // No range is left to claim once a thread is done with the job
+    auto it = std::find(m_jobs.begin(), m_jobs.end(), &job);
+    if (it != m_jobs.end()) {
+        m_jobs.erase(it);
+    }
+    if (job.done == job.num_ranges && job.active == 0) {
+        m_done_cv.notify_all();
+    }
+}
+
+void WorkerPool::Loop() {
+    WAIT_LOCK(m_mutex, lock);
+    while (true) {
+        while (m_jobs.empty() && !m_request_stop) {
+            m_work_cv.wait(lock);
+        }
+        if (m_request_stop) {
+            return;
+        }
+        Job &job = *m_jobs.front();
+        job.active++;
+        size_t ran;
+        {
+            REVERSE_LOCK(lock);
+            ran = job.Run();
+        }
+        job.active--;
+        Finish(job, ran);
+    }
+}
+
+void WorkerPool::StartWorkerThreads(int threads_num, const std::string &name) {
+    WITH_LOCK(m_mutex, m_request_stop = false);
+    assert(m_worker_threads.empty());
+    for (int n = 0; n < threads_num; n++) {
+        const std::string thread_name{strprintf("%s.%d", name, n)};
+        m_worker_threads.emplace_back([this, thread_name] {
+            util::TraceThread(thread_name.c_str(), [this] { Loop(); });
+        });
+    }
+    m_num_threads = m_worker_threads.size();
+}
+
+void WorkerPool::StopWorkerThreads() {
+    m_num_threads = 0;
+    WITH_LOCK(m_mutex, m_request_stop = true);
+    m_work_cv.notify_all();
+    for (std::thread &thread : m_worker_threads) {
+        thread.join();
+    }
+    m_worker_threads.clear();
+}
+
+} // namespace util
@@ -0,0 +1,156 @@
+// Copyright (c) 2024 The Bitcoin developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef BITCOIN_UTIL_PARALLEL_H
+#define BITCOIN_UTIL_PARALLEL_H
+
+#include <sync.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace util {
+
+/**
+ * Call func(begin, end) on contiguous ranges covering [0, count), each from
+ * its own thread, using at most max_threads threads including the calling
+ * one. Returns once all the ranges are processed.
+ *
+ * This is meant for occasional bursts of independent work, like loading the
+ * block index at startup, the threads are not reused. Work done repeatedly,
+ * e.g. for each block, should use a WorkerPool instead. func must not throw.
+ */
+template <typename Func>
+void ParallelForRanges(size_t count, size_t max_threads, const Func &func) {
+    if (count == 0) {
+        return;
+    }
+    const size_t num_threads = std::clamp<size_t>(max_threads, 1, count);
+    const size_t range_size = (count + num_threads - 1) / num_threads;
+
+    std::vector<std::thread> threads;
+    threads.reserve(num_threads - 1);
+    for (size_t begin = range_size; begin < count; begin += range_size) {
+        const size_t end = std::min(begin + range_size, count);
+        threads.emplace_back([&func, begin, end] { func(begin, end); });
+    }
+    func(0, std::min(range_size, count));
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+/**
+ * Persistent pool of worker threads, for the independent work done repeatedly
+ * on the validation paths, so no thread is created for each call.
+ *
+ * The thread calling ForRanges() processes ranges too, and does all the work
+ * itself if the pool is not started or its threads are busy with the work of
+ * other callers. So the result never depends on the pool size, which only
+ * bounds the parallelism.
+ */
+class WorkerPool {
+private:
+    /** The ranges of one ForRanges() call, claimed one at a time */
+    struct Job {
+        const std::function<void(size_t, size_t)> &func;
+        const size_t count;
+        const size_t range_size;
+        const size_t num_ranges;
+        std::atomic<size_t> next_range{0};
+        //! Number of ranges processed, guarded by the pool mutex
+        size_t done{0};
+        //! Number of workers running the job, guarded by the pool mutex
+        size_t active{0};
+
+        /** Process ranges until none is left, return how many were */
+        size_t Run() {
+            size_t ran{0};
+            for (size_t range = next_range++; range < num_ranges;
+                 range = next_range++) {
+                const size_t begin{range * range_size};
+                func(begin, std::min(begin + range_size, count));
+                ran++;
+            }
+            return ran;
+        }
+    };
+
+    Mutex m_mutex;
+    std::condition_variable m_work_cv;
+    std::condition_variable m_done_cv;
+    //! Jobs which might still have unclaimed ranges
+    std::deque<Job *> m_jobs GUARDED_BY(m_mutex);
+    bool m_request_stop GUARDED_BY(m_mutex){false};
+    std::vector<std::thread> m_worker_threads;
+    //! Size of m_worker_threads, which ForRanges() callers may read while the
+    //! pool is started or stopped
+    std::atomic<size_t> m_num_threads{0};
+
+    void Loop() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    /** Account for ranges processed by a thread done with the job */
+    void Finish(Job &job, size_t ran) EXCLUSIVE_LOCKS_REQUIRED(m_mutex);
+
+public:
+    /** Start the worker threads, named <name>.<n> */
+    void StartWorkerThreads(int threads_num, const std::string &name)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+    void StopWorkerThreads() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex);
+
+    /** Number of threads which can work on a job, including the caller */
+    size_t GetMaxParallelism() const { return m_num_threads + 1; }
+
+    /**
+     * Like ParallelForRanges(), but using the worker threads. func is called
+     * from at most max_threads threads including the calling one, and must
+     * not throw.
+     */
+    template <typename Func>
+    void ForRanges(size_t count, size_t max_threads, const Func &func)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        if (count == 0) {
+            return;
+        }
+        const size_t num_ranges{
+            std::clamp<size_t>(max_threads, 1,
+                               std::min(count, GetMaxParallelism()))};
+        if (num_ranges == 1) {
+            func(0, count);
+            return;
+        }
+        const std::function<void(size_t, size_t)> range_func{func};
+        const size_t range_size{(count + num_ranges - 1) / num_ranges};
+        Job job{range_func, count, range_size,
+                (count + range_size - 1) / range_size};
+        {
+            LOCK(m_mutex);
+            m_jobs.push_back(&job);
+        }
+        m_work_cv.notify_all();
+
+        const size_t ran{job.Run()};
+
+        WAIT_LOCK(m_mutex, lock);
+        Finish(job, ran);
+        // The workers might still be running the ranges they claimed, and the
+        // job must outlive them.
+        m_done_cv.wait(lock, [&]() EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+            return job.done == job.num_ranges && job.active == 0;
+        });
+    }
+};
+
+/** Pool shared by the callers of the validation paths */
+extern WorkerPool g_worker_pool;
+
+} // namespace util
+
+#endif // BITCOIN_UTIL_PARALLEL_H
@@ -45,6 +45,7 @@
 #include <random.h>
 #include <reverse_iterator.h>
 #include <script/script.h>
+#include <script/script_stack.h>
 #include <script/scriptcache.h>
 #include <script/sigcache.h>
 #include <shutdown.h>
@@ -1720,11 +1721,15 @@ void UpdateCoins(CCoinsViewCache &view, const CTransaction &tx, CTxUndo &txundo,
 }
 
 bool CScriptCheck::operator()() {
+    // The checks are run by a few threads, each reusing its own stacks for all
+    // the inputs it verifies
+    static thread_local ScriptStackArena t_arena;
+
     const CScript &scriptSig = ptxTo->vin[nIn].scriptSig;
     if (!VerifyScript(scriptSig, m_tx_out.scriptPubKey, nFlags,
                       CachingTransactionSignatureChecker(
                           ptxTo, nIn, m_tx_out.nValue, cacheStore, txdata),
-                      metrics, &error)) {
+                      metrics, t_arena, &error)) {
         return false;
     }
     if ((pTxLimitSigChecks &&
@@ -2334,6 +2339,31 @@ bool Chainstate::ConnectBlock(const CBlock &block, BlockValidationState &state,
                              "tx-duplicate");
     }
 
+    // Load the coins spent by the block with batched database reads, rather
+    // than one read per input as the transactions are checked. The coins
+    // created by the block itself are only added to the view as its
+    // transactions are connected, so looking them up would be wasted reads
+    // that always miss.
+    {
+        std::unordered_set<TxId, SaltedTxIdHasher> block_txids;
+        block_txids.reserve(block.vtx.size());
+        for (const auto &ptx : block.vtx) {
+            block_txids.insert(ptx->GetId());
+        }
+        std::vector<COutPoint> prevouts;
+        for (const auto &ptx : block.vtx) {
+            if (ptx->IsCoinBase()) {
+                continue;
+            }
+            for (const CTxIn &txin : ptx->vin) {
+                if (block_txids.count(txin.prevout.GetTxId()) == 0) {
+                    prevouts.push_back(txin.prevout);
+                }
+            }
+        }
+        view.PrefetchCoins(prevouts);
+    }
+
     size_t txIndex = 0;
     // nSigChecksRet may be accurate (found in cache) or 0 (checks were
     // deferred into vChecks).
@@ -13,94 +13,353 @@
 #include <primitives/transaction.h>
 #include <scheduler.h>
 
+#include <boost/core/demangle.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
 #include <future>
 #include <tuple>
+#include <typeinfo>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 const std::string RemovalReasonToString(const MemPoolRemovalReason &r) noexcept;
 
+namespace {
+/**
+ * Ordered queue of the background callbacks of one subscriber.
+ *
+ * The callbacks are executed one at a time by the scheduler threads, and the
+ * queue is rescheduled after each of them so a subscriber with a large backlog
+ * or slow callbacks can't delay the delivery to the other subscribers. The
+ * scheduled tasks keep a reference to the queue, so it can safely outlive the
+ * registration of its subscriber.
+ */
+class SubscriberQueue : public std::enable_shared_from_this<SubscriberQueue> {
+private:
+    CScheduler &m_scheduler;
+    mutable Mutex m_mutex;
+    struct Task {
+        std::function<void()> func;
+        std::chrono::steady_clock::time_point enqueued;
+    };
+    std::deque<Task> m_pending GUARDED_BY(m_mutex);
+    //! Whether a task is scheduled to process the queue
+    bool m_scheduled GUARDED_BY(m_mutex){false};
+    //! The subscriber, null once unregistered
+    std::shared_ptr<CValidationInterface> m_callbacks GUARDED_BY(m_mutex);
+
+    uint64_t m_processed GUARDED_BY(m_mutex){0};
+    std::chrono::microseconds m_total_latency GUARDED_BY(m_mutex){0};
+    std::chrono::microseconds m_max_latency GUARDED_BY(m_mutex){0};
+
+    void Schedule() {
+        m_scheduler.schedule(
+            [self = shared_from_this()] { self->ProcessOne(); },
+            std::chrono::steady_clock::now());
+    }
+
+    /**
+     * Run the first pending callback. Return whether there are more callbacks
+     * to run.
+     */
+    bool RunFirst() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        Task task;
+        {
+            LOCK(m_mutex);
+            if (m_pending.empty()) {
+                return false;
+            }
+            task = std::move(m_pending.front());
+            m_pending.pop_front();
+        }
+
+        task.func();
+
+        const auto latency =
+            std::chrono::duration_cast<std::chrono::microseconds>(
+                std::chrono::steady_clock::now() - task.enqueued);
+        LOCK(m_mutex);
+        m_processed++;
+        m_total_latency += latency;
+        m_max_latency = std::max(m_max_latency, latency);
+        return !m_pending.empty();
+    }
+
+    void ProcessOne() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        if (RunFirst()) {
+            // Give the other subscribers a chance to run before the next
+            // callback of this one.
+            Schedule();
+            return;
+        }
+        LOCK(m_mutex);
+        // A callback might have been added since RunFirst() returned
+        if (m_pending.empty()) {
+            m_scheduled = false;
+        } else {
+            Schedule();
+        }
+    }
+
+public:
+    const std::string m_name;
+
+    SubscriberQueue(CScheduler &scheduler,
+                    std::shared_ptr<CValidationInterface> callbacks,
+                    std::string name)
+        : m_scheduler(scheduler), m_callbacks(std::move(callbacks)),
+          m_name(std::move(name)) {}
+
+    std::shared_ptr<CValidationInterface> GetCallbacks() const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        return WITH_LOCK(m_mutex, return m_callbacks);
+    }
+
+    void SetCallbacks(std::shared_ptr<CValidationInterface> callbacks)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        {
+            LOCK(m_mutex);
+            std::swap(callbacks, m_callbacks);
+        }
+        // The previous subscriber is released outside of the lock
+    }
+
+    void Add(std::function<void()> func) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        LOCK(m_mutex);
+        m_pending.push_back(
+            {std::move(func), std::chrono::steady_clock::now()});
+        if (!m_scheduled) {
+            m_scheduled = true;
+            Schedule();
+        }
+    }
+
+    /**
+     * Run all the pending callbacks on the calling thread. Must be called
+     * after the CScheduler has no remaining processing threads.
+     */
+    void Flush() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        assert(!m_scheduler.AreThreadsServicingQueue());
+        while (RunFirst()) {
+        }
+    }
+
+    ValidationInterfaceQueueStats GetStats() const
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        LOCK(m_mutex);
+        return {m_name, m_pending.size(), m_processed, m_total_latency,
+                m_max_latency};
+    }
+
+    size_t CallbacksPending() const EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        return WITH_LOCK(m_mutex, return m_pending.size());
+    }
+};
+} // namespace
+
 /**
- * MainSignalsImpl manages a list of shared_ptr<CValidationInterface>
- * callbacks.
+ * MainSignalsImpl manages the registered CValidationInterface subscribers.
  *
- * A std::unordered_map is used to track what callbacks are currently
- * registered, and a std::list is used to store the callbacks that are
- * currently registered as well as any callbacks that are just unregistered
- * and about to be deleted when they are done executing.
+ * Each subscriber gets its own SubscriberQueue for the callbacks which run in
+ * the background, so the subscribers are notified independently from each
+ * other. A std::unordered_map is used to track the queues of the subscribers
+ * that are currently registered, while m_queues also tracks the queues of
+ * the unregistered subscribers that still have some callbacks to process.
  */
 class MainSignalsImpl {
 private:
+    CScheduler &m_scheduler;
     Mutex m_mutex;
-    //! List entries consist of a callback pointer and reference count. The
-    //! count is equal to the number of current executions of that entry, plus 1
-    //! if it's registered. It cannot be 0 because that would imply it is
-    //! unregistered and also not being executed (so shouldn't exist).
-    struct ListEntry {
-        std::shared_ptr<CValidationInterface> callbacks;
-        int count = 1;
-    };
-    std::list<ListEntry> m_list GUARDED_BY(m_mutex);
-    std::unordered_map<CValidationInterface *, std::list<ListEntry>::iterator>
+    std::unordered_map<CValidationInterface *, std::shared_ptr<SubscriberQueue>>
         m_map GUARDED_BY(m_mutex);
+    //! Queue used for the functions to call when no subscriber is registered
+    const std::shared_ptr<SubscriberQueue> m_default_queue;
+    std::vector<std::weak_ptr<SubscriberQueue>> m_queues GUARDED_BY(m_mutex);
 
-public:
-    // We are not allowed to assume the scheduler only runs in one thread,
-    // but must ensure all callbacks happen in-order, so we end up creating
-    // our own queue here :(
-    SingleThreadedSchedulerClient m_schedulerClient;
+    static std::string GetName(const CValidationInterface &callbacks) {
+        return boost::core::demangle(typeid(callbacks).name());
+    }
 
+    /** Queues of the subscribers currently registered */
+    std::vector<std::shared_ptr<SubscriberQueue>> GetRegisteredQueues()
+        EXCLUSIVE_LOCKS_REQUIRED(m_mutex) {
+        std::vector<std::shared_ptr<SubscriberQueue>> queues;
+        queues.reserve(m_map.size());
+        for (const auto &entry : m_map) {
+            queues.push_back(entry.second);
+        }
+        return queues;
+    }
+
+    /** All the queues that still exist, including the default one */
+    std::vector<std::shared_ptr<SubscriberQueue>> GetAllQueues()
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        std::vector<std::shared_ptr<SubscriberQueue>> queues{m_default_queue};
+        LOCK(m_mutex);
+        for (const auto &weak_queue : m_queues) {
+            if (auto queue = weak_queue.lock()) {
+                queues.push_back(std::move(queue));
+            }
+        }
+        return queues;
+    }
+
+public:
     explicit MainSignalsImpl(CScheduler &scheduler LIFETIMEBOUND)
-        : m_schedulerClient(scheduler) {}
+        : m_scheduler(scheduler),
+          m_default_queue(std::make_shared<SubscriberQueue>(
+              scheduler, nullptr, "CallFunctionInValidationInterfaceQueue")) {}
 
     void Register(std::shared_ptr<CValidationInterface> callbacks)
         EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
         LOCK(m_mutex);
-        auto inserted = m_map.emplace(callbacks.get(), m_list.end());
-        if (inserted.second) {
-            inserted.first->second = m_list.emplace(m_list.end());
+        auto it = m_map.find(callbacks.get());
+        if (it != m_map.end()) {
+            it->second->SetCallbacks(std::move(callbacks));
+            return;
         }
-        inserted.first->second->callbacks = std::move(callbacks);
+
+        // Forget about the queues that are gone
+        m_queues.erase(std::remove_if(m_queues.begin(), m_queues.end(),
+                                      [](const auto &weak_queue) {
+                                          return weak_queue.expired();
+                                      }),
+                       m_queues.end());
+
+        const std::string name = GetName(*callbacks);
+        CValidationInterface *key = callbacks.get();
+        auto queue = std::make_shared<SubscriberQueue>(
+            m_scheduler, std::move(callbacks), name);
+        m_queues.push_back(queue);
+        m_map.emplace(key, std::move(queue));
     }
 
     void Unregister(CValidationInterface *callbacks)
         EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
-        LOCK(m_mutex);
-        auto it = m_map.find(callbacks);
-        if (it != m_map.end()) {
-            if (!--it->second->count) {
-                m_list.erase(it->second);
+        std::shared_ptr<SubscriberQueue> queue;
+        {
+            LOCK(m_mutex);
+            auto it = m_map.find(callbacks);
+            if (it == m_map.end()) {
+                return;
             }
+            queue = std::move(it->second);
             m_map.erase(it);
         }
+        // The callbacks still pending for this subscriber will be skipped
+        queue->SetCallbacks(nullptr);
     }
 
-    //! Clear unregisters every previously registered callback, erasing every
-    //! map entry. After this call, the list may still contain callbacks that
-    //! are currently executing, but it will be cleared when they are done
-    //! executing.
+    //! Clear unregisters every previously registered callback. The callbacks
+    //! that are currently executing keep a reference to their subscriber until
+    //! they are done.
     void Clear() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
-        LOCK(m_mutex);
-        for (const auto &entry : m_map) {
-            if (!--entry.second->count) {
-                m_list.erase(entry.second);
-            }
+        std::vector<std::shared_ptr<SubscriberQueue>> queues;
+        {
+            LOCK(m_mutex);
+            queues = GetRegisteredQueues();
+            m_map.clear();
+        }
+        for (const auto &queue : queues) {
+            queue->SetCallbacks(nullptr);
         }
-        m_map.clear();
     }
 
+    /** Call f synchronously for each registered subscriber */
     template <typename F>
     void Iterate(F &&f) EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
-        WAIT_LOCK(m_mutex, lock);
-        for (auto it = m_list.begin(); it != m_list.end();) {
-            ++it->count;
-            {
-                REVERSE_LOCK(lock);
-                f(*it->callbacks);
+        std::vector<std::shared_ptr<SubscriberQueue>> queues =
+            WITH_LOCK(m_mutex, return GetRegisteredQueues());
+        for (const auto &queue : queues) {
+            if (auto callbacks = queue->GetCallbacks()) {
+                f(*callbacks);
             }
-            it = --it->count ? std::next(it) : m_list.erase(it);
         }
     }
+
+    /**
+     * Queue a call to f for each registered subscriber, it will be skipped if
+     * the subscriber is unregistered in the meantime.
+     */
+    void Enqueue(std::function<void(CValidationInterface &)> f)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        auto shared_f =
+            std::make_shared<const std::function<void(CValidationInterface &)>>(
+                std::move(f));
+        LOCK(m_mutex);
+        for (const auto &entry : m_map) {
+            SubscriberQueue *queue = entry.second.get();
+            queue->Add([queue, shared_f] {
+                if (auto callbacks = queue->GetCallbacks()) {
+                    (*shared_f)(*callbacks);
+                }
+            });
+        }
+    }
+
+    /**
+     * Queue a call to func once all the callbacks queued so far for all the
+     * registered subscribers are done.
+     */
+    void EnqueueBarrier(std::function<void()> func)
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        LOCK(m_mutex);
+        std::vector<std::shared_ptr<SubscriberQueue>> queues =
+            GetRegisteredQueues();
+        if (queues.empty()) {
+            m_default_queue->Add(std::move(func));
+            return;
+        }
+
+        // The last queue to reach the barrier calls func
+        auto remaining = std::make_shared<std::atomic<size_t>>(queues.size());
+        auto shared_func =
+            std::make_shared<const std::function<void()>>(std::move(func));
+        for (const auto &queue : queues) {
+            queue->Add([remaining, shared_func] {
+                if (--*remaining == 0) {
+                    (*shared_func)();
+                }
+            });
+        }
+    }
+
+    void Flush() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        // Running the callbacks of a queue can queue more callbacks for the
+        // others, e.g. via a barrier.
+        bool should_continue = true;
+        while (should_continue) {
+            should_continue = false;
+            for (const auto &queue : GetAllQueues()) {
+                queue->Flush();
+            }
+            for (const auto &queue : GetAllQueues()) {
+                should_continue |= queue->CallbacksPending() > 0;
+            }
+        }
+    }
+
+    size_t CallbacksPending() EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        size_t pending = 0;
+        for (const auto &queue : GetAllQueues()) {
+            pending = std::max(pending, queue->CallbacksPending());
+        }
+        return pending;
+    }
+
+    std::vector<ValidationInterfaceQueueStats> GetStats()
+        EXCLUSIVE_LOCKS_REQUIRED(!m_mutex) {
+        std::vector<ValidationInterfaceQueueStats> stats;
+        for (const auto &queue :
+             WITH_LOCK(m_mutex, return GetRegisteredQueues())) {
+            stats.push_back(queue->GetStats());
+        }
+        return stats;
+    }
 };
 
 static CMainSignals g_signals;
@@ -116,7 +375,7 @@ void CMainSignals::UnregisterBackgroundSignalScheduler() {
 
 void CMainSignals::FlushBackgroundCallbacks() {
     if (m_internals) {
-        m_internals->m_schedulerClient.EmptyQueue();
+        m_internals->Flush();
     }
 }
 
@@ -124,7 +383,14 @@ size_t CMainSignals::CallbacksPending() {
     if (!m_internals) {
         return 0;
     }
-    return m_internals->m_schedulerClient.CallbacksPending();
+    return m_internals->CallbacksPending();
+}
+
+std::vector<ValidationInterfaceQueueStats> CMainSignals::GetQueueStats() {
+    if (!m_internals) {
+        return {};
+    }
+    return m_internals->GetStats();
 }
 
 CMainSignals &GetMainSignals() {
@@ -164,7 +430,7 @@ void UnregisterAllValidationInterfaces() {
 }
 
 void CallFunctionInValidationInterfaceQueue(std::function<void()> func) {
-    g_signals.m_internals->m_schedulerClient.AddToProcessQueue(std::move(func));
+    g_signals.m_internals->EnqueueBarrier(std::move(func));
 }
 
 void SyncWithValidationInterfaceQueue() {
@@ -183,9 +449,9 @@ void SyncWithValidationInterfaceQueue() {
     do {                                                                       \
         auto local_name = (name);                                              \
         LOG_EVENT("Enqueuing " fmt, local_name, __VA_ARGS__);                  \
-        m_internals->m_schedulerClient.AddToProcessQueue([=] {                 \
+        m_internals->Enqueue([=](CValidationInterface &callbacks) {            \
             LOG_EVENT(fmt, local_name, __VA_ARGS__);                           \
-            event();                                                           \
+            event(callbacks);                                                  \
         });                                                                    \
     } while (0)
 
@@ -199,10 +465,9 @@ void CMainSignals::UpdatedBlockTip(const CBlockIndex *pindexNew,
     // for the caller to invoke this signal in the same critical section where
     // the chain is updated
 
-    auto event = [pindexNew, pindexFork, fInitialDownload, this] {
-        m_internals->Iterate([&](CValidationInterface &callbacks) {
-            callbacks.UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
-        });
+    auto event = [pindexNew, pindexFork,
+                  fInitialDownload](CValidationInterface &callbacks) {
+        callbacks.UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
     };
     ENQUEUE_AND_LOG_EVENT(
         event, "%s: new block hash=%s fork block hash=%s (in IBD=%s)", __func__,
@@ -215,11 +480,9 @@ void CMainSignals::TransactionAddedToMempool(
     const CTransactionRef &tx,
     std::shared_ptr<const std::vector<Coin>> spent_coins,
     uint64_t mempool_sequence) {
-    auto event = [tx, spent_coins, mempool_sequence, this] {
-        m_internals->Iterate([&](CValidationInterface &callbacks) {
-            callbacks.TransactionAddedToMempool(tx, spent_coins,
-                                                mempool_sequence);
-        });
+    auto event = [tx, spent_coins,
+                  mempool_sequence](CValidationInterface &callbacks) {
+        callbacks.TransactionAddedToMempool(tx, spent_coins, mempool_sequence);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: txid=%s", __func__,
                           tx->GetHash().ToString());
@@ -228,11 +491,9 @@ void CMainSignals::TransactionAddedToMempool(
 void CMainSignals::TransactionRemovedFromMempool(const CTransactionRef &tx,
                                                  MemPoolRemovalReason reason,
                                                  uint64_t mempool_sequence) {
-    auto event = [tx, reason, mempool_sequence, this] {
-        m_internals->Iterate([&](CValidationInterface &callbacks) {
-            callbacks.TransactionRemovedFromMempool(tx, reason,
-                                                    mempool_sequence);
-        });
+    auto event = [tx, reason,
+                  mempool_sequence](CValidationInterface &callbacks) {
+        callbacks.TransactionRemovedFromMempool(tx, reason, mempool_sequence);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: txid=%s reason=%s", __func__,
                           tx->GetHash().ToString(),
@@ -241,10 +502,8 @@ void CMainSignals::TransactionRemovedFromMempool(const CTransactionRef &tx,
 
 void CMainSignals::BlockConnected(const std::shared_ptr<const CBlock> &pblock,
                                   const CBlockIndex *pindex) {
-    auto event = [pblock, pindex, this] {
-        m_internals->Iterate([&](CValidationInterface &callbacks) {
-            callbacks.BlockConnected(pblock, pindex);
-        });
+    auto event = [pblock, pindex](CValidationInterface &callbacks) {
+        callbacks.BlockConnected(pblock, pindex);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s block height=%d", __func__,
                           pblock->GetHash().ToString(), pindex->nHeight);
@@ -252,20 +511,16 @@ void CMainSignals::BlockConnected(const std::shared_ptr<const CBlock> &pblock,
 
 void CMainSignals::BlockDisconnected(
     const std::shared_ptr<const CBlock> &pblock, const CBlockIndex *pindex) {
-    auto event = [pblock, pindex, this] {
-        m_internals->Iterate([&](CValidationInterface &callbacks) {
-            callbacks.BlockDisconnected(pblock, pindex);
-        });
+    auto event = [pblock, pindex](CValidationInterface &callbacks) {
+        callbacks.BlockDisconnected(pblock, pindex);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s", __func__,
                           pblock->GetHash().ToString());
 }
 
 void CMainSignals::ChainStateFlushed(const CBlockLocator &locator) {
-    auto event = [locator, this] {
-        m_internals->Iterate([&](CValidationInterface &callbacks) {
-            callbacks.ChainStateFlushed(locator);
-        });
+    auto event = [locator](CValidationInterface &callbacks) {
+        callbacks.ChainStateFlushed(locator);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s", __func__,
                           locator.IsNull() ? "null"
@@ -290,10 +545,8 @@ void CMainSignals::NewPoWValidBlock(
 }
 
 void CMainSignals::BlockFinalized(const CBlockIndex *pindex) {
-    auto event = [pindex, this] {
-        m_internals->Iterate([&](CValidationInterface &callbacks) {
-            callbacks.BlockFinalized(pindex);
-        });
+    auto event = [pindex](CValidationInterface &callbacks) {
+        callbacks.BlockFinalized(pindex);
     };
     ENQUEUE_AND_LOG_EVENT(event, "%s: block hash=%s", __func__,
                           pindex ? pindex->GetBlockHash().ToString() : "null");
@@ -10,8 +10,13 @@
 #include <primitives/transaction.h> // CTransaction(Ref)
 #include <sync.h>
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <string>
+#include <vector>
 
 class BlockValidationState;
 class CBlock;
@@ -77,7 +82,8 @@ void SyncWithValidationInterfaceQueue() LOCKS_EXCLUDED(cs_main);
  * UpdatedBlockTip() callback may depend on an operation performed in
  * the BlockConnected() callback without worrying about explicit
  * synchronization. No ordering should be assumed across
- * ValidationInterface() subscribers.
+ * ValidationInterface() subscribers: each of them has its own queue of
+ * callbacks, so a slow subscriber doesn't delay the others.
  */
 class CValidationInterface {
 protected:
@@ -197,6 +203,19 @@ protected:
     friend class ValidationInterfaceTest;
 };
 
+/** Statistics about the background callbacks of a subscriber */
+struct ValidationInterfaceQueueStats {
+    //! Type of the subscriber
+    std::string name;
+    //! Number of callbacks waiting to be processed
+    size_t pending;
+    //! Number of callbacks processed so far
+    uint64_t processed;
+    //! Total and maximum time between queuing and completing a callback
+    std::chrono::microseconds total_latency;
+    std::chrono::microseconds max_latency;
+};
+
 class MainSignalsImpl;
 class CMainSignals {
 private:
@@ -223,8 +242,15 @@ public:
     /** Call any remaining callbacks on the calling thread */
     void FlushBackgroundCallbacks();
 
+    /**
+     * Largest number of background callbacks waiting to be processed for a
+     * single subscriber.
+     */
     size_t CallbacksPending();
 
+    /** Statistics about the callbacks of each registered subscriber */
+    std::vector<ValidationInterfaceQueueStats> GetQueueStats();
+
     void UpdatedBlockTip(const CBlockIndex *, const CBlockIndex *,
                          bool fInitialDownload);
     void TransactionAddedToMempool(const CTransactionRef &,
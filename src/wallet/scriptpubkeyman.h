@@ -780,7 +780,9 @@ public:
 
     const WalletDescriptor GetWalletDescriptor() const
         EXCLUSIVE_LOCKS_REQUIRED(cs_desc_man);
-    const std::vector<CScript> GetScriptPubKeys() const;
+    const std::vector<CScript>
+    GetScriptPubKeys(int32_t minimum_index = 0) const;
+    int32_t GetEndRange() const;
 };
 
 #endif // BITCOIN_WALLET_SCRIPTPUBKEYMAN_H
@@ -406,9 +406,8 @@ static int64_t AddTx(ChainstateManager &chainman, CWallet &wallet,
     CBlockIndex *block = nullptr;
     if (blockTime > 0) {
         LOCK(cs_main);
-        auto inserted = chainman.BlockIndex().emplace(
-            std::piecewise_construct, std::make_tuple(GetRandHash()),
-            std::make_tuple());
+        auto inserted =
+            chainman.BlockIndex().try_emplace(BlockHash{GetRandHash()});
         assert(inserted.second);
         const BlockHash &hash = inserted.first->first;
         block = &inserted.first->second;
@@ -5,6 +5,7 @@
 
 #include <wallet/wallet.h>
 
+#include <blockfilter.h>
 #include <chain.h>
 #include <chainparams.h>
 #include <common/args.h>
@@ -1683,6 +1684,70 @@ int64_t CWallet::RescanFromTime(int64_t startTime,
     return startTime;
 }
 
+namespace {
+/**
+ * Matches the wallet's scriptPubKeys against BIP 157 block filters so that
+ * rescans only fetch and deserialize the blocks that may be relevant.
+ * Only descriptor wallets are supported, as their script set can be fully
+ * enumerated and kept up to date as the descriptor ranges get topped up.
+ */
+class FastWalletRescanFilter {
+public:
+    explicit FastWalletRescanFilter(const CWallet &wallet) : m_wallet(wallet) {
+        // Fast rescanning via block filters is only supported by descriptor
+        // wallets right now.
+        assert(m_wallet.IsWalletFlagSet(WALLET_FLAG_DESCRIPTORS));
+
+        // Create the initial filter with scripts from all ScriptPubKeyMans.
+        for (auto spkm : m_wallet.GetAllScriptPubKeyMans()) {
+            auto desc_spkm{dynamic_cast<DescriptorScriptPubKeyMan *>(spkm)};
+            assert(desc_spkm != nullptr);
+            AddScriptPubKeys(desc_spkm);
+            // Save each range descriptor's end for possible future filter
+            // updates.
+            if (desc_spkm->IsHDEnabled()) {
+                m_last_range_ends.emplace(desc_spkm->GetID(),
+                                          desc_spkm->GetEndRange());
+            }
+        }
+    }
+
+    void UpdateIfNeeded() {
+        // Repopulate the filter with new scripts if a top-up has happened
+        // since the last iteration.
+        for (auto &[desc_spkm_id, last_range_end] : m_last_range_ends) {
+            auto desc_spkm{dynamic_cast<DescriptorScriptPubKeyMan *>(
+                m_wallet.GetScriptPubKeyMan(desc_spkm_id))};
+            assert(desc_spkm != nullptr);
+            int32_t current_range_end{desc_spkm->GetEndRange()};
+            if (current_range_end > last_range_end) {
+                AddScriptPubKeys(desc_spkm, last_range_end);
+                last_range_end = current_range_end;
+            }
+        }
+    }
+
+    std::optional<bool> MatchesBlock(const BlockHash &block_hash) const {
+        return m_wallet.chain().blockFilterMatchesAny(
+            BlockFilterType::BASIC, block_hash, m_filter_set);
+    }
+
+private:
+    const CWallet &m_wallet;
+    /** Map of descriptor ScriptPubKeyMan IDs to their last range end. */
+    std::map<uint256, int32_t> m_last_range_ends;
+    GCSFilter::ElementSet m_filter_set;
+
+    void AddScriptPubKeys(const DescriptorScriptPubKeyMan *desc_spkm,
+                          int32_t last_range_end = 0) {
+        for (const auto &script_pub_key :
+             desc_spkm->GetScriptPubKeys(last_range_end)) {
+            m_filter_set.emplace(script_pub_key.begin(), script_pub_key.end());
+        }
+    }
+};
+} // namespace
+
 /**
  * Scan the block chain (starting in start_block) for transactions from or to
  * us. If fUpdate is true, found transactions that already exist in the wallet
@@ -1716,8 +1781,16 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(
     BlockHash block_hash = start_block;
     ScanResult result;
 
-    WalletLogPrintf("Rescan started from block %s...\n",
-                    start_block.ToString());
+    std::unique_ptr<FastWalletRescanFilter> fast_rescan_filter;
+    if (IsWalletFlagSet(WALLET_FLAG_DESCRIPTORS) &&
+        chain().hasBlockFilterIndex(BlockFilterType::BASIC)) {
+        fast_rescan_filter = std::make_unique<FastWalletRescanFilter>(*this);
+    }
+
+    WalletLogPrintf("Rescan started from block %s... (%s)\n",
+                    start_block.ToString(),
+                    fast_rescan_filter ? "fast variant using block filters"
+                                       : "slow variant inspecting all blocks");
 
     fAbortRescan = false;
     // Show rescan progress in GUI as dialog or on splashscreen, if -rescan on
@@ -1755,11 +1828,30 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(
                             block_height, progress_current);
         }
 
-        // Read block data
-        CBlock block;
-        chain().findBlock(block_hash, FoundBlock().data(block));
+        bool fetch_block{true};
+        if (fast_rescan_filter) {
+            fast_rescan_filter->UpdateIfNeeded();
+            auto matches_block{fast_rescan_filter->MatchesBlock(block_hash)};
+            if (matches_block.has_value()) {
+                if (*matches_block) {
+                    LogPrint(BCLog::SCAN,
+                             "Fast rescan: inspect block %d [%s] (filter "
+                             "matched)\n",
+                             block_height, block_hash.ToString());
+                } else {
+                    result.last_scanned_block = block_hash;
+                    result.last_scanned_height = block_height;
+                    fetch_block = false;
+                }
+            } else {
+                LogPrint(BCLog::SCAN,
+                         "Fast rescan: inspect block %d [%s] (WARNING: block "
+                         "filter not found!)\n",
+                         block_height, block_hash.ToString());
+            }
+        }
 
-        // Find next block separately from reading data above, because reading
+        // Find next block separately from reading data below, because reading
         // is slow and there might be a reorg while it is read.
         bool block_still_active = false;
         bool next_block = false;
@@ -1771,34 +1863,38 @@ CWallet::ScanResult CWallet::ScanForWalletTransactions(
                                              .inActiveChain(next_block)
                                              .hash(next_block_hash)));
 
-        if (!block.IsNull()) {
-            LOCK(cs_wallet);
-            if (!block_still_active) {
-                // Abort scan if current block is no longer active, to prevent
-                // marking transactions as coming from the wrong block.
+        if (fetch_block) {
+            // Read block data
+            CBlock block;
+            chain().findBlock(block_hash, FoundBlock().data(block));
+
+            if (!block.IsNull()) {
+                LOCK(cs_wallet);
+                if (!block_still_active) {
+                    // Abort scan if current block is no longer active, to
+                    // prevent marking transactions as coming from the wrong
+                    // block.
+                    result.last_failed_block = block_hash;
+                    result.status = ScanResult::FAILURE;
+                    break;
+                }
+                for (size_t posInBlock = 0; posInBlock < block.vtx.size();
+                     ++posInBlock) {
+                    SyncTransaction(block.vtx[posInBlock],
+                                    {CWalletTx::Status::CONFIRMED, block_height,
+                                     block_hash, int(posInBlock)},
+                                    fUpdate);
+                }
+                // scan succeeded, record block as most recent successfully
+                // scanned
+                result.last_scanned_block = block_hash;
+                result.last_scanned_height = block_height;
+            } else {
+                // could not scan block, keep scanning but record this block as
+                // the most recent failure
                 result.last_failed_block = block_hash;
                 result.status = ScanResult::FAILURE;
-                break;
             }
-            for (size_t posInBlock = 0; posInBlock < block.vtx.size();
-                 ++posInBlock) {
-                CWalletTx::Confirmation confirm(CWalletTx::Status::CONFIRMED,
-                                                block_height, block_hash,
-                                                posInBlock);
-                SyncTransaction(block.vtx[posInBlock],
-                                {CWalletTx::Status::CONFIRMED, block_height,
-                                 block_hash, int(posInBlock)},
-                                fUpdate);
-            }
-            // scan succeeded, record block as most recent successfully
-            // scanned
-            result.last_scanned_block = block_hash;
-            result.last_scanned_height = block_height;
-        } else {
-            // could not scan block, keep scanning but record this block as
-            // the most recent failure
-            result.last_failed_block = block_hash;
-            result.status = ScanResult::FAILURE;
         }
         if (max_height && block_height >= *max_height) {
             break;
@@ -28,19 +28,21 @@ CZMQNotificationInterface::GetActiveNotifiers() const {
 }
 
 std::unique_ptr<CZMQNotificationInterface> CZMQNotificationInterface::Create(
-    std::function<bool(CBlock &, const CBlockIndex &)> get_block_by_index) {
+    std::function<node::SerializedData(const CBlockIndex &)> get_raw_block,
+    std::function<node::SerializedData(const CTransaction &)> get_raw_tx) {
     std::map<std::string, CZMQNotifierFactory> factories;
     factories["pubhashblock"] =
         CZMQAbstractNotifier::Create<CZMQPublishHashBlockNotifier>;
     factories["pubhashtx"] =
         CZMQAbstractNotifier::Create<CZMQPublishHashTransactionNotifier>;
     factories["pubrawblock"] =
-        [&get_block_by_index]() -> std::unique_ptr<CZMQAbstractNotifier> {
-        return std::make_unique<CZMQPublishRawBlockNotifier>(
-            get_block_by_index);
+        [&get_raw_block]() -> std::unique_ptr<CZMQAbstractNotifier> {
+        return std::make_unique<CZMQPublishRawBlockNotifier>(get_raw_block);
     };
     factories["pubrawtx"] =
-        CZMQAbstractNotifier::Create<CZMQPublishRawTransactionNotifier>;
+        [&get_raw_tx]() -> std::unique_ptr<CZMQAbstractNotifier> {
+        return std::make_unique<CZMQPublishRawTransactionNotifier>(get_raw_tx);
+    };
     factories["pubsequence"] =
         CZMQAbstractNotifier::Create<CZMQPublishSequenceNotifier>;
 
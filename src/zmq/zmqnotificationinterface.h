@@ -5,6 +5,7 @@
 #ifndef BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 #define BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 
+#include <node/serializedcache.h>
 #include <validationinterface.h>
 
 #include <functional>
@@ -21,7 +22,8 @@ public:
     std::list<const CZMQAbstractNotifier *> GetActiveNotifiers() const;
 
     static std::unique_ptr<CZMQNotificationInterface> Create(
-        std::function<bool(CBlock &, const CBlockIndex &)> get_block_by_index);
+        std::function<node::SerializedData(const CBlockIndex &)> get_raw_block,
+        std::function<node::SerializedData(const CTransaction &)> get_raw_tx);
 
 protected:
     bool Initialize();
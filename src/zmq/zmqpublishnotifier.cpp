@@ -12,8 +12,7 @@
 #include <node/blockstorage.h>
 #include <primitives/blockhash.h>
 #include <primitives/txid.h>
-#include <rpc/server.h>
-#include <streams.h>
+#include <util/time.h>
 #include <zmq/zmqutil.h>
 
 #include <zmq.h>
@@ -211,16 +210,20 @@ bool CZMQPublishRawBlockNotifier::NotifyBlock(const CBlockIndex *pindex) {
     LogPrint(BCLog::ZMQ, "zmq: Publish rawblock %s to %s\n",
              pindex->GetBlockHash().GetHex(), this->address);
 
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    CBlock block;
-    if (!m_get_block_by_index(block, *pindex)) {
+    const auto start{SteadyClock::now()};
+    // Usually served from the cache of recently written blocks, so there is
+    // neither disk I/O nor serialization involved.
+    const node::SerializedData data{m_get_raw_block(*pindex)};
+    if (!data) {
         zmqError("Can't read block from disk");
         return false;
     }
 
-    ss << block;
-
-    return SendZmqMessage(MSG_RAWBLOCK, &(*ss.begin()), ss.size());
+    const bool sent{SendZmqMessage(MSG_RAWBLOCK, data->data(), data->size())};
+    LogPrint(BCLog::ZMQ, "zmq: Published rawblock %s (%u bytes) in %dus\n",
+             pindex->GetBlockHash().GetHex(), data->size(),
+             Ticks<std::chrono::microseconds>(SteadyClock::now() - start));
+    return sent;
 }
 
 bool CZMQPublishRawTransactionNotifier::NotifyTransaction(
@@ -228,9 +231,8 @@ bool CZMQPublishRawTransactionNotifier::NotifyTransaction(
     TxId txid = transaction.GetId();
     LogPrint(BCLog::ZMQ, "zmq: Publish rawtx %s to %s\n", txid.GetHex(),
              this->address);
-    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION | RPCSerializationFlags());
-    ss << transaction;
-    return SendZmqMessage(MSG_RAWTX, &(*ss.begin()), ss.size());
+    const node::SerializedData data{m_get_raw_tx(transaction)};
+    return SendZmqMessage(MSG_RAWTX, data->data(), data->size());
 }
 
 // TODO: Dedup this code to take label char, log string
@@ -5,11 +5,11 @@
 #ifndef BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
 #define BITCOIN_ZMQ_ZMQPUBLISHNOTIFIER_H
 
+#include <node/serializedcache.h>
 #include <zmq/zmqabstractnotifier.h>
 
 #include <functional>
 
-class CBlock;
 class CBlockIndex;
 
 class CZMQAbstractPublishNotifier : public CZMQAbstractNotifier {
@@ -42,18 +42,25 @@ public:
 
 class CZMQPublishRawBlockNotifier : public CZMQAbstractPublishNotifier {
 private:
-    const std::function<bool(CBlock &, const CBlockIndex &)>
-        m_get_block_by_index;
+    const std::function<node::SerializedData(const CBlockIndex &)>
+        m_get_raw_block;
 
 public:
     CZMQPublishRawBlockNotifier(
-        std::function<bool(CBlock &, const CBlockIndex &)> get_block_by_index)
-        : m_get_block_by_index{std::move(get_block_by_index)} {}
+        std::function<node::SerializedData(const CBlockIndex &)> get_raw_block)
+        : m_get_raw_block{std::move(get_raw_block)} {}
     bool NotifyBlock(const CBlockIndex *pindex) override;
 };
 
 class CZMQPublishRawTransactionNotifier : public CZMQAbstractPublishNotifier {
+private:
+    const std::function<node::SerializedData(const CTransaction &)>
+        m_get_raw_tx;
+
 public:
+    CZMQPublishRawTransactionNotifier(
+        std::function<node::SerializedData(const CTransaction &)> get_raw_tx)
+        : m_get_raw_tx{std::move(get_raw_tx)} {}
     bool NotifyTransaction(const CTransaction &transaction) override;
 };
 
@@ -12,7 +12,14 @@ from io import BytesIO
 from struct import pack, unpack
 
 from test_framework.blocktools import COINBASE_MATURITY
-from test_framework.messages import BLOCK_HEADER_SIZE
+from test_framework.messages import (
+    BLOCK_HEADER_SIZE,
+    XEC,
+    COutPoint,
+    CTxOut,
+    deser_compact_size,
+    ser_compact_size,
+)
 from test_framework.test_framework import BitcoinTestFramework
 from test_framework.util import (
     assert_equal,
@@ -251,6 +258,92 @@ class RESTTest(BitcoinTestFramework):
             f"/getutxos/checkmempool/{long_uri}", http_method="POST", status=200
         )
 
+        self.log.info("Test the /batch/getutxos and /batch/tx URIs")
+
+        def batch_request(uri, items, status=200, req_type=ReqType.BIN):
+            body = ser_compact_size(len(items)) + b"".join(items)
+            return self.test_rest_request(
+                uri,
+                http_method="POST",
+                req_type=req_type,
+                body=body.hex() if req_type == ReqType.HEX else body,
+                status=status,
+                ret_type=RetType.BYTES,
+            )
+
+        def read_batch_items(f, count):
+            assert_equal(deser_compact_size(f), count)
+            items = [f.read(deser_compact_size(f)) for _ in range(count)]
+            # Nothing should be left over
+            assert_equal(f.read(), b"")
+            return items
+
+        outpoints = [
+            COutPoint(int(txid, 16), n).serialize(),
+            COutPoint(int(spent[0], 16), spent[1]).serialize(),
+            COutPoint(int(txid, 16), n).serialize(),
+        ]
+        output = BytesIO(batch_request("/batch/getutxos", outpoints))
+        (chain_height,) = unpack("<i", output.read(4))
+        assert_equal(chain_height, self.nodes[0].getblockcount())
+        assert_equal(output.read(32)[::-1].hex(), self.nodes[0].getbestblockhash())
+        coins = read_batch_items(output, len(outpoints))
+        # The spent outpoint is reported as an empty item
+        assert_equal(coins[1], b"")
+        assert_equal(coins[0], coins[2])
+        coin = BytesIO(coins[0])
+        # Skip the dummy transaction version
+        coin.read(4)
+        (coin_height,) = unpack("<I", coin.read(4))
+        assert_equal(coin_height, chain_height)
+        txout = CTxOut()
+        txout.deserialize(coin)
+        assert_equal(txout.nValue, 100000 * XEC)
+
+        # The hex format gives the same result
+        hex_response = batch_request("/batch/getutxos", outpoints, req_type=ReqType.HEX)
+        assert_equal(
+            hex_response.decode().strip(),
+            batch_request("/batch/getutxos", outpoints).hex(),
+        )
+
+        # Without checking the mempool, an outpoint spent in the mempool is
+        # still unspent
+        mempool_txid = self.nodes[0].sendtoaddress(not_related_address, 1000)
+        mempool_tx = self.nodes[0].getrawtransaction(mempool_txid, True)
+        mempool_spent = [
+            COutPoint(int(vin["txid"], 16), vin["vout"]).serialize()
+            for vin in mempool_tx["vin"]
+        ]
+        output = BytesIO(batch_request("/batch/getutxos", mempool_spent))
+        output.read(36)
+        assert all(read_batch_items(output, len(mempool_spent)))
+        output = BytesIO(batch_request("/batch/getutxos/checkmempool", mempool_spent))
+        output.read(36)
+        assert not any(read_batch_items(output, len(mempool_spent)))
+
+        # Only the mempool is searched without -txindex
+        txids = [
+            bytes.fromhex(mempool_txid)[::-1],
+            bytes.fromhex(txid)[::-1],
+            bytes(32),
+        ]
+        txs = read_batch_items(BytesIO(batch_request("/batch/tx", txids)), len(txids))
+        assert_equal(txs[0].hex(), mempool_tx["hex"])
+        assert_equal(txs[1:], [b"", b""])
+
+        # Invalid requests
+        batch_request("/batch/getutxos", [], status=400)
+        batch_request("/batch/tx", [b"\x00"], status=400)
+        batch_request("/batch/getutxos", outpoints, status=404, req_type=ReqType.JSON)
+        batch_request("/batch/getutxos", outpoints[:1] * 10001, status=400)
+        batch_request("/batch/tx", txids[:1] * 1001, status=400)
+        # The batch requests must be POST requests
+        for uri in ["/batch/getutxos", "/batch/tx"]:
+            self.test_rest_request(
+                uri, req_type=ReqType.BIN, status=405, ret_type=RetType.OBJ
+            )
+
         # Generate block to not affect upcoming tests
         self.generate(self.nodes[0], 1)
 
@@ -87,6 +87,16 @@ class RpcMiscTest(BitcoinTestFramework):
         logging_help = self.nodes[0].help("logging")
         assert f"valid logging categories are: {categories}" in logging_help
 
+        self.log.info("test getvalidationinterfaceinfo")
+        node.syncwithvalidationinterfacequeue()
+        subscribers = node.getvalidationinterfaceinfo()
+        assert_greater_than_or_equal(len(subscribers), 1)
+        for subscriber in subscribers:
+            assert_equal(subscriber["pending"], 0)
+            assert_greater_than_or_equal(
+                subscriber["max_latency"], subscriber["avg_latency"]
+            )
+
         self.log.info("test getindexinfo")
         # Without any indices running the RPC returns an empty object
         assert_equal(node.getindexinfo(), {})
@@ -0,0 +1,91 @@
+# Copyright (c) 2022 The Bitcoin Core developers
+# Distributed under the MIT software license, see the accompanying
+# file COPYING or http://www.opensource.org/licenses/mit-license.php.
+"""Test that fast rescan using block filters for descriptor wallets detects
+   top-ups correctly and finds the same transactions than the slow variant."""
+
+from test_framework.descriptors import descsum_create
+from test_framework.test_framework import BitcoinTestFramework
+from test_framework.util import assert_equal
+from test_framework.wallet import MiniWallet, getnewdestination
+
+# smaller than default size to speed-up test
+KEYPOOL_SIZE = 10
+# number of blocks to mine
+NUM_BLOCKS = 6
+XPUB = "tpubD6NzVbkrYhZ4YNXVQbNhMK1WqguFsUXceaVJKbmno2aZ3B6QfbMeraaYvnBSGpV3vxLyTTK9DYT1yoEck4XUScMzXoQ2U2oSmE2JyMedq3H"
+
+
+class WalletFastRescanTest(BitcoinTestFramework):
+    def set_test_params(self):
+        self.num_nodes = 1
+        self.extra_args = [[f"-keypool={KEYPOOL_SIZE}", "-blockfilterindex=1"]]
+
+    def skip_test_if_missing_module(self):
+        self.skip_if_no_wallet()
+
+    def get_wallet_txids(self, node, wallet_name):
+        w = node.get_wallet_rpc(wallet_name)
+        txs = w.listtransactions("*", 1000000)
+        return [tx["txid"] for tx in txs]
+
+    def import_descriptors(self, node, wallet_name, descriptors):
+        node.createwallet(
+            wallet_name=wallet_name,
+            descriptors=True,
+            disable_private_keys=True,
+            blank=True,
+        )
+        w = node.get_wallet_rpc(wallet_name)
+        result = w.importdescriptors(descriptors)
+        assert all(r["success"] for r in result)
+
+    def run_test(self):
+        node = self.nodes[0]
+        wallet = MiniWallet(node)
+
+        ranged_desc = descsum_create(f"pkh({XPUB}/0/*)")
+        fixed_pubkey, fixed_spk, fixed_addr = getnewdestination()
+        fixed_desc = descsum_create(f"pkh({fixed_pubkey.hex()})")
+        descriptors = [
+            {
+                "desc": ranged_desc,
+                "timestamp": 0,
+                "range": [0, KEYPOOL_SIZE - 1],
+            },
+            {"desc": fixed_desc, "timestamp": 0},
+        ]
+
+        self.log.info(
+            "Create txs sending to end range address of the descriptor, "
+            "triggering top-ups"
+        )
+        for i in range(NUM_BLOCKS):
+            self.log.info(f"Block {i + 1}/{NUM_BLOCKS}")
+            end_range = (i + 1) * KEYPOOL_SIZE - 1
+            addr = node.deriveaddresses(ranged_desc, [end_range, end_range])[0]
+            spk = bytes.fromhex(node.validateaddress(addr)["scriptPubKey"])
+            self.log.info(f"-> range end {end_range}, address {addr}")
+            wallet.send_to(from_node=node, scriptPubKey=spk, amount=10000)
+            self.log.info(f"-> fixed non-range descriptor address {fixed_addr}")
+            wallet.send_to(from_node=node, scriptPubKey=fixed_spk, amount=10000)
+            self.generate(node, 1)
+
+        self.log.info("Import descriptors with block filter index")
+        with node.assert_debug_log(["fast variant using block filters"]):
+            self.import_descriptors(node, "rescan_fast", descriptors)
+        txids_fast = self.get_wallet_txids(node, "rescan_fast")
+
+        self.restart_node(0, [f"-keypool={KEYPOOL_SIZE}", "-blockfilterindex=0"])
+        self.log.info("Import descriptors w/o block filter index")
+        with node.assert_debug_log(["slow variant inspecting all blocks"]):
+            self.import_descriptors(node, "rescan_slow", descriptors)
+        txids_slow = self.get_wallet_txids(node, "rescan_slow")
+
+        assert_equal(len(txids_slow), 2 * NUM_BLOCKS)
+        assert_equal(len(txids_fast), 2 * NUM_BLOCKS)
+        assert_equal(sorted(txids_slow), sorted(txids_fast))
+
+
+if __name__ == "__main__":
+    WalletFastRescanTest().main()